@@ -12,6 +12,7 @@
 #include "GameSetup.h"
 #include "GlobalUnsynced.h"
 #include "LoadScreen.h"
+#include "ReplayBenchmark.h"
 #include "SelectedUnitsHandler.h"
 #include "WaitCommandsAI.h"
 #include "WordCompletion.h"
@@ -114,15 +115,19 @@
 #include "System/SafeUtil.h"
 #include "System/SpringExitCode.h"
 #include "System/SpringMath.h"
+#include "System/StringUtil.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/LoadSave/LoadSaveHandler.h"
+#include "System/LoadSave/CregLoadSaveHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
+#include "System/LoadSave/DemoReader.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/Misc.h"
 #include "System/Platform/Watchdog.h"
 #include "System/Sound/ISound.h"
 #include "System/Sound/ISoundChannels.h"
 #include "System/Sync/DumpState.h"
+#include "System/Sync/SyncChecker.h"
 #include "System/TimeProfiler.h"
 
 
@@ -134,6 +139,8 @@ CONFIG(bool, GameEndOnConnectionLoss).defaultValue(true);
 CONFIG(bool, WindowedEdgeMove).defaultValue(true).description("Sets whether moving the mouse cursor to the screen edge will move the camera across the map.");
 CONFIG(bool, FullscreenEdgeMove).defaultValue(true).description("see WindowedEdgeMove, just for fullscreen mode");
 
+CONFIG(int, DemoKeyframeInterval).defaultValue(0).minimumValue(0).description("Interval (in seconds) at which savestates are embedded into recorded demos, which allows seeking in them quickly. 0 disables keyframes.");
+
 CONFIG(bool, ShowFPS).defaultValue(false).description("Displays current framerate.");
 CONFIG(bool, ShowClock).defaultValue(true).headlessValue(false).description("Displays a clock on the top-right corner of the screen showing the elapsed time of the current game.");
 CONFIG(bool, ShowSpeed).defaultValue(false).description("Displays current game speed.");
@@ -204,6 +211,7 @@ CR_REG_METADATA(CGame, (
 
 	CR_MEMBER(speedControl),
 	CR_MEMBER(luaGCControl),
+	CR_IGNORED(demoKeyframeInterval),
 
 	CR_IGNORED(jobDispatcher),
 	CR_IGNORED(curKeyCodeChain),
@@ -247,6 +255,7 @@ CGame::CGame(const std::string& mapFileName, const std::string& modFileName, ILo
 	showSpeed = configHandler->GetBool("ShowSpeed");
 
 	speedControl = configHandler->GetInt("SpeedControl");
+	demoKeyframeInterval = configHandler->GetInt("DemoKeyframeInterval") * GAME_SPEED;
 
 	playerRoster.SetSortTypeByCode((PlayerRoster::SortType)configHandler->GetInt("ShowPlayerInfo"));
 
@@ -579,7 +588,7 @@ void CGame::PreLoadSimulation(LuaParser* defsParser)
 
 	loadscreen->SetLoadMessage("Creating QuadField & CEGs");
 	moveDefHandler.Init(defsParser);
-	quadField.Init(int2(mapDims.mapx, mapDims.mapy), CQuadField::BASE_QUAD_SIZE);
+	quadField.Init(int2(mapDims.mapx, mapDims.mapy), CQuadField::BASE_QUAD_SIZE, modInfo.enableQuadFieldSoA);
 	damageArrayHandler.Init(defsParser);
 	explGenHandler.Init();
 }
@@ -833,6 +842,11 @@ void CGame::LoadFinalize()
 		);
 	}
 
+	if (gameSetup->hostDemo && CReplayBenchmark::IsEnabled()) {
+		replayBenchmark = new CReplayBenchmark();
+		replayBenchmark->Init();
+	}
+
 	lastReadNetTime = spring_gettime();
 	lastSimFrameTime = lastReadNetTime;
 	lastDrawFrameTime = lastReadNetTime;
@@ -888,6 +902,11 @@ void CGame::KillMisc()
 	CEndGameBox::Destroy();
 	IVideoCapturing::FreeInstance();
 
+	if (replayBenchmark != nullptr)
+		replayBenchmark->Kill();
+
+	spring::SafeDelete(replayBenchmark);
+
 	LOG("[Game::%s][2]", __func__);
 	// delete this first since AI's might call back into sim-components in their dtors
 	// this means the simulation *should not* assume the EOH still exists on game exit
@@ -930,6 +949,9 @@ void CGame::KillSimulation()
 {
 	LOG("[Game::%s][1]", __func__);
 
+	// results are not needed anymore, but the searches must not outlive the sim
+	unitHandler.FinishAsyncPathRequests(false);
+
 	// Kill all teams that are still alive, in
 	// case the game did not do so through Lua.
 	//
@@ -1129,6 +1151,12 @@ bool CGame::Update()
 
 	LEAVE_SYNCED_CODE();
 
+	// quit once all frames of the benchmarked demo have been simulated
+	if (replayBenchmark != nullptr && gameServer != nullptr && replayBenchmark->IsFinished(gs->frameNum, gameServer->GetDemoEndFrameNum())) {
+		replayBenchmark->WriteResults();
+		gu->globalQuit = true;
+	}
+
 	{
 		SLuaAllocError error = {};
 
@@ -1698,6 +1726,9 @@ void CGame::SimFrame() {
 
 		teamHandler.GameFrame(gs->frameNum);
 		playerHandler.GameFrame(gs->frameNum);
+
+		// overlaps with everything until the next synced event
+		unitHandler.LaunchAsyncPathRequests();
 	}
 
 	lastSimFrameTime = spring_gettime();
@@ -1706,6 +1737,9 @@ void CGame::SimFrame() {
 
 	eventHandler.DbgTimingInfo(TIMING_SIM, lastFrameTime, lastSimFrameTime);
 
+	if (replayBenchmark != nullptr)
+		replayBenchmark->SimFrame(gs->frameNum);
+
 	#ifdef HEADLESS
 	{
 		const float msecMaxSimFrameTime = 1000.0f / (GAME_SPEED * gs->wantedSpeedFactor);
@@ -2018,6 +2052,102 @@ void CGame::Save(std::string&& fileName, std::string&& saveArgs)
 	globalSaveFileData.args = std::move(saveArgs);
 }
 
+void CGame::SaveDemoKeyframe()
+{
+	std::string saveData;
+
+	if (!CCregLoadSaveHandler::SaveKeyframe(saveData))
+		return;
+
+#ifdef SYNCCHECK
+	// read after saving, which also delivers pending path requests
+	const unsigned int syncChecksum = CSyncChecker::GetChecksum();
+#else
+	const unsigned int syncChecksum = 0;
+#endif
+
+	clientNet->GetDemoRecorder()->SaveKeyframe(gs->frameNum, syncChecksum, saveData, clientNet->GetPacketTime(gs->frameNum));
+}
+
+void CGame::SendGameState()
+{
+	// this frame's asynchronous path requests were applied after its sync
+	// response, so the state and checksum no longer match what the server
+	// verifies the savestate against; it requests another one later
+	if (unitHandler.GetAsyncPathFrameNum() == gs->frameNum) {
+		LOG_L(L_WARNING, "[Game::%s] not sending savestate of frame %d (path requests pending at its end)", __func__, gs->frameNum);
+		return;
+	}
+
+	std::string saveData;
+
+	if (!CCregLoadSaveHandler::SaveKeyframe(saveData))
+		return;
+
+#ifdef SYNCCHECK
+	// same as this frame's sync response, nothing synced ran since
+	const unsigned int syncChecksum = CSyncChecker::GetChecksum();
+#else
+	const unsigned int syncChecksum = 0;
+#endif
+
+	const std::vector<std::uint8_t> data = zlib::deflate(reinterpret_cast<const std::uint8_t*>(saveData.data()), saveData.size());
+
+	if (data.empty()) {
+		LOG_L(L_ERROR, "[Game::%s] failed to compress savestate of frame %d", __func__, gs->frameNum);
+		return;
+	}
+
+	LOG("[Game::%s] sending savestate of frame %d (%u KB, %u KB compressed)", __func__, gs->frameNum, unsigned(saveData.size() / 1024), unsigned(data.size() / 1024));
+
+	for (uint32_t dataOffset = 0; dataOffset < data.size(); dataOffset += CBaseNetProtocol::MAX_GAMESTATE_CHUNK_SIZE) {
+		clientNet->Send(CBaseNetProtocol::Get().SendGameState(gu->myPlayerNum, gs->frameNum, syncChecksum, data, dataOffset));
+	}
+}
+
+bool CGame::SeekDemo(int frameNum)
+{
+	if (gameServer == nullptr || !gameSetup->hostDemo)
+		return false;
+
+	int keyframeNum = 0;
+
+	try {
+		CDemoReader demoReader(gameSetup->demoName, 0.0f);
+		const DemoKeyframe* keyframe = demoReader.FindKeyframe(frameNum);
+
+		if (keyframe != nullptr)
+			keyframeNum = keyframe->frameNum;
+	} catch (const std::exception& ex) {
+		LOG_L(L_WARNING, "[Game::%s] could not scan demo \"%s\" for keyframes (%s)", __func__, gameSetup->demoName.c_str(), ex.what());
+	}
+
+	// forward skips are cheaper without reloading unless they pass a keyframe
+	if (frameNum >= gs->frameNum && keyframeNum <= gs->frameNum)
+		return false;
+
+	std::string myPlayerName = gu->GetMyPlayer()->name;
+
+	// undo the suffix added by SpringApp::LoadDemoFile, it adds it again
+	if (myPlayerName.size() > 7 && myPlayerName.compare(myPlayerName.size() - 7, 7, " (spec)") == 0)
+		myPlayerName.resize(myPlayerName.size() - 7);
+
+	std::string script;
+
+	script += "[GAME]\n{\n";
+	script += "\tDemoFile=" + gameSetup->demoName + ";\n";
+	script += "\tDemoSeekFrame=" + IntToString(frameNum) + ";\n";
+	script += "\tMyPlayerName=" + myPlayerName + ";\n";
+	script += "\tIsHost=1;\n";
+	script += "}\n";
+
+	LOG("[Game::%s] restarting demo at keyframe %d to seek to frame %d", __func__, keyframeNum, frameNum);
+
+	gameSetup->reloadScript = std::move(script);
+	gu->globalReload = true;
+	return true;
+}
+
 
 
 
@@ -100,6 +100,8 @@ public:
 	void ParseInputTextGeometry(const std::string& geo);
 
 	void Save(std::string&& fileName, std::string&& saveArgs);
+	/// restarts the demo being watched from its last keyframe before <frameNum>
+	bool SeekDemo(int frameNum);
 
 	void ResizeEvent() override;
 
@@ -119,6 +121,10 @@ private:
 	/// Format and display a chat message received over network
 	void HandleChatMsg(const ChatMessage& msg);
 
+	void SaveDemoKeyframe();
+	/// uploads a savestate of the current frame for mid-game joiners, see NETMSG_GAMESTATE_REQUEST
+	void SendGameState();
+
 	/// Called when a key is released by the user
 	int KeyReleased(int keyCode, int scanCode) override;
 	/// Called when the key is pressed by the user (can be called several times due to key repeat)
@@ -211,6 +217,9 @@ public:
 	// 0 := 1/f rate, 1 := 30/s rate
 	int luaGCControl = 0;
 
+	/// number of frames between keyframes written to the recorded demo (0 := none)
+	int demoKeyframeInterval = 0;
+
 private:
 	JobDispatcher jobDispatcher;
 
@@ -41,6 +41,8 @@ CR_REG_METADATA(CGameSetup, (
 	CR_IGNORED(gameStartDelay),
 
 	CR_IGNORED(numDemoPlayers),
+	CR_IGNORED(demoKeyframeNum),
+	CR_IGNORED(demoSeekFrameNum),
 	CR_IGNORED(maxUnitsPerTeam),
 
 	CR_IGNORED(minSpeed),
@@ -183,6 +185,8 @@ void CGameSetup::ResetState()
 
 	gameStartDelay = 0;
 	numDemoPlayers = 0;
+	demoKeyframeNum = 0;
+	demoSeekFrameNum = 0;
 	maxUnitsPerTeam = 0;
 
 	maxSpeed = 0.0f;
@@ -588,6 +592,9 @@ bool CGameSetup::Init(const std::string& buf)
 	demoName    = file.SGetValueDef("",  "GAME\\Demofile");
 	hostDemo    = !demoName.empty();
 
+	file.GetTDef(demoKeyframeNum,  0, "GAME\\DemoKeyframe");
+	file.GetTDef(demoSeekFrameNum, 0, "GAME\\DemoSeekFrame");
+
 	file.GetTDef(gameStartDelay, 4u, "GAME\\GameStartDelay");
 
 	file.GetDef(recordDemo,          "1", "GAME\\RecordDemo");
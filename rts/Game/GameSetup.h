@@ -48,6 +48,8 @@ public:
 		gameStartDelay = gs.gameStartDelay;
 
 		numDemoPlayers = gs.numDemoPlayers;
+		demoKeyframeNum = gs.demoKeyframeNum;
+		demoSeekFrameNum = gs.demoSeekFrameNum;
 		maxUnitsPerTeam = gs.maxUnitsPerTeam;
 
 		maxSpeed = gs.maxSpeed;
@@ -200,6 +202,12 @@ public:
 	unsigned int gameStartDelay;
 
 	int numDemoPlayers;
+	/**
+	 * When seeking in a demo, the frame of the keyframe the local client
+	 * loads (0 if none) and the frame to skip to from there.
+	 */
+	int demoKeyframeNum;
+	int demoSeekFrameNum;
 	int maxUnitsPerTeam;
 
 	float maxSpeed;
@@ -7,6 +7,8 @@
 #include "Sim/Misc/GlobalConstants.h"
 #include "Game/GameSetup.h"
 #include "Game/SelectedUnitsHandler.h"
+#include "System/Exceptions.h"
+#include "System/StringUtil.h"
 
 CR_BIND(CPlayerHandler,)
 
@@ -137,3 +139,28 @@ void CPlayerHandler::AddPlayer(const CPlayer& player)
 	}
 }
 
+void CPlayerHandler::SerializePlayers(creg::ISerializer* s)
+{
+	int numPlayers = players.size();
+	s->SerializeInt(&numPlayers, sizeof(numPlayers));
+
+	if (numPlayers < 0 || numPlayers > MAX_PLAYERS)
+		throw content_error("[PlayerHandler::SerializePlayers] invalid number of players " + IntToString(numPlayers));
+
+	if (!s->IsWriting() && numPlayers > ActivePlayers()) {
+		// add stubs, overwritten below
+		CPlayer player;
+		player.playerNum = numPlayers - 1;
+
+		AddPlayer(player);
+	}
+
+	for (int i = 0; i < numPlayers; i++) {
+		// whether a player is replayed from a demo is up to the local setup
+		const bool isFromDemo = players[i].isFromDemo;
+
+		s->SerializeObjectInstance(&players[i], players[i].GetClass());
+		players[i].isFromDemo = isFromDemo;
+	}
+}
+
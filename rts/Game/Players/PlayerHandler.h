@@ -75,6 +75,15 @@ public:
 	 */
 	void AddPlayer(const CPlayer& player);
 
+	/**
+	 * @brief Saves or restores the players in place
+	 *
+	 * Used by savestates that continue a running game (demo keyframes,
+	 * mid-game joins); the list never shrinks, so players that joined
+	 * after the state was taken (e.g. the local one) are kept
+	 */
+	void SerializePlayers(creg::ISerializer* s);
+
 private:
 	/**
 	 * @brief players
@@ -1,6 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include <cfloat>
+#include <cstring>
 
 #include <SDL_keycode.h>
 
@@ -34,6 +35,7 @@
 #include "System/Exceptions.h"
 #include "System/SafeUtil.h"
 #include "System/SpringExitCode.h"
+#include "System/StringUtil.h"
 #include "System/TimeProfiler.h"
 #include "System/TdfParser.h"
 #include "System/Input/KeyInput.h"
@@ -42,6 +44,7 @@
 #include "System/FileSystem/VFSHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/LoadSave/DemoReader.h"
+#include "System/LoadSave/CregLoadSaveHandler.h"
 #include "System/LoadSave/LoadSaveHandler.h"
 #include "System/Log/ILog.h"
 #include "System/Net/RawPacket.h"
@@ -385,6 +388,12 @@ void CPreGame::UpdateClientNet()
 				GameDataReceived(packet);
 			} break;
 
+			case NETMSG_GAMESTATE: {
+				// sent between NETMSG_GAMEDATA and NETMSG_SETPLAYERNUM if
+				// we are joining mid-game and the server has a savestate
+				GameStateReceived(packet);
+			} break;
+
 			case NETMSG_SETPLAYERNUM: {
 				// this is sent after NETMSG_GAMEDATA, to let us know which
 				// player number we have (server assigns them based on order
@@ -420,7 +429,7 @@ void CPreGame::UpdateClientNet()
 }
 
 
-void CPreGame::StartServerForDemo(const std::string& demoName)
+void CPreGame::StartServerForDemo(const std::string& demoName, int demoKeyframeNum)
 {
 	TdfParser script((gameData->GetSetupText()).c_str(), (gameData->GetSetupText()).size());
 	TdfParser::TdfSection* tgame = script.GetRootSection()->sections["game"];
@@ -435,6 +444,11 @@ void CPreGame::StartServerForDemo(const std::string& demoName)
 		tgame->AddPair("MapName", gameSetup->mapName);
 		tgame->AddPair("Gametype", gameSetup->modName);
 		tgame->AddPair("Demofile", demoName);
+
+		if (demoKeyframeNum > 0)
+			tgame->AddPair("DemoKeyframe", demoKeyframeNum);
+		if (clientSetup->demoSeekFrame > 0)
+			tgame->AddPair("DemoSeekFrame", clientSetup->demoSeekFrame);
 		tgame->remove("OnlyLocal", false);
 		tgame->remove("HostIP", false);
 		tgame->remove("HostPort", false);
@@ -487,7 +501,7 @@ void CPreGame::ReadDataFromDemo(const std::string& demoName)
 		assert(gameData->GetSetupText() == scanner.GetSetupScript());
 
 		if (CGameSetup::LoadReceivedScript(gameData->GetSetupText(), true)) {
-			StartServerForDemo(demoName);
+			StartServerForDemo(demoName, LoadDemoKeyframe(scanner));
 		} else {
 			throw content_error("Demo contains incorrect script");
 		}
@@ -496,6 +510,89 @@ void CPreGame::ReadDataFromDemo(const std::string& demoName)
 	assert(gameServer != nullptr);
 }
 
+int CPreGame::LoadDemoKeyframe(CDemoReader& demoReader)
+{
+	if (clientSetup->demoSeekFrame <= 0)
+		return 0;
+
+	// a savestate is only readable by the engine build that wrote it
+	if (strcmp(demoReader.GetFileHeader().versionString, SpringVersion::GetSync().c_str()) != 0)
+		return 0;
+
+	const DemoKeyframe* keyframe = demoReader.FindKeyframe(clientSetup->demoSeekFrame);
+
+	if (keyframe == nullptr)
+		return 0;
+
+	std::string saveData;
+
+	if (!demoReader.ReadKeyframe(*keyframe, saveData))
+		return 0;
+
+	LOG("[PreGame::%s] loading keyframe of frame %d (%u bytes) to seek to frame %d", __func__, keyframe->frameNum, keyframe->saveDataSize, clientSetup->demoSeekFrame);
+
+	CCregLoadSaveHandler* keyframeHandler = new CCregLoadSaveHandler();
+	keyframeHandler->LoadKeyframe(saveData, keyframe->syncChecksum);
+
+	assert(saveFileHandler == nullptr);
+	saveFileHandler = keyframeHandler;
+	return keyframe->frameNum;
+}
+
+void CPreGame::GameStateReceived(std::shared_ptr<const netcode::RawPacket> packet)
+{
+	if (!CGameSetup::ScriptLoaded())
+		throw content_error("No game data received from server");
+
+	uint8_t playerNum;
+	int32_t frameNum;
+	uint32_t syncChecksum;
+	uint32_t dataSize;
+	uint32_t dataOffset;
+
+	try {
+		netcode::UnpackPacket pckt(packet, 3);
+		pckt >> playerNum;
+		pckt >> frameNum;
+		pckt >> syncChecksum;
+		pckt >> dataSize;
+		pckt >> dataOffset;
+
+		// chunks arrive in order and the server only sends one savestate
+		if (dataOffset != gameStateData.size() || dataSize < dataOffset)
+			throw netcode::UnpackPacketException("unexpected chunk");
+
+		std::vector<std::uint8_t> chunk(packet->length - CBaseNetProtocol::GAMESTATE_HEADER_SIZE);
+		pckt >> chunk;
+
+		if (chunk.size() > (dataSize - dataOffset))
+			throw netcode::UnpackPacketException("chunk exceeds savestate");
+
+		gameStateData.insert(gameStateData.end(), chunk.begin(), chunk.end());
+	} catch (const netcode::UnpackPacketException& ex) {
+		throw content_error(std::string("invalid savestate received: ") + ex.what());
+	}
+
+	if (gameStateData.size() < dataSize)
+		return;
+
+	const std::vector<std::uint8_t> saveData = zlib::inflate(gameStateData);
+
+	if (saveData.empty())
+		throw content_error("invalid savestate received: decompression failed");
+
+	LOG("[PreGame::%s] joining from a savestate of frame %d by player %d (%u KB)", __func__, frameNum, playerNum, unsigned(saveData.size() / 1024));
+
+	CCregLoadSaveHandler* gameStateHandler = new CCregLoadSaveHandler();
+	gameStateHandler->LoadKeyframe(std::string(saveData.begin(), saveData.end()), syncChecksum);
+
+	assert(saveFileHandler == nullptr);
+	saveFileHandler = gameStateHandler;
+
+	gameStateData.clear();
+	gameStateData.shrink_to_fit();
+}
+
 void CPreGame::GameDataReceived(std::shared_ptr<const netcode::RawPacket> packet)
 {
 	ScopedOnceTimer timer("PreGame::GameDataReceived");
@@ -3,13 +3,16 @@
 #ifndef PREGAME_H
 #define PREGAME_H
 
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "GameController.h"
 #include "System/Misc/SpringTime.h"
 
 class ILoadSaveHandler;
+class CDemoReader;
 class GameData;
 class CGameSetup;
 class ClientSetup;
@@ -54,15 +57,19 @@ private:
 	void AddModArchivesToVFS(const CGameSetup* setup);
 
 	void StartServer(const std::string& setupscript);
-	void StartServerForDemo(const std::string& demoName);
+	void StartServerForDemo(const std::string& demoName, int demoKeyframeNum);
 
 	/// reads out map, mod and script from demos (with or without a gameSetupScript)
 	void ReadDataFromDemo(const std::string& demoName);
+	/// when seeking, sets up the keyframe before ClientSetup::demoSeekFrame to be loaded; returns its frame
+	int LoadDemoKeyframe(CDemoReader& demoReader);
 
 	/// receive network traffic
 	void UpdateClientNet();
 
 	void GameDataReceived(std::shared_ptr<const netcode::RawPacket> packet);
+	/// collects the savestate a mid-game joiner starts from, sets it up to be loaded once complete
+	void GameStateReceived(std::shared_ptr<const netcode::RawPacket> packet);
 
 private:
 	/**
@@ -76,6 +83,9 @@ private:
 	std::string modFileName;
 	ILoadSaveHandler* saveFileHandler;
 
+	/// compressed savestate chunks received so far
+	std::vector<std::uint8_t> gameStateData;
+
 	spring_time connectTimer;
 
 	bool wantDemo;
@@ -0,0 +1,241 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "ReplayBenchmark.h"
+#include "System/StringHash.h"
+#include "System/StringUtil.h"
+#include "System/TimeProfiler.h"
+#include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/Log/ILog.h"
+
+CONFIG(std::string, ReplayBenchmarkOutput).defaultValue("").description("If set, demos are replayed at maximum speed and per-timer frame-time percentiles are written to this file (JSON if it ends in .json, CSV otherwise) when the demo ends. Usually set via --benchmark-replay.");
+
+
+CReplayBenchmark* replayBenchmark = nullptr;
+
+// pseudo-timer holding the wall-clock time between two sampled frames
+static constexpr const char* FRAME_TIMER_NAME = "(frame)";
+
+
+static float GetPercentile(const std::vector<float>& sortedTimes, float p)
+{
+	if (sortedTimes.empty())
+		return 0.0f;
+
+	// nearest-rank
+	const size_t rank = std::ceil(p * sortedTimes.size());
+	return sortedTimes[std::max(rank, size_t(1)) - 1];
+}
+
+static std::string EscapeJSON(const std::string& str)
+{
+	std::string ret;
+	ret.reserve(str.size());
+
+	for (const char c: str) {
+		if (c == '"' || c == '\\')
+			ret += '\\';
+
+		ret += c;
+	}
+
+	return ret;
+}
+
+
+
+bool CReplayBenchmark::IsEnabled()
+{
+	return (!configHandler->GetString("ReplayBenchmarkOutput").empty());
+}
+
+
+void CReplayBenchmark::Init()
+{
+	outputFile = configHandler->GetString("ReplayBenchmarkOutput");
+
+	timerSamples.clear();
+	timerSamples.reserve(256);
+
+	// non-special timers only record while the profiler is enabled
+	profiler.SetEnabled(true);
+	profiler.GetTotalTimes(totalTimes);
+
+	// baseline, everything before the first frame (loading) is ignored
+	for (const auto& p: totalTimes) {
+		timerSamples[p.first].lastTotal = p.second;
+	}
+
+	startTime = spring_gettime();
+	lastFrameTime = startTime;
+
+	firstFrameNum = -1;
+	lastFrameNum = -1;
+	numFrames = 0;
+
+	written = false;
+
+	LOG("[ReplayBenchmark::%s] replaying at maximum speed, results will be written to \"%s\"", __func__, outputFile.c_str());
+}
+
+void CReplayBenchmark::Kill()
+{
+	// game was quit before the demo ended, still dump what we have
+	if (!written && numFrames > 0)
+		WriteResults();
+
+	timerSamples.clear();
+	totalTimes.clear();
+}
+
+
+void CReplayBenchmark::SimFrame(int frameNum)
+{
+	const spring_time curTime = spring_gettime();
+
+	if (firstFrameNum < 0)
+		firstFrameNum = frameNum;
+
+	lastFrameNum = frameNum;
+	numFrames += 1;
+
+	profiler.GetTotalTimes(totalTimes);
+
+	for (const auto& p: totalTimes) {
+		TimerSamples& samples = timerSamples[p.first];
+
+		// timers that did not run in earlier frames count as zero there
+		samples.frameTimes.resize(numFrames - 1, 0.0f);
+		samples.frameTimes.push_back((p.second - samples.lastTotal).toMilliSecsf());
+		samples.lastTotal = p.second;
+	}
+
+	{
+		TimerSamples& samples = timerSamples[hashString(FRAME_TIMER_NAME)];
+
+		samples.frameTimes.resize(numFrames - 1, 0.0f);
+		samples.frameTimes.push_back((curTime - lastFrameTime).toMilliSecsf());
+	}
+
+	lastFrameTime = curTime;
+}
+
+
+bool CReplayBenchmark::IsFinished(int frameNum, int demoEndFrameNum) const
+{
+	return (!written && demoEndFrameNum >= 0 && frameNum >= demoEndFrameNum);
+}
+
+
+std::vector<CReplayBenchmark::TimerStats> CReplayBenchmark::GetTimerStats() const
+{
+	std::vector<TimerStats> stats;
+	std::vector<float> sortedTimes;
+
+	stats.reserve(timerSamples.size());
+
+	for (const auto& p: timerSamples) {
+		if (p.second.frameTimes.empty())
+			continue;
+
+		sortedTimes.assign(p.second.frameTimes.begin(), p.second.frameTimes.end());
+		sortedTimes.resize(numFrames, 0.0f);
+
+		std::sort(sortedTimes.begin(), sortedTimes.end());
+
+		TimerStats ts;
+		ts.name = (p.first == hashString(FRAME_TIMER_NAME))? FRAME_TIMER_NAME: CTimeProfiler::GetTimerName(p.first);
+		ts.mean = 0.0f;
+		ts.p50 = GetPercentile(sortedTimes, 0.50f);
+		ts.p95 = GetPercentile(sortedTimes, 0.95f);
+		ts.p99 = GetPercentile(sortedTimes, 0.99f);
+		ts.max = sortedTimes.back();
+
+		for (const float t: sortedTimes)
+			ts.mean += t;
+
+		ts.mean /= sortedTimes.size();
+
+		stats.push_back(std::move(ts));
+	}
+
+	std::sort(stats.begin(), stats.end(), [](const TimerStats& a, const TimerStats& b) { return (a.name < b.name); });
+	return stats;
+}
+
+
+bool CReplayBenchmark::WriteResults()
+{
+	written = true;
+
+	if (numFrames == 0) {
+		LOG_L(L_WARNING, "[ReplayBenchmark::%s] no frames were simulated, nothing to write", __func__);
+		return false;
+	}
+
+	const std::vector<TimerStats> stats = GetTimerStats();
+	const std::string fileName = dataDirsAccess.LocateFile(outputFile, FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS);
+
+	const bool ret = (StringToLower(FileSystem::GetExtension(fileName)) == "json")?
+		WriteJSON(fileName, stats):
+		WriteCSV(fileName, stats);
+
+	if (!ret) {
+		LOG_L(L_ERROR, "[ReplayBenchmark::%s] could not write results to \"%s\"", __func__, fileName.c_str());
+		return false;
+	}
+
+	LOG("[ReplayBenchmark::%s] wrote statistics of %u timers over %d frames (%.2fs) to \"%s\"", __func__, unsigned(stats.size()), numFrames, (spring_gettime() - startTime).toSecsf(), fileName.c_str());
+	return true;
+}
+
+bool CReplayBenchmark::WriteCSV(const std::string& fileName, const std::vector<TimerStats>& stats) const
+{
+	FILE* f = fopen(fileName.c_str(), "w");
+
+	if (f == nullptr)
+		return false;
+
+	fprintf(f, "timer,frames,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+
+	for (const TimerStats& ts: stats) {
+		fprintf(f, "\"%s\",%d,%.4f,%.4f,%.4f,%.4f,%.4f\n", ts.name.c_str(), numFrames, ts.mean, ts.p50, ts.p95, ts.p99, ts.max);
+	}
+
+	fclose(f);
+	return true;
+}
+
+bool CReplayBenchmark::WriteJSON(const std::string& fileName, const std::vector<TimerStats>& stats) const
+{
+	FILE* f = fopen(fileName.c_str(), "w");
+
+	if (f == nullptr)
+		return false;
+
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"firstFrame\": %d,\n", firstFrameNum);
+	fprintf(f, "\t\"lastFrame\": %d,\n", lastFrameNum);
+	fprintf(f, "\t\"frames\": %d,\n", numFrames);
+	fprintf(f, "\t\"wallTimeSecs\": %.3f,\n", (lastFrameTime - startTime).toSecsf());
+	fprintf(f, "\t\"timers\": {\n");
+
+	for (size_t i = 0, n = stats.size(); i < n; ++i) {
+		const TimerStats& ts = stats[i];
+
+		fprintf(f, "\t\t\"%s\": {\"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f}%s\n",
+			EscapeJSON(ts.name).c_str(), ts.mean, ts.p50, ts.p95, ts.p99, ts.max, (i + 1 < n)? ",": "");
+	}
+
+	fprintf(f, "\t}\n");
+	fprintf(f, "}\n");
+
+	fclose(f);
+	return true;
+}
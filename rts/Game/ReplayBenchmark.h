@@ -0,0 +1,75 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef REPLAY_BENCHMARK_H
+#define REPLAY_BENCHMARK_H
+
+#include <string>
+#include <vector>
+
+#include "System/Misc/SpringTime.h"
+#include "System/UnorderedMap.hpp"
+
+/**
+ * Collects per-frame CTimeProfiler statistics while a demo is replayed
+ * at maximum speed (see the "--benchmark-replay" command-line switch),
+ * and writes p50/p95/p99 frame-times of every timer to a CSV or JSON
+ * file (chosen by extension) once the demo has ended.
+ *
+ * Samples are taken after each SimFrame and cover everything that ran
+ * since the previous one, so unsynced timers (Update, Lua, ...) are
+ * included as well. Frames in which a timer did not run count as zero.
+ */
+class CReplayBenchmark
+{
+public:
+	static bool IsEnabled();
+
+	void Init();
+	void Kill();
+
+	void SimFrame(int frameNum);
+
+	bool IsFinished(int frameNum, int demoEndFrameNum) const;
+	bool WriteResults();
+
+private:
+	struct TimerSamples {
+		spring_time lastTotal;
+		// milliseconds spent per sampled frame
+		std::vector<float> frameTimes;
+	};
+
+	struct TimerStats {
+		std::string name;
+
+		float mean;
+		float p50;
+		float p95;
+		float p99;
+		float max;
+	};
+
+	std::vector<TimerStats> GetTimerStats() const;
+
+	bool WriteCSV(const std::string& fileName, const std::vector<TimerStats>& stats) const;
+	bool WriteJSON(const std::string& fileName, const std::vector<TimerStats>& stats) const;
+
+private:
+	std::string outputFile;
+
+	spring::unordered_map<unsigned, TimerSamples> timerSamples;
+	std::vector< std::pair<unsigned, spring_time> > totalTimes;
+
+	spring_time startTime;
+	spring_time lastFrameTime;
+
+	int firstFrameNum = -1;
+	int lastFrameNum = -1;
+	int numFrames = 0;
+
+	bool written = false;
+};
+
+extern CReplayBenchmark* replayBenchmark;
+
+#endif // REPLAY_BENCHMARK_H
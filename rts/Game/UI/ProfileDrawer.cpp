@@ -479,6 +479,7 @@ static void DrawInfoText(TypedRenderBuffer<VA_TYPE_C   >& rb)
 	constexpr const char* spdFmtStr = "[4] {Current,Wanted}SimSpeedMul={%2.2f, %2.2f}x";
 	constexpr const char* sfxFmtStr = "[5] {Synced,Unsynced}Projectiles={%u,%u} Particles=%u Saturation=%.1f";
 	constexpr const char* pfsFmtStr = "[6] (%s)PFS-updates queued: {%i, %i}";
+	constexpr const char* pcsFmtStr = "[6] (%s)PFS-updates queued: {%i, %i} PathCache={%.0f%% hits, %.1fK evictions, %.0f/%.0fKB}";
 	constexpr const char* luaFmtStr = "[7] Lua-allocated memory: %.1fMB (%.1fK allocs : %.5u usecs : %.1u states)";
 	constexpr const char* gpuFmtStr = "[8] GPU-allocated memory: %.1fMB / %.1fMB";
 	constexpr const char* sopFmtStr = "[9] SOP-allocated memory: {U,F,P,W}={%.1f/%.1f, %.1f/%.1f, %.1f/%.1f, %.1f/%.1f}KB";
@@ -511,7 +512,20 @@ static void DrawInfoText(TypedRenderBuffer<VA_TYPE_C   >& rb)
 				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "TK", pfsUpdates.x, pfsUpdates.y);
 			} break;
 			case HAPFS_TYPE: {
-				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "HA", pfsUpdates.x, pfsUpdates.y);
+				PathCacheStats pcStats[2];
+
+				if (pm->GetPathCacheStats(pcStats[0], false) && pm->GetPathCacheStats(pcStats[1], true)) {
+					pcStats[0] += pcStats[1];
+
+					font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pcsFmtStr, "HA", pfsUpdates.x, pfsUpdates.y,
+						pcStats[0].numHits * 100.0f / std::max(1.0f, float(pcStats[0].numHits + pcStats[0].numMisses)),
+						pcStats[0].numEvictions / 1000.0f,
+						pcStats[0].memUsage / 1024.0f,
+						pcStats[0].memBudget / 1024.0f
+					);
+				} else {
+					font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "HA", pfsUpdates.x, pfsUpdates.y);
+				}
 			} break;
 			case QTPFS_TYPE: {
 				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "QT", pfsUpdates.x, pfsUpdates.y);
@@ -89,6 +89,7 @@
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/Misc/ModInfo.h"
+#include "Sim/Path/IPathManager.h"
 #include "Sim/Projectiles/ProjectileHandler.h"
 #include "Sim/Units/UnitDef.h"
 #include "Sim/Units/UnitDefHandler.h"
@@ -99,8 +100,11 @@
 #include "System/GlobalConfig.h"
 #include "System/SafeUtil.h"
 #include "System/TimeProfiler.h"
+#include "System/TimeUtil.h"
 #include "System/Log/ILog.h"
 #include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/SimpleParser.h"
 #include "System/Sound/ISound.h"
 #include "System/Sound/ISoundChannels.h"
@@ -1545,6 +1549,46 @@ public:
 };
 
 
+class SeekActionExecutor : public IUnsyncedActionExecutor {
+public:
+	SeekActionExecutor() : IUnsyncedActionExecutor(
+		"Seek",
+		"Moves a demo being watched to the given game-second (or frame if prefixed by f, relative if prefixed by +),"
+		" restarting it from a keyframe if that is faster than skipping"
+	) {
+	}
+
+	bool Execute(const UnsyncedAction& action) const final {
+		if (gameServer == nullptr || !gameSetup->hostDemo)
+			return false;
+
+		std::string timeStr = action.GetArgs();
+
+		bool seekFrames = false;
+		bool seekRelative = false;
+
+		if ((seekFrames = (!timeStr.empty() && timeStr[0] == 'f')))
+			timeStr.erase(0, 1);
+		if ((seekRelative = (!timeStr.empty() && timeStr[0] == '+')))
+			timeStr.erase(0, 1);
+
+		if (timeStr.empty())
+			return false;
+
+		const int amount = StringToInt(timeStr);
+		const int frameNum = std::max(0, (seekFrames? amount: (GAME_SPEED * amount)) + (gs->frameNum * seekRelative));
+
+		if (game->SeekDemo(frameNum))
+			return true;
+
+		// no keyframe to start from, skip there as usual
+		CommandMessage pckt(Action("skip f" + IntToString(frameNum)), gu->myPlayerNum);
+		clientNet->Send(pckt.Pack());
+		return true;
+	}
+};
+
+
 class LuaGarbageCollectControlExecutor: public IUnsyncedActionExecutor {
 public:
 	LuaGarbageCollectControlExecutor() : IUnsyncedActionExecutor(
@@ -3445,11 +3489,53 @@ public:
 };
 
 
+class TraceEventsActionExecutor : public IUnsyncedActionExecutor {
+public:
+	TraceEventsActionExecutor() : IUnsyncedActionExecutor(
+		"TraceEvents",
+		"Control recording of profiler timer events: \"start\", \"stop\", or \"dump [<file>]\" to write the most recent events of every thread as Chrome trace-event JSON (default file: traces/<time>.json)"
+	) {
+	}
+
+	bool Execute(const UnsyncedAction& action) const final {
+		const std::vector<std::string> args = CSimpleParser::Tokenize(action.GetArgs());
+
+		if (args.empty())
+			return false;
+
+		switch (hashString(args[0].c_str())) {
+			case hashString("start"): {
+				traceRecorder.SetEnabled(true);
+				LOG("[TraceEventsAction] recording timer events");
+			} break;
+			case hashString("stop"): {
+				traceRecorder.SetEnabled(false);
+				LOG("[TraceEventsAction] stopped recording timer events");
+			} break;
+			case hashString("dump"): {
+				const std::string fileName = (args.size() > 1)? args[1]: ("traces/" + CTimeUtil::GetCurrentTimeStr() + ".json");
+				const std::string filePath = dataDirsAccess.LocateFile(fileName, FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS);
+
+				if (traceRecorder.Dump(filePath)) {
+					LOG("[TraceEventsAction] wrote timer events to \"%s\"", filePath.c_str());
+				} else {
+					LOG_L(L_WARNING, "[TraceEventsAction] could not write timer events to \"%s\"", filePath.c_str());
+				}
+			} break;
+			default: {
+				return false;
+			} break;
+		}
+
+		return true;
+	}
+};
+
 class DebugInfoActionExecutor : public IUnsyncedActionExecutor {
 public:
 	DebugInfoActionExecutor() : IUnsyncedActionExecutor(
 		"DebugInfo",
-		"Print debug info to the chat/log-file about either sound, profiling, or command-descriptions"
+		"Print debug info to the chat/log-file about either sound, profiling, command-descriptions, or path-caches"
 	) {
 	}
 
@@ -3466,8 +3552,30 @@ public:
 			case hashString("cmddescrs"): {
 				commandDescriptionCache.Dump(true);
 			} break;
+			case hashString("pathcache"): {
+				PathCacheStats stats;
+
+				for (const bool synced: {false, true}) {
+					if (!pathManager->GetPathCacheStats(stats, synced)) {
+						LOG("[DbgInfoAction::%s] pathfinder has no path-caches", __func__);
+						break;
+					}
+
+					LOG("[DbgInfoAction::%s][%s] hits=%lu misses=%lu evictions=%lu expirations=%lu items=%lu (max=%lu) mem=%.1f/%.1fKB", __func__,
+						synced? "synced": "unsynced",
+						static_cast<unsigned long>(stats.numHits),
+						static_cast<unsigned long>(stats.numMisses),
+						static_cast<unsigned long>(stats.numEvictions),
+						static_cast<unsigned long>(stats.numExpirations),
+						static_cast<unsigned long>(stats.numItems),
+						static_cast<unsigned long>(stats.maxNumItems),
+						stats.memUsage / 1024.0f,
+						stats.memBudget / 1024.0f
+					);
+				}
+			} break;
 			default: {
-				LOG_L(L_WARNING, "[DbgInfoAction::%s] unknown argument \"%s\" (use \"sound\", \"profiling\", or \"cmddescrs\")", __func__, args.c_str());
+				LOG_L(L_WARNING, "[DbgInfoAction::%s] unknown argument \"%s\" (use \"sound\", \"profiling\", \"cmddescrs\", or \"pathcache\")", __func__, args.c_str());
 			} break;
 		}
 
@@ -3740,6 +3848,7 @@ void UnsyncedGameCommands::AddDefaultActionExecutors()
 	AddActionExecutor(AllocActionExecutor<NetPingActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<NetMsgSmoothingActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<SpeedControlActionExecutor>());
+	AddActionExecutor(AllocActionExecutor<SeekActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<GameInfoActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<HideInterfaceActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<HardwareCursorActionExecutor>());
@@ -3842,6 +3951,7 @@ void UnsyncedGameCommands::AddDefaultActionExecutors()
 	AddActionExecutor(AllocActionExecutor<ReloadTexturesActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<DumpAtlasActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<DebugInfoActionExecutor>());
+	AddActionExecutor(AllocActionExecutor<TraceEventsActionExecutor>());
 
 	// XXX are these redirects really required?
 	AddActionExecutor(AllocActionExecutor<RedirectToSyncedActionExecutor>("ATM"));
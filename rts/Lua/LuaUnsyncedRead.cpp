@@ -54,6 +54,7 @@
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/Misc/QuadField.h"
+#include "Sim/Path/IPathManager.h"
 #include "Sim/Projectiles/Projectile.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitHandler.h"
@@ -105,6 +106,7 @@ bool LuaUnsyncedRead::PushEntries(lua_State* L)
 
 	REGISTER_LUA_CFUNC(GetLuaMemUsage);
 	REGISTER_LUA_CFUNC(GetVidMemUsage);
+	REGISTER_LUA_CFUNC(GetPathCacheStats);
 
 	REGISTER_LUA_CFUNC(GetDrawFrame);
 	REGISTER_LUA_CFUNC(GetFrameTimeOffset);
@@ -502,6 +504,27 @@ int LuaUnsyncedRead::GetVidMemUsage(lua_State* L)
 	return 2;
 }
 
+int LuaUnsyncedRead::GetPathCacheStats(lua_State* L)
+{
+	PathCacheStats stats;
+
+	// only the default pathfinder has search caches
+	if (!pathManager->GetPathCacheStats(stats, luaL_optboolean(L, 1, false)))
+		return 0;
+
+	lua_createtable(L, 0, 9);
+	LuaPushNamedNumber(L, "hits", stats.numHits);
+	LuaPushNamedNumber(L, "misses", stats.numMisses);
+	LuaPushNamedNumber(L, "hitRate", stats.numHits / std::max(1.0f, float(stats.numHits + stats.numMisses)));
+	LuaPushNamedNumber(L, "evictions", stats.numEvictions);
+	LuaPushNamedNumber(L, "expirations", stats.numExpirations);
+	LuaPushNamedNumber(L, "items", stats.numItems);
+	LuaPushNamedNumber(L, "maxItems", stats.maxNumItems);
+	LuaPushNamedNumber(L, "memUsage", stats.memUsage / 1024.0f); // KB
+	LuaPushNamedNumber(L, "memBudget", stats.memBudget / 1024.0f); // KB
+	return 1;
+}
+
 
 /******************************************************************************/
 
@@ -3,7 +3,9 @@
 #include "System/Net/UDPListener.h"
 #include "System/Net/UDPConnection.h"
 
+#include <cstring>
 #include <functional>
+#include <limits>
 
 #if defined DEDICATED || defined DEBUG
 	#include <iostream>
@@ -75,6 +77,7 @@ CONFIG(bool, WhiteListAdditionalPlayers).defaultValue(true);
 CONFIG(bool, ServerRecordDemos).defaultValue(false).dedicatedValue(true);
 CONFIG(bool, ServerLogInfoMessages).defaultValue(false);
 CONFIG(bool, ServerLogDebugMessages).defaultValue(false);
+CONFIG(int, ServerJoinSnapshotInterval).defaultValue(0).minimumValue(0).description("seconds between savestates requested from a synced player, mid-game joiners load the latest one instead of replaying the whole game (0 = disabled)");
 CONFIG(std::string, AutohostIP).defaultValue("127.0.0.1");
 
 
@@ -110,6 +113,9 @@ static constexpr unsigned gameProgressFrameInterval = GAME_SPEED * 5;
 
 static constexpr unsigned syncResponseEchoInterval = GAME_SPEED * 2;
 
+/// user-speed used when replaying a demo for benchmarking, effectively unbounded
+static constexpr float REPLAY_BENCHMARK_SPEED = 1000.0f;
+
 
 //FIXME remodularize server commands, so they get registered in word completion etc.
 decltype(CGameServer::commandBlacklist) CGameServer::commandBlacklist{
@@ -185,6 +191,13 @@ void CGameServer::Initialize()
 	if (myGameSetup->hostDemo) {
 		Message(spring::format(PlayingDemo, myGameSetup->demoName.c_str()));
 		demoReader.reset(new CDemoReader(myGameSetup->demoName, modGameTime + 0.1f));
+
+		#ifndef DEDICATED
+		// replay benchmarks run as fast as the local client can keep up with,
+		// speed-control will throttle internalSpeed to its actual sim-rate
+		if (!configHandler->GetString("ReplayBenchmarkOutput").empty())
+			minUserSpeed = (maxUserSpeed = REPLAY_BENCHMARK_SPEED);
+		#endif
 	}
 
 	// initialize players, teams & ais
@@ -246,6 +259,13 @@ void CGameServer::Initialize()
 		std::sort(commandBlacklist.begin(), commandBlacklist.end());
 	}
 
+	if (demoReader != nullptr) {
+		if (myGameSetup->demoKeyframeNum > 0)
+			SkipToDemoKeyframe(myGameSetup->demoKeyframeNum);
+
+		demoSeekFrameNum = myGameSetup->demoSeekFrameNum;
+	}
+
 	if (configHandler->GetBool("ServerRecordDemos")) {
 		demoRecorder.reset(new CDemoRecorder(myGameSetup->mapName, myGameSetup->modName, true));
 		demoRecorder->WriteSetupText(myGameData->GetSetupText());
@@ -255,6 +275,10 @@ void CGameServer::Initialize()
 	}
 
 	loopSleepTime = configHandler->GetInt("ServerSleepTime");
+#ifdef SYNCCHECK
+	// savestates are only handed out once CheckSync verified their frame
+	gameStateInterval = (demoReader == nullptr)? configHandler->GetInt("ServerJoinSnapshotInterval") * GAME_SPEED: 0;
+#endif
 	linkMinPacketSize = globalConfig.linkIncomingMaxPacketRate > 0 ? (globalConfig.linkIncomingSustainedBandwidth / globalConfig.linkIncomingMaxPacketRate) : 1;
 
 	lastNewFrameTick = spring_gettime();
@@ -430,6 +454,54 @@ void CGameServer::SkipTo(int targetFrameNum)
 	isPaused = wasPaused;
 }
 
+void CGameServer::SkipToDemoKeyframe(int keyframeNum)
+{
+	netcode::RawPacket* buf = nullptr;
+
+	// no client is connected yet, anything broadcast here ends up in the
+	// packet-cache; frames and other synced data before the keyframe are
+	// part of its savestate and must not be sent
+	while ((buf = demoReader->GetData(std::numeric_limits<float>::max()))) {
+		std::shared_ptr<const RawPacket> rpkt(buf);
+
+		if (buf->length <= 0)
+			continue;
+
+		switch (buf->data[0]) {
+			case NETMSG_NEWFRAME:
+			case NETMSG_KEYFRAME: {
+				serverFrameNum++;
+			} break;
+
+			case NETMSG_DEMO_KEYFRAME: {
+				if (DemoKeyframes::GetFrameNum(buf->data, buf->length) != keyframeNum)
+					break;
+
+				assert(serverFrameNum == keyframeNum);
+
+				// resume reading at the chunk after the keyframe
+				modGameTime = demoReader->GetNextDemoReadTime();
+				return;
+			}
+
+			case NETMSG_CREATE_NEWPLAYER: {
+				if (AddDemoPlayer(rpkt))
+					Broadcast(rpkt);
+			} break;
+
+			case NETMSG_PLAYERNAME:
+			case NETMSG_PLAYERLEFT: {
+				Broadcast(rpkt);
+			} break;
+
+			default: {
+			} break;
+		}
+	}
+
+	Message(spring::format("Warning: keyframe of frame %d not found in demo", keyframeNum));
+}
+
 std::string CGameServer::GetPlayerNames(const std::vector<int>& indices) const
 {
 	std::string playerstring;
@@ -482,19 +554,8 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 			}
 
 			case NETMSG_CREATE_NEWPLAYER: {
-				try {
-					netcode::UnpackPacket pckt(rpkt, 3);
-					unsigned char spectator, team, playerNum;
-					std::string name;
-					pckt >> playerNum;
-					pckt >> spectator;
-					pckt >> team;
-					pckt >> name;
-					AddAdditionalUser(name, "", true, (bool)spectator, (int)team, playerNum); // even though this is a demo, keep the players vector properly updated
-				} catch (const netcode::UnpackPacketException& ex) {
-					Message(spring::format("Warning: Discarding invalid new player packet in demo: %s", ex.what()));
+				if (!AddDemoPlayer(rpkt))
 					continue;
-				}
 
 				Broadcast(rpkt);
 				break;
@@ -503,7 +564,9 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 			case NETMSG_GAMEDATA:
 			case NETMSG_SETPLAYERNUM:
 			case NETMSG_USER_SPEED:
-			case NETMSG_INTERNAL_SPEED: {
+			case NETMSG_INTERNAL_SPEED:
+			case NETMSG_GAMESTATE_REQUEST:
+			case NETMSG_DEMO_KEYFRAME: {
 				// never send these from demos
 				break;
 			}
@@ -533,6 +596,7 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 
 	if (demoReader->ReachedEnd()) {
 		demoReader.reset();
+		demoEndFrameNum = serverFrameNum;
 		Message(DemoEnd);
 
 		ret = false;
@@ -541,6 +605,25 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 	return ret;
 }
 
+bool CGameServer::AddDemoPlayer(std::shared_ptr<const netcode::RawPacket> packet)
+{
+	try {
+		netcode::UnpackPacket pckt(packet, 3);
+		unsigned char spectator, team, playerNum;
+		std::string name;
+		pckt >> playerNum;
+		pckt >> spectator;
+		pckt >> team;
+		pckt >> name;
+		AddAdditionalUser(name, "", true, (bool)spectator, (int)team, playerNum); // even though this is a demo, keep the players vector properly updated
+	} catch (const netcode::UnpackPacketException& ex) {
+		Message(spring::format("Warning: Discarding invalid new player packet in demo: %s", ex.what()));
+		return false;
+	}
+
+	return true;
+}
+
 void CGameServer::Broadcast(std::shared_ptr<const netcode::RawPacket> packet)
 {
 	for (GameParticipant& p: players) {
@@ -554,6 +637,139 @@ void CGameServer::Broadcast(std::shared_ptr<const netcode::RawPacket> packet)
 		demoRecorder->SaveToDemo(packet->data, packet->length, GetDemoTime());
 }
 
+void CGameServer::RequestGameState()
+{
+	if (!canReconnect && !allowSpecJoin)
+		return;
+
+	// prefer the host, whose simulation is never behind the server
+	unsigned int playerNum = -1u;
+
+	if (HasLocalClient() && players[localClientNumber].myState == GameParticipant::INGAME && !players[localClientNumber].desynced) {
+		playerNum = localClientNumber;
+	} else {
+		for (const GameParticipant& p: players) {
+			if (p.myState != GameParticipant::INGAME || p.desynced)
+				continue;
+			if (playerNum != -1u && p.lastFrameResponse <= players[playerNum].lastFrameResponse)
+				continue;
+
+			playerNum = p.id;
+		}
+	}
+
+	if (playerNum == -1u)
+		return;
+
+	// a pending request that was never answered (e.g. sender left) is abandoned
+	pendingGameState = {};
+	pendingGameState.frameNum = serverFrameNum;
+	pendingGameState.playerNum = playerNum;
+	pendingGameState.numCachedPackets = numDroppedPackets + packetCache.size();
+
+	players[playerNum].SendData(CBaseNetProtocol::Get().SendGameStateRequest(serverFrameNum));
+}
+
+void CGameServer::GotGameState(unsigned int playerNum, std::shared_ptr<const netcode::RawPacket> packet)
+{
+	try {
+		netcode::UnpackPacket pckt(packet, 3);
+
+		uint8_t senderNum;
+		int32_t frameNum;
+		uint32_t syncChecksum;
+		uint32_t dataSize;
+		uint32_t dataOffset;
+
+		pckt >> senderNum;
+		pckt >> frameNum;
+		pckt >> syncChecksum;
+		pckt >> dataSize;
+		pckt >> dataOffset;
+
+		if (senderNum != playerNum) {
+			Message(spring::format(WrongPlayer, NETMSG_GAMESTATE, playerNum, senderNum));
+			return;
+		}
+
+		// stale, unrequested or repeated chunk
+		if (playerNum != pendingGameState.playerNum || frameNum != pendingGameState.frameNum || dataOffset != pendingGameState.data.size() || pendingGameState.complete)
+			return;
+
+		const uint32_t chunkSize = packet->length - CBaseNetProtocol::GAMESTATE_HEADER_SIZE;
+
+		if (dataSize > (dataOffset + chunkSize) && chunkSize < CBaseNetProtocol::MAX_GAMESTATE_CHUNK_SIZE)
+			throw netcode::UnpackPacketException("truncated chunk");
+		if (dataSize == 0)
+			throw netcode::UnpackPacketException("empty savestate");
+		if ((dataOffset + chunkSize) > dataSize)
+			throw netcode::UnpackPacketException("chunk exceeds savestate size");
+
+		pendingGameState.syncChecksum = syncChecksum;
+		pendingGameState.data.insert(pendingGameState.data.end(), packet->data + CBaseNetProtocol::GAMESTATE_HEADER_SIZE, packet->data + packet->length);
+
+		if (pendingGameState.data.size() < dataSize)
+			return;
+	} catch (const netcode::UnpackPacketException& ex) {
+		Message(spring::format("Player %d sent invalid GameState: %s", playerNum, ex.what()));
+		pendingGameState = {};
+		return;
+	}
+
+	// a desynced savestate would desync everybody who loads it
+	if (players[playerNum].desynced) {
+		pendingGameState = {};
+		return;
+	}
+
+	pendingGameState.complete = true;
+	AcceptGameState();
+}
+
+#ifdef SYNCCHECK
+void CGameServer::VerifyGameState(bool majorityInSync, unsigned int correctChecksum)
+{
+	const auto& syncResponse = players[pendingGameState.playerNum].syncResponse;
+	const auto syncResponseIt = syncResponse.find(pendingGameState.frameNum);
+
+	// the sender has to be among the majority of players that are in sync at the savestate's frame
+	if (!majorityInSync || syncResponseIt == syncResponse.end() || syncResponseIt->second != correctChecksum) {
+		if (logInfoMessages)
+			Message(spring::format("[GameServer::%s] discarding savestate of frame %d from player %d, frame not verified in sync", __func__, pendingGameState.frameNum, pendingGameState.playerNum), false);
+
+		pendingGameState = {};
+		return;
+	}
+
+	pendingGameState.verified = true;
+	pendingGameState.verifiedChecksum = correctChecksum;
+	AcceptGameState();
+}
+#endif
+
+void CGameServer::AcceptGameState()
+{
+	if (!pendingGameState.complete || !pendingGameState.verified)
+		return;
+
+	// the checksum joiners continue from must be the one everybody agreed on
+	if (pendingGameState.syncChecksum != pendingGameState.verifiedChecksum) {
+		Message(spring::format("Player %d sent a GameState with a wrong checksum for frame %d", pendingGameState.playerNum, pendingGameState.frameNum));
+		pendingGameState = {};
+		return;
+	}
+
+	// joiners no longer need anything the savestate already covers
+	packetCache.erase(packetCache.begin(), packetCache.begin() + (pendingGameState.numCachedPackets - numDroppedPackets));
+	numDroppedPackets = pendingGameState.numCachedPackets;
+
+	gameState = std::move(pendingGameState);
+	pendingGameState = {};
+
+	if (logInfoMessages)
+		Message(spring::format("[GameServer::%s] savestate of frame %d from player %d (%u bytes), %u packets cached", __func__, gameState.frameNum, gameState.playerNum, uint32_t(gameState.data.size()), uint32_t(packetCache.size())), false);
+}
+
 void CGameServer::Message(const std::string& message, bool broadcast, bool internal)
 {
 	if (!internal) {
@@ -666,6 +882,9 @@ void CGameServer::CheckSync()
 		desyncGroups.clear();
 		desyncSpecs.clear();
 
+		unsigned numResponses = 0;
+		unsigned numCorrectResponses = 0;
+
 		for (GameParticipant& p: players) {
 			if (p.clientLink == nullptr || p.myState == GameParticipant::State::DISCONNECTING)
 				continue;
@@ -683,6 +902,9 @@ void CGameServer::CheckSync()
 
 			const unsigned pChecksum = pChecksumIt->second;
 
+			numResponses += 1;
+			numCorrectResponses += (haveCorrectChecksum && pChecksum == correctChecksum);
+
 			if ((p.desynced = (haveCorrectChecksum && pChecksum != correctChecksum))) {
 				if (demoReader || !p.spectator) {
 					desyncGroups[pChecksum].push_back(p.id);
@@ -750,6 +972,9 @@ void CGameServer::CheckSync()
 
 		// Remove complete sets (for which all player's checksums have been received).
 		if (completeResponseSet) {
+			if (static_cast<int>(outstandingSyncFrame) == pendingGameState.frameNum)
+				VerifyGameState((numCorrectResponses * 2) > numResponses, correctChecksum);
+
 			for (GameParticipant& p: players) {
 				if (p.myState < GameParticipant::DISCONNECTING)
 					p.syncResponse.erase(outstandingSyncFrame);
@@ -825,6 +1050,12 @@ void CGameServer::Update()
 		}
 	}
 
+	if (gameHasStarted && demoSeekFrameNum > 0) {
+		// continues from the keyframe if the local client loaded one
+		SkipTo(demoSeekFrameNum);
+		demoSeekFrameNum = 0;
+	}
+
 	if (!gameHasStarted)
 		CheckForGameStart();
 	else if (!PreSimFrame() || demoReader != nullptr)
@@ -1329,6 +1560,10 @@ void CGameServer::ProcessPacket(const unsigned playerNum, std::shared_ptr<const
 		} break;
 
 
+		case NETMSG_GAMESTATE: {
+			GotGameState(a, packet);
+		} break;
+
 		case NETMSG_SYNCRESPONSE: {
 #ifdef SYNCCHECK
 			netcode::UnpackPacket pckt(packet, 1);
@@ -2011,7 +2246,7 @@ void CGameServer::ServerReadNet()
 				if (aiPacket == nullptr)
 					break;
 
-				const bool droppablePacket = (aiPacket->length <= 0 || (aiPacket->data[0] != NETMSG_SYNCRESPONSE && aiPacket->data[0] != NETMSG_KEYFRAME));
+				const bool droppablePacket = (aiPacket->length <= 0 || (aiPacket->data[0] != NETMSG_SYNCRESPONSE && aiPacket->data[0] != NETMSG_KEYFRAME && aiPacket->data[0] != NETMSG_GAMESTATE));
 
 				if (forcedDropPacket && droppablePacket) {
 					++numPktsDropped;
@@ -2638,6 +2873,12 @@ void CGameServer::CreateNewFrame(bool fromServerThread, bool fixedFrameTime)
 				Broadcast(CBaseNetProtocol::Get().SendNewFrame());
 			}
 
+			// the checksum is reset after the sync response of every 4096th
+			// frame (see CGame::ClientReadNet), a savestate of such a frame
+			// could not be verified against the responses
+			if (gameStateInterval > 0 && (serverFrameNum % gameStateInterval) == 0 && (serverFrameNum & 4095) != 0)
+				RequestGameState();
+
 			// every gameProgressFrameInterval, we broadcast current frame in a
 			// special message (that doesn't get cached and skips normal queue)
 			// to let players know their loading %
@@ -2985,6 +3226,12 @@ unsigned CGameServer::BindConnection(
 
 	newPlayer.Connected(clientLink, isLocal);
 	newPlayer.SendData(std::shared_ptr<const RawPacket>(myGameData->Pack()));
+
+	// the player loads the latest savestate instead of simulating the game from its start
+	for (uint32_t dataOffset = 0; gameState.frameNum >= 0 && dataOffset < gameState.data.size(); dataOffset += CBaseNetProtocol::MAX_GAMESTATE_CHUNK_SIZE) {
+		newPlayer.SendData(CBaseNetProtocol::Get().SendGameState(gameState.playerNum, gameState.frameNum, gameState.syncChecksum, gameState.data, dataOffset));
+	}
+
 	newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
 
 	// after gamedata and playerNum, the player can start loading
@@ -3003,7 +3250,7 @@ unsigned CGameServer::BindConnection(
 		}
 	}
 
-	// finally send player all packets he missed until now
+	// finally send player all packets he missed until now (since the savestate, if any)
 	for (const std::shared_ptr<const netcode::RawPacket>& p: packetCache)
 		newPlayer.SendData(p);
 
@@ -98,6 +98,8 @@ public:
 	bool HasLocalClient() const { return (localClientNumber != -1u); }
 	/// Is the server still running?
 	bool HasFinished() const;
+	/// frame at which the hosted demo ran out of data, or -1 if it has not (yet)
+	int GetDemoEndFrameNum() const { return demoEndFrameNum; }
 
 	void UpdateSpeedControl(int speedCtrl);
 	static std::string SpeedControlToString(int speedCtrl);
@@ -172,9 +174,22 @@ private:
 	void WriteDemoData();
 	/// read data from demo and send it to clients
 	bool SendDemoData(int targetFrameNum);
+	/// registers a NETMSG_CREATE_NEWPLAYER read from the demo
+	bool AddDemoPlayer(std::shared_ptr<const netcode::RawPacket> packet);
 
 	void Broadcast(std::shared_ptr<const netcode::RawPacket> packet);
 
+	/// asks a synced player for a savestate of the current frame
+	void RequestGameState();
+	/// collects the chunks of a requested savestate
+	void GotGameState(unsigned int playerNum, std::shared_ptr<const netcode::RawPacket> packet);
+#ifdef SYNCCHECK
+	/// called by CheckSync once every sync response for the requested savestate's frame is in
+	void VerifyGameState(bool majorityInSync, unsigned int correctChecksum);
+#endif
+	/// makes the pending savestate the one sent to joiners and trims packetCache, once it is complete and verified
+	void AcceptGameState();
+
 	/**
 	 * @brief skip frames
 	 *
@@ -182,6 +197,13 @@ private:
 	 * targetFrame to all clients
 	 */
 	void SkipTo(int targetFrameNum);
+	/**
+	 * @brief skip frames covered by a demo keyframe
+	 *
+	 * Reads the demo up to the keyframe of keyframeNum without sending
+	 * any frames, the local client loads the keyframe's savestate instead
+	 */
+	void SkipToDemoKeyframe(int keyframeNum);
 
 	void Message(const std::string& message, bool broadcast = true, bool internal = false);
 	void PrivateMessage(int playerNum, const std::string& message);
@@ -223,6 +245,30 @@ private:
 
 	std::deque< std::shared_ptr<const netcode::RawPacket> > packetCache;
 
+	struct GameState {
+		std::vector<uint8_t> data; // compressed
+		int frameNum = -1;
+		unsigned int playerNum = -1u;
+		unsigned int syncChecksum = 0;
+		/// number of broadcast packets (including dropped ones) the savestate covers
+		size_t numCachedPackets = 0;
+
+		/// whether all chunks were received
+		bool complete = false;
+		/// whether the majority of players, including the sender, were in sync at frameNum
+		bool verified = false;
+		/// the checksum they agreed on
+		unsigned int verifiedChecksum = 0;
+	};
+
+	/// latest complete and verified savestate, sent to mid-game joiners before packetCache
+	GameState gameState;
+	/// savestate currently being received or waiting for its frame to be sync-checked
+	GameState pendingGameState;
+
+	/// number of packets removed from the front of packetCache
+	size_t numDroppedPackets = 0;
+
 	/////////////////// sync stuff ///////////////////
 #ifdef SYNCCHECK
 	std::set<int> outstandingSyncFrames;
@@ -249,9 +295,13 @@ private:
 	int medianPing = 0;
 	int curSpeedCtrl = 0;
 	int loopSleepTime = 0;
+	/// frames between savestate requests, 0 if disabled
+	int gameStateInterval = 0;
 
 
 	int serverFrameNum = -1;
+	/// frame to skip to once the (demo) game has started
+	int demoSeekFrameNum = 0;
 
 	int syncErrorFrame = 0;
 	int syncWarningFrame = 0;
@@ -299,6 +349,8 @@ private:
 	std::atomic<bool> reloadingServer{false};
 	std::atomic<bool> quitServer{false};
 
+	std::atomic<int> demoEndFrameNum{-1};
+
 	union {
 		unsigned char charArray[16];
 		unsigned int intArray[4];
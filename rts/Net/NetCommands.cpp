@@ -278,6 +278,10 @@ void CGame::ClientReadNet()
 		if (packet == nullptr)
 			break;
 
+		// any message can lead to synced changes, deliver the previous frame's
+		// path requests first (this also makes them complete before NEWFRAME)
+		unitHandler.FinishAsyncPathRequests();
+
 		lastReceivedNetPacketTime = spring_gettime();
 
 		const uint8_t* inbuf = packet->data;
@@ -575,6 +579,25 @@ void CGame::ClientReadNet()
 				if ((gs->frameNum & 4095) == 0)
 					CSyncChecker::NewFrame();
 #endif
+
+				// keyframes are taken after the checksum reset, seeking continues from them
+				if (demoKeyframeInterval > 0 && (gs->frameNum % demoKeyframeInterval) == 0 && !haveServerDemo && clientNet->GetDemoRecorder()->IsValid())
+					SaveDemoKeyframe();
+
+				AddTraffic(-1, packetCode, dataLength);
+			} break;
+
+			case NETMSG_GAMESTATE_REQUEST: {
+				const int32_t frameNum = *(int32_t*)(inbuf + 1);
+
+				// the server sends this right after the frame, so the state
+				// is exactly what a mid-game joiner gets once it is loaded
+				if (frameNum == gs->frameNum) {
+					SendGameState();
+				} else {
+					LOG_L(L_WARNING, "[Game::%s] savestate requested for frame %d, current frame is %d", __func__, frameNum, gs->frameNum);
+				}
+
 				AddTraffic(-1, packetCode, dataLength);
 			} break;
 
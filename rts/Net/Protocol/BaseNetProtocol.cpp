@@ -7,6 +7,7 @@
 #include "System/Net/RawPacket.h"
 #include "System/Net/PackPacket.h"
 #include "System/Net/ProtocolDef.h"
+#include <algorithm>
 #include <cinttypes>
 
 using netcode::PackPacket;
@@ -559,6 +560,37 @@ PacketType CBaseNetProtocol::SendClientData(uint8_t playerNum, const std::vector
 }
 
 
+PacketType CBaseNetProtocol::SendGameStateRequest(int32_t frameNum)
+{
+	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(frameNum), NETMSG_GAMESTATE_REQUEST);
+	*packet << frameNum;
+	return PacketType(packet);
+}
+
+PacketType CBaseNetProtocol::SendGameState(uint8_t playerNum, int32_t frameNum, uint32_t syncChecksum, const std::vector<uint8_t>& data, uint32_t dataOffset)
+{
+	assert(dataOffset < data.size());
+
+	const uint32_t dataSize = data.size();
+	const uint32_t chunkSize = std::min(dataSize - dataOffset, MAX_GAMESTATE_CHUNK_SIZE);
+
+	const uint32_t packetSize = GAMESTATE_HEADER_SIZE + chunkSize;
+
+	PackPacket* packet = new PackPacket(packetSize, NETMSG_GAMESTATE);
+	*packet << static_cast<uint16_t>(packetSize);
+	*packet << playerNum;
+	*packet << frameNum;
+	*packet << syncChecksum;
+	*packet << dataSize;
+	*packet << dataOffset;
+
+	std::memcpy(packet->GetWritingPos(), data.data() + dataOffset, chunkSize);
+	packet->pos += chunkSize;
+
+	return PacketType(packet);
+}
+
+
 
 #ifdef SYNCDEBUG
 PacketType CBaseNetProtocol::SendSdCheckrequest(int32_t frameNum)
@@ -666,6 +698,8 @@ CBaseNetProtocol::CBaseNetProtocol()
 	proto->AddType(NETMSG_AI_STATE_CHANGED, 4);
 	proto->AddType(NETMSG_GAME_FRAME_PROGRESS, 5);
 	proto->AddType(NETMSG_PING, 1 + (1 + 1 + 4));
+	proto->AddType(NETMSG_GAMESTATE_REQUEST, 5);
+	proto->AddType(NETMSG_GAMESTATE, -2);
 
 #ifdef SYNCDEBUG
 	proto->AddType(NETMSG_SD_CHKREQUEST, 5);
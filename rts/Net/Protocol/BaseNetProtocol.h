@@ -39,6 +39,11 @@ class CBaseNetProtocol
 public:
 	typedef std::shared_ptr<const netcode::RawPacket> PacketType;
 
+	/// savestates are split into NETMSG_GAMESTATE's of at most this many bytes
+	static constexpr uint32_t MAX_GAMESTATE_CHUNK_SIZE = 32768;
+	/// bytes in front of the chunk data of a NETMSG_GAMESTATE (message id, size, playerNum, frameNum, syncChecksum, dataSize, dataOffset)
+	static constexpr uint32_t GAMESTATE_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint8_t) + sizeof(int32_t) + 3 * sizeof(uint32_t);
+
 	static CBaseNetProtocol& Get();
 
 	PacketType SendKeyFrame(int32_t frameNum);
@@ -110,6 +115,10 @@ public:
 
 	PacketType SendClientData(uint8_t playerNum, const std::vector<uint8_t>& data);
 
+	PacketType SendGameStateRequest(int32_t frameNum);
+	/// sends the chunk of <data> starting at <dataOffset>
+	PacketType SendGameState(uint8_t playerNum, int32_t frameNum, uint32_t syncChecksum, const std::vector<uint8_t>& data, uint32_t dataOffset);
+
 #ifdef SYNCDEBUG
 	PacketType SendSdCheckrequest(int32_t frameNum);
 	PacketType SendSdCheckresponse(uint8_t playerNum, uint64_t flop, std::vector<uint32_t> checksums);
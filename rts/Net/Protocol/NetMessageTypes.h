@@ -93,6 +93,12 @@ enum NETMSG {
 
 	NETMSG_PING = 78, // uint8_t playerNum, uint8_t pingTag, float localTime
 
+	NETMSG_DEMO_KEYFRAME = 79, // int32_t frameNum, uint32_t syncChecksum, uint8_t saveData[] # only written to demos, never sent #
+
+	NETMSG_GAMESTATE_REQUEST = 80, // int32_t frameNum # asks a player for a savestate, sent right after the frame #
+	NETMSG_GAMESTATE         = 81, // uint16_t messageSize, uint8_t playerNum, int32_t frameNum, uint32_t syncChecksum, uint32_t dataSize, uint32_t dataOffset, std::vector<uint8_t> data
+	                               // # chunk of a compressed savestate, sent by the player to the server and by the server to mid-game joiners #
+
 	NETMSG_LAST //max types of netmessages, internal only
 };
 
@@ -10,14 +10,14 @@
 #include "System/Matrix44f.h"
 #include "System/Log/ILog.h"
 
-unsigned int CCollisionHandler::numDiscTests = 0;
-unsigned int CCollisionHandler::numContTests = 0;
+std::atomic<unsigned int> CCollisionHandler::numDiscTests = {0};
+std::atomic<unsigned int> CCollisionHandler::numContTests = {0};
 
 
 
 void CCollisionHandler::PrintStats()
 {
-	LOG("[CCollisionHandler] dis-/continuous tests: %i/%i", numDiscTests, numContTests);
+	LOG("[CCollisionHandler] dis-/continuous tests: %i/%i", numDiscTests.load(), numContTests.load());
 }
 
 
@@ -136,7 +136,7 @@ bool CCollisionHandler::CollisionFootPrint(const CSolidObject* o, const float3&
 
 bool CCollisionHandler::Collision(const CollisionVolume* v, const CMatrix44f& m, const float3& p)
 {
-	numDiscTests += 1;
+	numDiscTests.fetch_add(1, std::memory_order_relaxed);
 
 	// get the inverse volume transformation matrix and
 	// apply it to the projectile's position, then test
@@ -345,7 +345,7 @@ inline bool CCollisionHandler::Intersect(
 
 bool CCollisionHandler::Intersect(const CollisionVolume* v, const CMatrix44f& m, const float3& p0, const float3& p1, CollisionQuery* q)
 {
-	numContTests += 1;
+	numContTests.fetch_add(1, std::memory_order_relaxed);
 
 	const CMatrix44f mInv = m.InvertAffine();
 	const float3 pi0 = mInv.Mul(p0);
@@ -8,6 +8,7 @@
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Map/ReadMap.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/Log/ILog.h"
 #include "System/Sync/HsiehHash.h"
 #include "System/creg/STL_Deque.h"
@@ -18,6 +19,8 @@
 
 #define USE_STAGGERED_UPDATES 0
 
+CONFIG(bool, IncrementalLosUpdates).defaultValue(false).description("After terrain changes, only re-trace the LOS and radar rays that cross the changed area. Results are identical, but every instance keeps its per-ray state in memory.");
+
 
 
 CR_BIND(CLosHandler, )
@@ -62,6 +65,7 @@ inline void SLosInstance::Init(int radius, int allyteam, int2 basePos, float bas
 	this->isCached = false;
 	this->isQueuedForUpdate = false;
 	this->isQueuedForTerraform = false;
+	this->dirtyRect = {};
 }
 
 
@@ -94,8 +98,10 @@ void ILosType::Init(const int mipLevel_, LosType type_)
 	const float* ctrHeightMap = readMap->GetCenterHeightMapSynced();
 	const float* mipHeightMap = readMap->GetMIPHeightMapSynced(mipLevel_);
 
+	const bool incrementalRaycasts = (algoType == LOS_ALGO_RAYCAST && configHandler->GetBool("IncrementalLosUpdates"));
+
 	for (CLosMap& losMap: losMaps) {
-		losMap.Init(size, int2(mapDims.mapx, mapDims.mapy), ctrHeightMap, mipHeightMap, type == LOS_TYPE_LOS);
+		losMap.Init(size, int2(mapDims.mapx, mapDims.mapy), ctrHeightMap, mipHeightMap, type == LOS_TYPE_LOS, incrementalRaycasts);
 	}
 }
 
@@ -384,6 +390,8 @@ inline void ILosType::DeleteInstance(SLosInstance* li)
 	}
 
 	li->squares.clear();
+	li->occludedRaySquares.clear();
+	li->visibleSquares.clear();
 	freeIDs.push_back(li->id);
 }
 
@@ -557,8 +565,7 @@ void ILosType::Update()
 		for_mt(0, losRecalc.size(), [&](const int idx) {
 			auto li = losRecalc[idx];
 			assert(li->refCount > 0);
-			li->squares.clear();
-			losMaps[li->allyteam].PrepareRaycast(li);
+			losMaps[li->allyteam].UpdateRaycast(li);
 		});
 	}
 
@@ -629,14 +636,37 @@ void ILosType::UpdateHeightMapSynced(SRectangle rect)
 		DeleteInstance(li);
 	}
 
+	// LOS-map squares whose (mip-)height depends on the changed heightmap
+	// squares; center heights are interpolated from the surrounding corners
+	const SRectangle losRect(
+		std::max(0, (rect.x1 - 1) >> mipLevel),
+		std::max(0, (rect.z1 - 1) >> mipLevel),
+		std::min(size.x, ((rect.x2 + 1) >> mipLevel) + 1),
+		std::min(size.y, ((rect.z2 + 1) >> mipLevel) + 1)
+	);
+
+	const auto AddDirtyRect = [&](SLosInstance* li) {
+		SRectangle& dr = li->dirtyRect;
+
+		if (dr.GetArea() <= 0) {
+			dr = losRect;
+			return;
+		}
+
+		dr = {std::min(dr.x1, losRect.x1), std::min(dr.z1, losRect.z1), std::max(dr.x2, losRect.x2), std::max(dr.z2, losRect.z2)};
+	};
+
 	// relos used instances
 	for (auto& p: instanceHashes) {
 		for (SLosInstance* li: p.second) {
-			if (li->status & SLosInstance::TLosStatus::RECALC)
-				continue;
 			if (!CheckOverlap(li, rect))
 				continue;
 
+			AddDirtyRect(li);
+
+			if (li->status & SLosInstance::TLosStatus::RECALC)
+				continue;
+
 			UpdateInstanceStatus(li, SLosInstance::TLosStatus::RECALC);
 		}
 	}
@@ -16,74 +16,6 @@
 #include "System/UnorderedMap.hpp"
 
 
-/**
- * LoS Instance
- *
- * The main goal of this object is to store the squares on the LOS map that
- * have been incremented (CLosHandler::LosAdd) when the unit last moved.
- * (CLosHandler::MoveUnit)
- *
- * These squares must be remembered because 1) ray-casting against the terrain
- * is not particularly fast and more importantly 2) the terrain may have changed
- * between the LosAdd and the moment we want to undo the LosAdd.
- *
- * LosInstances may be shared between multiple units. Reference counting is
- * used to track how many units currently use one instance.
- *
- * An instance will be shared iff the other unit is in the same square
- * (basePos, baseSquare) on the LOS map, has the same radius, is in the
- * same ally-team and has the same height.
- */
-struct SLosInstance
-{
-	SLosInstance(int id)
-		: id(id)
-		, allyteam(-1)
-		, radius(-1)
-		, basePos()
-		, baseHeight(-1)
-		, refCount(0)
-		, hashNum(-1)
-		, status(NONE)
-		, isCached(false)
-		, isQueuedForUpdate(false)
-		, isQueuedForTerraform(false)
-	{}
-	void Init(int radius, int allyteam, int2 basePos, float baseHeight, int hashNum);
-
-public:
-	// hash properties
-	int id;
-	int allyteam;
-	int radius;
-	int2 basePos;
-	float baseHeight;
-
-	// working data
-	int refCount;
-	struct RLE { int start; unsigned length; };
-	static constexpr RLE EMPTY_RLE = RLE{0,0};
-	std::vector<RLE> squares;
-
-	// helpers
-	int hashNum;
-	enum TLosStatus {
-		NONE       =  0,
-		NEW        =  1,
-		REACTIVATE =  2,
-		RECALC     =  4,
-		REMOVE     =  8,
-	};
-	int status;
-
-	bool isCached;
-	bool isQueuedForUpdate;
-	bool isQueuedForTerraform;
-};
-
-
-
-
 /**
  * All different types of LOS are implemented using ILosType, which is a
  * 2d array essentially containing a reference count. That is to say, each
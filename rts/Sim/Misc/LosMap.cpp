@@ -2,21 +2,21 @@
 
 #include <algorithm>
 #include <array>
+#include <numeric>
 
 #include "LosMap.h"
-#include "LosHandler.h"
+#include "LosRaycast.h"
 #include "Map/ReadMap.h"
 #include "System/SpringMath.h"
 #include "System/float3.h"
 #include "System/Log/ILog.h"
 #include "System/StringUtil.h"
+#include "System/UnorderedMap.hpp"
 #include "System/Threading/ThreadPool.h"
-#ifdef USE_UNSYNCED_HEIGHTMAP
+#if (defined(USE_UNSYNCED_HEIGHTMAP) && !defined(UNIT_TEST))
 	#include "Game/GlobalUnsynced.h" // for myAllyTeam
 #endif
 
-constexpr float LOS_BONUS_HEIGHT = 5.0f;
-
 
 
 static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RADIUS_ISQRT_TABLES;
@@ -24,6 +24,9 @@ static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RADIUS_ISQRT_TABL
 static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RAYCAST_ANGLE_TABLES;
 static std::array<std::vector< char>, ThreadPool::MAX_THREADS> LOSRAY_SQUARE_TABLES; // visible squares per instance
 
+static std::array<std::vector<int>, ThreadPool::MAX_THREADS> CIRCLE_WIDTH_TABLES; // half-width per sight-circle row
+static std::array<std::vector<int>, ThreadPool::MAX_THREADS> CHANGED_SQUARE_TABLES; // squares touched by re-traced rays
+
 
 static float isqrtTableLookup(unsigned r, int threadNum)
 {
@@ -47,6 +50,25 @@ static void isqrtTableExpand(unsigned r, int threadNum)
 
 
 
+inline static constexpr size_t ToAngleMapIdx(const int2 p, const int radius)
+{
+	// [-radius, +radius]^2 -> [0, +2*radius]^2 -> idx
+	return (p.y + radius) * (2 * radius + 1) + (p.x + radius);
+}
+
+// ray tables only contain the upper right quadrant, the others are mirrored
+inline static int2 RotateRaySquare(const int2 square, int dir)
+{
+	switch (dir) {
+		case  0: return (                 square);
+		case  1: return (                -square);
+		case  2: return (int2( square.y, -square.x));
+		default: return (int2(-square.y,  square.x));
+	}
+}
+
+
+
 // Midpoint circle algorithm
 // func() only get called for the lower top right octant.
 // The others need to get by mirroring.
@@ -118,6 +140,16 @@ public:
 	typedef std::vector<int2> LosLine;
 	typedef std::vector<LosLine> LosTable;
 
+	// flat (ray-square, direction) bit indices used by incremental raycasts
+	struct LosRayIndices {
+		// first ray-square of each ray, plus the total count
+		std::vector<int> rayOffsets;
+		// bits of all rays passing through a sight-square, indexed
+		// by ToAngleMapIdx and stored contiguously per square
+		std::vector<int> squareOffsets;
+		std::vector<int> squareRayBits;
+	};
+
 	// only generates table if not in cache
 	void GenerateForLosSize(size_t losSize);
 
@@ -133,12 +165,20 @@ public:
 		return losTables[losSize].size();
 	}
 
+	const LosTable& GetLosTable(size_t losSize) const {
+		return losTables[losSize];
+	}
+
+	// only generates indices if not in cache
+	const LosRayIndices& GetLosRayIndices(size_t losSize);
+
 private:
 	// [0] is the zero-radius table
 	// NOTE:
 	//   do we even need a table for *every* possible radius?
 	//   why not precalculate only the largest and subsample?
 	std::array<LosTable, MAX_UNIT_SENSOR_RADIUS + 1> losTables;
+	spring::unordered_map<int, LosRayIndices> losRayIndices;
 
 private:
 	static LosLine GetRay(int x, int y);
@@ -170,6 +210,50 @@ void CLosTableHelper::GenerateForLosSize(size_t losSize)
 
 
 
+const CLosTableHelper::LosRayIndices& CLosTableHelper::GetLosRayIndices(size_t losSize)
+{
+	GenerateForLosSize(losSize);
+
+	LosRayIndices& indices = losRayIndices[losSize];
+
+	if (!indices.rayOffsets.empty())
+		return indices;
+
+	const LosTable& table = losTables[losSize];
+	const int radius = losSize;
+
+	indices.rayOffsets.reserve(table.size() + 1);
+	indices.rayOffsets.push_back(0);
+
+	for (const LosLine& ray: table) {
+		indices.rayOffsets.push_back(indices.rayOffsets.back() + ray.size());
+	}
+
+	const auto ForEachRayBit = [&](const auto& func) {
+		for (size_t i = 0; i < table.size(); ++i) {
+			for (size_t n = 0; n < table[i].size(); ++n) {
+				for (int dir = 0; dir < 4; ++dir) {
+					func(ToAngleMapIdx(RotateRaySquare(table[i][n], dir), radius), (indices.rayOffsets[i] + n) * 4 + dir);
+				}
+			}
+		}
+	};
+
+	// counting-sort all bits by the square they belong to
+	indices.squareOffsets.resize(Square((2 * radius) + 1) + 1, 0);
+	indices.squareRayBits.resize(indices.rayOffsets.back() * 4);
+
+	ForEachRayBit([&](size_t squareIdx, int) { indices.squareOffsets[squareIdx + 1] += 1; });
+
+	std::partial_sum(indices.squareOffsets.begin(), indices.squareOffsets.end(), indices.squareOffsets.begin());
+	std::vector<int> squareFill(indices.squareOffsets.begin(), indices.squareOffsets.end() - 1);
+
+	ForEachRayBit([&](size_t squareIdx, int bitIdx) { indices.squareRayBits[squareFill[squareIdx]++] = bitIdx; });
+	return indices;
+}
+
+
+
 /**
  * @brief Precalcs the rays for LineOfSight raytracing.
  * In LoS we raytrace all squares in a radius if they are in view
@@ -432,7 +516,7 @@ void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 	if (losSquares.empty() || losSquares[0].length == SLosInstance::EMPTY_RLE.length)
 		return;
 
-#ifdef USE_UNSYNCED_HEIGHTMAP
+#if (defined(USE_UNSYNCED_HEIGHTMAP) && !defined(UNIT_TEST))
 	// inform ReadMap when squares enter LoS
 	const bool visibleInstanceSquares = (instance->allyteam >= 0 && (instance->allyteam == gu->myAllyTeam || gu->spectatingFullView));
 	const bool updateUnsyncedHeightMap = sendReadmapEvents && visibleInstanceSquares;
@@ -481,10 +565,21 @@ void CLosMap::PrepareRaycast(SLosInstance* instance) const
 }
 
 
+void CLosMap::UpdateRaycast(SLosInstance* instance) const
+{
+	if (!incrementalRaycasts || !IncrementalLosAdd(instance)) {
+		instance->squares.clear();
+		PrepareRaycast(instance);
+	}
+
+	instance->dirtyRect = {};
+}
+
+
 #define MAP_SQUARE(pos) ((pos).y * size.x + (pos).x)
 
 
-void CLosMap::LosAdd(SLosInstance* li) const
+bool CLosMap::IsEmitterBelowGround(const SLosInstance* li) const
 {
 	const auto MAP_SQUARE_FULLRES = [&](int2 pos) {
 		float2 fpos = pos;
@@ -496,10 +591,21 @@ void CLosMap::LosAdd(SLosInstance* li) const
 	};
 
 	const SRectangle fullRect(0, 0, size.x, size.y);
+
+	return (fullRect.Inside(li->basePos) && li->baseHeight <= ctrHeightMap[MAP_SQUARE_FULLRES(li->basePos)]);
+}
+
+
+void CLosMap::LosAdd(SLosInstance* li) const
+{
 	const SRectangle safeRect(li->radius, li->radius, size.x - li->radius, size.y - li->radius);
 
-	if (fullRect.Inside(li->basePos) && li->baseHeight <= ctrHeightMap[MAP_SQUARE_FULLRES(li->basePos)])
+	if (IsEmitterBelowGround(li)) {
+		// nothing to update incrementally
+		li->occludedRaySquares.clear();
+		li->visibleSquares.clear();
 		return;
+	}
 
 	// add all squares within the instance's sight radius
 	if (safeRect.Inside(li->basePos)) {
@@ -512,14 +618,32 @@ void CLosMap::LosAdd(SLosInstance* li) const
 }
 
 
-inline static constexpr size_t ToAngleMapIdx(const int2 p, const int radius)
-{
-	// [-radius, +radius]^2 -> [0, +2*radius]^2 -> idx
-	return (p.y + radius) * (2 * radius + 1) + (p.x + radius);
+// returns true if the square at <off> is occluded on this ray
+inline bool CastLosSquare(
+	float* prvAngle,
+	float* maxAngle,
+	const float squareAngle,
+	const int2& off,
+	int threadNum
+) {
+	// angle to square is smaller than current max-angle, so not visible
+	if (squareAngle < *maxAngle)
+		return true;
+
+	if (squareAngle < *prvAngle) {
+		const float invR = isqrtTableLookup(off.x * off.x + off.y * off.y, threadNum);
+		const float angle = *prvAngle - LOS_BONUS_HEIGHT * invR;
+
+		if (squareAngle < (*maxAngle = angle))
+			return true;
+	}
+
+	*prvAngle = squareAngle;
+	return false;
 }
 
 
-inline void CastLos(
+inline bool CastLos(
 	float* prvAngle,
 	float* maxAngle,
 	const int2& off,
@@ -530,23 +654,11 @@ inline void CastLos(
 ) {
 	const size_t oidx = ToAngleMapIdx(off, losRadius);
 
-	// angle to square is smaller than current max-angle, so not visible
-	if (raycastAngles[oidx] < *maxAngle) {
-		losRaySquares[oidx] = false;
-		return;
-	}
-
-	if (raycastAngles[oidx] < *prvAngle) {
-		const float invR = isqrtTableLookup(off.x * off.x + off.y * off.y, threadNum);
-		const float angle = *prvAngle - LOS_BONUS_HEIGHT * invR;
-
-		if (raycastAngles[oidx] < (*maxAngle = angle)) {
-			losRaySquares[oidx] = false;
-			return;
-		}
-	}
+	if (!CastLosSquare(prvAngle, maxAngle, raycastAngles[oidx], off, threadNum))
+		return false;
 
-	*prvAngle = raycastAngles[oidx];
+	losRaySquares[oidx] = false;
+	return true;
 }
 
 
@@ -580,6 +692,29 @@ void CLosMap::AddSquaresToInstance(SLosInstance* li, const std::vector<char>& lo
 }
 
 
+// returns the ray offsets if the per-ray occlusion state of <li> should be kept
+static const int* PrepareRayOcclusionState(SLosInstance* li, CLosTableHelper& helper, bool incrementalRaycasts)
+{
+	if (!incrementalRaycasts)
+		return nullptr;
+
+	const auto& rayIndices = helper.GetLosRayIndices(li->radius);
+
+	li->occludedRaySquares.clear();
+	li->occludedRaySquares.resize(rayIndices.rayOffsets.back() * 4, false);
+	return (rayIndices.rayOffsets.data());
+}
+
+
+void CLosMap::StoreRaycastState(SLosInstance* li, const std::vector<char>& losRaySquares) const
+{
+	if (!incrementalRaycasts)
+		return;
+
+	li->visibleSquares.assign(losRaySquares.begin(), losRaySquares.end());
+}
+
+
 void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 {
 	// How does it work?
@@ -607,6 +742,8 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 
 	helper.GenerateForLosSize(radius);
 
+	const int* rayOffsets = PrepareRayOcclusionState(li, helper, incrementalRaycasts);
+
 	losRaySquares.clear();
 	losRaySquares.resize(Square((2 * radius) + 1), false);
 	raycastAngles.clear();
@@ -650,29 +787,25 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 		}
 	});
 
-	// cast the rays
+	// cast the rays; all four mirrored directions of a ray are handled
+	// together so the (runtime-selected) SIMD kernels can run them as
+	// lanes, results are identical to those of the scalar kernel
 	losRaySquares[ToAngleMapIdx(int2(0, 0), radius)] = true;
 
-	const size_t numRays = helper.GetLosTableSize(radius);
-
-	for (size_t i = 0; i < numRays; ++i) {
-		float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-		float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-
-		const size_t numSquares = helper.GetLosTableRaySize(radius, i);
-
-		for (size_t n = 0; n < numSquares; n++) {
-			const int2 square = helper.GetLosTableRaySquare(radius, i, n);
+	LosRaycast::CastArgs castArgs;
+	castArgs.rays = &helper.GetLosTable(radius);
+	castArgs.isqrtTable = RADIUS_ISQRT_TABLES[threadNum].data();
+	castArgs.squareAngles = raycastAngles.data();
+	castArgs.visibleSquares = losRaySquares.data();
+	castArgs.rayOffsets = rayOffsets;
+	castArgs.occludedRaySquares = (rayOffsets != nullptr)? &li->occludedRaySquares: nullptr;
+	castArgs.radius = radius;
 
-			CastLos(&prvAngles[0], &maxAngles[0],       square              , losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[1], &maxAngles[1],      -square              , losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[2], &maxAngles[2], int2( square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y,  square.x), losRaySquares, raycastAngles, radius, threadNum);
-		}
-	}
+	LosRaycast::CastRays(castArgs);
 
 	// translate visible square indices to map square idx + RLE
 	AddSquaresToInstance(li, losRaySquares);
+	StoreRaycastState(li, losRaySquares);
 }
 
 
@@ -693,6 +826,14 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 
 	helper.GenerateForLosSize(radius);
 
+	const int* rayOffsets = PrepareRayOcclusionState(li, helper, incrementalRaycasts);
+	const auto SetRayOccluded = [&](size_t i, size_t n, int dir, bool occluded) {
+		if (rayOffsets == nullptr)
+			return;
+
+		li->occludedRaySquares[(rayOffsets[i] + n) * 4 + dir] = occluded;
+	};
+
 	losRaySquares.clear();
 	losRaySquares.resize(Square((2 * radius) + 1), false);
 	raycastAngles.clear();
@@ -758,7 +899,7 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				if (!safeRect.Inside(pos + square))
 					break;
 
-				CastLos(&prvAngles[0], &maxAngles[0],  square,                   losRaySquares, raycastAngles, radius, threadNum);
+				SetRayOccluded(i, n, 0, CastLos(&prvAngles[0], &maxAngles[0],  square,                   losRaySquares, raycastAngles, radius, threadNum));
 			}
 			for (size_t n = 0; n < numSquares; n++) {
 				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
@@ -766,7 +907,7 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				if (!safeRect.Inside(pos - square))
 					break;
 
-				CastLos(&prvAngles[1], &maxAngles[1], -square,                   losRaySquares, raycastAngles, radius, threadNum);
+				SetRayOccluded(i, n, 1, CastLos(&prvAngles[1], &maxAngles[1], -square,                   losRaySquares, raycastAngles, radius, threadNum));
 			}
 			for (size_t n = 0; n < numSquares; n++) {
 				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
@@ -774,7 +915,7 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				if (!safeRect.Inside(pos + int2(square.y, -square.x)))
 					break;
 
-				CastLos(&prvAngles[2], &maxAngles[2], int2(square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
+				SetRayOccluded(i, n, 2, CastLos(&prvAngles[2], &maxAngles[2], int2(square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum));
 			}
 			for (size_t n = 0; n < numSquares; n++) {
 				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
@@ -782,7 +923,7 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				if (!safeRect.Inside(pos + int2(-square.y, square.x)))
 					break;
 
-				CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y, square.x), losRaySquares, raycastAngles, radius, threadNum);
+				SetRayOccluded(i, n, 3, CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y, square.x), losRaySquares, raycastAngles, radius, threadNum));
 			}
 		}
 	} else {
@@ -797,20 +938,168 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
 
 				if (safeRect.Inside(pos + square))
-					CastLos(&prvAngles[0], &maxAngles[0],  square,                   losRaySquares, raycastAngles, radius, threadNum);
+					SetRayOccluded(i, n, 0, CastLos(&prvAngles[0], &maxAngles[0],  square,                   losRaySquares, raycastAngles, radius, threadNum));
 
 				if (safeRect.Inside(pos - square))
-					CastLos(&prvAngles[1], &maxAngles[1], -square,                   losRaySquares, raycastAngles, radius, threadNum);
+					SetRayOccluded(i, n, 1, CastLos(&prvAngles[1], &maxAngles[1], -square,                   losRaySquares, raycastAngles, radius, threadNum));
 
 				if (safeRect.Inside(pos + int2(square.y, -square.x)))
-					CastLos(&prvAngles[2], &maxAngles[2], int2(square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
+					SetRayOccluded(i, n, 2, CastLos(&prvAngles[2], &maxAngles[2], int2(square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum));
 
 				if (safeRect.Inside(pos + int2(-square.y, square.x)))
-					CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y, square.x), losRaySquares, raycastAngles, radius, threadNum);
+					SetRayOccluded(i, n, 3, CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y, square.x), losRaySquares, raycastAngles, radius, threadNum));
 			}
 		}
 	}
 
 	// translate visible square indices to map square idx + RLE
 	AddSquaresToInstance(li, losRaySquares);
+	StoreRaycastState(li, losRaySquares);
+}
+
+
+bool CLosMap::IncrementalLosAdd(SLosInstance* li) const
+{
+	// Only the rays whose squares can lie inside dirtyRect are re-traced; a
+	// square's result on a ray depends only on the heights along that ray up
+	// to the square, so all other per-ray results are still valid. Squares
+	// whose result changed on a re-traced ray are then re-evaluated against
+	// every ray passing through them, which yields exactly the same squares
+	// as a full {Unsafe,Safe}LosAdd.
+	if (li->occludedRaySquares.empty() || li->dirtyRect.GetArea() <= 0)
+		return false;
+	// let the full path handle emitters that dropped below ground
+	if (IsEmitterBelowGround(li))
+		return false;
+
+	const int threadNum = ThreadPool::GetThreadNum();
+
+	const int2 pos   = li->basePos;
+	const int radius = li->radius;
+	const float losHeight = li->baseHeight;
+
+	const SRectangle& dirtyRect = li->dirtyRect;
+	const SRectangle mapRect(0, 0, size.x, size.y);
+	const SRectangle safeRect(radius, radius, size.x - radius, size.y - radius);
+
+	// same map-boundary handling as {Unsafe,Safe}LosAdd
+	const bool unsafeCast = safeRect.Inside(pos);
+	const bool breakAtEdge = (!unsafeCast && mapRect.Inside(pos));
+
+
+	CLosTableHelper& helper = losTableHelpers[threadNum];
+
+	const auto& rayIndices = helper.GetLosRayIndices(radius);
+
+	std::vector<char>& losRaySquares = LOSRAY_SQUARE_TABLES[threadNum];
+	std::vector<int>& circleWidths = CIRCLE_WIDTH_TABLES[threadNum];
+	std::vector<int>& changedSquares = CHANGED_SQUARE_TABLES[threadNum];
+
+	assert(li->occludedRaySquares.size() == size_t(rayIndices.rayOffsets.back() * 4));
+	assert(li->visibleSquares.size() == size_t(Square((2 * radius) + 1)));
+
+	isqrtTableExpand((radius + 1) * (radius + 1), threadNum);
+
+	circleWidths.clear();
+	circleWidths.resize((2 * radius) + 1, -1);
+	changedSquares.clear();
+
+	MidpointCircleAlgoPerLine(radius, [&](int width, int y) {
+		circleWidths[y + radius] = std::max(circleWidths[y + radius], width);
+	});
+
+	// squares marked visible before casting, matches the angle precalculation
+	const auto IsSightSquare = [&](const int2 off) {
+		if (off == int2(0, 0))
+			return (unsafeCast || breakAtEdge);
+		if (std::abs(off.x) > circleWidths[off.y + radius])
+			return false;
+
+		return (unsafeCast || mapRect.Inside(pos + off));
+	};
+	const auto GetSquareAngle = [&](const int2 off) -> float {
+		if (off == int2(0, 0) || !IsSightSquare(off))
+			return -1e8;
+
+		const float invR = isqrtTableLookup(off.x*off.x + off.y*off.y, threadNum);
+		const float dh = std::max(0.0f, mipHeightMap[MAP_SQUARE(pos + off)]) - losHeight;
+
+		return ((dh + LOS_BONUS_HEIGHT) * invR);
+	};
+
+
+	// re-trace affected rays
+	auto& occludedRaySquares = li->occludedRaySquares;
+
+	const size_t numRays = helper.GetLosTableSize(radius);
+
+	for (size_t i = 0; i < numRays; ++i) {
+		const size_t numSquares = helper.GetLosTableRaySize(radius, i);
+		const int2 lastSquare = helper.GetLosTableRaySquare(radius, i, numSquares - 1);
+
+		for (int dir = 0; dir < 4; ++dir) {
+			// rays never leave the bounding box of their end points
+			const int2 rayEnd = pos + RotateRaySquare(lastSquare, dir);
+			const SRectangle rayRect(
+				std::min(pos.x, rayEnd.x),     std::min(pos.y, rayEnd.y),
+				std::max(pos.x, rayEnd.x) + 1, std::max(pos.y, rayEnd.y) + 1
+			);
+
+			if (!rayRect.CheckOverlap(dirtyRect))
+				continue;
+
+			float maxAngle = -1e7;
+			float prvAngle = -1e7;
+
+			for (size_t n = 0; n < numSquares; n++) {
+				const int2 off = RotateRaySquare(helper.GetLosTableRaySquare(radius, i, n), dir);
+
+				if (!unsafeCast && !mapRect.Inside(pos + off)) {
+					if (breakAtEdge)
+						break;
+
+					continue;
+				}
+
+				const bool occluded = CastLosSquare(&prvAngle, &maxAngle, GetSquareAngle(off), off, threadNum);
+				const size_t bitIdx = (rayIndices.rayOffsets[i] + n) * 4 + dir;
+
+				if (occludedRaySquares[bitIdx] == occluded)
+					continue;
+
+				occludedRaySquares[bitIdx] = occluded;
+				changedSquares.push_back(ToAngleMapIdx(off, radius));
+			}
+		}
+	}
+
+	// nothing changed, keep the current squares
+	if (changedSquares.empty())
+		return true;
+
+	// re-evaluate visibility of every square whose result changed on some ray
+	const int diameter = (2 * radius) + 1;
+
+	for (const int squareIdx: changedSquares) {
+		const int2 off = {(squareIdx % diameter) - radius, (squareIdx / diameter) - radius};
+
+		bool visible = IsSightSquare(off);
+
+		for (int k = rayIndices.squareOffsets[squareIdx]; visible && k < rayIndices.squareOffsets[squareIdx + 1]; ++k) {
+			visible = !occludedRaySquares[rayIndices.squareRayBits[k]];
+		}
+
+		li->visibleSquares[squareIdx] = visible;
+	}
+
+	losRaySquares.assign(li->visibleSquares.begin(), li->visibleSquares.end());
+
+	// translate visible square indices to map square idx + RLE
+	li->squares.clear();
+	AddSquaresToInstance(li, losRaySquares);
+
+	if (li->squares.empty())
+		li->squares.push_back(SLosInstance::EMPTY_RLE);
+
+	return true;
 }
@@ -7,18 +7,97 @@
 
 #include <vector>
 #include "System/type2.h"
+#include "System/Rectangle.h"
 #include "System/SpringMath.h"
 
 
-struct SLosInstance;
+/**
+ * LoS Instance
+ *
+ * The main goal of this object is to store the squares on the LOS map that
+ * have been incremented (CLosHandler::LosAdd) when the unit last moved.
+ * (CLosHandler::MoveUnit)
+ *
+ * These squares must be remembered because 1) ray-casting against the terrain
+ * is not particularly fast and more importantly 2) the terrain may have changed
+ * between the LosAdd and the moment we want to undo the LosAdd.
+ *
+ * LosInstances may be shared between multiple units. Reference counting is
+ * used to track how many units currently use one instance.
+ *
+ * An instance will be shared iff the other unit is in the same square
+ * (basePos, baseSquare) on the LOS map, has the same radius, is in the
+ * same ally-team and has the same height.
+ */
+struct SLosInstance
+{
+	SLosInstance(int id)
+		: id(id)
+		, allyteam(-1)
+		, radius(-1)
+		, basePos()
+		, baseHeight(-1)
+		, refCount(0)
+		, hashNum(-1)
+		, status(NONE)
+		, isCached(false)
+		, isQueuedForUpdate(false)
+		, isQueuedForTerraform(false)
+	{}
+	void Init(int radius, int allyteam, int2 basePos, float baseHeight, int hashNum);
+
+public:
+	// hash properties
+	int id;
+	int allyteam;
+	int radius;
+	int2 basePos;
+	float baseHeight;
+
+	// working data
+	int refCount;
+	struct RLE { int start; unsigned length; };
+	static constexpr RLE EMPTY_RLE = RLE{0,0};
+	std::vector<RLE> squares;
+
+	// incremental raycast state (see CLosMap::UpdateRaycast), only kept
+	// when IncrementalLosUpdates is enabled:
+	//   per-(ray, square, direction) bits set if the ray occluded the square
+	//   per-square visibility bits of the (2 * radius + 1)^2 sight area
+	//   LOS-map squares whose height changed since the last raycast
+	std::vector<bool> occludedRaySquares;
+	std::vector<bool> visibleSquares;
+	SRectangle dirtyRect;
+
+	// helpers
+	int hashNum;
+	enum TLosStatus {
+		NONE       =  0,
+		NEW        =  1,
+		REACTIVATE =  2,
+		RECALC     =  4,
+		REMOVE     =  8,
+	};
+	int status;
+
+	bool isCached;
+	bool isQueuedForUpdate;
+	bool isQueuedForTerraform;
+};
 
 
 /// map containing counts of how many units have Line Of Sight (LOS) to each square
 class CLosMap
 {
 public:
-	void Init(const int2 size_, const int2 mapDims, const float* ctrHeightMap_, const float* mipHeightMap_, bool sendReadmapEvents_)
-	{
+	void Init(
+		const int2 size_,
+		const int2 mapDims,
+		const float* ctrHeightMap_,
+		const float* mipHeightMap_,
+		bool sendReadmapEvents_,
+		bool incrementalRaycasts_ = false
+	) {
 		size = size_;
 		LOS2HEIGHT = mapDims / size;
 
@@ -29,6 +108,7 @@ public:
 		mipHeightMap = mipHeightMap_;
 
 		sendReadmapEvents = sendReadmapEvents_;
+		incrementalRaycasts = incrementalRaycasts_;
 	}
 
 	void Kill() {}
@@ -43,6 +123,10 @@ public:
 	/// arbitrary area, for losMap, non-circular radar maps, ...
 	void PrepareRaycast(SLosInstance* instance) const;
 
+	/// recalculates the squares of a raycast instance, only re-tracing rays
+	/// that cross its dirtyRect when incremental raycasts are enabled
+	void UpdateRaycast(SLosInstance* instance) const;
+
 public:
 	int At(int2 p) const {
 		p.x = Clamp(p.x, 0, size.x - 1);
@@ -57,6 +141,10 @@ private:
 	void LosAdd(SLosInstance* instance) const;
 	void UnsafeLosAdd(SLosInstance* instance) const;
 	void SafeLosAdd(SLosInstance* instance) const;
+	bool IncrementalLosAdd(SLosInstance* instance) const;
+
+	bool IsEmitterBelowGround(const SLosInstance* instance) const;
+	void StoreRaycastState(SLosInstance* instance, const std::vector<char>& losRaySquares) const;
 
 	void AddSquaresToInstance(SLosInstance* li, const std::vector<char>& losRaySquares) const;
 
@@ -70,6 +158,7 @@ protected:
 	const float* mipHeightMap = nullptr;
 
 	bool sendReadmapEvents = false;
+	bool incrementalRaycasts = false;
 };
 
 #endif // LOS_MAP_H
@@ -0,0 +1,289 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cassert>
+
+#include "LosRaycast.h"
+
+// the vectorized kernels are compiled per-function for their instruction set
+// (the engine itself is built for a plain SSE baseline) and only ever called
+// after a runtime check, so they are limited to compilers with target-attrs
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+	#define LOS_RAYCAST_X86 1
+	#include <immintrin.h>
+#else
+	#define LOS_RAYCAST_X86 0
+#endif
+
+
+static inline size_t ToAngleMapIdx(const int2 p, const int radius)
+{
+	return (p.y + radius) * (2 * radius + 1) + (p.x + radius);
+}
+
+static inline void SetOccludedBits(const LosRaycast::CastArgs& args, size_t rayIdx, size_t sqrIdx, int mask)
+{
+	if (args.occludedRaySquares == nullptr || args.rayOffsets == nullptr)
+		return;
+
+	std::vector<bool>& bits = *args.occludedRaySquares;
+	const size_t base = (args.rayOffsets[rayIdx] + sqrIdx) * 4;
+
+	bits[base + 0] = ((mask >> 0) & 1);
+	bits[base + 1] = ((mask >> 1) & 1);
+	bits[base + 2] = ((mask >> 2) & 1);
+	bits[base + 3] = ((mask >> 3) & 1);
+}
+
+
+
+//////////////////////////////////////////////////////////////////////
+/// scalar reference, mirrors CastLosSquare in LosMap.cpp
+
+static void CastRaysScalar(const LosRaycast::CastArgs& args)
+{
+	const LosRaycast::RayTable& rays = *args.rays;
+	const int radius = args.radius;
+
+	for (size_t i = 0, numRays = rays.size(); i < numRays; ++i) {
+		float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+		float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+
+		for (size_t n = 0, numSquares = rays[i].size(); n < numSquares; ++n) {
+			const int2 square = rays[i][n];
+			const int2 offsets[4] = {square, -square, int2(square.y, -square.x), int2(-square.y, square.x)};
+
+			const float invR = args.isqrtTable[square.x * square.x + square.y * square.y];
+			int occludedMask = 0;
+
+			for (int dir = 0; dir < 4; ++dir) {
+				const size_t oidx = ToAngleMapIdx(offsets[dir], radius);
+				const float squareAngle = args.squareAngles[oidx];
+
+				bool occluded = (squareAngle < maxAngles[dir]);
+
+				if (!occluded && squareAngle < prvAngles[dir])
+					occluded = (squareAngle < (maxAngles[dir] = prvAngles[dir] - LOS_BONUS_HEIGHT * invR));
+
+				if (occluded) {
+					args.visibleSquares[oidx] = false;
+					occludedMask |= (1 << dir);
+				} else {
+					prvAngles[dir] = squareAngle;
+				}
+			}
+
+			SetOccludedBits(args, i, n, occludedMask);
+		}
+	}
+}
+
+
+
+#if (LOS_RAYCAST_X86 == 1)
+//////////////////////////////////////////////////////////////////////
+/// SSE2, one ray per step with its four directions as lanes
+
+__attribute__((target("sse2")))
+static inline __m128 Select128(const __m128 mask, const __m128 a, const __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// casts squares [n, numSquares) of ray <i>, lane states are carried in prv and max
+__attribute__((target("sse2")))
+static void CastRaySSE2(const LosRaycast::CastArgs& args, size_t i, size_t n, __m128& prv, __m128& max)
+{
+	const LosRaycast::RayLine& ray = (*args.rays)[i];
+	const __m128 bonus = _mm_set1_ps(LOS_BONUS_HEIGHT);
+	const int radius = args.radius;
+
+	for (size_t numSquares = ray.size(); n < numSquares; ++n) {
+		const int2 square = ray[n];
+		const size_t oidx[4] = {
+			ToAngleMapIdx(              square  , radius),
+			ToAngleMapIdx(             -square  , radius),
+			ToAngleMapIdx(int2( square.y, -square.x), radius),
+			ToAngleMapIdx(int2(-square.y,  square.x), radius),
+		};
+
+		const __m128 angle = _mm_setr_ps(args.squareAngles[oidx[0]], args.squareAngles[oidx[1]], args.squareAngles[oidx[2]], args.squareAngles[oidx[3]]);
+		const __m128 invR = _mm_set1_ps(args.isqrtTable[square.x * square.x + square.y * square.y]);
+
+		// same operation order as the scalar kernel, no contraction allowed
+		const __m128 occlMax = _mm_cmplt_ps(angle, max);
+		const __m128 descent = _mm_andnot_ps(occlMax, _mm_cmplt_ps(angle, prv));
+		const __m128 peakMax = _mm_sub_ps(prv, _mm_mul_ps(bonus, invR));
+
+		max = Select128(descent, peakMax, max);
+
+		const __m128 occluded = _mm_or_ps(occlMax, _mm_and_ps(descent, _mm_cmplt_ps(angle, peakMax)));
+		const int occludedMask = _mm_movemask_ps(occluded);
+
+		prv = Select128(occluded, prv, angle);
+
+		for (int dir = 0; dir < 4; ++dir) {
+			if ((occludedMask >> dir) & 1)
+				args.visibleSquares[oidx[dir]] = false;
+		}
+
+		SetOccludedBits(args, i, n, occludedMask);
+	}
+}
+
+__attribute__((target("sse2")))
+static void CastRaysSSE2(const LosRaycast::CastArgs& args)
+{
+	for (size_t i = 0, numRays = args.rays->size(); i < numRays; ++i) {
+		__m128 prv = _mm_set1_ps(-1e7f);
+		__m128 max = _mm_set1_ps(-1e7f);
+
+		CastRaySSE2(args, i, 0, prv, max);
+	}
+}
+
+
+
+//////////////////////////////////////////////////////////////////////
+/// AVX2, two rays per step with four directions each as lanes
+
+__attribute__((target("avx2")))
+static void CastRaysAVX2(const LosRaycast::CastArgs& args)
+{
+	const LosRaycast::RayTable& rays = *args.rays;
+	const int radius = args.radius;
+	const int stride = 2 * radius + 1;
+
+	const __m256 bonus = _mm256_set1_ps(LOS_BONUS_HEIGHT);
+	const __m256i center = _mm256_set1_epi32(radius * stride + radius);
+	const __m256i strides = _mm256_set1_epi32(stride);
+
+	const size_t numRays = rays.size();
+	const size_t numPairs = numRays & ~size_t(1);
+
+	for (size_t i = 0; i < numPairs; i += 2) {
+		const LosRaycast::RayLine& rayA = rays[i + 0];
+		const LosRaycast::RayLine& rayB = rays[i + 1];
+
+		__m256 prv = _mm256_set1_ps(-1e7f);
+		__m256 max = _mm256_set1_ps(-1e7f);
+
+		const size_t numShared = std::min(rayA.size(), rayB.size());
+
+		for (size_t n = 0; n < numShared; ++n) {
+			const int2 a = rayA[n];
+			const int2 b = rayB[n];
+
+			// lane offsets are {sq, -sq, (sq.y,-sq.x), (-sq.y,sq.x)} of both rays
+			const __m256i xs = _mm256_setr_epi32(a.x, -a.x, a.y, -a.y, b.x, -b.x, b.y, -b.y);
+			const __m256i ys = _mm256_setr_epi32(a.y, -a.y, -a.x, a.x, b.y, -b.y, -b.x, b.x);
+			const __m256i idx = _mm256_add_epi32(center, _mm256_add_epi32(_mm256_mullo_epi32(ys, strides), xs));
+
+			const __m256 angle = _mm256_i32gather_ps(args.squareAngles, idx, 4);
+			const __m256 invR = _mm256_insertf128_ps(
+				_mm256_castps128_ps256(_mm_set1_ps(args.isqrtTable[a.x * a.x + a.y * a.y])),
+				_mm_set1_ps(args.isqrtTable[b.x * b.x + b.y * b.y]),
+				1
+			);
+
+			const __m256 occlMax = _mm256_cmp_ps(angle, max, _CMP_LT_OQ);
+			const __m256 descent = _mm256_andnot_ps(occlMax, _mm256_cmp_ps(angle, prv, _CMP_LT_OQ));
+			const __m256 peakMax = _mm256_sub_ps(prv, _mm256_mul_ps(bonus, invR));
+
+			max = _mm256_blendv_ps(max, peakMax, descent);
+
+			const __m256 occluded = _mm256_or_ps(occlMax, _mm256_and_ps(descent, _mm256_cmp_ps(angle, peakMax, _CMP_LT_OQ)));
+			const int occludedMask = _mm256_movemask_ps(occluded);
+
+			prv = _mm256_blendv_ps(angle, prv, occluded);
+
+			if (occludedMask != 0) {
+				alignas(32) int oidx[8];
+				_mm256_store_si256(reinterpret_cast<__m256i*>(oidx), idx);
+
+				for (int lane = 0; lane < 8; ++lane) {
+					if ((occludedMask >> lane) & 1)
+						args.visibleSquares[oidx[lane]] = false;
+				}
+			}
+
+			SetOccludedBits(args, i + 0, n, occludedMask & 0xF);
+			SetOccludedBits(args, i + 1, n, occludedMask >> 4);
+		}
+
+		// finish the longer ray of the pair with its current lane state
+		if (rayA.size() > numShared) {
+			__m128 prvA = _mm256_castps256_ps128(prv);
+			__m128 maxA = _mm256_castps256_ps128(max);
+			CastRaySSE2(args, i + 0, numShared, prvA, maxA);
+		}
+		if (rayB.size() > numShared) {
+			__m128 prvB = _mm256_extractf128_ps(prv, 1);
+			__m128 maxB = _mm256_extractf128_ps(max, 1);
+			CastRaySSE2(args, i + 1, numShared, prvB, maxB);
+		}
+	}
+
+	if (numPairs < numRays) {
+		__m128 prv = _mm_set1_ps(-1e7f);
+		__m128 max = _mm_set1_ps(-1e7f);
+
+		CastRaySSE2(args, numPairs, 0, prv, max);
+	}
+}
+#endif
+
+
+
+//////////////////////////////////////////////////////////////////////
+/// dispatch
+
+bool LosRaycast::IsKernelSupported(KernelType type)
+{
+	switch (type) {
+		case KERNEL_SCALAR: return true;
+	#if (LOS_RAYCAST_X86 == 1)
+		case KERNEL_SSE2: return __builtin_cpu_supports("sse2");
+		case KERNEL_AVX2: return __builtin_cpu_supports("avx2");
+	#endif
+		default: break;
+	}
+
+	return false;
+}
+
+LosRaycast::KernelType LosRaycast::GetBestKernel()
+{
+	static const KernelType bestKernel = []() {
+		// fastest first, by LosRaycastBenchmark
+		constexpr KernelType rankedKernels[] = {KERNEL_SSE2, KERNEL_AVX2};
+
+		for (const KernelType type: rankedKernels) {
+			if (IsKernelSupported(type))
+				return type;
+		}
+
+		return KERNEL_SCALAR;
+	}();
+
+	return bestKernel;
+}
+
+const char* LosRaycast::GetKernelName(KernelType type)
+{
+	constexpr const char* names[KERNEL_COUNT] = {"scalar", "sse2", "avx2"};
+	return ((type >= KERNEL_SCALAR && type < KERNEL_COUNT)? names[type]: "unknown");
+}
+
+void LosRaycast::CastRays(KernelType type, const CastArgs& args)
+{
+	assert(IsKernelSupported(type));
+
+	switch (type) {
+	#if (LOS_RAYCAST_X86 == 1)
+		case KERNEL_SSE2: { CastRaysSSE2(args); } break;
+		case KERNEL_AVX2: { CastRaysAVX2(args); } break;
+	#endif
+		default: { CastRaysScalar(args); } break;
+	}
+}
@@ -0,0 +1,63 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LOS_RAYCAST_H
+#define LOS_RAYCAST_H
+
+#include <vector>
+
+#include "System/type2.h"
+
+// height above the ground at which a square counts as seen; added when
+// building the angle-map (CLosMap) and subtracted at peaks (LosRaycast)
+static constexpr float LOS_BONUS_HEIGHT = 5.0f;
+
+/**
+ * Ray-casting kernels used by CLosMap::UnsafeLosAdd.
+ *
+ * Every ray of the (upper-right quadrant) ray table is cast in all four
+ * mirrored directions over a precalculated angle-map of (2*radius+1)^2
+ * squares; occluded squares get their entry in the visibility map cleared.
+ * The vectorized kernels process the four directions (SSE2) or two rays
+ * times four directions (AVX2) per step and produce exactly the same
+ * output as the scalar kernel, so the choice does not affect sync.
+ */
+namespace LosRaycast {
+	typedef std::vector<int2> RayLine;
+	typedef std::vector<RayLine> RayTable;
+
+	enum KernelType {
+		KERNEL_SCALAR = 0,
+		KERNEL_SSE2   = 1,
+		KERNEL_AVX2   = 2,
+		KERNEL_COUNT  = 3,
+	};
+
+	struct CastArgs {
+		const RayTable* rays = nullptr;
+
+		// isqrt(r^2) for every ray-square distance r
+		const float* isqrtTable = nullptr;
+		// per-square angles, indexed like the visibility map
+		const float* squareAngles = nullptr;
+		// per-square visibility, occluded squares are set to false
+		char* visibleSquares = nullptr;
+
+		// optional per-(ray-square, direction) occlusion bits, see
+		// SLosInstance::occludedRaySquares; skipped if either is null
+		const int* rayOffsets = nullptr;
+		std::vector<bool>* occludedRaySquares = nullptr;
+
+		int radius = 0;
+	};
+
+	bool IsKernelSupported(KernelType type);
+	// fastest kernel supported by the host CPU, determined once; AVX2 ranks
+	// below SSE2 (its gathers make it slower, see LosRaycastBenchmark)
+	KernelType GetBestKernel();
+	const char* GetKernelName(KernelType type);
+
+	void CastRays(KernelType type, const CastArgs& args);
+	inline void CastRays(const CastArgs& args) { CastRays(GetBestKernel(), args); }
+}
+
+#endif // LOS_RAYCAST_H
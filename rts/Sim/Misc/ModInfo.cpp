@@ -101,8 +101,19 @@ void CModInfo::ResetState()
 		pathFinderSystem = NOPFS_TYPE;
 		pfRawDistMult    = 1.25f;
 		pfUpdateRate     = 0.007f;
+		pathCacheMemoryBudget = 1024;
 
 		enableSmoothMesh = true;
+		enableParallelMoveTypeUpdate = false;
+		enableParallelProjectileUpdate = false;
+		enableParallelProjectileCollisions = false;
+		enableParallelLosStatusUpdate = false;
+		enableParallelQTPFSSearches = false;
+		enableQuadFieldSoA = false;
+		enableFlowFieldPathing = false;
+		enableAsyncPathRequests = false;
+		enableHierarchicalPathing = false;
+		enableParallelPieceAnims = false;
 
 		allowTake = true;
 	}
@@ -142,8 +153,19 @@ void CModInfo::Init(const std::string& modFileName)
 		pathFinderSystem = Clamp(system.GetInt("pathFinderSystem", HAPFS_TYPE), int(NOPFS_TYPE), int(PFS_TYPE_MAX));
 		pfRawDistMult = system.GetFloat("pathFinderRawDistMult", pfRawDistMult);
 		pfUpdateRate = system.GetFloat("pathFinderUpdateRate", pfUpdateRate);
+		pathCacheMemoryBudget = std::max(0, system.GetInt("pathCacheMemoryBudget", pathCacheMemoryBudget));
 
 		enableSmoothMesh = system.GetBool("enableSmoothMesh", enableSmoothMesh);
+		enableParallelMoveTypeUpdate = system.GetBool("enableParallelMoveTypeUpdate", enableParallelMoveTypeUpdate);
+		enableParallelProjectileUpdate = system.GetBool("enableParallelProjectileUpdate", enableParallelProjectileUpdate);
+		enableParallelProjectileCollisions = system.GetBool("enableParallelProjectileCollisions", enableParallelProjectileCollisions);
+		enableParallelLosStatusUpdate = system.GetBool("enableParallelLosStatusUpdate", enableParallelLosStatusUpdate);
+		enableParallelQTPFSSearches = system.GetBool("enableParallelQTPFSSearches", enableParallelQTPFSSearches);
+		enableQuadFieldSoA = system.GetBool("enableQuadFieldSoA", enableQuadFieldSoA);
+		enableFlowFieldPathing = system.GetBool("enableFlowFieldPathing", enableFlowFieldPathing);
+		enableAsyncPathRequests = system.GetBool("enableAsyncPathRequests", enableAsyncPathRequests);
+		enableHierarchicalPathing = system.GetBool("enableHierarchicalPathing", enableHierarchicalPathing);
+		enableParallelPieceAnims = system.GetBool("enableParallelPieceAnims", enableParallelPieceAnims);
 
 		allowTake = system.GetBool("allowTake", allowTake);
 	}
@@ -179,8 +179,55 @@ public:
 	float pfRawDistMult;
 	float pfUpdateRate;
 
+	/// memory budget (in KB) of each synced path-estimator search cache
+	int pathCacheMemoryBudget;
+
 	bool enableSmoothMesh;
 
+	/// if true, ground unit movetypes are Update'd in parallel and their
+	/// events (UnitMoved, out-of-map kills) are applied in unit-id order
+	bool enableParallelMoveTypeUpdate;
+
+	/// if true, synced projectiles without side-effects in the current frame
+	/// are Update'd in parallel before the serial quadfield reinsertion pass
+	bool enableParallelProjectileUpdate;
+
+	/// if true, projectile-vs-unit/feature/shield hit-tests are computed in
+	/// parallel and their Collision callbacks applied in container order
+	bool enableParallelProjectileCollisions;
+
+	/// if true, units whose LOS status changed are found per allyteam in
+	/// parallel and UpdateLosStatus is called for them in unit order
+	bool enableParallelLosStatusUpdate;
+
+	/// if true, QTPFS executes the queued searches of the node-layers being
+	/// updated in one frame concurrently (team search limits are split up
+	/// per layer beforehand, so results do not depend on the thread count)
+	bool enableParallelQTPFSSearches;
+
+	/// if true, QuadField keeps SoA position snapshots of the units in each
+	/// quad and uses them to pre-filter Get{Units,Solids}Exact queries
+	bool enableQuadFieldSoA;
+
+	/// if true, long synced move requests of one movetype towards the same
+	/// estimator block share a single Dijkstra field (HAPFS only)
+	bool enableFlowFieldPathing;
+
+	/// if true, the path requests of units are searched on worker threads in
+	/// between two frames and delivered at the start of the next (requires a
+	/// pathfinder that supports concurrent requests, i.e. TKPFS)
+	bool enableAsyncPathRequests;
+
+	/// if true, long path requests search lazily built abstraction levels on
+	/// top of the med-res estimator instead of the precalculated low-res one
+	/// (TKPFS only)
+	bool enableHierarchicalPathing;
+
+	/// if true, the piece animations of unit scripts are ticked on multiple
+	/// threads; AnimFinished callbacks of all scripts run after all pieces
+	/// have moved instead of right after their own script's animations
+	bool enableParallelPieceAnims;
+
 	bool allowTake;
 };
 
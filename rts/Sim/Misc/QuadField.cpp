@@ -11,6 +11,8 @@
 #include "System/ContainerUtil.h"
 #include "System/Threading/ThreadPool.h"
 
+#include "xsimd/xsimd.hpp"
+
 #ifndef UNIT_TEST
 	#include "Sim/Features/Feature.h"
 	#include "Sim/Projectiles/Projectile.h"
@@ -26,21 +28,27 @@ CR_REG_METADATA(CQuadField, (
 	CR_MEMBER(quadSizeX),
 	CR_MEMBER(quadSizeZ),
 	CR_MEMBER(invQuadSize),
+	CR_MEMBER(unitSoAQueries),
 
 	CR_IGNORED(tempUnits),
 	CR_IGNORED(tempFeatures),
 	CR_IGNORED(tempProjectiles),
 	CR_IGNORED(tempSolids),
-	CR_IGNORED(tempQuads)
+	CR_IGNORED(tempQuads),
+	CR_IGNORED(changeStamp),
+
+	CR_POSTLOAD(PostLoad)
 ))
 
 CR_BIND(CQuadField::Quad, )
 CR_REG_METADATA_SUB(CQuadField, Quad, (
 	CR_MEMBER(units),
+	CR_IGNORED(unitSoA),
 	CR_IGNORED(teamUnits),
 	CR_MEMBER(features),
 	CR_MEMBER(projectiles),
 	CR_MEMBER(repulsers),
+	CR_IGNORED(lastChange),
 
 	CR_POSTLOAD(PostLoad)
 ))
@@ -107,8 +115,152 @@ void CQuadField::Quad::PostLoad()
 #endif
 }
 
-void CQuadField::Init(int2 mapDims, int quadSize)
+void CQuadField::PostLoad()
+{
+#ifndef UNIT_TEST
+	if (!unitSoAQueries)
+		return;
+
+	// neither the snapshots nor the slots are saved, rebuild both
+	for (size_t qi = 0; qi < baseQuads.size(); qi++) {
+		Quad& quad = baseQuads[qi];
+
+		quad.unitSoA.Clear();
+
+		for (size_t slot = 0; slot < quad.units.size(); slot++) {
+			CUnit* unit = quad.units[slot];
+
+			const auto it = std::find(unit->quads.begin(), unit->quads.end(), int(qi));
+
+			assert(it != unit->quads.end());
+
+			unit->quadSlots.resize(unit->quads.size());
+			unit->quadSlots[it - unit->quads.begin()] = slot;
+
+			quad.unitSoA.Append(unit->pos, unit->radius);
+		}
+	}
+#endif
+}
+
+
+#ifndef UNIT_TEST
+void CQuadField::Quad::InsertUnit(CUnit* unit)
+{
+	spring::VectorInsertUnique(units, unit, false);
+	spring::VectorInsertUnique(teamUnits[unit->allyteam], unit, false);
+}
+
+void CQuadField::Quad::EraseUnit(CUnit* unit)
+{
+	spring::VectorErase(units, unit);
+	spring::VectorErase(teamUnits[unit->allyteam], unit);
+}
+
+
+/**
+ * Calls <func> with the index of every entry of <soa> whose (padded)
+ * sphere or cylinder intersects the one given by <pos> and <radius>.
+ */
+template<typename F>
+static void ForEachUnitSoAInRange(const CQuadField::Quad::UnitSoA& soa, const float3& pos, float radius, bool spherical, F&& func)
+{
+	using SIMDVfloat = xsimd::simd_type<float>;
+
+	constexpr size_t simdSize = SIMDVfloat::size;
+
+	const size_t numUnits = soa.Size();
+	const size_t vecSize = numUnits - numUnits % simdSize;
+
+	const float ySel = spherical? 1.0f: 0.0f;
+
+	const SIMDVfloat vx(pos.x);
+	const SIMDVfloat vy(pos.y);
+	const SIMDVfloat vz(pos.z);
+	const SIMDVfloat vr(radius);
+	const SIMDVfloat vs(ySel);
+
+	for (size_t i = 0; i < vecSize; i += simdSize) {
+		const SIMDVfloat dx = xsimd::load_unaligned(&soa.posX[i]) - vx;
+		const SIMDVfloat dy = (xsimd::load_unaligned(&soa.posY[i]) - vy) * vs;
+		const SIMDVfloat dz = xsimd::load_unaligned(&soa.posZ[i]) - vz;
+		const SIMDVfloat rr = xsimd::load_unaligned(&soa.reach[i]) + vr;
+		const auto inRange = ((dx * dx + dy * dy + dz * dz) < (rr * rr));
+
+		if (!xsimd::any(inRange))
+			continue;
+
+		for (size_t j = 0; j < simdSize; ++j) {
+			if (inRange[j])
+				func(i + j);
+		}
+	}
+
+	for (size_t i = vecSize; i < numUnits; ++i) {
+		const float dx = soa.posX[i] - pos.x;
+		const float dy = (soa.posY[i] - pos.y) * ySel;
+		const float dz = soa.posZ[i] - pos.z;
+		const float rr = soa.reach[i] + radius;
+
+		if ((dx * dx + dy * dy + dz * dz) < (rr * rr))
+			func(i);
+	}
+}
+
+/**
+ * Calls <func> with the index of every entry of <soa> whose position
+ * lies inside the xz-rectangle given by <mins> and <maxs>; this is the
+ * same comparison GetUnitsExact makes, on the same floats.
+ */
+template<typename F>
+static void ForEachUnitSoAInRect(const CQuadField::Quad::UnitSoA& soa, const float3& mins, const float3& maxs, F&& func)
 {
+	using SIMDVfloat = xsimd::simd_type<float>;
+
+	constexpr size_t simdSize = SIMDVfloat::size;
+
+	const size_t numUnits = soa.Size();
+	const size_t vecSize = numUnits - numUnits % simdSize;
+
+	const SIMDVfloat vminx(mins.x);
+	const SIMDVfloat vminz(mins.z);
+	const SIMDVfloat vmaxx(maxs.x);
+	const SIMDVfloat vmaxz(maxs.z);
+
+	for (size_t i = 0; i < vecSize; i += simdSize) {
+		const SIMDVfloat px = xsimd::load_unaligned(&soa.posX[i]);
+		const SIMDVfloat pz = xsimd::load_unaligned(&soa.posZ[i]);
+		const auto inRect =
+			(px >= vminx) && (px <= vmaxx) &&
+			(pz >= vminz) && (pz <= vmaxz);
+
+		if (!xsimd::any(inRect))
+			continue;
+
+		for (size_t j = 0; j < simdSize; ++j) {
+			if (inRect[j])
+				func(i + j);
+		}
+	}
+
+	for (size_t i = vecSize; i < numUnits; ++i) {
+		const float px = soa.posX[i];
+		const float pz = soa.posZ[i];
+
+		if (px < mins.x || px > maxs.x)
+			continue;
+		if (pz < mins.z || pz > maxs.z)
+			continue;
+
+		func(i);
+	}
+}
+#endif
+
+void CQuadField::Init(int2 mapDims, int quadSize, bool unitSoA)
+{
+	unitSoAQueries = unitSoA;
+
 	quadSizeX = quadSize;
 	quadSizeZ = quadSize;
 	numQuadsX = (mapDims.x * SQUARE_SIZE) / quadSize;
@@ -322,6 +474,67 @@ void CQuadField::GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const f
 
 
 #ifndef UNIT_TEST
+// appends <unit> to quad <quadIdx>; the caller appends <quadIdx> to unit->quads
+void CQuadField::InsertUnitIntoQuad(CUnit* unit, int quadIdx)
+{
+	Quad& quad = baseQuads[quadIdx];
+
+	quad.InsertUnit(unit);
+	MarkChanged(quadIdx);
+
+	if (!unitSoAQueries)
+		return;
+
+	quad.unitSoA.Append(unit->pos, unit->radius);
+	unit->quadSlots.push_back(quad.units.size() - 1);
+}
+
+// removes <unit> from quad unit->quads[unitQuadIdx]; the caller updates unit->quads
+void CQuadField::EraseUnitFromQuad(CUnit* unit, size_t unitQuadIdx)
+{
+	const int quadIdx = unit->quads[unitQuadIdx];
+
+	Quad& quad = baseQuads[quadIdx];
+
+	MarkChanged(quadIdx);
+
+	if (!unitSoAQueries) {
+		quad.EraseUnit(unit);
+		return;
+	}
+
+	// same swap-with-last as spring::VectorErase, without the search
+	const size_t slot = unit->quadSlots[unitQuadIdx];
+
+	assert(quad.units[slot] == unit);
+
+	CUnit* lastUnit = quad.units.back();
+
+	quad.units[slot] = lastUnit;
+	quad.units.pop_back();
+	quad.unitSoA.Erase(slot);
+
+	spring::VectorErase(quad.teamUnits[unit->allyteam], unit);
+
+	if (lastUnit == unit)
+		return;
+
+	const auto it = std::find(lastUnit->quads.begin(), lastUnit->quads.end(), quadIdx);
+
+	assert(it != lastUnit->quads.end());
+	lastUnit->quadSlots[it - lastUnit->quads.begin()] = slot;
+}
+
+void CQuadField::UpdateUnitSnapshot(const CUnit* unit)
+{
+	if (!unitSoAQueries)
+		return;
+
+	for (size_t i = 0; i < unit->quads.size(); i++) {
+		baseQuads[unit->quads[i]].unitSoA.Assign(unit->quadSlots[i], unit->pos, unit->radius);
+	}
+}
+
 bool CQuadField::InsertUnitIf(CUnit* unit, const float3& wpos)
 {
 	assert(unit != nullptr);
@@ -334,11 +547,11 @@ bool CQuadField::InsertUnitIf(CUnit* unit, const float3& wpos)
 		return false;
 
 	// unit might also be overlapping the cell, so test for uniqueness
-	if (!spring::VectorInsertUnique(unit->quads, wposQuadIdx, true))
+	if (std::find(unit->quads.begin(), unit->quads.end(), wposQuadIdx) != unit->quads.end())
 		return false;
 
-	spring::VectorInsertUnique(baseQuads[wposQuadIdx].units, unit, false);
-	spring::VectorInsertUnique(baseQuads[wposQuadIdx].teamUnits[unit->allyteam], unit, false);
+	InsertUnitIntoQuad(unit, wposQuadIdx);
+	unit->quads.push_back(wposQuadIdx);
 	return true;
 }
 
@@ -364,11 +577,23 @@ bool CQuadField::RemoveUnitIf(CUnit* unit, const float3& wpos)
 		return false;
 	}
 
-	if (!spring::VectorErase(unit->quads, wposQuadIdx))
+	const auto it = std::find(unit->quads.begin(), unit->quads.end(), wposQuadIdx);
+
+	if (it == unit->quads.end())
 		return false;
 
-	spring::VectorErase(baseQuads[wposQuadIdx].units, unit);
-	spring::VectorErase(baseQuads[wposQuadIdx].teamUnits[unit->allyteam], unit);
+	const size_t unitQuadIdx = it - unit->quads.begin();
+
+	EraseUnitFromQuad(unit, unitQuadIdx);
+
+	// keep quads and quadSlots parallel, same as spring::VectorErase
+	if (unitSoAQueries) {
+		unit->quadSlots[unitQuadIdx] = unit->quadSlots.back();
+		unit->quadSlots.pop_back();
+	}
+
+	unit->quads[unitQuadIdx] = unit->quads.back();
+	unit->quads.pop_back();
 	return true;
 }
 #endif
@@ -383,18 +608,25 @@ void CQuadField::MovedUnit(CUnit* unit)
 
 	// compare if the quads have changed, if not stop here
 	if (qfQuery.quads->size() == unit->quads.size()) {
-		if (std::equal(qfQuery.quads->begin(), qfQuery.quads->end(), unit->quads.begin()))
+		if (std::equal(qfQuery.quads->begin(), qfQuery.quads->end(), unit->quads.begin())) {
+			for (const int qi: unit->quads) {
+				MarkChanged(qi);
+			}
+
+			// radius might have changed (e.g. SetUnitRadiusAndHeight)
+			UpdateUnitSnapshot(unit);
 			return;
+		}
 	}
 
-	for (const int qi: unit->quads) {
-		spring::VectorErase(baseQuads[qi].units, unit);
-		spring::VectorErase(baseQuads[qi].teamUnits[unit->allyteam], unit);
+	for (size_t i = 0; i < unit->quads.size(); i++) {
+		EraseUnitFromQuad(unit, i);
 	}
 
+	unit->quadSlots.clear();
+
 	for (const int qi: *qfQuery.quads) {
-		spring::VectorInsertUnique(baseQuads[qi].units, unit, false);
-		spring::VectorInsertUnique(baseQuads[qi].teamUnits[unit->allyteam], unit, false);
+		InsertUnitIntoQuad(unit, qi);
 	}
 
 	unit->quads = std::move(*qfQuery.quads);
@@ -402,12 +634,12 @@ void CQuadField::MovedUnit(CUnit* unit)
 
 void CQuadField::RemoveUnit(CUnit* unit)
 {
-	for (const int qi: unit->quads) {
-		spring::VectorErase(baseQuads[qi].units, unit);
-		spring::VectorErase(baseQuads[qi].teamUnits[unit->allyteam], unit);
+	for (size_t i = 0; i < unit->quads.size(); i++) {
+		EraseUnitFromQuad(unit, i);
 	}
 
 	unit->quads.clear();
+	unit->quadSlots.clear();
 
 	#ifdef DEBUG_QUADFIELD
 	for (const Quad& q: baseQuads) {
@@ -436,10 +668,12 @@ void CQuadField::MovedRepulser(CPlasmaRepulser* repulser)
 
 	for (const int qi: repulserQuads) {
 		spring::VectorErase(baseQuads[qi].repulsers, repulser);
+		MarkChanged(qi);
 	}
 
 	for (const int qi: *qfQuery.quads) {
 		spring::VectorInsertUnique(baseQuads[qi].repulsers, repulser, false);
+		MarkChanged(qi);
 	}
 
 	repulser->SetQuads(std::move(*qfQuery.quads));
@@ -449,6 +683,7 @@ void CQuadField::RemoveRepulser(CPlasmaRepulser* repulser)
 {
 	for (const int qi: repulser->GetQuads()) {
 		spring::VectorErase(baseQuads[qi].repulsers, repulser);
+		MarkChanged(qi);
 	}
 
 	repulser->ClearQuads();
@@ -470,6 +705,7 @@ void CQuadField::AddFeature(CFeature* feature)
 
 	for (const int qi: *qfQuery.quads) {
 		spring::VectorInsertUnique(baseQuads[qi].features, feature, false);
+		MarkChanged(qi);
 	}
 }
 
@@ -480,6 +716,7 @@ void CQuadField::RemoveFeature(CFeature* feature)
 
 	for (const int qi: *qfQuery.quads) {
 		spring::VectorErase(baseQuads[qi].features, feature);
+		MarkChanged(qi);
 	}
 
 	#ifdef DEBUG_QUADFIELD
@@ -575,23 +812,34 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& pos, float rad
 	const int tempNum = gs->GetMtTempNum(curThread);
 	qfq.units = tempUnits[curThread].ReserveVector();
 
-	for (const int qi: *qfQuery.quads) {
-		for (CUnit* u: baseQuads[qi].units) {
-			if (u->mtTempNum[curThread] == tempNum)
-				continue;
+	const auto testUnit = [&](CUnit* u) {
+		if (u->mtTempNum[curThread] == tempNum)
+			return;
 
-			u->mtTempNum[curThread] = tempNum;
+		u->mtTempNum[curThread] = tempNum;
 
-			const float totRad       = radius + u->radius;
-			const float totRadSq     = totRad * totRad;
-			const float posUnitDstSq = spherical?
-				pos.SqDistance(u->pos):
-				pos.SqDistance2D(u->pos);
+		const float totRad       = radius + u->radius;
+		const float totRadSq     = totRad * totRad;
+		const float posUnitDstSq = spherical?
+			pos.SqDistance(u->pos):
+			pos.SqDistance2D(u->pos);
 
-			if (posUnitDstSq >= totRadSq)
-				continue;
+		if (posUnitDstSq >= totRadSq)
+			return;
 
-			qfq.units->push_back(u);
+		qfq.units->push_back(u);
+	};
+
+	for (const int qi: *qfQuery.quads) {
+		const Quad& quad = baseQuads[qi];
+
+		if (unitSoAQueries) {
+			ForEachUnitSoAInRange(quad.unitSoA, pos, radius, spherical, [&](size_t i) { testUnit(quad.units[i]); });
+			continue;
+		}
+
+		for (CUnit* u: quad.units) {
+			testUnit(u);
 		}
 	}
 
@@ -607,21 +855,31 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& mins, const fl
 	const int tempNum = gs->GetMtTempNum(curThread);
 	qfq.units = tempUnits[curThread].ReserveVector();
 
-	for (const int qi: *qfQuery.quads) {
-		for (CUnit* unit: baseQuads[qi].units) {
+	const auto testUnit = [&](CUnit* unit) {
+		if (unit->mtTempNum[curThread] == tempNum)
+			return;
 
-			if (unit->mtTempNum[curThread] == tempNum)
-				continue;
+		unit->mtTempNum[curThread] = tempNum;
 
-			unit->mtTempNum[curThread] = tempNum;
+		const float3& pos = unit->pos;
+		if (pos.x < mins.x || pos.x > maxs.x)
+			return;
+		if (pos.z < mins.z || pos.z > maxs.z)
+			return;
 
-			const float3& pos = unit->pos;
-			if (pos.x < mins.x || pos.x > maxs.x)
-				continue;
-			if (pos.z < mins.z || pos.z > maxs.z)
-				continue;
+		qfq.units->push_back(unit);
+	};
+
+	for (const int qi: *qfQuery.quads) {
+		const Quad& quad = baseQuads[qi];
+
+		if (unitSoAQueries) {
+			ForEachUnitSoAInRect(quad.unitSoA, mins, maxs, [&](size_t i) { testUnit(quad.units[i]); });
+			continue;
+		}
 
-			qfq.units->push_back(unit);
+		for (CUnit* unit: quad.units) {
+			testUnit(unit);
 		}
 	}
 
@@ -758,23 +1016,32 @@ void CQuadField::GetSolidsExact(
 	GetQuads(qfQuery, pos, radius);
 	const int tempNum = gs->GetMtTempNum(curThread);
 	qfq.solids = tempSolids[curThread].ReserveVector();
-	
 
-	for (const int qi: *qfQuery.quads) {
-		for (CUnit* u: baseQuads[qi].units) {
-			if (u->mtTempNum[curThread] == tempNum)
-				continue;
+	const auto testUnit = [&](CUnit* u) {
+		if (u->mtTempNum[curThread] == tempNum)
+			return;
 
-			u->mtTempNum[curThread] = tempNum;
+		u->mtTempNum[curThread] = tempNum;
 
-			if (!u->HasPhysicalStateBit(physicalStateBits))
-				continue;
-			if (!u->HasCollidableStateBit(collisionStateBits))
-				continue;
-			if ((pos - u->pos).SqLength() >= Square(radius + u->radius))
-				continue;
+		if (!u->HasPhysicalStateBit(physicalStateBits))
+			return;
+		if (!u->HasCollidableStateBit(collisionStateBits))
+			return;
+		if ((pos - u->pos).SqLength() >= Square(radius + u->radius))
+			return;
+
+		qfq.solids->push_back(u);
+	};
+
+	for (const int qi: *qfQuery.quads) {
+		const Quad& quad = baseQuads[qi];
 
-			qfq.solids->push_back(u);
+		if (unitSoAQueries) {
+			ForEachUnitSoAInRange(quad.unitSoA, pos, radius, true, [&](size_t i) { testUnit(quad.units[i]); });
+		} else {
+			for (CUnit* u: quad.units) {
+				testUnit(u);
+			}
 		}
 
 		for (CFeature* f: baseQuads[qi].features) {
@@ -846,17 +1113,32 @@ bool CQuadField::NoSolidsExact(
 }
 
 
+bool CQuadField::ChangedSince(const float3& pos, float radius, std::uint64_t stamp)
+{
+	QuadFieldQuery qfQuery;
+	GetQuads(qfQuery, pos, radius);
+
+	for (const int qi: *qfQuery.quads) {
+		if (baseQuads[qi].lastChange > stamp)
+			return true;
+	}
+
+	return false;
+}
+
 // optimization specifically for projectile collisions
 void CQuadField::GetUnitsAndFeaturesColVol(
 	const float3& pos,
 	const float radius,
 	std::vector<CUnit*>& units,
 	std::vector<CFeature*>& features,
-	std::vector<CPlasmaRepulser*>* repulsers
+	std::vector<CPlasmaRepulser*>* repulsers,
+	int threadOwner
 ) {
-	const int tempNum = gs->GetTempNum();
+	const int tempNum = gs->GetMtTempNum(threadOwner);
 
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = threadOwner;
 	GetQuads(qfQuery, pos, radius);
 	// start counting from the previous object-cache sizes
 
@@ -865,10 +1147,10 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 
 		for (CUnit* u: quad.units) {
 			// prevent double adding
-			if (u->tempNum == tempNum)
+			if (u->mtTempNum[threadOwner] == tempNum)
 				continue;
 
-			u->tempNum = tempNum;
+			u->mtTempNum[threadOwner] = tempNum;
 
 			const auto* colvol = &u->collisionVolume;
 			const float totRad = radius + colvol->GetBoundingRadius();
@@ -881,10 +1163,10 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 
 		for (CFeature* f: quad.features) {
 			// prevent double adding
-			if (f->tempNum == tempNum)
+			if (f->mtTempNum[threadOwner] == tempNum)
 				continue;
 
-			f->tempNum = tempNum;
+			f->mtTempNum[threadOwner] = tempNum;
 
 			const auto* colvol = &f->collisionVolume;
 			const float totRad = radius + colvol->GetBoundingRadius();
@@ -897,10 +1179,10 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 		if (repulsers != nullptr) {
 			for (CPlasmaRepulser* r: quad.repulsers) {
 				// prevent double adding
-				if (r->tempNum == tempNum)
+				if (r->mtTempNum[threadOwner] == tempNum)
 					continue;
 
-				r->tempNum = tempNum;
+				r->mtTempNum[threadOwner] = tempNum;
 
 				const auto* colvol = &r->collisionVolume;
 				const float totRad = radius + colvol->GetBoundingRadius();
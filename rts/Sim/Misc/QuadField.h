@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <vector>
 
 #include "System/Misc/NonCopyable.h"
@@ -90,7 +91,7 @@ public:
 	static void Resize(int quadSize);
 	*/
 
-	void Init(int2 mapDims, int quadSize);
+	void Init(int2 mapDims, int quadSize, bool unitSoAQueries = false);
 	void Kill();
 
 	void GetQuads(QuadFieldQuery& qfq, float3 pos, float radius);
@@ -102,7 +103,8 @@ public:
 		const float radius,
 		std::vector<CUnit*>& units,
 		std::vector<CFeature*>& features,
-		std::vector<CPlasmaRepulser*>* repulsers = nullptr
+		std::vector<CPlasmaRepulser*>* repulsers = nullptr,
+		int threadOwner = 0
 	);
 
 	/**
@@ -157,6 +159,7 @@ public:
 
 	void MovedUnit(CUnit* unit);
 	void RemoveUnit(CUnit* unit);
+	void UpdateUnitSnapshot(const CUnit* unit);
 
 	void AddFeature(CFeature* feature);
 	void RemoveFeature(CFeature* feature);
@@ -187,10 +190,12 @@ public:
 		Quad& operator = (const Quad& q) = delete;
 		Quad& operator = (Quad&& q) {
 			units = std::move(q.units);
+			unitSoA = std::move(q.unitSoA);
 			teamUnits = std::move(q.teamUnits);
 			features = std::move(q.features);
 			projectiles = std::move(q.projectiles);
 			repulsers = std::move(q.repulsers);
+			lastChange = q.lastChange;
 			return *this;
 		}
 
@@ -198,6 +203,7 @@ public:
 		void Resize(int numAllyTeams) { teamUnits.resize(numAllyTeams); }
 		void Clear() {
 			units.clear();
+			unitSoA.Clear();
 			// reuse inner vectors when reloading
 			// teamUnits.clear();
 			for (auto& v: teamUnits) {
@@ -208,12 +214,68 @@ public:
 			repulsers.clear();
 		}
 
+		void InsertUnit(CUnit* unit);
+		void EraseUnit(CUnit* unit);
+
+	public:
+		/**
+		 * Structure-of-arrays copy of the position and radius of each
+		 * entry in <units> (same order), used by the *Exact queries to
+		 * reject far-away units without dereferencing them. Only kept
+		 * if enableQuadFieldSoA is set; CUnit::Move refreshes a unit's
+		 * entries (through CUnit::quadSlots) whenever it changes pos.
+		 */
+		struct UnitSoA {
+			void Clear() {
+				posX.clear();
+				posY.clear();
+				posZ.clear();
+				reach.clear();
+			}
+			void Append(const float3& pos, float radius) {
+				posX.push_back(pos.x);
+				posY.push_back(pos.y);
+				posZ.push_back(pos.z);
+				reach.push_back(radius + REACH_PADDING);
+			}
+			void Assign(size_t i, const float3& pos, float radius) {
+				posX[i] = pos.x;
+				posY[i] = pos.y;
+				posZ[i] = pos.z;
+				reach[i] = radius + REACH_PADDING;
+			}
+			// mirrors spring::VectorErase, i.e. moves the last entry into <i>
+			void Erase(size_t i) {
+				posX[i] = posX.back(); posX.pop_back();
+				posY[i] = posY.back(); posY.pop_back();
+				posZ[i] = posZ.back(); posZ.pop_back();
+				reach[i] = reach.back(); reach.pop_back();
+			}
+
+			size_t Size() const { return posX.size(); }
+
+			// absorbs rounding differences between the SIMD distance
+			// test and float3::SqDistance so the pre-filter can never
+			// reject a unit the exact test would accept
+			static constexpr float REACH_PADDING = 1.0f;
+
+			std::vector<float> posX;
+			std::vector<float> posY;
+			std::vector<float> posZ;
+			std::vector<float> reach; ///< radius + padding
+		};
+
 	public:
 		std::vector<CUnit*> units;
+		UnitSoA unitSoA;
 		std::vector< std::vector<CUnit*> > teamUnits;
 		std::vector<CFeature*> features;
 		std::vector<CProjectile*> projectiles;
 		std::vector<CPlasmaRepulser*> repulsers;
+
+		// value of CQuadField::changeStamp when the unit, feature or
+		// repulser lists (or a unit position) were last changed
+		std::uint64_t lastChange = 0;
 	};
 
 	const Quad& GetQuad(unsigned i) const {
@@ -232,12 +294,30 @@ public:
 	int GetQuadSizeX() const { return quadSizeX; }
 	int GetQuadSizeZ() const { return quadSizeZ; }
 
+	bool UseUnitSoAQueries() const { return unitSoAQueries; }
+
+	/**
+	 * Lets callers that hold on to query results (e.g. the parallel
+	 * projectile collision gathering) find out whether any quad that
+	 * a query at <pos> with <radius> would read has changed since the
+	 * given GetChangeStamp() value.
+	 */
+	std::uint64_t GetChangeStamp() const { return changeStamp; }
+	bool ChangedSince(const float3& pos, float radius, std::uint64_t stamp);
+
 	constexpr static unsigned int BASE_QUAD_SIZE = 128;
 
 private:
 	int2 WorldPosToQuadField(const float3 p) const;
 	int WorldPosToQuadFieldIdx(const float3 p) const;
 
+	void MarkChanged(int quadIdx) { baseQuads[quadIdx].lastChange = ++changeStamp; }
+
+	void InsertUnitIntoQuad(CUnit* unit, int quadIdx);
+	void EraseUnitFromQuad(CUnit* unit, size_t unitQuadIdx);
+
+	void PostLoad();
+
 private:
 	std::vector<Quad> baseQuads;
 
@@ -255,6 +335,10 @@ private:
 
 	int quadSizeX;
 	int quadSizeZ;
+
+	std::uint64_t changeStamp = 0;
+
+	bool unitSoAQueries = false;
 };
 
 extern CQuadField quadField;
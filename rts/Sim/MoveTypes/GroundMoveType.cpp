@@ -419,6 +419,7 @@ CGroundMoveType::CGroundMoveType(CUnit* owner):
 	killFeatures.reserve(UNIT_EVENTS_RESERVE);
 	killUnits.reserve(UNIT_EVENTS_RESERVE);
 	moveFeatures.reserve(UNIT_EVENTS_RESERVE);
+	deferredMoveVecs.reserve(2);
 }
 
 CGroundMoveType::~CGroundMoveType()
@@ -585,7 +586,10 @@ void CGroundMoveType::ProcessCollisionEvents() {
 	collidedFeatures.clear();
 }
 
-bool CGroundMoveType::Update()
+bool CGroundMoveType::Update() { return (UpdateImpl(false)); }
+bool CGroundMoveType::UpdateMt() { return (UpdateImpl(true)); }
+
+bool CGroundMoveType::UpdateImpl(bool deferred)
 {
 	if (owner->requestRemoveUnloadTransportId) {
 		owner->unloadingTransportId = -1;
@@ -597,6 +601,38 @@ bool CGroundMoveType::Update()
 	if (owner->IsSkidding()) return false;
 	if (owner->IsFalling()) return false;
 
+	// quadfield is shared, features are moved by UpdateMtDeferred
+	if (!deferred)
+		MoveCollidedFeatures();
+
+	if (resultantForces.SqLength() > 0.f)
+		MoveOwner(resultantForces, deferred);
+
+	AdjustPosToWaterLine(deferred);
+
+	ASSERT_SANE_OWNER_SPEED(owner->speed);
+
+	// <dif> is normally equal to owner->speed (if no collisions)
+	// we need more precision (less tolerance) in the y-dimension
+	// for all-terrain units that are slowed down a lot on cliffs
+	return (OwnerMoved(owner->heading, owner->pos - oldPos, float3(float3::cmp_eps(), float3::cmp_eps() * 1e-2f, float3::cmp_eps())));
+}
+
+void CGroundMoveType::UpdateMtDeferred()
+{
+	MoveCollidedFeatures();
+
+	// replay the synced half of owner->Move in the same order
+	for (const float3& dv: deferredMoveVecs) {
+		owner->midPos += dv;
+		owner->aimPos += dv;
+	}
+
+	deferredMoveVecs.clear();
+}
+
+void CGroundMoveType::MoveCollidedFeatures()
+{
 	for (auto collision: moveFeatures) {
 		auto collidee = std::get<0>(collision);
 		auto moveVec = std::get<1>(collision);
@@ -605,18 +641,22 @@ bool CGroundMoveType::Update()
 		quadField.AddFeature(collidee);
 	}
 	moveFeatures.clear();
-	
-	if (resultantForces.SqLength() > 0.f)
-		owner->Move(resultantForces, true);
+}
 
-	AdjustPosToWaterLine();
+void CGroundMoveType::MoveOwner(const float3& dv, bool deferred)
+{
+	if (!deferred) {
+		owner->Move(dv, true);
+		return;
+	}
 
-	ASSERT_SANE_OWNER_SPEED(owner->speed);
+	// midPos and aimPos are synced, writing them from a worker
+	// thread would race on the sync-checksum; only pos is moved
+	owner->pos += dv;
+	deferredMoveVecs.push_back(dv);
 
-	// <dif> is normally equal to owner->speed (if no collisions)
-	// we need more precision (less tolerance) in the y-dimension
-	// for all-terrain units that are slowed down a lot on cliffs
-	return (OwnerMoved(owner->heading, owner->pos - oldPos, float3(float3::cmp_eps(), float3::cmp_eps() * 1e-2f, float3::cmp_eps())));
+	// only touches the owner's own snapshot entries
+	quadField.UpdateUnitSnapshot(owner);
 }
 
 void CGroundMoveType::UpdateOwnerAccelAndHeading()
@@ -1786,6 +1826,9 @@ unsigned int CGroundMoveType::GetNewPath()
 
 		pathController.SetRealGoalPosition(newPathID, goalPos);
 		pathController.SetTempGoalPosition(newPathID, earlyCurrWayPoint);
+	} else if (deferPathingFailure) {
+		// Fail runs callins; handled by UpdatePreCollisions
+		pathingFailed = true;
 	} else {
 		Fail(false);
 	}
@@ -2897,7 +2940,7 @@ float CGroundMoveType::GetGroundHeight(const float3& p) const
 	return gh;
 }
 
-void CGroundMoveType::AdjustPosToWaterLine()
+void CGroundMoveType::AdjustPosToWaterLine(bool deferred)
 {
 	if (owner->IsFalling())
 		return;
@@ -2906,12 +2949,12 @@ void CGroundMoveType::AdjustPosToWaterLine()
 
 	if (modInfo.allowGroundUnitGravity) {
 		if (owner->FloatOnWater()) {
-			owner->Move(UpVector * (std::max(CGround::GetHeightReal(owner->pos.x, owner->pos.z),   -waterline) - owner->pos.y), true);
+			MoveOwner(UpVector * (std::max(CGround::GetHeightReal(owner->pos.x, owner->pos.z),   -waterline) - owner->pos.y), deferred);
 		} else {
-			owner->Move(UpVector * (std::max(CGround::GetHeightReal(owner->pos.x, owner->pos.z), owner->pos.y) - owner->pos.y), true);
+			MoveOwner(UpVector * (std::max(CGround::GetHeightReal(owner->pos.x, owner->pos.z), owner->pos.y) - owner->pos.y), deferred);
 		}
 	} else {
-		owner->Move(UpVector * (GetGroundHeight(owner->pos) - owner->pos.y), true);
+		MoveOwner(UpVector * (GetGroundHeight(owner->pos) - owner->pos.y), deferred);
 	}
 }
 
@@ -32,6 +32,9 @@ public:
 	void* GetPreallocContainer() { return owner; }  // creg
 
 	bool Update() override;
+	bool UpdateMt() override;
+	void UpdateMtDeferred() override;
+	bool CanUpdateMt() const override { return true; }
 	void SlowUpdate() override;
 	void UpdatePreCollisionsMt() override;
 	void UpdateCollisionDetections() override;
@@ -99,17 +102,21 @@ public:
 	const float3& GetGroundNormal(const float3&) const;
 	float GetGroundHeight(const float3&) const;
 
-	void DelayedReRequestPath() {
+	void DelayedReRequestPath(bool concurrent) override {
 		earlyCurrWayPoint = currWayPoint;
 		earlyNextWayPoint = nextWayPoint;
 
 		PathRequestType curRepath = wantRepath;
 		wantRepath = PATH_REQUEST_NONE;
 
+		deferPathingFailure = concurrent;
+
 		if (curRepath & PATH_REQUEST_UPDATE_FULLPATH) { DoReRequestPath(); }
 		else if (curRepath & PATH_REQUEST_UPDATE_EXISTING) { DoSetNextWaypoint(); }
+
+		deferPathingFailure = false;
 	}
-	void SyncWaypoints() {
+	void SyncWaypoints() override {
 		// Synced vars trigger a checksum update on change, which is expensive so we should check
 		// that there has been a change before triggering an update to the checksum.
 		if (!currWayPoint.bitExactEquals(earlyCurrWayPoint))
@@ -185,7 +192,10 @@ private:
 	void CheckCollisionSkid();
 	void CalcSkidRot();
 
-	void AdjustPosToWaterLine();
+	bool UpdateImpl(bool deferred);
+	void MoveCollidedFeatures();
+	void MoveOwner(const float3& dv, bool deferred);
+	void AdjustPosToWaterLine(bool deferred = false);
 	bool UpdateDirectControl();
 	void UpdateOwnerAccelAndHeading();
 	void UpdateOwnerPos(const float3&, const float3&);
@@ -257,6 +267,7 @@ private:
 	bool useRawMovement = false;            /// if true, move towards goal without invoking PFS (unrelated to MoveDef::allowRawMovement)
 	bool pathingFailed = false;
 	bool pathingArrived = false;
+	bool deferPathingFailure = false;       /// if true, GetNewPath sets pathingFailed instead of calling Fail
 	int setHeading = 0; // 1 = Regular (use setHeadingDir), 2 = Main
 	short setHeadingDir = 0;
 
@@ -265,6 +276,7 @@ private:
 	std::vector<CFeature*> killFeatures;
 	std::vector<CUnit*> killUnits;
 	std::vector<std::tuple<CFeature*, float3>> moveFeatures;
+	std::vector<float3> deferredMoveVecs;   /// owner->Move's whose synced part is postponed by UpdateMt
 };
 
 #endif // GROUNDMOVETYPE_H
@@ -62,6 +62,15 @@ public:
 
 	virtual bool Update() = 0;
 	virtual void SlowUpdate() {};
+
+	// thread-safe variant of Update, used when modInfo.enableParallelMoveTypeUpdate
+	// is set; any side-effects on shared state are postponed by UpdateMt and then
+	// applied by UpdateMtDeferred on the main thread (movetypes that can not split
+	// their update this way return false from CanUpdateMt and run Update serially)
+	virtual bool CanUpdateMt() const { return false; }
+	virtual bool UpdateMt() { return false; }
+	virtual void UpdateMtDeferred() {}
+
 	void UpdateCollisionMap();
 
 	virtual void UpdatePreCollisionsMt() {};
@@ -99,7 +108,9 @@ public:
 	float CalcStaticTurnRadius() const;
 
 	virtual PathRequestType WantsReRequestPath() const { return wantRepath; }
-	virtual void DelayedReRequestPath() {}
+	// if <concurrent>, other units' requests are executed at the same time
+	// and callins triggered by the request must be postponed
+	virtual void DelayedReRequestPath(bool concurrent) {}
 	virtual void SyncWaypoints() {}
 	virtual unsigned int GetPathId() { return 0; }
 
@@ -25,6 +25,7 @@ public:
 	void KeepPointingTo(float3 pos, float distance, bool aggressive) override {}
 
 	bool Update() override { return false; }
+	bool CanUpdateMt() const override { return true; }
 	void SlowUpdate() override;
 };
 
@@ -30,6 +30,7 @@ public:
 	size_t GetMemFootPrint() const { return (blockStates.GetMemFootPrint()); }
 
 	PathNodeStateBuffer& GetNodeStateBuffer() { return blockStates; }
+	const PathNodeStateBuffer& GetNodeStateBuffer() const { return blockStates; }
 
 	unsigned int GetBlockSize() const { return BLOCK_SIZE; }
 	int2 GetNumBlocks() const { return nbrOfBlocks; }
@@ -7,23 +7,21 @@
 #include "Sim/Misc/GlobalSynced.h"
 #include "System/Log/ILog.h"
 
-#define MAX_CACHE_QUEUE_SIZE   200
 #define MAX_PATH_LIFETIME_SECS   6
 #define USE_NONCOLLIDABLE_HASH   1
 
-CPathCache::CPathCache(int blocksX, int blocksZ)
+CPathCache::CPathCache(int blocksX, int blocksZ, size_t memBudget)
 	: numBlocksX(blocksX)
 	, numBlocksZ(blocksZ)
 	, numBlocks(numBlocksX * numBlocksZ)
 
-	, maxCacheSize(0)
-	, numCacheHits(0)
-	, numCacheMisses(0)
 	, numHashCollisions(0)
 {
 	// {result, path, strtBlock, goalBlock, goalRadius, pathType}
 	dummyCacheItem = {IPath::Error, {}, {-1, -1}, {-1, -1}, -1.0f, -1};
 
+	stats.memBudget = memBudget;
+
 	cachedPaths.reserve(4096);
 }
 
@@ -31,12 +29,12 @@ CPathCache::~CPathCache()
 {
 	const char* fmt =
 #ifdef _WIN32
-		"[%s(%ux%u)] cacheHits=%u hitPercentage=%.0f%% numHashColls=%u maxCacheSize=%I64u";
+		"[%s(%ux%u)] cacheHits=%I64u hitPercentage=%.0f%% evictions=%I64u expirations=%I64u numHashColls=%u maxCacheSize=%I64u";
 #else
-		"[%s(%ux%u)] cacheHits=%u hitPercentage=%.0f%% numHashColls=%u maxCacheSize=%lu";
+		"[%s(%ux%u)] cacheHits=%lu hitPercentage=%.0f%% evictions=%lu expirations=%lu numHashColls=%u maxCacheSize=%lu";
 #endif
 
-	LOG(fmt, __FUNCTION__, numBlocksX, numBlocksZ, numCacheHits, GetCacheHitPercentage(), numHashCollisions, maxCacheSize);
+	LOG(fmt, __FUNCTION__, numBlocksX, numBlocksZ, stats.numHits, GetCacheHitPercentage(), stats.numEvictions, stats.numExpirations, numHashCollisions, stats.maxNumItems);
 }
 
 bool CPathCache::AddPath(
@@ -47,23 +45,38 @@ bool CPathCache::AddPath(
 	float goalRadius,
 	int pathType
 ) {
-	if (cacheQue.size() > MAX_CACHE_QUEUE_SIZE)
-		RemoveFrontQueItem();
-
 	const std::uint64_t hash = GetHash(strtBlock, goalBlock, goalRadius, pathType);
 	const std::uint32_t cols = numHashCollisions;
+	const std::uint32_t size = GetEntryMemSize(*path);
 	const auto iter = cachedPaths.find(hash);
 
 	// register any hash collisions
 	if (iter != cachedPaths.end())
-		return ((numHashCollisions += HashCollision(iter->second, strtBlock, goalBlock, goalRadius, pathType)) != cols);
+		return ((numHashCollisions += HashCollision(iter->second.item, strtBlock, goalBlock, goalRadius, pathType)) != cols);
 
-	cachedPaths[hash] = CacheItem{result, *path, strtBlock, goalBlock, goalRadius, pathType};
+	// a path that does not fit even into an empty cache is not worth evicting everything for
+	if (size > stats.memBudget)
+		return false;
+
+	while ((stats.memUsage + size) > stats.memBudget) {
+		RemoveEntry(cachedPaths.find(lruList.front()));
+		stats.numEvictions += 1;
+	}
 
 	const int lifeTime = (result == IPath::Ok) ? GAME_SPEED * MAX_PATH_LIFETIME_SECS : GAME_SPEED * (MAX_PATH_LIFETIME_SECS / 2);
 
-	cacheQue.push_back({gs->frameNum + lifeTime, hash});
-	maxCacheSize = std::max<std::uint64_t>(maxCacheSize, cacheQue.size());
+	CacheEntry& entry = cachedPaths[hash];
+
+	entry.item = CacheItem{result, *path, strtBlock, goalBlock, goalRadius, pathType};
+	entry.timeout = gs->frameNum + lifeTime;
+	entry.memSize = size;
+	entry.lruIter = lruList.insert(lruList.end(), hash);
+
+	cacheQue.push_back({entry.timeout, hash});
+
+	stats.numItems = cachedPaths.size();
+	stats.maxNumItems = std::max(stats.maxNumItems, stats.numItems);
+	stats.memUsage += size;
 	return false;
 }
 
@@ -77,35 +90,59 @@ const CPathCache::CacheItem& CPathCache::GetCachedPath(
 	const auto iter = cachedPaths.find(hash);
 
 	if (iter == cachedPaths.end()) {
-		++numCacheMisses; return dummyCacheItem;
+		++stats.numMisses; return dummyCacheItem;
 	}
-	if ((iter->second).strtBlock != strtBlock) {
-		++numCacheMisses; return dummyCacheItem;
+
+	const CacheItem& item = (iter->second).item;
+
+	if (item.strtBlock != strtBlock) {
+		++stats.numMisses; return dummyCacheItem;
 	}
-	if ((iter->second).goalBlock != goalBlock) {
-		++numCacheMisses; return dummyCacheItem;
+	if (item.goalBlock != goalBlock) {
+		++stats.numMisses; return dummyCacheItem;
 	}
-	if ((iter->second).pathType != pathType) {
-		++numCacheMisses; return dummyCacheItem;
+	if (item.pathType != pathType) {
+		++stats.numMisses; return dummyCacheItem;
 	}
 
-	++numCacheHits;
-	return (iter->second);
+	// mark as most recently used
+	lruList.splice(lruList.end(), lruList, (iter->second).lruIter);
+
+	++stats.numHits;
+	return item;
 }
 
 void CPathCache::Update()
 {
-	while (!cacheQue.empty() && (cacheQue.front().timeout) < gs->frameNum)
-		RemoveFrontQueItem();
+	RemoveExpiredEntries();
 }
 
-void CPathCache::RemoveFrontQueItem()
+void CPathCache::RemoveExpiredEntries()
 {
-	const auto it = cachedPaths.find((cacheQue.front()).hash);
+	while (!cacheQue.empty() && (cacheQue.front().timeout) < gs->frameNum) {
+		const CacheQueItem& qi = cacheQue.front();
+		const auto iter = cachedPaths.find(qi.hash);
+
+		// skip hashes that were evicted (and possibly re-added) in the meantime
+		if (iter != cachedPaths.end() && (iter->second).timeout == qi.timeout) {
+			RemoveEntry(iter);
+			stats.numExpirations += 1;
+		}
+
+		cacheQue.pop_front();
+	}
+}
+
+void CPathCache::RemoveEntry(spring::unordered_map<std::uint64_t, CacheEntry>::iterator iter)
+{
+	assert(iter != cachedPaths.end());
+
+	stats.memUsage -= (iter->second).memSize;
+
+	lruList.erase((iter->second).lruIter);
+	cachedPaths.erase(iter);
 
-	assert(it != cachedPaths.end());
-	cachedPaths.erase(it);
-	cacheQue.pop_front();
+	stats.numItems = cachedPaths.size();
 }
 
 std::uint64_t CPathCache::GetHash(
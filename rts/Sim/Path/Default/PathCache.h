@@ -4,15 +4,22 @@
 #define PATHCACHE_H
 
 #include <deque>
+#include <list>
 
 #include "IPath.h"
+#include "Sim/Path/IPathManager.h"
 #include "System/type2.h"
 #include "System/UnorderedMap.hpp"
 
+/**
+ * Caches the results of recent estimator searches. Bounded by a memory budget
+ * (least recently used paths are evicted first) and by a lifetime (paths are
+ * not invalidated by terrain changes, so they must not be served forever).
+ */
 class CPathCache
 {
 public:
-	CPathCache(int blocksX, int blocksZ);
+	CPathCache(int blocksX, int blocksZ, size_t memBudget);
 	~CPathCache();
 
 	struct CacheItem {
@@ -41,8 +48,27 @@ public:
 		int pathType
 	);
 
+	const PathCacheStats& GetStats() const { return stats; }
+
 private:
-	void RemoveFrontQueItem();
+	struct CacheEntry {
+		CacheItem item;
+
+		std::int32_t timeout;
+		std::uint32_t memSize;
+
+		// position in lruList, front is least recently used
+		std::list<std::uint64_t>::iterator lruIter;
+	};
+
+	void RemoveEntry(spring::unordered_map<std::uint64_t, CacheEntry>::iterator iter);
+	void RemoveExpiredEntries();
+
+	// approximate, but must not depend on the compiler or STL since the synced
+	// caches are evicted by it; the constant covers entry, list- and map-nodes
+	static std::uint32_t GetEntryMemSize(const IPath::Path& path) {
+		return (256 + path.path.size() * (3 * sizeof(float)) + path.squares.size() * (2 * sizeof(int)));
+	}
 
 	std::uint64_t GetHash(
 		const int2 strtBlk,
@@ -60,10 +86,10 @@ private:
 	) const;
 
 	float GetCacheHitPercentage() const {
-		if ((numCacheHits + numCacheMisses) == 0)
+		if ((stats.numHits + stats.numMisses) == 0)
 			return 0.0f;
 
-		return ((numCacheHits / float(numCacheHits + numCacheMisses)) * 100.0f);
+		return ((stats.numHits / float(stats.numHits + stats.numMisses)) * 100.0f);
 	}
 
 private:
@@ -75,17 +101,18 @@ private:
 	// returned on any cache-miss
 	CacheItem dummyCacheItem;
 
+	// insertion order, for lifetime expiry; can contain already evicted hashes
 	std::deque<CacheQueItem> cacheQue;
-	spring::unordered_map<std::uint64_t, CacheItem> cachedPaths; // ints are sync-safe keys
+	std::list<std::uint64_t> lruList;
+	spring::unordered_map<std::uint64_t, CacheEntry> cachedPaths; // ints are sync-safe keys
 
 	std::uint32_t numBlocksX;
 	std::uint32_t numBlocksZ;
 	std::uint64_t numBlocks;
 
-	std::uint64_t maxCacheSize;
-	std::uint32_t numCacheHits;
-	std::uint32_t numCacheMisses;
 	std::uint32_t numHashCollisions;
+
+	PathCacheStats stats;
 };
 
 #endif
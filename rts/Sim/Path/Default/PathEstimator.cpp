@@ -2,9 +2,6 @@
 
 #include "System/Platform/Win/win32.h"
 
-#include "zlib.h"
-#include "minizip/zip.h"
-
 #include "PathEstimator.h"
 #include "PathFinder.h"
 #include "PathFinderDef.h"
@@ -17,12 +14,11 @@
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
+#include "Sim/Path/PathEstimatorFile.h"
 #include "Net/Protocol/NetProtocol.h"
 #include "System/Threading/ThreadPool.h" // for_mt
 #include "System/TimeProfiler.h"
 #include "System/Config/ConfigHandler.h"
-#include "System/FileSystem/Archives/IArchive.h"
-#include "System/FileSystem/ArchiveLoader.h"
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/FileQueryFlags.h"
@@ -35,6 +31,7 @@
 
 CONFIG(int, PathingThreadCount).defaultValue(0).safemodeValue(1).minimumValue(0);
 CONFIG(int, MaxPathCostsMemoryFootPrint).defaultValue(512).minimumValue(64).description("Maximum memusage (in MByte) of multithreaded pathcache generator at loading time.");
+CONFIG(int, PathCacheMemoryBudget).defaultValue(1024).minimumValue(0).description("Maximum memusage (in KByte) of each unsynced path-estimator search cache, least recently used paths are evicted first. The synced caches are bounded by the pathCacheMemoryBudget modrule.");
 
 PCMemPool pcMemPool;
 PEMemPool peMemPool;
@@ -44,8 +41,13 @@ static const std::string GetPathCacheDir() {
 	return (FileSystem::GetCacheDir() + "/paths/");
 }
 
-static const std::string GetCacheFileName(const std::string& fileHashCode, const std::string& peFileName, const std::string& mapFileName) {
-	return (GetPathCacheDir() + mapFileName + "." + peFileName + "-" + fileHashCode + ".zip");
+static const std::string GetCacheFileName(
+	const std::string& fileHashCode,
+	const std::string& peFileName,
+	const std::string& mapFileName,
+	const char* fileExtension = PathEstimatorFile::FILE_EXTENSION
+) {
+	return (GetPathCacheDir() + mapFileName + "." + peFileName + "-" + fileHashCode + fileExtension);
 }
 
 
@@ -217,8 +219,9 @@ void CPathEstimator::InitEstimator(const std::string& peFileName, const std::str
 	pfMemPool.free(pathFinders[0]);
 	pathFinders[0] = parentPathFinder;
 
-	pathCache[0] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y);
-	pathCache[1] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y);
+	// synced budget must be the same for all clients
+	pathCache[0] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y, configHandler->GetInt("PathCacheMemoryBudget") * 1024);
+	pathCache[1] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y, modInfo.pathCacheMemoryBudget * 1024);
 }
 
 
@@ -964,57 +967,16 @@ bool CPathEstimator::ReadFile(const std::string& peFileName, const std::string&
 	if (!FileSystem::FileExists(cacheFileName))
 		return false;
 
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
-
-	if (upfile == nullptr || !upfile->IsOpen()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
 	char calcMsg[512];
 	sprintf(calcMsg, "Reading Estimate PathCosts [%d]", BLOCK_SIZE);
 	loadscreen->SetLoadMessage(calcMsg);
 
-	const unsigned fid = upfile->FindFile("pathinfo");
-	if (fid >= upfile->NumFiles()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	std::vector<std::uint8_t> buffer;
-
-	if (!upfile->GetFile(fid, buffer) || buffer.size() < 4) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	const unsigned int filehash = *(reinterpret_cast<unsigned int*>(&buffer[0]));
-	const unsigned int blockSize = blockStates.GetSize() * sizeof(short2);
-	unsigned int pos = sizeof(unsigned);
-
-	if (filehash != fileHashCode) {
+	// mapped and copied straight into the estimator arrays, nothing to inflate
+	if (!PathEstimatorFile::Read(dataDirsAccess.LocateFile(cacheFileName), fileHashCode, blockStates.peNodeOffsets, vertexCosts)) {
 		FileSystem::Remove(cacheFileName);
 		return false;
 	}
 
-	if (buffer.size() < (pos + blockSize * moveDefHandler.GetNumMoveDefs())) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	// read center-offset data
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		std::memcpy(&blockStates.peNodeOffsets[pathType][0], &buffer[pos], blockSize);
-		pos += blockSize;
-	}
-
-	// read vertex-cost data
-	if (buffer.size() < (pos + vertexCosts.size() * sizeof(float))) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	std::memcpy(&vertexCosts[0], &buffer[pos], vertexCosts.size() * sizeof(float));
 	return true;
 }
 
@@ -1033,39 +995,16 @@ bool CPathEstimator::WriteFile(const std::string& peFileName, const std::string&
 
 	LOG("[PathEstimator::%s] hash=%s file=\"%s\" (exists=%d)", __func__, hashHexString.c_str(), cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
 
-	// open file for writing in a suitable location
-	zipFile file = zipOpen(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE).c_str(), APPEND_STATUS_CREATE);
-
-	if (file == nullptr)
+	if (!PathEstimatorFile::Write(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE), fileHashCode, blockStates.peNodeOffsets, vertexCosts))
 		return false;
 
-	zipOpenNewFileInZip(file, "pathinfo", nullptr, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, Z_BEST_COMPRESSION);
+	// the old-format cache for the same hash is never read again
+	const std::string legacyFileName = GetCacheFileName(hashHexString, peFileName, mapFileName, PathEstimatorFile::LEGACY_FILE_EXTENSION);
 
-	// write hash-code (NOTE: this also affects the CRC!)
-	zipWriteInFileInZip(file, (const void*) &fileHashCode, 4);
-
-	// write center-offsets
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		zipWriteInFileInZip(file, (const void*) &blockStates.peNodeOffsets[pathType][0], blockStates.peNodeOffsets[pathType].size() * sizeof(short2));
-	}
+	if (FileSystem::FileExists(legacyFileName))
+		FileSystem::Remove(legacyFileName);
 
-	// write vertex-costs
-	zipWriteInFileInZip(file, vertexCosts.data(), vertexCosts.size() * sizeof(float));
-
-	zipCloseFileInZip(file);
-	zipClose(file, nullptr);
-
-
-	// get the CRC over the written path data
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
-
-	if (upfile == nullptr || !upfile->IsOpen()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	assert(upfile->FindFile("pathinfo") < upfile->NumFiles());
-  return true;
+	return true;
 }
 
 
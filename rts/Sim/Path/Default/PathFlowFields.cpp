@@ -0,0 +1,200 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <functional>
+
+#include "PathFlowFields.hpp"
+#include "PathConstants.h"
+#include "PathEstimator.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
+#include "System/TimeProfiler.h"
+
+// requests per goal-block before a field pays for itself
+#define FLOW_FIELD_MIN_REQUESTS      8
+// fields are not invalidated by terrain changes, rebuild them periodically
+#define FLOW_FIELD_LIFETIME_SECS     6
+#define FLOW_FIELD_IDLE_TIME_SECS   10
+
+// not extern'ed, so static
+static PathFlowFields gPathFlowFields;
+
+
+PathFlowFields* PathFlowFields::GetInstance() {
+	return &gPathFlowFields;
+}
+
+void PathFlowFields::FreeInstance(PathFlowFields* pff) {
+	assert(pff == &gPathFlowFields);
+	pff->Kill();
+}
+
+
+
+void PathFlowFields::Init(const CPathEstimator* pe) {
+	pathEstimator = pe;
+
+	fields.clear();
+	fields.reserve(64);
+}
+
+void PathFlowFields::Update() {
+	for (auto it = fields.begin(); it != fields.end(); ) {
+		if ((gs->frameNum - it->second.lastUseFrame) > (GAME_SPEED * FLOW_FIELD_IDLE_TIME_SECS)) {
+			it = fields.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+
+unsigned int PathFlowFields::GetBlockIdx(const float3& pos) const {
+	const int2 numBlocks = pathEstimator->GetNumBlocks();
+	const unsigned int blockPixelSize = pathEstimator->GetBlockSize() * SQUARE_SIZE;
+
+	const int bx = Clamp(int(pos.x / blockPixelSize), 0, numBlocks.x - 1);
+	const int bz = Clamp(int(pos.z / blockPixelSize), 0, numBlocks.y - 1);
+
+	return (pathEstimator->BlockPosToIdx({bx, bz}));
+}
+
+
+unsigned int PathFlowFields::AddRequest(const MoveDef& moveDef, const float3& goalPos) {
+	const int2 numBlocks = pathEstimator->GetNumBlocks();
+
+	const unsigned int goalBlockIdx = GetBlockIdx(goalPos);
+	const unsigned int fieldKey = moveDef.pathType * numBlocks.x * numBlocks.y + goalBlockIdx;
+
+	FlowField& field = fields[fieldKey];
+
+	field.goalBlockIdx = goalBlockIdx;
+	field.numRequests += 1;
+	field.lastUseFrame = gs->frameNum;
+
+	if (field.numRequests < FLOW_FIELD_MIN_REQUESTS)
+		return -1u;
+
+	return fieldKey;
+}
+
+
+bool PathFlowFields::TracePath(const MoveDef& moveDef, unsigned int key, const float3& startPos, IPath::Path& path) {
+	const auto it = fields.find(key);
+
+	if (it == fields.end())
+		return false;
+
+	FlowField& field = it->second;
+
+	if (field.buildFrame < 0 || (gs->frameNum - field.buildFrame) > (GAME_SPEED * FLOW_FIELD_LIFETIME_SECS))
+		BuildField(moveDef, field);
+
+	field.lastUseFrame = gs->frameNum;
+
+	const unsigned int strtBlockIdx = GetBlockIdx(startPos);
+
+	if (field.costs[strtBlockIdx] >= PATHCOST_INFINITY)
+		return false;
+
+	const std::vector<short2>& nodeOffsets = pathEstimator->GetNodeStateBuffer().peNodeOffsets[moveDef.pathType];
+
+	path.path.clear();
+	path.squares.clear();
+
+	// edge costs are clamped to be non-negative, so the directions form a tree rooted at the goal
+	for (unsigned int blockIdx = strtBlockIdx; ; ) {
+		const short2 square = nodeOffsets[blockIdx];
+
+		path.path.emplace_back(square.x * SQUARE_SIZE, CMoveMath::yLevel(moveDef, square.x, square.y), square.y * SQUARE_SIZE);
+
+		if (blockIdx == field.goalBlockIdx)
+			break;
+
+		blockIdx = pathEstimator->BlockPosToIdx(pathEstimator->BlockIdxToPos(blockIdx) + PE_DIRECTION_VECTORS[field.dirs[blockIdx]]);
+	}
+
+	// estimator paths are stored back-to-front
+	std::reverse(path.path.begin(), path.path.end());
+
+	path.pathGoal = path.path[0];
+	path.pathCost = field.costs[strtBlockIdx];
+	return true;
+}
+
+
+void PathFlowFields::BuildField(const MoveDef& moveDef, FlowField& field) {
+	SCOPED_TIMER("Sim::Path::FlowFields");
+
+	const int2 numBlocks = pathEstimator->GetNumBlocks();
+
+	const PathNodeStateBuffer& blockStates = pathEstimator->GetNodeStateBuffer();
+	const std::vector<short2>& nodeOffsets = blockStates.peNodeOffsets[moveDef.pathType];
+	const std::vector<float>& vertexCosts = pathEstimator->GetVertexCosts();
+
+	const unsigned int vertexBaseIdx = moveDef.pathType * numBlocks.x * numBlocks.y * PATH_DIRECTION_VERTICES;
+
+	// (cost, blockIdx) pairs compare lexicographically, which makes the
+	// expansion order (and thereby the tie-breaking) fully deterministic
+	const auto cmp = std::greater<std::pair<float, unsigned int>>();
+
+	field.costs.clear();
+	field.costs.resize(numBlocks.x * numBlocks.y, PATHCOST_INFINITY);
+	field.dirs.clear();
+	field.dirs.resize(numBlocks.x * numBlocks.y, 0);
+	field.buildFrame = gs->frameNum;
+
+	field.costs[field.goalBlockIdx] = 0.0f;
+
+	openQueue.clear();
+	openQueue.emplace_back(0.0f, field.goalBlockIdx);
+
+	while (!openQueue.empty()) {
+		std::pop_heap(openQueue.begin(), openQueue.end(), cmp);
+
+		const float curCost = openQueue.back().first;
+		const unsigned int curBlockIdx = openQueue.back().second;
+
+		openQueue.pop_back();
+
+		// stale entry
+		if (curCost > field.costs[curBlockIdx])
+			continue;
+
+		const int2 curBlockPos = pathEstimator->BlockIdxToPos(curBlockIdx);
+		const short2 curSquare = nodeOffsets[curBlockIdx];
+
+		// a forward search pays the extra-cost of the block it enters
+		const float extraCost = blockStates.GetNodeExtraCost(curSquare.x, curSquare.y, true);
+
+		for (unsigned int pathDir = 0; pathDir < PATH_DIRECTIONS; pathDir++) {
+			const int2 ngbBlockPos = curBlockPos + PE_DIRECTION_VECTORS[pathDir];
+
+			if (static_cast<unsigned int>(ngbBlockPos.x) >= numBlocks.x)
+				continue;
+			if (static_cast<unsigned int>(ngbBlockPos.y) >= numBlocks.y)
+				continue;
+
+			// vertex costs are bi-directional
+			const unsigned int ngbBlockIdx = pathEstimator->BlockPosToIdx(ngbBlockPos);
+			const unsigned int vertexCostIdx = vertexBaseIdx + curBlockIdx * PATH_DIRECTION_VERTICES + GetBlockVertexOffset(pathDir, numBlocks.x);
+
+			const float vertexCost = vertexCosts[vertexCostIdx];
+
+			if (vertexCost >= PATHCOST_INFINITY)
+				continue;
+
+			const float ngbCost = curCost + std::max(vertexCost + extraCost, 0.0f);
+
+			if (ngbCost >= field.costs[ngbBlockIdx])
+				continue;
+
+			field.costs[ngbBlockIdx] = ngbCost;
+			field.dirs[ngbBlockIdx] = (pathDir + (PATH_DIRECTIONS >> 1)) % PATH_DIRECTIONS;
+
+			openQueue.emplace_back(ngbCost, ngbBlockIdx);
+			std::push_heap(openQueue.begin(), openQueue.end(), cmp);
+		}
+	}
+}
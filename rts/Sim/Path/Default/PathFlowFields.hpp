@@ -0,0 +1,76 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PATH_FLOWFIELDS_HDR
+#define PATH_FLOWFIELDS_HDR
+
+#include <vector>
+
+#include "IPath.h"
+#include "System/type2.h"
+#include "System/float3.h"
+#include "System/UnorderedMap.hpp"
+
+class CPathEstimator;
+struct MoveDef;
+
+/**
+ * Shared goal-fields for group moves. When enough synced requests of one
+ * movetype head for the same estimator block, a single Dijkstra pass over
+ * the estimator's vertex graph (rooted at that block) replaces the block-
+ * level searches of every request; paths are then obtained by descending
+ * the field from each unit's current block.
+ */
+class PathFlowFields {
+public:
+	static PathFlowFields* GetInstance();
+	static void FreeInstance(PathFlowFields*);
+
+	void Init(const CPathEstimator* pe);
+	void Kill() { fields.clear(); }
+
+	// drops fields that have not been used for a while
+	void Update();
+
+	/**
+	 * Registers a request towards <goalPos> and returns the key of its field
+	 * once the group is large enough (-1u otherwise); the field is (re)built
+	 * lazily, so the key stays valid for tracing even after it has expired.
+	 */
+	unsigned int AddRequest(const MoveDef& moveDef, const float3& goalPos);
+
+	/**
+	 * Writes the block-centers from <startPos> down the field of <key> into
+	 * <path> (ordered like estimator paths, i.e. goal first); returns false
+	 * if the field does not exist (anymore) or cannot reach <startPos>.
+	 */
+	bool TracePath(const MoveDef& moveDef, unsigned int key, const float3& startPos, IPath::Path& path);
+
+	size_t GetNumFields() const { return fields.size(); }
+
+private:
+	struct FlowField {
+		// cost-to-goal and direction (PATHDIR_*) towards the goal per block
+		std::vector<float> costs;
+		std::vector<std::uint8_t> dirs;
+
+		unsigned int goalBlockIdx = 0;
+		unsigned int numRequests = 0;
+
+		int buildFrame = -1;
+		int lastUseFrame = 0;
+	};
+
+	unsigned int GetBlockIdx(const float3& pos) const;
+
+	void BuildField(const MoveDef& moveDef, FlowField& field);
+
+private:
+	const CPathEstimator* pathEstimator = nullptr;
+
+	spring::unordered_map<unsigned int, FlowField> fields;
+
+	// Dijkstra scratch
+	std::vector<std::pair<float, unsigned int>> openQueue;
+};
+
+#endif
@@ -5,10 +5,12 @@
 #include "PathFinder.h"
 #include "PathEstimator.h"
 #include "PathFlowMap.hpp"
+#include "PathFlowFields.hpp"
 #include "PathHeatMap.hpp"
 #include "PathLog.h"
 #include "PathMemPool.h"
 #include "Map/MapInfo.h"
+#include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Objects/SolidObject.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
@@ -26,6 +28,7 @@ CPathManager::CPathManager()
 , medResPE(nullptr)
 , lowResPE(nullptr)
 , pathFlowMap(nullptr)
+, pathFlowFields(nullptr)
 , pathHeatMap(nullptr)
 , nextPathID(0)
 {
@@ -33,6 +36,7 @@ CPathManager::CPathManager()
 	CPathFinder::InitStatic();
 
 	pathFlowMap = PathFlowMap::GetInstance();
+	pathFlowFields = PathFlowFields::GetInstance();
 	pathHeatMap = PathHeatMap::GetInstance();
 
 	pathMap.reserve(1024);
@@ -56,6 +60,7 @@ CPathManager::~CPathManager()
 	}
 
 	PathHeatMap::FreeInstance(pathHeatMap);
+	PathFlowFields::FreeInstance(pathFlowFields);
 	PathFlowMap::FreeInstance(pathFlowMap);
 	IPathFinder::KillStatic();
 }
@@ -85,6 +90,8 @@ std::int64_t CPathManager::Finalize() {
 		maxResPF->Init(false);
 		medResPE->Init(maxResPF, MEDRES_PE_BLOCKSIZE, "pe" , mapInfo->map.name);
 		lowResPE->Init(medResPE, LOWRES_PE_BLOCKSIZE, "pe2", mapInfo->map.name);
+
+		pathFlowFields->Init(medResPE);
 	}
 
 	const spring_time dt = spring_gettime() - t0;
@@ -363,6 +370,27 @@ IPath::SearchResult CPathManager::ArrangePath(
 }
 
 
+IPath::SearchResult CPathManager::ArrangeFlowPath(
+	MultiPath* newPath,
+	const MoveDef* moveDef,
+	const float3& startPos,
+	const float3& goalPos
+) {
+	const unsigned int fieldKey = pathFlowFields->AddRequest(*moveDef, goalPos);
+
+	if (fieldKey == -1u)
+		return IPath::Error;
+
+	// the traced path ends in the goal-block; FinalizePath replaces its
+	// front by the actual goal and MedRes2MaxRes refines the first part
+	if (!pathFlowFields->TracePath(*moveDef, fieldKey, startPos, newPath->medResPath))
+		return IPath::Error;
+
+	newPath->flowFieldKey = fieldKey;
+	return IPath::Ok;
+}
+
+
 /*
 Request a new multipath, store the result and return a handle-id to it.
 */
@@ -394,7 +422,14 @@ unsigned int CPathManager::RequestPath(
 	if (caller != nullptr)
 		caller->UnBlock();
 
-	const IPath::SearchResult result = ArrangePath(&newPath, moveDef, startPos, goalPos, caller);
+	IPath::SearchResult result = IPath::Error;
+
+	// long synced moves can share the block-level search with others heading for the same goal
+	if (modInfo.enableFlowFieldPathing && synced && startPos.SqDistance2D(goalPos) > Square(MEDRES_SEARCH_DISTANCE * SQUARE_SIZE))
+		result = ArrangeFlowPath(&newPath, moveDef, startPos, goalPos);
+
+	if (result != IPath::Ok)
+		result = ArrangePath(&newPath, moveDef, startPos, goalPos, caller);
 
 	unsigned int pathID = 0;
 
@@ -563,8 +598,21 @@ float3 CPathManager::NextWayPoint(
 		if (multiPath->caller != nullptr)
 			multiPath->caller->UnBlock();
 
-		if (extendMedResPath)
+		// flow-paths have no low-res part; instead of extending, descend the
+		// field again from the caller's current block in case it was pushed
+		// off course (the old med-res path is kept if the field is gone, and
+		// no more retracing is needed once the max-res part reaches the goal)
+		if (multiPath->flowFieldKey != -1u && medResPath.path.empty())
+			multiPath->flowFieldKey = -1u;
+
+		if (multiPath->flowFieldKey != -1u) {
+			IPath::Path flowPath;
+
+			if (pathFlowFields->TracePath(*multiPath->moveDef, multiPath->flowFieldKey, callerPos, flowPath))
+				medResPath = std::move(flowPath);
+		} else if (extendMedResPath) {
 			LowRes2MedRes(*multiPath, callerPos, owner, synced);
+		}
 
 		MedRes2MaxRes(*multiPath, callerPos, owner, synced);
 
@@ -635,6 +683,7 @@ void CPathManager::Update()
 	assert(IsFinalized());
 
 	pathFlowMap->Update();
+	pathFlowFields->Update();
 	pathHeatMap->Update();
 
 	medResPE->Update();
@@ -802,3 +851,12 @@ int2 CPathManager::GetNumQueuedUpdates() const {
 	return data;
 }
 
+bool CPathManager::GetPathCacheStats(PathCacheStats& stats, bool synced) const {
+	if (!IsFinalized())
+		return false;
+
+	stats  = medResPE->pathCache[synced]->GetStats();
+	stats += lowResPE->pathCache[synced]->GetStats();
+	return true;
+}
+
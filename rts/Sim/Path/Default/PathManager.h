@@ -14,6 +14,7 @@ class CSolidObject;
 class CPathFinder;
 class CPathEstimator;
 class PathFlowMap;
+class PathFlowFields;
 class PathHeatMap;
 class CPathFinderDef;
 struct MoveDef;
@@ -21,13 +22,14 @@ struct MoveDef;
 class CPathManager: public IPathManager {
 public:
 	struct MultiPath {
-		MultiPath(): moveDef(nullptr), caller(nullptr) {}
+		MultiPath(): moveDef(nullptr), caller(nullptr), flowFieldKey(-1u) {}
 		MultiPath(const MoveDef* moveDef, const float3& startPos, const float3& goalPos, float goalRadius)
 			: searchResult(IPath::Error)
 			, start(startPos)
 			, peDef(startPos, goalPos, goalRadius, 3.0f, 2000)
 			, moveDef(moveDef)
 			, caller(nullptr)
+			, flowFieldKey(-1u)
 		{}
 
 		MultiPath(const MultiPath& mp) = delete;
@@ -48,6 +50,8 @@ public:
 			moveDef = mp.moveDef;
 			caller  = mp.caller;
 
+			flowFieldKey = mp.flowFieldKey;
+
 			mp.moveDef = nullptr;
 			mp.caller  = nullptr;
 			return *this;
@@ -70,6 +74,9 @@ public:
 
 		// additional information
 		CSolidObject* caller;
+
+		// if not -1u, the med-res path is (re)traced from this shared field
+		unsigned int flowFieldKey;
 	};
 
 public:
@@ -145,6 +152,7 @@ public:
 	const float* GetNodeExtraCosts(bool) const override;
 
 	int2 GetNumQueuedUpdates() const override;
+	bool GetPathCacheStats(PathCacheStats& stats, bool synced) const override;
 
 
 	const CPathFinder* GetMaxResPF() const { return maxResPF; }
@@ -157,6 +165,13 @@ public:
 	const spring::unordered_map<unsigned int, MultiPath>& GetPathMap() const { return pathMap; }
 
 private:
+	IPath::SearchResult ArrangeFlowPath(
+		MultiPath* newPath,
+		const MoveDef* moveDef,
+		const float3& startPos,
+		const float3& goalPos
+	);
+
 	IPath::SearchResult ArrangePath(
 		MultiPath* newPath,
 		const MoveDef* moveDef,
@@ -193,6 +208,7 @@ private:
 	CPathEstimator* lowResPE;
 
 	PathFlowMap* pathFlowMap;
+	PathFlowFields* pathFlowFields;
 	PathHeatMap* pathHeatMap;
 
 	spring::unordered_map<unsigned int, MultiPath> pathMap;
@@ -13,6 +13,31 @@
 struct MoveDef;
 class CSolidObject;
 
+// counters are cumulative, sizes are in bytes
+struct PathCacheStats {
+	PathCacheStats& operator += (const PathCacheStats& s) {
+		numHits        += s.numHits;
+		numMisses      += s.numMisses;
+		numEvictions   += s.numEvictions;
+		numExpirations += s.numExpirations;
+		numItems       += s.numItems;
+		maxNumItems    += s.maxNumItems;
+		memUsage       += s.memUsage;
+		memBudget      += s.memBudget;
+		return *this;
+	}
+
+	std::uint64_t numHits = 0;
+	std::uint64_t numMisses = 0;
+	std::uint64_t numEvictions = 0; // LRU paths dropped to stay within budget
+	std::uint64_t numExpirations = 0; // paths dropped at the end of their lifetime
+
+	std::uint64_t numItems = 0;
+	std::uint64_t maxNumItems = 0;
+	std::uint64_t memUsage = 0;
+	std::uint64_t memBudget = 0;
+};
+
 class IPathManager {
 public:
 	static IPathManager* GetInstance(int type);
@@ -171,6 +196,8 @@ public:
 	virtual const float* GetNodeExtraCosts(bool synced) const { return nullptr; }
 
 	virtual int2 GetNumQueuedUpdates() const { return (int2(0, 0)); }
+	// summed over the synced or unsynced caches of all estimators; false if there are none
+	virtual bool GetPathCacheStats(PathCacheStats& stats, bool synced) const { return false; }
 
 	virtual bool SupportsMultiThreadedRequests() const { return false; }
 	virtual void SavePathCacheForPathId(int pathIdToSave) {};
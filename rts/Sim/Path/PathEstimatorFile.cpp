@@ -0,0 +1,196 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+
+#include "PathEstimatorFile.h"
+#include "System/CRC.h"
+#include "System/FileSystem/MemoryMappedFile.h"
+#include "System/Log/ILog.h"
+#include "System/Platform/Win/win32.h"
+
+namespace PathEstimatorFile {
+	struct Header {
+		char magic[8];
+
+		std::uint32_t version;
+		std::uint32_t hashCode;
+
+		std::uint32_t numPathTypes;
+		std::uint32_t numBlocks;   // offsets per path-type
+		std::uint32_t numVertices; // vertex costs
+
+		std::uint32_t dataChecksum; // over both sections, padding excluded
+
+		std::uint64_t offsetsPos;
+		std::uint64_t costsPos;
+
+		// over all preceding bytes
+		std::uint32_t headerChecksum;
+		std::uint32_t padding;
+	};
+
+	static_assert(sizeof(Header) == 56, "");
+	static_assert(sizeof(Header) <= SECTION_ALIGNMENT, "");
+
+	static constexpr char MAGIC[sizeof(Header::magic)] = {'S', 'P', 'R', 'I', 'N', 'G', 'P', 'E'};
+
+
+	static std::uint64_t AlignUp(std::uint64_t pos) {
+		return ((pos + SECTION_ALIGNMENT - 1) & ~std::uint64_t(SECTION_ALIGNMENT - 1));
+	}
+
+	static std::uint32_t CalcHeaderChecksum(const Header& header) {
+		return (CRC::CalcDigest(&header, offsetof(Header, headerChecksum)));
+	}
+
+	static bool WritePadding(FILE* file, std::uint64_t pos) {
+		static const char zeros[SECTION_ALIGNMENT] = {0};
+
+		const long curPos = ftell(file);
+
+		if (curPos < 0 || std::uint64_t(curPos) > pos)
+			return false;
+
+		return (fwrite(zeros, 1, pos - curPos, file) == (pos - curPos));
+	}
+
+	// atomically replaces <dstPath>, so it exists at any point in time
+	static bool ReplaceFile(const std::string& srcPath, const std::string& dstPath) {
+	#ifdef _WIN32
+		// rename() fails there if the destination exists
+		return (MoveFileExA(srcPath.c_str(), dstPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+	#else
+		return (rename(srcPath.c_str(), dstPath.c_str()) == 0);
+	#endif
+	}
+
+
+	bool Write(
+		const std::string& filePath,
+		std::uint32_t hashCode,
+		const std::vector< std::vector<short2> >& nodeOffsets,
+		const std::vector<float>& vertexCosts
+	) {
+		const std::string tempPath = filePath + ".tmp";
+
+		Header header;
+		CRC dataCRC;
+
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, MAGIC, sizeof(header.magic));
+
+		header.version = FORMAT_VERSION;
+		header.hashCode = hashCode;
+		header.numPathTypes = nodeOffsets.size();
+		header.numBlocks = nodeOffsets.empty()? 0: nodeOffsets[0].size();
+		header.numVertices = vertexCosts.size();
+
+		for (const auto& offsets: nodeOffsets) {
+			if (offsets.size() != header.numBlocks)
+				return false;
+
+			dataCRC.Update(offsets.data(), offsets.size() * sizeof(short2));
+		}
+
+		dataCRC.Update(vertexCosts.data(), vertexCosts.size() * sizeof(float));
+
+		header.dataChecksum = dataCRC.GetDigest();
+		header.offsetsPos = AlignUp(sizeof(Header));
+		header.costsPos = AlignUp(header.offsetsPos + std::uint64_t(header.numPathTypes) * header.numBlocks * sizeof(short2));
+		header.headerChecksum = CalcHeaderChecksum(header);
+
+		// write to a temporary first, concurrent loads must never see a partial file
+		FILE* file = fopen(tempPath.c_str(), "wb");
+
+		if (file == nullptr)
+			return false;
+
+		bool ret = (fwrite(&header, sizeof(header), 1, file) == 1);
+
+		ret = ret && WritePadding(file, header.offsetsPos);
+
+		for (const auto& offsets: nodeOffsets) {
+			ret = ret && (fwrite(offsets.data(), sizeof(short2), offsets.size(), file) == offsets.size());
+		}
+
+		ret = ret && WritePadding(file, header.costsPos);
+		ret = ret && (fwrite(vertexCosts.data(), sizeof(float), vertexCosts.size(), file) == vertexCosts.size());
+		ret = (fclose(file) == 0) && ret;
+
+		ret = ret && ReplaceFile(tempPath, filePath);
+
+		if (!ret)
+			remove(tempPath.c_str());
+
+		return ret;
+	}
+
+
+	bool Read(
+		const std::string& filePath,
+		std::uint32_t hashCode,
+		std::vector< std::vector<short2> >& nodeOffsets,
+		std::vector<float>& vertexCosts
+	) {
+		CMemoryMappedFile file(filePath);
+
+		if (!file.IsOpen())
+			return false;
+
+		if (file.GetSize() < sizeof(Header)) {
+			LOG_L(L_WARNING, "[PathEstimatorFile::%s] \"%s\" is truncated", __func__, filePath.c_str());
+			return false;
+		}
+
+		Header header;
+		memcpy(&header, file.GetData(), sizeof(header));
+
+		if (memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0 || header.headerChecksum != CalcHeaderChecksum(header)) {
+			LOG_L(L_WARNING, "[PathEstimatorFile::%s] \"%s\" has a corrupt header", __func__, filePath.c_str());
+			return false;
+		}
+
+		// not an error, just stale
+		if (header.version != FORMAT_VERSION || header.hashCode != hashCode)
+			return false;
+
+		if (header.numPathTypes != nodeOffsets.size() || header.numVertices != vertexCosts.size())
+			return false;
+
+		for (const auto& offsets: nodeOffsets) {
+			if (offsets.size() != header.numBlocks)
+				return false;
+		}
+
+		const std::uint64_t offsetsSize = std::uint64_t(header.numPathTypes) * header.numBlocks * sizeof(short2);
+		const std::uint64_t costsSize = std::uint64_t(header.numVertices) * sizeof(float);
+
+		if (header.offsetsPos < sizeof(Header) || header.costsPos < (header.offsetsPos + offsetsSize) || file.GetSize() < (header.costsPos + costsSize)) {
+			LOG_L(L_WARNING, "[PathEstimatorFile::%s] \"%s\" is truncated", __func__, filePath.c_str());
+			return false;
+		}
+
+		CRC dataCRC;
+
+		const std::uint8_t* offsetsData = file.GetData() + header.offsetsPos;
+		const std::uint8_t* costsData = file.GetData() + header.costsPos;
+
+		dataCRC.Update(offsetsData, offsetsSize);
+		dataCRC.Update(costsData, costsSize);
+
+		if (dataCRC.GetDigest() != header.dataChecksum) {
+			LOG_L(L_WARNING, "[PathEstimatorFile::%s] \"%s\" has corrupt data", __func__, filePath.c_str());
+			return false;
+		}
+
+		for (auto& offsets: nodeOffsets) {
+			memcpy(offsets.data(), offsetsData, offsets.size() * sizeof(short2));
+			offsetsData += (offsets.size() * sizeof(short2));
+		}
+
+		memcpy(vertexCosts.data(), costsData, costsSize);
+		return true;
+	}
+}
@@ -0,0 +1,48 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PATH_ESTIMATOR_FILE_H
+#define PATH_ESTIMATOR_FILE_H
+
+#include <string>
+#include <vector>
+#include <cinttypes>
+
+#include "System/type2.h"
+
+/**
+ * On-disk cache of the precomputed path-estimator data (per-pathtype block
+ * center offsets and vertex costs), shared by the Default and TKPFS PE's.
+ *
+ * The file is stored uncompressed: a header followed by the offset- and
+ * cost-sections, each starting on a page boundary, so it can be memory-
+ * mapped and copied straight into the estimator arrays without inflating
+ * anything. The header is protected by its own CRC (rejected before any
+ * data is touched), the sections by a second CRC.
+ */
+namespace PathEstimatorFile {
+	static constexpr std::uint32_t FORMAT_VERSION = 1;
+	static constexpr std::uint32_t SECTION_ALIGNMENT = 4096;
+
+	static constexpr const char* FILE_EXTENSION = ".pecache";
+	// zip archives written before this format, deleted once replaced
+	static constexpr const char* LEGACY_FILE_EXTENSION = ".zip";
+
+	// takes absolute paths; any existing file is replaced atomically
+	bool Write(
+		const std::string& filePath,
+		std::uint32_t hashCode,
+		const std::vector< std::vector<short2> >& nodeOffsets,
+		const std::vector<float>& vertexCosts
+	);
+
+	// <nodeOffsets> and <vertexCosts> must already have their final sizes,
+	// a file that does not match them (or <hashCode>) is rejected
+	bool Read(
+		const std::string& filePath,
+		std::uint32_t hashCode,
+		std::vector< std::vector<short2> >& nodeOffsets,
+		std::vector<float>& vertexCosts
+	);
+}
+
+#endif // PATH_ESTIMATOR_FILE_H
@@ -190,6 +190,7 @@ void QTPFS::QTNode::InitStatic() {
 
 void QTPFS::QTNode::Init(
 	const QTNode* /*parent*/,
+	unsigned int ni,
 	unsigned int nn,
 	unsigned int x1, unsigned int z1,
 	unsigned int x2, unsigned int z2
@@ -198,6 +199,7 @@ void QTPFS::QTNode::Init(
 	assert(MIN_SIZE_Z > 0);
 
 	nodeNumber = nn;
+	nodeIndex = ni;
 	heapIndex = -1u;
 
 	searchState  =   0;
@@ -225,25 +227,12 @@ void QTPFS::QTNode::Init(
 
 	prevNode = nullptr;
 
-	neighbors.clear();
-	netpoints.clear();
-}
-
-
-
-std::uint64_t QTPFS::QTNode::GetMemFootPrint(const NodeLayer& nl) const {
-	std::uint64_t memFootPrint = sizeof(QTNode);
-
-	if (IsLeaf()) {
-		memFootPrint += (neighbors.size() * sizeof(decltype(neighbors)::value_type));
-		memFootPrint += (netpoints.size() * sizeof(decltype(netpoints)::value_type));
-	} else {
-		for (unsigned int i = 0; i < QTNODE_CHILD_COUNT; i++) {
-			memFootPrint += (nl.GetPoolNode(childBaseIndex + i)->GetMemFootPrint(nl));
-		}
-	}
+	// any previous range was released by NodeLayer::FreePoolNode
+	neighborsIndex = 0;
+	numNeighbors = 0;
+	maxNumNeighbors = 0;
 
-	return memFootPrint;
+	edgeTransitionPoint = {0.0f, 0.0f};
 }
 
 std::uint64_t QTPFS::QTNode::GetCheckSum(const NodeLayer& nl) const {
@@ -330,8 +319,7 @@ bool QTPFS::QTNode::Split(NodeLayer& nl, unsigned int depth, bool forced) {
 
 	childBaseIndex = childIndices[0];
 
-	neighbors.clear();
-	netpoints.clear();
+	ClearNeighborCache(nl);
 
 	nl.SetNumLeafNodes(nl.GetNumLeafNodes() + (4 - 1));
 	assert(!IsLeaf());
@@ -342,9 +330,6 @@ bool QTPFS::QTNode::Merge(NodeLayer& nl) {
 	if (IsLeaf())
 		return false;
 
-	neighbors.clear();
-	// netpoints.clear();
-
 	// get rid of our children completely
 	for (unsigned int i = 0; i < QTNODE_CHILD_COUNT; i++) {
 		nl.GetPoolNode(childBaseIndex + i)->Merge(nl);
@@ -679,202 +664,179 @@ void QTPFS::QTNode::Serialize(std::fstream& fStream, NodeLayer& nodeLayer, unsig
 	}
 }
 
-unsigned int QTPFS::QTNode::GetNeighbors(const std::vector<INode*>& nodes, std::vector<INode*>& ngbs) {
+unsigned int QTPFS::QTNode::GetNeighbors(NodeLayer& nl) {
 	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
-	UpdateNeighborCache(nodes);
+	UpdateNeighborCache(nl);
 	#endif
-
-	if (!neighbors.empty()) {
-		ngbs.clear();
-		ngbs.resize(neighbors.size());
-
-		std::copy(neighbors.begin(), neighbors.end(), ngbs.begin());
-	}
-
-	return (neighbors.size());
+	return numNeighbors;
 }
 
-const std::vector<QTPFS::INode*>& QTPFS::QTNode::GetNeighbors(const std::vector<INode*>& nodes) {
-	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
-	UpdateNeighborCache(nodes);
-	#endif
-	return neighbors;
+void QTPFS::QTNode::ClearNeighborCache(NodeLayer& nl) {
+	nl.FreeNeighborSlots(maxNumNeighbors);
+
+	neighborsIndex = 0;
+	numNeighbors = 0;
+	maxNumNeighbors = 0;
 }
 
 // this is *either* called from ::GetNeighbors when the conservative
 // update-scheme is enabled, *or* from PM::ExecQueuedNodeLayerUpdates
 // (never both)
-bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
+bool QTPFS::QTNode::UpdateNeighborCache(NodeLayer& nl) {
 	assert(IsLeaf());
-	assert(!nodes.empty());
-
-	if (prevMagicNum != currMagicNum) {
-		prevMagicNum = currMagicNum;
 
-		unsigned int ngbRels = 0;
-		unsigned int maxNgbs = GetMaxNumNeighbors();
+	if (prevMagicNum == currMagicNum)
+		return false;
 
-		// regenerate our neighbor cache
-		if (maxNgbs > 0) {
-			neighbors.clear();
-			neighbors.reserve(maxNgbs + 4);
+	prevMagicNum = currMagicNum;
 
-			netpoints.clear();
-			netpoints.reserve(1 + maxNgbs * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + 4);
-			// NOTE: caching ETP's breaks QTPFS_ORTHOPROJECTED_EDGE_TRANSITIONS
-			// NOTE: [0] is a reserved index and must always be valid
-			netpoints.emplace_back();
+	if (GetMaxNumNeighbors() == 0) {
+		ClearNeighborCache(nl);
+		return true;
+	}
 
-			INode* ngb = nullptr;
+	// collect the indices first, the range is only (re-)allocated
+	// once their number is known so the packed arrays stay dense
+	std::vector<unsigned int>& ngbs = nl.GetTempNeighbors();
 
-			if (xmin() > 0) {
-				const unsigned int hmx = xmin() - 1;
+	unsigned int ngbRels = 0;
 
-				// walk along EDGE_L (west) neighbors
-				for (unsigned int hmz = zmin(); hmz < zmax(); ) {
-					ngb = nodes[hmz * mapDims.mapx + hmx];
-					hmz = ngb->zmax();
+	ngbs.clear();
 
-					neighbors.push_back(ngb);
+	if (xmin() > 0) {
+		const unsigned int hmx = xmin() - 1;
 
-					for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-						netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngb, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-					}
-				}
+		// walk along EDGE_L (west) neighbors
+		for (unsigned int hmz = zmin(); hmz < zmax(); ) {
+			const INode* ngb = nl.GetNode(hmx, hmz);
+			hmz = ngb->zmax();
 
-				ngbRels |= REL_NGB_EDGE_L;
-			}
-			if (xmax() < static_cast<unsigned int>(mapDims.mapx)) {
-				const unsigned int hmx = xmax() + 0;
+			ngbs.push_back(ngb->GetIndex());
+		}
 
-				// walk along EDGE_R (east) neighbors
-				for (unsigned int hmz = zmin(); hmz < zmax(); ) {
-					ngb = nodes[hmz * mapDims.mapx + hmx];
-					hmz = ngb->zmax();
+		ngbRels |= REL_NGB_EDGE_L;
+	}
+	if (xmax() < static_cast<unsigned int>(mapDims.mapx)) {
+		const unsigned int hmx = xmax() + 0;
 
-					neighbors.push_back(ngb);
+		// walk along EDGE_R (east) neighbors
+		for (unsigned int hmz = zmin(); hmz < zmax(); ) {
+			const INode* ngb = nl.GetNode(hmx, hmz);
+			hmz = ngb->zmax();
 
-					for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-						netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngb, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-					}
-				}
+			ngbs.push_back(ngb->GetIndex());
+		}
 
-				ngbRels |= REL_NGB_EDGE_R;
-			}
+		ngbRels |= REL_NGB_EDGE_R;
+	}
 
-			if (zmin() > 0) {
-				const unsigned int hmz = zmin() - 1;
+	if (zmin() > 0) {
+		const unsigned int hmz = zmin() - 1;
 
-				// walk along EDGE_T (north) neighbors
-				for (unsigned int hmx = xmin(); hmx < xmax(); ) {
-					ngb = nodes[hmz * mapDims.mapx + hmx];
-					hmx = ngb->xmax();
+		// walk along EDGE_T (north) neighbors
+		for (unsigned int hmx = xmin(); hmx < xmax(); ) {
+			const INode* ngb = nl.GetNode(hmx, hmz);
+			hmx = ngb->xmax();
 
-					neighbors.push_back(ngb);
+			ngbs.push_back(ngb->GetIndex());
+		}
 
-					for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-						netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngb, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-					}
-				}
+		ngbRels |= REL_NGB_EDGE_T;
+	}
+	if (zmax() < static_cast<unsigned int>(mapDims.mapy)) {
+		const unsigned int hmz = zmax() + 0;
 
-				ngbRels |= REL_NGB_EDGE_T;
-			}
-			if (zmax() < static_cast<unsigned int>(mapDims.mapy)) {
-				const unsigned int hmz = zmax() + 0;
+		// walk along EDGE_B (south) neighbors
+		for (unsigned int hmx = xmin(); hmx < xmax(); ) {
+			const INode* ngb = nl.GetNode(hmx, hmz);
+			hmx = ngb->xmax();
 
-				// walk along EDGE_B (south) neighbors
-				for (unsigned int hmx = xmin(); hmx < xmax(); ) {
-					ngb = nodes[hmz * mapDims.mapx + hmx];
-					hmx = ngb->xmax();
+			ngbs.push_back(ngb->GetIndex());
+		}
 
-					neighbors.push_back(ngb);
+		ngbRels |= REL_NGB_EDGE_B;
+	}
 
-					for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-						netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngb, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-					}
+	#ifdef QTPFS_CORNER_CONNECTED_NODES
+	// top- and bottom-left corners
+	if ((ngbRels & REL_NGB_EDGE_L) != 0) {
+		if ((ngbRels & REL_NGB_EDGE_T) != 0) {
+			const INode* ngbL = nl.GetNode(xmin() - 1, zmin() + 0);
+			const INode* ngbT = nl.GetNode(xmin() + 0, zmin() - 1);
+			const INode* ngbC = nl.GetNode(xmin() - 1, zmin() - 1);
+
+			// VERT_TL ngb must be distinct from EDGE_L and EDGE_T ngbs
+			if (ngbC != ngbL && ngbC != ngbT) {
+				if (ngbL->AllSquaresAccessible() && ngbT->AllSquaresAccessible()) {
+					ngbs.push_back(ngbC->GetIndex());
 				}
-
-				ngbRels |= REL_NGB_EDGE_B;
 			}
-
-			#ifdef QTPFS_CORNER_CONNECTED_NODES
-			// top- and bottom-left corners
-			if ((ngbRels & REL_NGB_EDGE_L) != 0) {
-				if ((ngbRels & REL_NGB_EDGE_T) != 0) {
-					const INode* ngbL = nodes[(zmin() + 0) * mapDims.mapx + (xmin() - 1)];
-					const INode* ngbT = nodes[(zmin() - 1) * mapDims.mapx + (xmin() + 0)];
-						  INode* ngbC = nodes[(zmin() - 1) * mapDims.mapx + (xmin() - 1)];
-
-					// VERT_TL ngb must be distinct from EDGE_L and EDGE_T ngbs
-					if (ngbC != ngbL && ngbC != ngbT) {
-						if (ngbL->AllSquaresAccessible() && ngbT->AllSquaresAccessible()) {
-							neighbors.push_back(ngbC);
-
-							for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-								netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngbC, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-							}
-						}
-					}
-				}
-				if ((ngbRels & REL_NGB_EDGE_B) != 0) {
-					const INode* ngbL = nodes[(zmax() - 1) * mapDims.mapx + (xmin() - 1)];
-					const INode* ngbB = nodes[(zmax() + 0) * mapDims.mapx + (xmin() + 0)];
-						  INode* ngbC = nodes[(zmax() + 0) * mapDims.mapx + (xmin() - 1)];
-
-					// VERT_BL ngb must be distinct from EDGE_L and EDGE_B ngbs
-					if (ngbC != ngbL && ngbC != ngbB) {
-						if (ngbL->AllSquaresAccessible() && ngbB->AllSquaresAccessible()) {
-							neighbors.push_back(ngbC);
-
-							for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-								netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngbC, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-							}
-						}
-					}
+		}
+		if ((ngbRels & REL_NGB_EDGE_B) != 0) {
+			const INode* ngbL = nl.GetNode(xmin() - 1, zmax() - 1);
+			const INode* ngbB = nl.GetNode(xmin() + 0, zmax() + 0);
+			const INode* ngbC = nl.GetNode(xmin() - 1, zmax() + 0);
+
+			// VERT_BL ngb must be distinct from EDGE_L and EDGE_B ngbs
+			if (ngbC != ngbL && ngbC != ngbB) {
+				if (ngbL->AllSquaresAccessible() && ngbB->AllSquaresAccessible()) {
+					ngbs.push_back(ngbC->GetIndex());
 				}
 			}
+		}
+	}
 
-			// top- and bottom-right corners
-			if ((ngbRels & REL_NGB_EDGE_R) != 0) {
-				if ((ngbRels & REL_NGB_EDGE_T) != 0) {
-					const INode* ngbR = nodes[(zmin() + 0) * mapDims.mapx + (xmax() + 0)];
-					const INode* ngbT = nodes[(zmin() - 1) * mapDims.mapx + (xmax() - 1)];
-						  INode* ngbC = nodes[(zmin() - 1) * mapDims.mapx + (xmax() + 0)];
-
-					// VERT_TR ngb must be distinct from EDGE_R and EDGE_T ngbs
-					if (ngbC != ngbR && ngbC != ngbT) {
-						if (ngbR->AllSquaresAccessible() && ngbT->AllSquaresAccessible()) {
-							neighbors.push_back(ngbC);
-
-							for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-								netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngbC, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-							}
-						}
-					}
+	// top- and bottom-right corners
+	if ((ngbRels & REL_NGB_EDGE_R) != 0) {
+		if ((ngbRels & REL_NGB_EDGE_T) != 0) {
+			const INode* ngbR = nl.GetNode(xmax() + 0, zmin() + 0);
+			const INode* ngbT = nl.GetNode(xmax() - 1, zmin() - 1);
+			const INode* ngbC = nl.GetNode(xmax() + 0, zmin() - 1);
+
+			// VERT_TR ngb must be distinct from EDGE_R and EDGE_T ngbs
+			if (ngbC != ngbR && ngbC != ngbT) {
+				if (ngbR->AllSquaresAccessible() && ngbT->AllSquaresAccessible()) {
+					ngbs.push_back(ngbC->GetIndex());
 				}
-				if ((ngbRels & REL_NGB_EDGE_B) != 0) {
-					const INode* ngbR = nodes[(zmax() - 1) * mapDims.mapx + (xmax() + 0)];
-					const INode* ngbB = nodes[(zmax() + 0) * mapDims.mapx + (xmax() - 1)];
-						  INode* ngbC = nodes[(zmax() + 0) * mapDims.mapx + (xmax() + 0)];
-
-					// VERT_BR ngb must be distinct from EDGE_R and EDGE_B ngbs
-					if (ngbC != ngbR && ngbC != ngbB) {
-						if (ngbR->AllSquaresAccessible() && ngbB->AllSquaresAccessible()) {
-							neighbors.push_back(ngbC);
-
-							for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-								netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngbC, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-							}
-						}
-					}
+			}
+		}
+		if ((ngbRels & REL_NGB_EDGE_B) != 0) {
+			const INode* ngbR = nl.GetNode(xmax() + 0, zmax() - 1);
+			const INode* ngbB = nl.GetNode(xmax() - 1, zmax() + 0);
+			const INode* ngbC = nl.GetNode(xmax() + 0, zmax() + 0);
+
+			// VERT_BR ngb must be distinct from EDGE_R and EDGE_B ngbs
+			if (ngbC != ngbR && ngbC != ngbB) {
+				if (ngbR->AllSquaresAccessible() && ngbB->AllSquaresAccessible()) {
+					ngbs.push_back(ngbC->GetIndex());
 				}
 			}
-			#endif
 		}
+	}
+	#endif
 
-		return true;
+	// reuse our range if the new neighbors fit, otherwise move to a fresh one
+	if (ngbs.size() > maxNumNeighbors) {
+		nl.FreeNeighborSlots(maxNumNeighbors);
+
+		neighborsIndex = nl.AllocNeighborSlots(ngbs.size());
+		maxNumNeighbors = ngbs.size();
 	}
 
-	return false;
-}
+	numNeighbors = ngbs.size();
+
+	unsigned int* ngbIndices = nl.GetNeighbors(neighborsIndex);
+	float2* ngbNetPoints = nl.GetNetPoints(neighborsIndex);
 
+	for (unsigned int i = 0; i < numNeighbors; i++) {
+		// neighbors are never the root; a leaf root has none
+		const INode* ngb = nl.GetPoolNode(ngbIndices[i] = ngbs[i]);
+
+		// NOTE: caching ETP's breaks QTPFS_ORTHOPROJECTED_EDGE_TRANSITIONS
+		for (unsigned int j = 0; j < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; j++) {
+			ngbNetPoints[i * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + j] = INode::GetNeighborEdgeTransitionPoint(ngb, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (j + 1));
+		}
+	}
+
+	return true;
+}
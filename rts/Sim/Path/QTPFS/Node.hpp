@@ -38,12 +38,11 @@ namespace QTPFS {
 
 		#ifdef QTPFS_VIRTUAL_NODE_FUNCTIONS
 		virtual void Serialize(std::fstream&, NodeLayer&, unsigned int*, unsigned int, bool) = 0;
-		virtual unsigned int GetNeighbors(const std::vector<INode*>&, std::vector<INode*>&) = 0;
-		virtual const std::vector<INode*>& GetNeighbors(const std::vector<INode*>& v) = 0;
-		virtual bool UpdateNeighborCache(const std::vector<INode*>& nodes) = 0;
+		virtual unsigned int GetNeighbors(NodeLayer& nl) = 0;
+		virtual bool UpdateNeighborCache(NodeLayer& nl) = 0;
 
-		virtual void SetNeighborEdgeTransitionPoint(unsigned int ngbIdx, const float2& point) = 0;
-		virtual const float2& GetNeighborEdgeTransitionPoint(unsigned int ngbIdx) const = 0;
+		virtual void SetEdgeTransitionPoint(const float2& point) = 0;
+		virtual const float2& GetEdgeTransitionPoint() const = 0;
 		#endif
 
 		unsigned int GetNeighborRelation(const INode* ngb) const;
@@ -85,6 +84,9 @@ namespace QTPFS {
 		void SetPrevNode(INode* n) { prevNode = n; }
 		INode* GetPrevNode() { return prevNode; }
 
+		// index of this node in its layer's pool (or NodeLayer::ROOT_NODE_INDEX)
+		unsigned int GetIndex() const { return nodeIndex; }
+
 	protected:
 		// NOTE:
 		//     storing the heap-index is an *UGLY* break of abstraction,
@@ -96,6 +98,9 @@ namespace QTPFS {
 		float gCost = 0.0f;
 		float hCost = 0.0f;
 
+		// fills the padding before prevNode
+		unsigned int nodeIndex = -1u;
+
 		// points back to previous node in path
 		INode* prevNode = nullptr;
 
@@ -120,6 +125,7 @@ namespace QTPFS {
 
 		void Init(
 			const QTNode* parent,
+			unsigned int ni,
 			unsigned int nn,
 			unsigned int x1, unsigned int z1,
 			unsigned int x2, unsigned int z2
@@ -131,7 +137,6 @@ namespace QTPFS {
 		unsigned int GetChildID(unsigned int i) const { return (nodeNumber << 2) + (i + 1); }
 		unsigned int GetParentID() const { return ((nodeNumber - 1) >> 2); }
 
-		std::uint64_t GetMemFootPrint(const NodeLayer& nl) const;
 		std::uint64_t GetCheckSum(const NodeLayer& nl) const;
 
 		void PreTesselate(NodeLayer& nl, const SRectangle& r, SRectangle& ur, unsigned int depth);
@@ -145,12 +150,19 @@ namespace QTPFS {
 		bool Merge(NodeLayer& nl);
 
 		unsigned int GetMaxNumNeighbors() const;
-		unsigned int GetNeighbors(const std::vector<INode*>&, std::vector<INode*>&);
-		const std::vector<INode*>& GetNeighbors(const std::vector<INode*>&);
-		bool UpdateNeighborCache(const std::vector<INode*>& nodes);
+		// returns the number of neighbors, their indices and edge transition
+		// points start at NodeLayer::Get{Neighbor,NetPoint}s(GetNeighborsIndex())
+		unsigned int GetNeighbors(NodeLayer& nl);
+		unsigned int GetNumNeighbors() const { return numNeighbors; }
+		unsigned int GetNeighborsIndex() const { return neighborsIndex; }
+		void SetNeighborsRange(unsigned int idx, unsigned int num) { neighborsIndex = idx; numNeighbors = num; maxNumNeighbors = num; }
 
-		void SetNeighborEdgeTransitionPoint(unsigned int ngbIdx, const float2& point) { netpoints[ngbIdx] = point; }
-		const float2& GetNeighborEdgeTransitionPoint(unsigned int ngbIdx) const { return netpoints[ngbIdx]; }
+		bool UpdateNeighborCache(NodeLayer& nl);
+		void ClearNeighborCache(NodeLayer& nl);
+
+		// transition point through which the current search entered this node
+		void SetEdgeTransitionPoint(const float2& point) { edgeTransitionPoint = point; }
+		const float2& GetEdgeTransitionPoint() const { return edgeTransitionPoint; }
 
 		unsigned int xmin() const { return (_xminxmax  & 0xFFFF); }
 		unsigned int zmin() const { return (_zminzmax  & 0xFFFF); }
@@ -207,8 +219,13 @@ namespace QTPFS {
 
 		unsigned int childBaseIndex = -1u;
 
-		std::vector<INode*> neighbors;
-		std::vector<float2> netpoints;
+		// [neighborsIndex, neighborsIndex + maxNumNeighbors) is owned by
+		// this node in its layer's packed neighbor and net-point arrays
+		unsigned int neighborsIndex = 0;
+		unsigned int numNeighbors = 0;
+		unsigned int maxNumNeighbors = 0;
+
+		float2 edgeTransitionPoint;
 	};
 }
 
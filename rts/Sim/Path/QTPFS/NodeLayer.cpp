@@ -27,7 +27,7 @@ void QTPFS::NodeLayer::InitStatic() {
 void QTPFS::NodeLayer::RegisterNode(INode* n) {
 	for (unsigned int hmz = n->zmin(); hmz < n->zmax(); hmz++) {
 		for (unsigned int hmx = n->xmin(); hmx < n->xmax(); hmx++) {
-			nodeGrid[hmz * xsize + hmx] = n;
+			nodeGrid[hmz * xsize + hmx] = n->GetIndex();
 		}
 	}
 }
@@ -42,7 +42,11 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 	xsize = mapDims.mapx;
 	zsize = mapDims.mapy;
 
-	nodeGrid.resize(xsize * zsize, nullptr);
+	nodeGrid.resize(xsize * zsize, -1u);
+
+	nodeNeighbors.clear();
+	nodeNetPoints.clear();
+	numFreeNeighborSlots = 0;
 
 	{
 		// chunks are reserved OTF
@@ -62,6 +66,10 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 void QTPFS::NodeLayer::Clear() {
 	nodeGrid.clear();
 
+	nodeNeighbors.clear();
+	nodeNetPoints.clear();
+	numFreeNeighborSlots = 0;
+
 	curSpeedMods.clear();
 	oldSpeedMods.clear();
 	oldSpeedBins.clear();
@@ -256,14 +264,14 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 			unsigned int zspan = zsize;
 
 			for (int x = xmin; x < xmax; ) {
-				n = nodeGrid[z * xsize + x];
+				n = GetNode(x, z);
 				x = n->xmax();
 
 				zspan = std::min(zspan, n->zmax() - z);
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->GetNeighbors(*this);
 			}
 
 			z += zspan;
@@ -278,14 +286,14 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 			unsigned int zspan = zsize;
 
 			for (int x = xmin; x < xmax; ) {
-				n = nodeGrid[z * xsize + x];
+				n = GetNode(x, z);
 				x = n->xmax();
 
 				zspan = std::min(zspan, n->zmax() - z);
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->GetNeighbors(*this);
 			}
 
 			z += zspan;
@@ -300,14 +308,14 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 			unsigned int zspan = zsize;
 
 			for (int x = xmin; x < xmax; ) {
-				n = nodeGrid[z * xsize + x];
+				n = GetNode(x, z);
 				x = n->xmax();
 
 				zspan = std::min(zspan, n->zmax() - z);
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->GetNeighbors(*this);
 			}
 
 			z += zspan;
@@ -322,14 +330,14 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 			unsigned int zspan = zsize;
 
 			for (int x = xmin; x < xmax; ) {
-				n = nodeGrid[z * xsize + x];
+				n = GetNode(x, z);
 				x = n->xmax();
 
 				zspan = std::min(zspan, n->zmax() - z);
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->GetNeighbors(*this);
 			}
 
 			z += zspan;
@@ -353,7 +361,7 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdates(const SRectangle& ur, unsign
 		unsigned int zspan = zsize;
 
 		for (int x = xmin; x < xmax; ) {
-			n = nodeGrid[z * xsize + x];
+			n = GetNode(x, z);
 			x = n->xmax();
 
 			// calculate largest safe z-increment along this row
@@ -364,10 +372,59 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdates(const SRectangle& ur, unsign
 			//   during initialization, currMagicNum == 0 which nodes start with already 
 			//   (does not matter because prevMagicNum == -1, so updates are not no-ops)
 			n->SetMagicNumber(currMagicNum);
-			n->UpdateNeighborCache(nodeGrid);
+			n->UpdateNeighborCache(*this);
 		}
 
 		z += zspan;
 	}
+
+	// ranges of merged or outgrown leaves are only reclaimed in bulk
+	if (numFreeNeighborSlots > (nodeNeighbors.size() >> 1))
+		CompactNeighborSlots();
+}
+
+void QTPFS::NodeLayer::CompactNeighborSlots() {
+	std::vector<unsigned int> newNeighbors;
+	std::vector<float2> newNetPoints;
+	std::vector<INode*> nodeStack;
+
+	newNeighbors.reserve(nodeNeighbors.size() - numFreeNeighborSlots);
+	newNetPoints.reserve(newNeighbors.capacity() * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE);
+	nodeStack.reserve(64);
+	nodeStack.push_back(&rootNode);
+
+	// depth-first, so neighbor ranges of nearby leaves end up close together
+	while (!nodeStack.empty()) {
+		INode* n = nodeStack.back();
+
+		nodeStack.pop_back();
+
+		if (!n->IsLeaf()) {
+			for (unsigned int i = 0; i < QTNODE_CHILD_COUNT; i++) {
+				nodeStack.push_back(GetPoolNode(n->GetChildBaseIndex() + i));
+			}
+
+			continue;
+		}
+
+		const unsigned int oldIdx = n->GetNeighborsIndex();
+		const unsigned int newIdx = newNeighbors.size();
+		const unsigned int numNgbs = n->GetNumNeighbors();
+
+		if (numNgbs == 0) {
+			n->SetNeighborsRange(0, 0);
+			continue;
+		}
+
+		newNeighbors.insert(newNeighbors.end(), nodeNeighbors.begin() + oldIdx, nodeNeighbors.begin() + oldIdx + numNgbs);
+		newNetPoints.insert(newNetPoints.end(), GetNetPoints(oldIdx), GetNetPoints(oldIdx) + numNgbs * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE);
+
+		n->SetNeighborsRange(newIdx, numNgbs);
+	}
+
+	nodeNeighbors.swap(newNeighbors);
+	nodeNetPoints.swap(newNetPoints);
+
+	numFreeNeighborSlots = 0;
 }
 
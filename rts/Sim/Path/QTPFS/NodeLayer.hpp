@@ -66,16 +66,19 @@ namespace QTPFS {
 		void ExecNodeNeighborCacheUpdates(const SRectangle& ur, unsigned int currMagicNum);
 
 		float GetNodeRatio() const { return (numLeafNodes / std::max(1.0f, float(xsize * zsize))); }
-		const INode* GetNode(unsigned int x, unsigned int z) const { return nodeGrid[z * xsize + x]; }
-		      INode* GetNode(unsigned int x, unsigned int z)       { return nodeGrid[z * xsize + x]; }
-		const INode* GetNode(unsigned int i) const { return nodeGrid[i]; }
-		      INode* GetNode(unsigned int i)       { return nodeGrid[i]; }
+		const INode* GetNode(unsigned int x, unsigned int z) const { return GetNodeByIndex(nodeGrid[z * xsize + x]); }
+		      INode* GetNode(unsigned int x, unsigned int z)       { return GetNodeByIndex(nodeGrid[z * xsize + x]); }
+		const INode* GetNode(unsigned int i) const { return GetNodeByIndex(nodeGrid[i]); }
+		      INode* GetNode(unsigned int i)       { return GetNodeByIndex(nodeGrid[i]); }
 
 		const INode* GetPoolNode(unsigned int i) const { return &poolNodes[i / POOL_CHUNK_SIZE][i % POOL_CHUNK_SIZE]; }
 		      INode* GetPoolNode(unsigned int i)       { return &poolNodes[i / POOL_CHUNK_SIZE][i % POOL_CHUNK_SIZE]; }
 
+		const INode* GetNodeByIndex(unsigned int i) const { return ((i == ROOT_NODE_INDEX)? &rootNode: GetPoolNode(i)); }
+		      INode* GetNodeByIndex(unsigned int i)       { return ((i == ROOT_NODE_INDEX)? &rootNode: GetPoolNode(i)); }
+
 		INode* AllocRootNode(const INode* parent, unsigned int nn,  unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2) {
-			rootNode.Init(parent, nn, x1, z1, x2, z2);
+			rootNode.Init(parent, ROOT_NODE_INDEX, nn, x1, z1, x2, z2);
 			return &rootNode;
 		}
 
@@ -88,13 +91,38 @@ namespace QTPFS {
 			if (poolNodes[(idx = nodeIndcs.back()) / POOL_CHUNK_SIZE].empty())
 				poolNodes[idx / POOL_CHUNK_SIZE].resize(POOL_CHUNK_SIZE);
 
-			poolNodes[idx / POOL_CHUNK_SIZE][idx % POOL_CHUNK_SIZE].Init(parent, nn, x1, z1, x2, z2);
+			poolNodes[idx / POOL_CHUNK_SIZE][idx % POOL_CHUNK_SIZE].Init(parent, idx, nn, x1, z1, x2, z2);
 			nodeIndcs.pop_back();
 
 			return idx;
 		}
 
-		void FreePoolNode(unsigned int nodeIndex) { nodeIndcs.push_back(nodeIndex); }
+		void FreePoolNode(unsigned int nodeIndex) {
+			GetPoolNode(nodeIndex)->ClearNeighborCache(*this);
+			nodeIndcs.push_back(nodeIndex);
+		}
+
+
+		// packed neighbor-cache storage; every leaf owns one contiguous range
+		// (see QTNode::UpdateNeighborCache) with QTPFS_MAX_NETPOINTS_PER_NODE_EDGE
+		// edge transition points per neighbor slot
+		const unsigned int* GetNeighbors(unsigned int i) const { return (nodeNeighbors.data() + i); }
+		      unsigned int* GetNeighbors(unsigned int i)       { return (nodeNeighbors.data() + i); }
+		const float2* GetNetPoints(unsigned int i) const { return (nodeNetPoints.data() + i * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE); }
+		      float2* GetNetPoints(unsigned int i)       { return (nodeNetPoints.data() + i * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE); }
+
+		unsigned int AllocNeighborSlots(unsigned int n) {
+			const unsigned int idx = nodeNeighbors.size();
+
+			nodeNeighbors.resize(idx + n, -1u);
+			nodeNetPoints.resize((idx + n) * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE);
+			return idx;
+		}
+
+		void FreeNeighborSlots(unsigned int n) { numFreeNeighborSlots += n; }
+		void CompactNeighborSlots();
+
+		std::vector<unsigned int>& GetTempNeighbors() { return tmpNeighbors; }
 
 
 		const std::vector<SpeedBinType>& GetOldSpeedBins() const { return oldSpeedBins; }
@@ -102,8 +130,6 @@ namespace QTPFS {
 		const std::vector<SpeedModType>& GetOldSpeedMods() const { return oldSpeedMods; }
 		const std::vector<SpeedModType>& GetCurSpeedMods() const { return curSpeedMods; }
 
-		std::vector<INode*>& GetNodes() { return nodeGrid; }
-
 		void RegisterNode(INode* n);
 
 		void SetNumLeafNodes(unsigned int n) { numLeafNodes = n; }
@@ -114,6 +140,21 @@ namespace QTPFS {
 
 		SpeedBinType GetSpeedModBin(float absSpeedMod, float relSpeedMod) const;
 
+		std::uint64_t GetNodeMemFootPrint() const {
+			std::uint64_t memFootPrint = 0;
+			for (size_t i = 0, n = NUM_POOL_CHUNKS; i < n; i++) {
+				memFootPrint += (poolNodes[i].capacity() * sizeof(QTNode));
+			}
+			memFootPrint += (nodeIndcs.capacity() * sizeof(decltype(nodeIndcs)::value_type));
+			return memFootPrint;
+		}
+		std::uint64_t GetNeighborMemFootPrint() const {
+			std::uint64_t memFootPrint = 0;
+			memFootPrint += (nodeNeighbors.capacity() * sizeof(decltype(nodeNeighbors)::value_type));
+			memFootPrint += (nodeNetPoints.capacity() * sizeof(decltype(nodeNetPoints)::value_type));
+			memFootPrint += (tmpNeighbors.capacity() * sizeof(decltype(tmpNeighbors)::value_type));
+			return memFootPrint;
+		}
 		std::uint64_t GetMemFootPrint() const {
 			std::uint64_t memFootPrint = sizeof(NodeLayer);
 			memFootPrint += (curSpeedMods.size() * sizeof(SpeedModType));
@@ -121,20 +162,24 @@ namespace QTPFS {
 			memFootPrint += (curSpeedBins.size() * sizeof(SpeedBinType));
 			memFootPrint += (oldSpeedBins.size() * sizeof(SpeedBinType));
 			memFootPrint += (nodeGrid.size() * sizeof(decltype(nodeGrid)::value_type));
-			// memFootPrint += (poolNodes.size() * sizeof(decltype(poolNodes)::value_type));
-			for (size_t i = 0, n = NUM_POOL_CHUNKS; i < n; i++) {
-				memFootPrint += (poolNodes[i].size() * sizeof(QTNode));
-			}
-			memFootPrint += (nodeIndcs.size() * sizeof(decltype(nodeIndcs)::value_type));
+			memFootPrint += GetNodeMemFootPrint();
+			memFootPrint += GetNeighborMemFootPrint();
 			return memFootPrint;
 		}
 
+		static constexpr unsigned int ROOT_NODE_INDEX = -1u - 1;
+
 	private:
-		std::vector<INode*> nodeGrid;
+		// per-square index of the leaf covering it
+		std::vector<unsigned int> nodeGrid;
 
 		std::vector<QTNode> poolNodes[16];
 		std::vector<unsigned int> nodeIndcs;
 
+		std::vector<unsigned int> nodeNeighbors;
+		std::vector<float2> nodeNetPoints;
+		std::vector<unsigned int> tmpNeighbors;
+
 		std::vector<SpeedModType> curSpeedMods;
 		std::vector<SpeedModType> oldSpeedMods;
 		std::vector<SpeedBinType> curSpeedBins;
@@ -162,6 +207,7 @@ namespace QTPFS {
 		unsigned int layerNumber = 0;
 		unsigned int numLeafNodes = 0;
 		unsigned int updateCounter = 0;
+		unsigned int numFreeNeighborSlots = 0;
 
 		unsigned int xsize = 0;
 		unsigned int zsize = 0;
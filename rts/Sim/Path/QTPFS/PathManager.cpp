@@ -14,6 +14,7 @@
 #include "Game/LoadScreen.h"
 #include "Map/MapInfo.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
@@ -144,6 +145,7 @@ QTPFS::PathManager::~PathManager() {
 	pathSearches.clear();
 	pathTypes.clear();
 	pathTraces.clear();
+	layerSearchStates.clear();
 
 	numCurrExecutedSearches.clear();
 	numPrevExecutedSearches.clear();
@@ -185,8 +187,6 @@ void QTPFS::PathManager::InitStatic() {
 }
 
 void QTPFS::PathManager::Load() {
-	// NOTE: offset *must* start at a non-zero value
-	searchStateOffset = NODE_STATE_OFFSET;
 	numTerrainChanges = 0;
 	numPathRequests   = 0;
 	maxNumLeafNodes   = 0;
@@ -195,6 +195,8 @@ void QTPFS::PathManager::Load() {
 	nodeLayers.resize(moveDefHandler.GetNumMoveDefs());
 	pathCaches.resize(moveDefHandler.GetNumMoveDefs());
 	pathSearches.resize(moveDefHandler.GetNumMoveDefs());
+	layerSearchStates.clear();
+	layerSearchStates.resize(moveDefHandler.GetNumMoveDefs());
 
 	// add one extra element for object-less requests
 	numCurrExecutedSearches.resize(teamHandler.ActiveTeams() + 1, 0);
@@ -252,7 +254,7 @@ void QTPFS::PathManager::Load() {
 
 	{
 		const std::string sumStr = "pfs-checksum: " + IntToString(pfsCheckSum, "%08x") + ", ";
-		const std::string memStr = "mem-footprint: " + IntToString(GetMemFootPrint()) + "MB";
+		const std::string memStr = "mem-footprint: " + IntToString(GetMemFootPrint()) + "MB (" + GetMemFootPrintStr() + ")";
 
 		pmLoadScreen.AddMessage("[" + std::string(__func__) + "] " + sumStr + memStr);
 		pmLoadScreen.Kill();
@@ -264,13 +266,29 @@ std::uint64_t QTPFS::PathManager::GetMemFootPrint() const {
 
 	for (unsigned int i = 0; i < nodeLayers.size(); i++) {
 		memFootPrint += nodeLayers[i].GetMemFootPrint();
-		memFootPrint += nodeTrees[i]->GetMemFootPrint(nodeLayers[i]);
 	}
 
 	// convert to megabytes
 	return (memFootPrint / (1024 * 1024));
 }
 
+std::string QTPFS::PathManager::GetMemFootPrintStr() const {
+	std::uint64_t nodeMem = 0;
+	std::uint64_t nghbMem = 0;
+	std::uint64_t leafCnt = 0;
+
+	for (unsigned int i = 0; i < nodeLayers.size(); i++) {
+		nodeMem += nodeLayers[i].GetNodeMemFootPrint();
+		nghbMem += nodeLayers[i].GetNeighborMemFootPrint();
+		leafCnt += nodeLayers[i].GetNumLeafNodes();
+	}
+
+	char buf[256];
+	SNPRINTF(buf, sizeof(buf), "nodes: %uMB, neighbors: %uMB, leafs: %u, bytes/node: %u",
+		unsigned(nodeMem / (1024 * 1024)), unsigned(nghbMem / (1024 * 1024)), unsigned(leafCnt), unsigned(sizeof(QTNode)));
+	return buf;
+}
+
 
 
 void QTPFS::PathManager::SpawnSpringThreads(MemberFunc f, const SRectangle& r) {
@@ -318,9 +336,8 @@ void QTPFS::PathManager::InitNodeLayersThreaded(const SRectangle& rect) {
 			InitNodeLayer(layerNum, rect);
 			UpdateNodeLayer(layerNum, rect);
 
-			const QTNode* tree = nodeTrees[layerNum];
 			const NodeLayer& layer = nodeLayers[layerNum];
-			const unsigned int mem = (tree->GetMemFootPrint(layer) + layer.GetMemFootPrint()) / (1024 * 1024);
+			const unsigned int mem = layer.GetMemFootPrint() / (1024 * 1024);
 
 			#ifndef NDEBUG
 			sprintf(loadMsg, pstFmtStr, layerNum, mem, layer.GetNumLeafNodes(), layer.GetNodeRatio());
@@ -368,9 +385,8 @@ void QTPFS::PathManager::InitNodeLayersThread(
 		InitNodeLayer(layerNum, rect);
 		UpdateNodeLayer(layerNum, rect);
 
-		const QTNode* tree = nodeTrees[layerNum];
 		const NodeLayer& layer = nodeLayers[layerNum];
-		const unsigned int mem = (tree->GetMemFootPrint(layer) + layer.GetMemFootPrint()) / (1024 * 1024);
+		const unsigned int mem = layer.GetMemFootPrint() / (1024 * 1024);
 
 		#ifndef NDEBUG
 		sprintf(loadMsg, pstFmtStr, layerNum, mem, layer.GetNumLeafNodes(), layer.GetNodeRatio());
@@ -710,19 +726,38 @@ void QTPFS::PathManager::ThreadUpdate() {
 		static unsigned int minPathTypeUpdate = 0;
 		static unsigned int maxPathTypeUpdate = numPathTypeUpdates;
 
-		sharedPaths.clear();
-
 		for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
-			#ifndef QTPFS_IGNORE_DEAD_PATHS
-			QueueDeadPathSearches(pathTypeUpdate);
-			#endif
+			layerSearchStates[pathTypeUpdate].sharedPaths.clear();
+		}
 
-			#ifdef QTPFS_STAGGERED_LAYER_UPDATES
-			// NOTE: *must* be called between QueueDeadPathSearches and ExecuteQueuedSearches
-			ExecQueuedNodeLayerUpdates(pathTypeUpdate, !pathSearches[pathTypeUpdate].empty());
-			#endif
+		if (modInfo.enableParallelQTPFSSearches) {
+			// searches of one layer never touch the nodes, caches or queues of
+			// another, so only the searches themselves need to be run in bulk
+			for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+				#ifndef QTPFS_IGNORE_DEAD_PATHS
+				QueueDeadPathSearches(pathTypeUpdate);
+				#endif
+
+				#ifdef QTPFS_STAGGERED_LAYER_UPDATES
+				ExecQueuedNodeLayerUpdates(pathTypeUpdate, !pathSearches[pathTypeUpdate].empty());
+				#endif
+			}
+
+			ExecuteQueuedSearchesMT(minPathTypeUpdate, maxPathTypeUpdate);
+		} else {
+			for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+				#ifndef QTPFS_IGNORE_DEAD_PATHS
+				QueueDeadPathSearches(pathTypeUpdate);
+				#endif
 
-			ExecuteQueuedSearches(pathTypeUpdate);
+				#ifdef QTPFS_STAGGERED_LAYER_UPDATES
+				// NOTE: *must* be called between QueueDeadPathSearches and ExecuteQueuedSearches
+				ExecQueuedNodeLayerUpdates(pathTypeUpdate, !pathSearches[pathTypeUpdate].empty());
+				#endif
+
+				ExecuteQueuedSearches(pathTypeUpdate);
+				FinishQueuedSearches(pathTypeUpdate);
+			}
 		}
 
 		std::copy(numCurrExecutedSearches.begin(), numCurrExecutedSearches.end(), numPrevExecutedSearches.begin());
@@ -750,6 +785,7 @@ void QTPFS::PathManager::ThreadUpdate() {
 void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
 	NodeLayer& nodeLayer = nodeLayers[pathType];
 	PathCache& pathCache = pathCaches[pathType];
+	LayerSearchState& searchState = layerSearchStates[pathType];
 
 	std::vector<IPathSearch*>& searches = pathSearches[pathType];
 	std::vector<IPathSearch*>::iterator searchesIt = searches.begin();
@@ -758,18 +794,116 @@ void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
 		// execute pending searches collected via
 		// RequestPath and QueueDeadPathSearches
 		while (searchesIt != searches.end()) {
-			if (ExecuteSearch(searches, searchesIt, nodeLayer, pathCache, pathType)) {
-				searchStateOffset += NODE_STATE_OFFSET;
+			if (ExecuteSearch(searches, searchesIt, nodeLayer, pathCache, searchState, pathType)) {
+				searchState.searchStateOffset += NODE_STATE_OFFSET;
 			}
 		}
 	}
 }
 
+void QTPFS::PathManager::ExecuteQueuedSearchesMT(unsigned int minPathType, unsigned int maxPathType) {
+	#ifdef QTPFS_LIMIT_TEAM_SEARCHES
+	{
+		// hand out what is left of each team's budget in layer order
+		// a search resolved via a shared path still takes one unit of
+		// its layer's budget here, so teams can only ever execute less
+		// (never more) searches than with serial execution
+		std::vector<unsigned int> teamSearchBudgets(numCurrExecutedSearches.size(), 0);
+
+		for (unsigned int teamNum = 0; teamNum < teamSearchBudgets.size(); teamNum++) {
+			const unsigned int numSearches = numCurrExecutedSearches[teamNum] - numPrevExecutedSearches[teamNum];
+			teamSearchBudgets[teamNum] = MAX_TEAM_SEARCHES - std::min(numSearches, MAX_TEAM_SEARCHES);
+		}
+
+		for (unsigned int pathType = minPathType; pathType < maxPathType; pathType++) {
+			LayerSearchState& searchState = layerSearchStates[pathType];
+
+			searchState.teamSearchBudgets.clear();
+			searchState.teamSearchBudgets.resize(teamSearchBudgets.size(), 0);
+			searchState.teamSearchCounts.clear();
+			searchState.teamSearchCounts.resize(teamSearchBudgets.size(), 0);
+
+			for (const IPathSearch* search: pathSearches[pathType]) {
+				const unsigned int teamNum = search->GetTeam();
+
+				if (teamSearchBudgets[teamNum] == 0)
+					continue;
+
+				teamSearchBudgets[teamNum] -= 1;
+				searchState.teamSearchBudgets[teamNum] += 1;
+			}
+		}
+	}
+	#endif
+
+	{
+		SCOPED_MT_TIMER("Sim::Path::QTPFS::ExecuteSearchesMT");
+
+		for_mt(minPathType, maxPathType, [this](const int pathType) {
+			ExecuteQueuedSearches(pathType);
+		});
+	}
+
+	for (unsigned int pathType = minPathType; pathType < maxPathType; pathType++) {
+		LayerSearchState& searchState = layerSearchStates[pathType];
+
+		#ifdef QTPFS_LIMIT_TEAM_SEARCHES
+		for (unsigned int teamNum = 0; teamNum < searchState.teamSearchCounts.size(); teamNum++) {
+			numCurrExecutedSearches[teamNum] += searchState.teamSearchCounts[teamNum];
+		}
+
+		searchState.teamSearchBudgets.clear();
+		searchState.teamSearchCounts.clear();
+		#endif
+
+		FinishQueuedSearches(pathType);
+	}
+}
+
+void QTPFS::PathManager::FinishQueuedSearches(unsigned int pathType) {
+	LayerSearchState& searchState = layerSearchStates[pathType];
+
+	for (const unsigned int pathID: searchState.failedPathIDs) {
+		DeletePath(pathID);
+	}
+
+	#ifdef QTPFS_TRACE_PATH_SEARCHES
+	for (const auto& p: searchState.pathTraces) {
+		pathTraces[p.first] = p.second;
+	}
+	#endif
+
+	searchState.failedPathIDs.clear();
+	searchState.pathTraces.clear();
+}
+
+bool QTPFS::PathManager::AllowTeamSearch(LayerSearchState& searchState, unsigned int teamNum) {
+	// concurrently searched layers draw from their own budget, see ExecuteQueuedSearchesMT
+	if (!searchState.teamSearchBudgets.empty()) {
+		if (searchState.teamSearchBudgets[teamNum] == 0)
+			return false;
+
+		searchState.teamSearchBudgets[teamNum] -= 1;
+		searchState.teamSearchCounts[teamNum] += 1;
+		return true;
+	}
+
+	const unsigned int numCurrSearches = numCurrExecutedSearches[teamNum];
+	const unsigned int numPrevSearches = numPrevExecutedSearches[teamNum];
+
+	if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES)
+		return false;
+
+	numCurrExecutedSearches[teamNum] += 1;
+	return true;
+}
+
 bool QTPFS::PathManager::ExecuteSearch(
 	PathSearchVect& searches,
 	PathSearchVectIt& searchesIt,
 	NodeLayer& nodeLayer,
 	PathCache& pathCache,
+	LayerSearchState& searchState,
 	unsigned int pathType
 ) {
 	IPathSearch* search = *searchesIt;
@@ -800,9 +934,9 @@ bool QTPFS::PathManager::ExecuteSearch(
 
 	{
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		SharedPathMap::const_iterator sharedPathsIt = sharedPaths.find(path->GetHash());
+		SharedPathMap::const_iterator sharedPathsIt = searchState.sharedPaths.find(path->GetHash());
 
-		if (sharedPathsIt != sharedPaths.end()) {
+		if (sharedPathsIt != searchState.sharedPaths.end()) {
 			if (search->SharedFinalize(sharedPathsIt->second, path)) {
 				DeleteSearch(search, searches, searchesIt);
 				return false;
@@ -811,30 +945,26 @@ bool QTPFS::PathManager::ExecuteSearch(
 		#endif
 
 		#ifdef QTPFS_LIMIT_TEAM_SEARCHES
-		const unsigned int numCurrSearches = numCurrExecutedSearches[search->GetTeam()];
-		const unsigned int numPrevSearches = numPrevExecutedSearches[search->GetTeam()];
-
-		if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES) {
+		if (!AllowTeamSearch(searchState, search->GetTeam())) {
 			++searchesIt; return false;
 		}
-
-		numCurrExecutedSearches[search->GetTeam()] += 1;
 		#endif
 	}
 
 	// removes path from temp-paths, adds it to live-paths
-	if (search->Execute(searchStateOffset, numTerrainChanges)) {
+	if (search->Execute(searchState.searchStateOffset, numTerrainChanges)) {
 		search->Finalize(path);
 
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		sharedPaths[path->GetHash()] = path;
+		searchState.sharedPaths[path->GetHash()] = path;
 		#endif
 
 		#ifdef QTPFS_TRACE_PATH_SEARCHES
-		pathTraces[path->GetID()] = search->GetExecutionTrace();
+		searchState.pathTraces.emplace_back(path->GetID(), search->GetExecutionTrace());
 		#endif
 	} else {
-		DeletePath(path->GetID());
+		// touches the path-type map shared by all layers, deferred
+		searchState.failedPathIDs.push_back(path->GetID());
 	}
 
 	DeleteSearch(search, searches, searchesIt);
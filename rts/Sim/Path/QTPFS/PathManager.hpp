@@ -8,6 +8,7 @@
 #include "Sim/Path/IPathManager.h"
 #include "NodeLayer.hpp"
 #include "PathCache.hpp"
+#include "PathEnums.hpp"
 #include "PathSearch.hpp"
 #include "System/UnorderedMap.hpp"
 
@@ -83,6 +84,7 @@ namespace QTPFS {
 		void Load();
 
 		std::uint64_t GetMemFootPrint() const;
+		std::string GetMemFootPrintStr() const;
 
 		typedef void (PathManager::*MemberFunc)(
 			unsigned int threadNum,
@@ -122,6 +124,8 @@ namespace QTPFS {
 		#endif
 
 		void ExecuteQueuedSearches(unsigned int pathType);
+		void ExecuteQueuedSearchesMT(unsigned int minPathType, unsigned int maxPathType);
+		void FinishQueuedSearches(unsigned int pathType);
 		void QueueDeadPathSearches(unsigned int pathType);
 
 		unsigned int QueueSearch(
@@ -134,14 +138,19 @@ namespace QTPFS {
 			const bool synced
 		);
 
+		struct LayerSearchState;
+
 		bool ExecuteSearch(
 			PathSearchVect& searches,
 			PathSearchVectIt& searchesIt,
 			NodeLayer& nodeLayer,
 			PathCache& pathCache,
+			LayerSearchState& searchState,
 			unsigned int pathType
 		);
 
+		bool AllowTeamSearch(LayerSearchState& searchState, unsigned int teamNum);
+
 		bool IsFinalized() const { return (!nodeTrees.empty()); }
 
 
@@ -156,8 +165,30 @@ namespace QTPFS {
 		spring::unordered_map<unsigned int, unsigned int> pathTypes;
 		spring::unordered_map<unsigned int, PathSearchTrace::Execution*> pathTraces;
 
-		// maps "hashes" of executed searches to the found paths
-		spring::unordered_map<std::uint64_t, IPath*> sharedPaths;
+		// everything ExecuteSearch writes outside of its own node-layer and
+		// path-cache lives here, so that layers can be searched concurrently
+		struct LayerSearchState {
+			// maps "hashes" of executed searches to the found paths
+			// (hashes include the path-type, sharing across layers is
+			// not possible)
+			SharedPathMap sharedPaths;
+
+			// paths whose searches failed and traces of executed searches,
+			// handed to DeletePath and pathTraces by FinishQueuedSearches
+			std::vector<unsigned int> failedPathIDs;
+			std::vector< std::pair<unsigned int, PathSearchTrace::Execution*> > pathTraces;
+
+			// per-team number of searches this layer may still execute and
+			// has executed, only used by ExecuteQueuedSearchesMT
+			std::vector<unsigned int> teamSearchBudgets;
+			std::vector<unsigned int> teamSearchCounts;
+
+			// node search-states only need to be unique within a layer
+			// NOTE: offset *must* start at a non-zero value
+			unsigned int searchStateOffset = NODE_STATE_OFFSET;
+		};
+
+		std::vector<LayerSearchState> layerSearchStates;
 
 		std::vector<unsigned int> numCurrExecutedSearches;
 		std::vector<unsigned int> numPrevExecutedSearches;
@@ -165,7 +196,6 @@ namespace QTPFS {
 		static unsigned int LAYERS_PER_UPDATE;
 		static unsigned int MAX_TEAM_SEARCHES;
 
-		unsigned int searchStateOffset;
 		unsigned int numTerrainChanges;
 		unsigned int numPathRequests;
 		unsigned int maxNumLeafNodes;
@@ -15,7 +15,8 @@
 
 #include "System/float3.h"
 
-QTPFS::binary_heap<QTPFS::INode*> QTPFS::PathSearch::openNodes;
+std::array<QTPFS::binary_heap<QTPFS::INode*>, ThreadPool::MAX_THREADS> QTPFS::PathSearch::openNodesPool;
+unsigned int QTPFS::PathSearch::openNodesSize = 0;
 
 
 
@@ -49,6 +50,11 @@ bool QTPFS::PathSearch::Execute(
 	searchState = searchStateOffset; // starts at NODE_STATE_OFFSET
 	searchMagic = searchMagicNumber; // starts at numTerrainChanges
 
+	openNodes = &openNodesPool[ThreadPool::GetThreadNum()];
+
+	if (openNodes->capacity() < openNodesSize)
+		openNodes->reserve(openNodesSize);
+
 	haveFullPath = (srcNode == tgtNode);
 	havePartPath = false;
 
@@ -81,8 +87,8 @@ bool QTPFS::PathSearch::Execute(
 	ResetState(srcNode);
 	UpdateNode(srcNode, nullptr, 0);
 
-	while (!openNodes.empty()) {
-		IterateNodes(nodeLayer->GetNodes());
+	while (!openNodes->empty()) {
+		IterateNodes();
 
 		#ifdef QTPFS_TRACE_PATH_SEARCHES
 		searchExec->AddIteration(searchIter);
@@ -93,7 +99,7 @@ bool QTPFS::PathSearch::Execute(
 		havePartPath = (minNode != srcNode);
 
 		if (haveFullPath)
-			openNodes.reset();
+			openNodes->reset();
 	}
 
 	if (srcNode->GetMoveCost() == 0.0f)
@@ -136,8 +142,8 @@ void QTPFS::PathSearch::ResetState(INode* node) {
 		hCosts[i] = 0.0f;
 	}
 
-	openNodes.reset();
-	openNodes.push(node);
+	openNodes->reset();
+	openNodes->push(node);
 }
 
 void QTPFS::PathSearch::UpdateNode(INode* nextNode, INode* prevNode, unsigned int netPointIdx) {
@@ -149,11 +155,11 @@ void QTPFS::PathSearch::UpdateNode(INode* nextNode, INode* prevNode, unsigned in
 	nextNode->SetPrevNode(prevNode);
 	nextNode->SetPathCosts(gCosts[netPointIdx], hCosts[netPointIdx]);
 	nextNode->SetSearchState(searchState | NODE_STATE_OPEN);
-	nextNode->SetNeighborEdgeTransitionPoint(0, netPoints[netPointIdx]);
+	nextNode->SetEdgeTransitionPoint(netPoints[netPointIdx]);
 }
 
-void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
-	curNode = openNodes.top();
+void QTPFS::PathSearch::IterateNodes() {
+	curNode = openNodes->top();
 	curNode->SetSearchState(searchState | NODE_STATE_CLOSED);
 	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
 	// in the non-conservative case, this is done from
@@ -161,8 +167,8 @@ void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
 	curNode->SetMagicNumber(searchMagic);
 	#endif
 
-	openNodes.pop();
-	openNodes.check_heap_property(0);
+	openNodes->pop();
+	openNodes->check_heap_property(0);
 
 	#ifdef QTPFS_TRACE_PATH_SEARCHES
 	searchIter.SetPoppedNodeIdx(curNode->zmin() * mapDims.mapx + curNode->xmin());
@@ -184,15 +190,21 @@ void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
 		minNode = curNode;
 	#endif
 
-	IterateNodeNeighbors(curNode->GetNeighbors(allNodes));
+	const unsigned int numNgbs = curNode->GetNeighbors(*nodeLayer);
+	const unsigned int ngbsIdx = curNode->GetNeighborsIndex();
+
+	if (numNgbs == 0)
+		return;
+
+	IterateNodeNeighbors(nodeLayer->GetNeighbors(ngbsIdx), nodeLayer->GetNetPoints(ngbsIdx), numNgbs);
 }
 
-void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes) {
+void QTPFS::PathSearch::IterateNodeNeighbors(const unsigned int* nxtNodes, const float2* nxtPoints, unsigned int numNxtNodes) {
 	// if curNode equals srcNode, this is just the original srcPoint
-	const float2& curPoint2 = curNode->GetNeighborEdgeTransitionPoint(0);
+	const float2& curPoint2 = curNode->GetEdgeTransitionPoint();
 	const float3  curPoint  = {curPoint2.x, 0.0f, curPoint2.y};
 
-	for (unsigned int i = 0; i < nxtNodes.size(); i++) {
+	for (unsigned int i = 0; i < numNxtNodes; i++) {
 		// NOTE:
 		//   this uses the actual distance that edges of the final path will cover,
 		//   from <curPoint> (initialized to sourcePoint) to a position on the edge
@@ -210,7 +222,7 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		//   in the first case we would explore many more nodes than necessary (CPU
 		//   nightmare), while in the second we would get low-quality paths (player
 		//   nightmare)
-		nxtNode = nxtNodes[i];
+		nxtNode = nodeLayer->GetPoolNode(nxtNodes[i]);
 
 		if (nxtNode->AllSquaresImpassable())
 			continue;
@@ -228,7 +240,7 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 			// to be fancy (note that this is not always the best
 			// option, it causes local and global sub-optimalities
 			// which SmoothPath can only partially address)
-			netPoints[0] = curNode->GetNeighborEdgeTransitionPoint(1 + i);
+			netPoints[0] = nxtPoints[i];
 
 			// cannot use squared-distances because that will bias paths
 			// towards smaller nodes (eg. 1^2 + 1^2 + 1^2 + 1^2 != 4^2)
@@ -248,7 +260,7 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		// not handle; more points means a greater degree
 		// of non-cardinality (but gets expensive quickly)
 		for (unsigned int j = 0; j < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; j++) {
-			netPoints[j] = curNode->GetNeighborEdgeTransitionPoint(1 + i * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + j);
+			netPoints[j] = nxtPoints[i * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + j];
 
 			gDists[j] = curPoint.distance({netPoints[j].x, 0.0f, netPoints[j].y});
 			hDists[j] = tgtPoint.distance({netPoints[j].x, 0.0f, netPoints[j].y});
@@ -267,8 +279,8 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		if (!isCurrent) {
 			UpdateNode(nxtNode, curNode, netPointIdx);
 
-			openNodes.push(nxtNode);
-			openNodes.check_heap_property(0);
+			openNodes->push(nxtNode);
+			openNodes->check_heap_property(0);
 
 			#ifdef QTPFS_TRACE_PATH_SEARCHES
 			searchIter.AddPushedNodeIdx(nxtNode->zmin() * mapDims.mapx + nxtNode->xmin());
@@ -279,7 +291,7 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		if (gCosts[netPointIdx] >= nxtNode->GetPathCost(NODE_PATH_COST_G))
 			continue;
 		if (isClosed)
-			openNodes.push(nxtNode);
+			openNodes->push(nxtNode);
 
 		UpdateNode(nxtNode, curNode, netPointIdx);
 
@@ -287,8 +299,8 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		// (changing the f-cost of an OPEN node messes up the
 		// queue's internal consistency; a pushed node remains
 		// OPEN until it gets popped)
-		openNodes.resort(nxtNode);
-		openNodes.check_heap_property(0);
+		openNodes->resort(nxtNode);
+		openNodes->check_heap_property(0);
 	}
 }
 
@@ -316,7 +328,7 @@ void QTPFS::PathSearch::TracePath(IPath* path) {
 		float3 prvPoint = tgtPoint;
 
 		while ((prvNode != nullptr) && (tmpNode != srcNode)) {
-			const float2& tmpPoint2 = tmpNode->GetNeighborEdgeTransitionPoint(0);
+			const float2& tmpPoint2 = tmpNode->GetEdgeTransitionPoint();
 			const float3  tmpPoint  = {tmpPoint2.x, 0.0f, tmpPoint2.y};
 
 			assert(!math::isinf(tmpPoint.x) && !math::isinf(tmpPoint.z));
@@ -3,6 +3,7 @@
 #ifndef QTPFS_PATHSEARCH_HDR
 #define QTPFS_PATHSEARCH_HDR
 
+#include <array>
 #include <vector>
 
 #include "PathDefines.hpp"
@@ -10,6 +11,7 @@
 #include "NodeHeap.hpp"
 
 #include "System/float3.h"
+#include "System/Threading/ThreadPool.h"
 
 namespace QTPFS {
 	struct PathCache;
@@ -120,6 +122,7 @@ namespace QTPFS {
 	public:
 		PathSearch(unsigned int pathSearchType)
 			: IPathSearch(pathSearchType)
+			, openNodes(NULL)
 			, nodeLayer(NULL)
 			, pathCache(NULL)
 			, searchExec(NULL)
@@ -132,7 +135,7 @@ namespace QTPFS {
 			, haveFullPath(false)
 			, havePartPath(false)
 			{}
-		~PathSearch() { openNodes.reset(); }
+		~PathSearch() {}
 
 		void Initialize(
 			NodeLayer* layer,
@@ -151,23 +154,33 @@ namespace QTPFS {
 
 		const std::uint64_t GetHash(std::uint64_t N, std::uint32_t k) const;
 
-		static void InitGlobalQueue(unsigned int n) { openNodes.reserve(n); }
-		static void FreeGlobalQueue() { openNodes.clear(); }
+		static void InitGlobalQueue(unsigned int n) { openNodesSize = n; openNodesPool[0].reserve(n); }
+		static void FreeGlobalQueue() {
+			for (binary_heap<INode*>& queue: openNodesPool) {
+				queue.clear();
+			}
+		}
 
 	private:
 		void ResetState(INode* node);
 		void UpdateNode(INode* nextNode, INode* prevNode, unsigned int netPointIdx);
 
-		void IterateNodes(const std::vector<INode*>& allNodes);
-		void IterateNodeNeighbors(const std::vector<INode*>& nxtNodes);
+		void IterateNodes();
+		void IterateNodeNeighbors(const unsigned int* nxtNodes, const float2* nxtPoints, unsigned int numNxtNodes);
 
 		void TracePath(IPath* path);
 		void SmoothPath(IPath* path) const;
 		bool SmoothPathIter(IPath* path) const;
 
-		// global queue: allocated once, re-used by all searches without clear()'s
+		// per-thread queues: allocated once (on first use by a thread), re-used by
+		// all searches on that thread without clear()'s since layers can now be
+		// searched concurrently (see PathManager::ExecuteQueuedSearchesMT)
 		// this relies on INode::operator< to sort the INode*'s by increasing f-cost
-		static binary_heap<INode*> openNodes;
+		static std::array<binary_heap<INode*>, ThreadPool::MAX_THREADS> openNodesPool;
+		static unsigned int openNodesSize;
+
+		// queue of the thread executing us, set by Execute
+		binary_heap<INode*>* openNodes;
 
 		NodeLayer* nodeLayer;
 		PathCache* pathCache;
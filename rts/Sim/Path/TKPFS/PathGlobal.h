@@ -9,7 +9,17 @@ namespace TKPFS {
 
 extern int debugLoggingActive;
 
-extern bool PathingSystemActive;
+// set while searches run as part of the MT 'Pathing System', which updates
+// the path cache itself; thread-local because async searches run on worker
+// threads while the main thread may search as well
+extern thread_local bool PathingSystemActive;
+
+struct ScopedPathingSystem {
+	ScopedPathingSystem(): wasActive(PathingSystemActive) { PathingSystemActive = true; }
+	~ScopedPathingSystem() { PathingSystemActive = wasActive; }
+
+	const bool wasActive;
+};
 
 }
 
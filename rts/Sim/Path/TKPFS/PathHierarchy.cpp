@@ -0,0 +1,509 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <functional>
+
+#include "PathHierarchy.h"
+#include "PathConstants.h"
+
+namespace TKPFS {
+
+// search scratch, per thread and level: a search only triggers searches on
+// lower levels (while building edges), so one set per level suffices
+struct SearchBuffers {
+	std::vector<float> gCosts;
+	std::vector<std::uint8_t> pathDirs;
+	std::vector<std::uint8_t> closed;
+	std::vector<std::pair<float, unsigned int>> openQueue;
+};
+
+static thread_local std::vector<SearchBuffers> searchBuffers;
+
+
+void PathHierarchy::Init(
+	int2 numBlocks,
+	const std::vector<float>* vertexCosts,
+	const std::vector< std::vector<short2> >* nodeOffsets,
+	const std::vector<float>* speedMods
+) {
+	const std::lock_guard<std::recursive_mutex> lock(buildMutex);
+
+	baseVertexCosts = vertexCosts;
+	baseNodeOffsets = nodeOffsets;
+	maxSpeedMods = speedMods;
+
+	numPathTypes = nodeOffsets->size();
+
+	levels.clear();
+	levels.emplace_back();
+	levels[0].numNodes = numBlocks;
+
+	while (std::max(levels.back().numNodes.x, levels.back().numNodes.y) > int(MAX_TOP_LEVEL_SIZE)) {
+		Level level;
+
+		level.numNodes.x = (levels.back().numNodes.x + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+		level.numNodes.y = (levels.back().numNodes.y + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+		level.nodeSize = levels.back().nodeSize * CLUSTER_SIZE;
+
+		const size_t numStates = numPathTypes * level.numNodes.x * level.numNodes.y;
+
+		level.nodeReps.resize(numStates, -1u);
+		level.nodeStates = std::vector<std::atomic<std::uint8_t>>(numStates);
+		level.vertexCosts.resize(numStates * PATH_DIRECTION_VERTICES, PATHCOST_INFINITY);
+
+		levels.push_back(std::move(level));
+	}
+
+	// same order as PathingState::FindBlockPosOffset tries squares in
+	childOffsets.clear();
+	childOffsets.reserve(CLUSTER_SIZE * CLUSTER_SIZE);
+
+	for (unsigned int z = 0; z < CLUSTER_SIZE; ++z) {
+		for (unsigned int x = 0; x < CLUSTER_SIZE; ++x) {
+			childOffsets.emplace_back(x, z);
+		}
+	}
+
+	std::stable_sort(childOffsets.begin(), childOffsets.end(), [](const int2& a, const int2& b) {
+		const float c = (CLUSTER_SIZE - 1) * 0.5f;
+		return (((a.x - c) * (a.x - c) + (a.y - c) * (a.y - c)) < ((b.x - c) * (b.x - c) + (b.y - c) * (b.y - c)));
+	});
+}
+
+void PathHierarchy::Kill()
+{
+	const std::lock_guard<std::recursive_mutex> lock(buildMutex);
+
+	levels.clear();
+	childOffsets.clear();
+
+	baseVertexCosts = nullptr;
+	baseNodeOffsets = nullptr;
+	maxSpeedMods = nullptr;
+}
+
+
+void PathHierarchy::BlocksChanged(int2 minBlockPos, int2 maxBlockPos)
+{
+	const std::lock_guard<std::recursive_mutex> lock(buildMutex);
+
+	int2 rangeMin = minBlockPos;
+	int2 rangeMax = maxBlockPos;
+
+	for (unsigned int levelNum = 1; levelNum < levels.size(); levelNum++) {
+		Level& level = levels[levelNum];
+
+		// the nodes containing changed children, plus their neighbors whose
+		// edges were searched through them (and whose edges point at them)
+		rangeMin.x = std::max(rangeMin.x / int(CLUSTER_SIZE) - 1, 0);
+		rangeMin.y = std::max(rangeMin.y / int(CLUSTER_SIZE) - 1, 0);
+		rangeMax.x = std::min(rangeMax.x / int(CLUSTER_SIZE) + 1, level.numNodes.x - 1);
+		rangeMax.y = std::min(rangeMax.y / int(CLUSTER_SIZE) + 1, level.numNodes.y - 1);
+
+		const unsigned int numNodes = level.numNodes.x * level.numNodes.y;
+
+		for (unsigned int pathType = 0; pathType < numPathTypes; pathType++) {
+			for (int z = rangeMin.y; z <= rangeMax.y; z++) {
+				for (int x = rangeMin.x; x <= rangeMax.x; x++) {
+					level.nodeStates[pathType * numNodes + NodePosToIdx(levelNum, {x, z})].store(NODE_UNBUILT, std::memory_order_relaxed);
+				}
+			}
+		}
+	}
+}
+
+
+bool PathHierarchy::FindPath(
+	unsigned int pathType,
+	int2 strtBlockPos,
+	int2 goalBlockPos,
+	std::vector<int2>& blockPath,
+	float* pathCost
+) {
+	blockPath.clear();
+
+	if (levels.empty() || pathType >= numPathTypes)
+		return false;
+
+	if (searchBuffers.size() < levels.size())
+		searchBuffers.resize(levels.size());
+
+	assert(IsInLevel(0, strtBlockPos));
+	assert(IsInLevel(0, goalBlockPos));
+
+	std::vector<int2> nodePath;
+	std::vector<int2> childPath;
+	std::vector<int2> edgePath;
+
+	unsigned int levelNum = 0;
+	float cost = PATHCOST_INFINITY;
+
+	for (; levelNum < levels.size(); levelNum++) {
+		const int2 numNodes = levels[levelNum].numNodes;
+		const int2 strtNodePos = BlockPosToNodePos(levelNum, strtBlockPos);
+		const int2 goalNodePos = BlockPosToNodePos(levelNum, goalBlockPos);
+
+		const int2 boxMin = {
+			std::max(std::min(strtNodePos.x, goalNodePos.x) - SEARCH_BOX_MARGIN, 0),
+			std::max(std::min(strtNodePos.y, goalNodePos.y) - SEARCH_BOX_MARGIN, 0),
+		};
+		const int2 boxMax = {
+			std::min(std::max(strtNodePos.x, goalNodePos.x) + SEARCH_BOX_MARGIN, numNodes.x - 1),
+			std::min(std::max(strtNodePos.y, goalNodePos.y) + SEARCH_BOX_MARGIN, numNodes.y - 1),
+		};
+
+		const int2 boxSize = {boxMax.x - boxMin.x + 1, boxMax.y - boxMin.y + 1};
+
+		if ((levelNum + 1) < levels.size() && (boxSize.x * boxSize.y) > int(MAX_SEARCH_BOX_NODES))
+			continue;
+
+		if ((cost = SearchLevel(levelNum, pathType, strtNodePos, goalNodePos, boxMin, boxMax, &nodePath)) < PATHCOST_INFINITY)
+			break;
+
+		// a level that was searched in its entirety only fails if the goal
+		// is unreachable, which the coarser levels cannot change either
+		if (boxSize == numNodes)
+			return false;
+	}
+
+	if (cost >= PATHCOST_INFINITY)
+		return false;
+
+	// replace every edge by the path it was calculated from, down to level 0
+	for (; levelNum > 0; levelNum--) {
+		const auto GetChildPos = [&](int2 nodePos) {
+			return (BlockPosToNodePos(levelNum - 1, BlockIdxToPos(GetNodeRep(levelNum, pathType, nodePos))));
+		};
+
+		childPath.clear();
+		childPath.push_back(GetChildPos(nodePath[0]));
+
+		for (size_t n = 1; n < nodePath.size(); n++) {
+			int2 boxMin;
+			int2 boxMax;
+
+			GetChildBox(levelNum, nodePath[n - 1], nodePath[n], boxMin, boxMax);
+
+			const float edgeCost = SearchLevel(levelNum - 1, pathType, childPath.back(), GetChildPos(nodePath[n]), boxMin, boxMax, &edgePath);
+
+			// same search as the one the edge was built from
+			assert(edgeCost < PATHCOST_INFINITY);
+			(void) edgeCost;
+
+			childPath.insert(childPath.end(), edgePath.begin() + 1, edgePath.end());
+		}
+
+		nodePath.swap(childPath);
+	}
+
+	// the path runs from representative to representative; skip its parts
+	// that lead back towards the start or away from the goal
+	const auto SqDist = [](int2 a, int2 b) { return ((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y)); };
+
+	size_t first = 0;
+	size_t last = nodePath.size() - 1;
+
+	while (first < last && SqDist(nodePath[first + 1], strtBlockPos) < SqDist(nodePath[first], strtBlockPos))
+		first++;
+	while (last > first && SqDist(nodePath[last - 1], goalBlockPos) < SqDist(nodePath[last], goalBlockPos))
+		last--;
+
+	blockPath.reserve(last - first + 3);
+
+	if (nodePath[first] != strtBlockPos)
+		blockPath.push_back(strtBlockPos);
+
+	blockPath.insert(blockPath.end(), nodePath.begin() + first, nodePath.begin() + last + 1);
+
+	if (blockPath.back() != goalBlockPos)
+		blockPath.push_back(goalBlockPos);
+
+	if (pathCost != nullptr)
+		*pathCost = cost;
+
+	return true;
+}
+
+
+size_t PathHierarchy::GetNumBuiltNodes(unsigned int levelNum) const
+{
+	const Level& level = levels[levelNum];
+
+	if (levelNum == 0)
+		return (numPathTypes * level.numNodes.x * level.numNodes.y);
+
+	return (std::count_if(level.nodeStates.begin(), level.nodeStates.end(), [](const std::atomic<std::uint8_t>& s) { return (s.load() == NODE_BUILT); }));
+}
+
+
+bool PathHierarchy::IsBlockOpen(unsigned int pathType, int2 blockPos) const
+{
+	const int2 numBlocks = levels[0].numNodes;
+	const unsigned int vertexBaseIdx = (pathType * numBlocks.x * numBlocks.y + NodePosToIdx(0, blockPos)) * PATH_DIRECTION_VERTICES;
+
+	for (unsigned int pathDir = 0; pathDir < PATH_DIRECTIONS; pathDir++) {
+		if (!IsInLevel(0, blockPos + PE_DIRECTION_VECTORS[pathDir]))
+			continue;
+
+		if ((*baseVertexCosts)[vertexBaseIdx + GetBlockVertexOffset(pathDir, numBlocks.x)] < PATHCOST_INFINITY)
+			return true;
+	}
+
+	return false;
+}
+
+
+unsigned int PathHierarchy::GetNodeRep(unsigned int levelNum, unsigned int pathType, int2 nodePos)
+{
+	if (levelNum == 0)
+		return NodePosToIdx(0, nodePos);
+
+	Level& level = levels[levelNum];
+
+	const unsigned int stateIdx = pathType * level.numNodes.x * level.numNodes.y + NodePosToIdx(levelNum, nodePos);
+
+	if (level.nodeStates[stateIdx].load(std::memory_order_acquire) == NODE_UNBUILT) {
+		const std::lock_guard<std::recursive_mutex> lock(buildMutex);
+
+		// another thread might have built it while this one waited
+		if (level.nodeStates[stateIdx].load(std::memory_order_relaxed) == NODE_UNBUILT)
+			BuildNodeRep(levelNum, pathType, nodePos);
+	}
+
+	return level.nodeReps[stateIdx];
+}
+
+float PathHierarchy::GetEdgeCost(unsigned int levelNum, unsigned int pathType, int2 nodePos, unsigned int pathDir)
+{
+	Level& level = levels[levelNum];
+
+	const unsigned int numNodes = level.numNodes.x * level.numNodes.y;
+	const unsigned int vertexIdx = (pathType * numNodes + NodePosToIdx(levelNum, nodePos)) * PATH_DIRECTION_VERTICES + GetBlockVertexOffset(pathDir, level.numNodes.x);
+
+	if (levelNum == 0)
+		return (*baseVertexCosts)[vertexIdx];
+
+	// edges in the other half of the directions are stored by the neighbor
+	const int2 ownerPos = (pathDir < PATH_DIRECTION_VERTICES)? nodePos: nodePos + PE_DIRECTION_VECTORS[pathDir];
+
+	const unsigned int ownerStateIdx = pathType * numNodes + NodePosToIdx(levelNum, ownerPos);
+
+	if (level.nodeStates[ownerStateIdx].load(std::memory_order_acquire) != NODE_BUILT) {
+		const std::lock_guard<std::recursive_mutex> lock(buildMutex);
+
+		if (level.nodeStates[ownerStateIdx].load(std::memory_order_relaxed) != NODE_BUILT)
+			BuildNodeEdges(levelNum, pathType, ownerPos);
+	}
+
+	return level.vertexCosts[vertexIdx];
+}
+
+
+void PathHierarchy::BuildNodeRep(unsigned int levelNum, unsigned int pathType, int2 nodePos)
+{
+	assert(levelNum > 0);
+
+	Level& level = levels[levelNum];
+
+	const unsigned int stateIdx = pathType * level.numNodes.x * level.numNodes.y + NodePosToIdx(levelNum, nodePos);
+
+	unsigned int nodeRep = -1u;
+
+	// take the most central child through which paths can pass
+	for (const int2& offset: childOffsets) {
+		const int2 childPos = nodePos * int(CLUSTER_SIZE) + offset;
+
+		if (!IsInLevel(levelNum - 1, childPos))
+			continue;
+
+		if (levelNum == 1) {
+			if (!IsBlockOpen(pathType, childPos))
+				continue;
+
+			nodeRep = NodePosToIdx(0, childPos);
+			break;
+		}
+
+		if ((nodeRep = GetNodeRep(levelNum - 1, pathType, childPos)) != -1u)
+			break;
+	}
+
+	level.nodeReps[stateIdx] = nodeRep;
+	level.nodeStates[stateIdx].store(NODE_REP_BUILT, std::memory_order_release);
+}
+
+void PathHierarchy::BuildNodeEdges(unsigned int levelNum, unsigned int pathType, int2 nodePos)
+{
+	assert(levelNum > 0);
+
+	Level& level = levels[levelNum];
+
+	const unsigned int stateIdx = pathType * level.numNodes.x * level.numNodes.y + NodePosToIdx(levelNum, nodePos);
+	const unsigned int nodeRep = GetNodeRep(levelNum, pathType, nodePos);
+
+	for (unsigned int pathDir = 0; pathDir < PATH_DIRECTION_VERTICES; pathDir++) {
+		const int2 ngbPos = nodePos + PE_DIRECTION_VECTORS[pathDir];
+
+		float vertexCost = PATHCOST_INFINITY;
+
+		if (nodeRep != -1u && IsInLevel(levelNum, ngbPos)) {
+			const unsigned int ngbRep = GetNodeRep(levelNum, pathType, ngbPos);
+
+			if (ngbRep != -1u) {
+				int2 boxMin;
+				int2 boxMax;
+
+				// like the estimator's vertex costs, restricted to both nodes
+				GetChildBox(levelNum, nodePos, ngbPos, boxMin, boxMax);
+
+				const int2 strtChildPos = BlockPosToNodePos(levelNum - 1, BlockIdxToPos(nodeRep));
+				const int2 goalChildPos = BlockPosToNodePos(levelNum - 1, BlockIdxToPos(ngbRep));
+
+				vertexCost = SearchLevel(levelNum - 1, pathType, strtChildPos, goalChildPos, boxMin, boxMax, nullptr);
+			}
+		}
+
+		level.vertexCosts[stateIdx * PATH_DIRECTION_VERTICES + pathDir] = vertexCost;
+	}
+
+	level.nodeStates[stateIdx].store(NODE_BUILT, std::memory_order_release);
+}
+
+
+float PathHierarchy::SearchLevel(
+	unsigned int levelNum,
+	unsigned int pathType,
+	int2 strtNodePos,
+	int2 goalNodePos,
+	int2 boxMin,
+	int2 boxMax,
+	std::vector<int2>* nodePath
+) {
+	SearchBuffers& buffers = searchBuffers[levelNum];
+
+	const unsigned int strtRep = GetNodeRep(levelNum, pathType, strtNodePos);
+	const unsigned int goalRep = GetNodeRep(levelNum, pathType, goalNodePos);
+
+	if (strtRep == -1u || goalRep == -1u)
+		return PATHCOST_INFINITY;
+
+	if (nodePath != nullptr) {
+		nodePath->clear();
+		nodePath->push_back(strtNodePos);
+	}
+
+	if (strtNodePos == goalNodePos)
+		return 0.0f;
+
+	const std::vector<short2>& nodeOffsets = (*baseNodeOffsets)[pathType];
+	const short2 goalSquare = nodeOffsets[goalRep];
+	const float maxSpeedMod = (*maxSpeedMods)[pathType];
+
+	// octile distance between representatives, no sqrt for the synced searches
+	const auto Heuristic = [&](unsigned int nodeRep) {
+		const int dx = std::abs(nodeOffsets[nodeRep].x - goalSquare.x);
+		const int dz = std::abs(nodeOffsets[nodeRep].y - goalSquare.y);
+
+		return ((std::max(dx, dz) + std::min(dx, dz) * 0.41421356f) * maxSpeedMod);
+	};
+
+	const int2 boxSize = {boxMax.x - boxMin.x + 1, boxMax.y - boxMin.y + 1};
+	const auto BoxPosToIdx = [&](int2 nodePos) { return ((nodePos.y - boxMin.y) * boxSize.x + (nodePos.x - boxMin.x)); };
+
+	// (cost, idx) pairs compare lexicographically, which makes the
+	// expansion order (and thereby the tie-breaking) deterministic
+	const auto cmp = std::greater<std::pair<float, unsigned int>>();
+
+	buffers.gCosts.clear();
+	buffers.gCosts.resize(boxSize.x * boxSize.y, PATHCOST_INFINITY);
+	buffers.pathDirs.clear();
+	buffers.pathDirs.resize(boxSize.x * boxSize.y, 0);
+	buffers.closed.clear();
+	buffers.closed.resize(boxSize.x * boxSize.y, 0);
+	buffers.openQueue.clear();
+
+	const unsigned int goalBoxIdx = BoxPosToIdx(goalNodePos);
+
+	buffers.gCosts[BoxPosToIdx(strtNodePos)] = 0.0f;
+	buffers.openQueue.emplace_back(Heuristic(strtRep), BoxPosToIdx(strtNodePos));
+
+	while (!buffers.openQueue.empty()) {
+		std::pop_heap(buffers.openQueue.begin(), buffers.openQueue.end(), cmp);
+
+		const unsigned int curBoxIdx = buffers.openQueue.back().second;
+
+		buffers.openQueue.pop_back();
+
+		if (buffers.closed[curBoxIdx] != 0)
+			continue;
+		if (curBoxIdx == goalBoxIdx)
+			break;
+
+		buffers.closed[curBoxIdx] = 1;
+
+		const int2 curNodePos = {boxMin.x + int(curBoxIdx % boxSize.x), boxMin.y + int(curBoxIdx / boxSize.x)};
+		const float curCost = buffers.gCosts[curBoxIdx];
+
+		for (unsigned int pathDir = 0; pathDir < PATH_DIRECTIONS; pathDir++) {
+			const int2 ngbNodePos = curNodePos + PE_DIRECTION_VECTORS[pathDir];
+
+			if (ngbNodePos.x < boxMin.x || ngbNodePos.x > boxMax.x)
+				continue;
+			if (ngbNodePos.y < boxMin.y || ngbNodePos.y > boxMax.y)
+				continue;
+
+			const unsigned int ngbBoxIdx = BoxPosToIdx(ngbNodePos);
+
+			if (buffers.closed[ngbBoxIdx] != 0)
+				continue;
+
+			// can build nodes (and thereby search) on lower levels
+			const float vertexCost = GetEdgeCost(levelNum, pathType, curNodePos, pathDir);
+
+			if (vertexCost >= PATHCOST_INFINITY)
+				continue;
+
+			const float ngbCost = curCost + std::max(vertexCost, 0.0f);
+
+			if (ngbCost >= buffers.gCosts[ngbBoxIdx])
+				continue;
+
+			buffers.gCosts[ngbBoxIdx] = ngbCost;
+			buffers.pathDirs[ngbBoxIdx] = pathDir;
+
+			buffers.openQueue.emplace_back(ngbCost + Heuristic(GetNodeRep(levelNum, pathType, ngbNodePos)), ngbBoxIdx);
+			std::push_heap(buffers.openQueue.begin(), buffers.openQueue.end(), cmp);
+		}
+	}
+
+	if (buffers.gCosts[goalBoxIdx] >= PATHCOST_INFINITY)
+		return PATHCOST_INFINITY;
+
+	if (nodePath != nullptr) {
+		nodePath->clear();
+
+		for (int2 nodePos = goalNodePos; nodePos != strtNodePos; nodePos = nodePos - PE_DIRECTION_VECTORS[buffers.pathDirs[BoxPosToIdx(nodePos)]]) {
+			nodePath->push_back(nodePos);
+		}
+
+		nodePath->push_back(strtNodePos);
+		std::reverse(nodePath->begin(), nodePath->end());
+	}
+
+	return buffers.gCosts[goalBoxIdx];
+}
+
+
+void PathHierarchy::GetChildBox(unsigned int levelNum, int2 a, int2 b, int2& boxMin, int2& boxMax) const
+{
+	const int2 numChildren = levels[levelNum - 1].numNodes;
+
+	boxMin.x = std::min(a.x, b.x) * CLUSTER_SIZE;
+	boxMin.y = std::min(a.y, b.y) * CLUSTER_SIZE;
+	boxMax.x = std::min((std::max(a.x, b.x) + 1) * int(CLUSTER_SIZE), numChildren.x) - 1;
+	boxMax.y = std::min((std::max(a.y, b.y) + 1) * int(CLUSTER_SIZE), numChildren.y) - 1;
+}
+
+}
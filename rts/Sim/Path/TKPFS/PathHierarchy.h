@@ -0,0 +1,149 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef TKPFS_PATH_HIERARCHY_H
+#define TKPFS_PATH_HIERARCHY_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "System/type2.h"
+
+namespace TKPFS {
+
+/**
+ * Abstraction levels on top of an estimator's block graph, for searches that
+ * span (very) large maps. Level 0 is the estimator itself; every node of level
+ * k groups CLUSTER_SIZE x CLUSTER_SIZE nodes of level k-1 and is represented by
+ * one of their blocks. Two adjacent nodes are connected by the cost of the
+ * cheapest level k-1 path between their representatives within the two nodes,
+ * the same way the estimator connects adjacent blocks.
+ *
+ * Levels are added until the top one fits in MAX_TOP_LEVEL_SIZE nodes per axis,
+ * but nothing above level 0 is precomputed: nodes are built the first time a
+ * search touches them and reset whenever a block below them changes. Built data
+ * therefore only depends on the estimator's current state (never on which or
+ * how many searches came before), which keeps synced searches deterministic.
+ *
+ * FindPath may run on several threads at once; they only serialize while one
+ * of them builds nodes. Init, Kill and BlocksChanged must not overlap searches.
+ */
+class PathHierarchy {
+public:
+	static constexpr unsigned int CLUSTER_SIZE = 4;
+	static constexpr unsigned int MAX_TOP_LEVEL_SIZE = 16;
+
+	// searches run on the lowest level on which the box around start and goal
+	// (plus SEARCH_BOX_MARGIN nodes) has at most this many nodes
+	static constexpr unsigned int MAX_SEARCH_BOX_NODES = 32 * 32;
+	static constexpr int SEARCH_BOX_MARGIN = 2;
+
+	/**
+	 * The vectors belong to the level 0 estimator and must outlive this:
+	 * <vertexCosts> and <nodeOffsets> are laid out like PathingState's, and
+	 * <maxSpeedMods> holds the reciprocal maximum speedmod per path-type.
+	 */
+	void Init(
+		int2 numBlocks,
+		const std::vector<float>* vertexCosts,
+		const std::vector< std::vector<short2> >* nodeOffsets,
+		const std::vector<float>* maxSpeedMods
+	);
+	void Kill();
+
+	/**
+	 * Must be called after the estimator recalculated the offsets or vertex
+	 * costs of the blocks within [minBlockPos, maxBlockPos] (inclusive).
+	 */
+	void BlocksChanged(int2 minBlockPos, int2 maxBlockPos);
+
+	/**
+	 * Searches from <strtBlockPos> to <goalBlockPos> and writes the level 0
+	 * blocks of the path into <blockPath> (start first). The path runs through
+	 * the representatives of the nodes on the level it was found on, so it can
+	 * deviate from the optimal estimator path by up to one node at each end.
+	 * Returns false if none was found, which (since a representative does not
+	 * reach every part of its node) can also happen for reachable goals.
+	 */
+	bool FindPath(
+		unsigned int pathType,
+		int2 strtBlockPos,
+		int2 goalBlockPos,
+		std::vector<int2>& blockPath,
+		float* pathCost = nullptr
+	);
+
+	unsigned int GetNumLevels() const { return (levels.size()); }
+	int2 GetNumNodes(unsigned int levelNum) const { return levels[levelNum].numNodes; }
+
+	// number of nodes (over all path-types) whose edges are currently built
+	size_t GetNumBuiltNodes(unsigned int levelNum) const;
+
+private:
+	enum {
+		NODE_UNBUILT   = 0,
+		NODE_REP_BUILT = 1, // representative block chosen
+		NODE_BUILT     = 2, // and edge costs calculated
+	};
+
+	struct Level {
+		int2 numNodes;
+		int nodeSize = 1; // in level 0 nodes per axis
+
+		// per (pathType, node); representatives are level 0 indices
+		std::vector<unsigned int> nodeReps;
+		// read without holding buildMutex, a node's data is written before its state
+		std::vector<std::atomic<std::uint8_t>> nodeStates;
+		// PATH_DIRECTION_VERTICES per (pathType, node), see GetBlockVertexOffset
+		std::vector<float> vertexCosts;
+	};
+
+	int NodePosToIdx(unsigned int levelNum, int2 nodePos) const { return (nodePos.y * levels[levelNum].numNodes.x + nodePos.x); }
+	int2 BlockPosToNodePos(unsigned int levelNum, int2 blockPos) const { return (blockPos / levels[levelNum].nodeSize); }
+	int2 BlockIdxToPos(unsigned int blockIdx) const { return int2(blockIdx % levels[0].numNodes.x, blockIdx / levels[0].numNodes.x); }
+
+	bool IsInLevel(unsigned int levelNum, int2 nodePos) const {
+		const int2 numNodes = levels[levelNum].numNodes;
+		return (static_cast<unsigned int>(nodePos.x) < static_cast<unsigned int>(numNodes.x) && static_cast<unsigned int>(nodePos.y) < static_cast<unsigned int>(numNodes.y));
+	}
+	bool IsBlockOpen(unsigned int pathType, int2 blockPos) const;
+
+	unsigned int GetNodeRep(unsigned int levelNum, unsigned int pathType, int2 nodePos);
+	float GetEdgeCost(unsigned int levelNum, unsigned int pathType, int2 nodePos, unsigned int pathDir);
+
+	void BuildNodeRep(unsigned int levelNum, unsigned int pathType, int2 nodePos);
+	void BuildNodeEdges(unsigned int levelNum, unsigned int pathType, int2 nodePos);
+
+	float SearchLevel(
+		unsigned int levelNum,
+		unsigned int pathType,
+		int2 strtNodePos,
+		int2 goalNodePos,
+		int2 boxMin,
+		int2 boxMax,
+		std::vector<int2>* nodePath
+	);
+
+	// box covering the nodes <a> and <b> of level <levelNum> on level <levelNum - 1>
+	void GetChildBox(unsigned int levelNum, int2 a, int2 b, int2& boxMin, int2& boxMax) const;
+
+private:
+	const std::vector<float>* baseVertexCosts = nullptr;
+	const std::vector< std::vector<short2> >* baseNodeOffsets = nullptr;
+	const std::vector<float>* maxSpeedMods = nullptr;
+
+	unsigned int numPathTypes = 0;
+
+	std::vector<Level> levels;
+
+	// children of a node, nearest to its center first
+	std::vector<int2> childOffsets;
+
+	// recursive since building a node's edges builds nodes on lower levels
+	std::recursive_mutex buildMutex;
+};
+
+}
+
+#endif
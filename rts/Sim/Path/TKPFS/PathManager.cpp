@@ -5,6 +5,7 @@
 #include "PathConstants.h"
 #include "PathFinder.h"
 #include "PathEstimator.h"
+#include "PathHierarchy.h"
 #include "Sim/Path/Default/PathFlowMap.hpp"
 #include "PathHeatMap.h"
 #include "Sim/Path/Default/PathLog.h"
@@ -35,7 +36,7 @@ static CPathEstimator gLowResPE;
 namespace TKPFS {
 
 int debugLoggingActive = -1;
-bool PathingSystemActive = false;
+thread_local bool PathingSystemActive = false;
 
 enum {
 	PATH_LOW_RES = 0,
@@ -47,6 +48,8 @@ enum {
 };
 
 static PathingState pathingStates[PATH_ESTIMATOR_LEVELS];
+// replaces the low-res level if modInfo.enableHierarchicalPathing
+static PathHierarchy pathHierarchy;
 
 const CPathFinder* CPathManager::GetMaxResPF() const { return &maxResPFs[0]; }
 const CPathEstimator* CPathManager::GetMedResPE() const { return &medResPEs[0]; }
@@ -151,6 +154,8 @@ CPathManager::~CPathManager()
 	for (int i=0; i<PATH_ESTIMATOR_LEVELS; ++i)
 		pathingStates[i].Terminate();
 
+	pathHierarchy.Kill();
+
 	PathHeatMap::FreeInstance(pathHeatMap);
 	PathFlowMap::FreeInstance(pathFlowMap);
 	IPathFinder::KillStatic();
@@ -194,7 +199,14 @@ std::int64_t CPathManager::Finalize()
 		}
 		
 		pathingStates[PATH_MED_RES].Init(std::move(maxResList), nullptr,                      MEDRES_PE_BLOCKSIZE, "pe" , mapInfo->map.name);
-		pathingStates[PATH_LOW_RES].Init(std::move(medResList), &pathingStates[PATH_MED_RES], LOWRES_PE_BLOCKSIZE, "pe2", mapInfo->map.name);
+		pathingStates[PATH_LOW_RES].Init(std::move(medResList), &pathingStates[PATH_MED_RES], LOWRES_PE_BLOCKSIZE, "pe2", mapInfo->map.name, !modInfo.enableHierarchicalPathing);
+	}
+
+	if (modInfo.enableHierarchicalPathing) {
+		PathingState& medResPS = pathingStates[PATH_MED_RES];
+
+		pathHierarchy.Init(medResPS.GetNumBlocks(), &medResPS.vertexCosts, &medResPS.blockStates.peNodeOffsets, &medResPS.maxSpeedMods);
+		medResPS.pathHierarchy = &pathHierarchy;
 	}
 
 	finalized = true;
@@ -254,6 +266,90 @@ void CPathManager::FinalizePath(MultiPath* path, const float3 startPos, const fl
 }
 
 
+// stands in for a low-res PE search, see PathHierarchy
+static IPath::SearchResult GetHierarchyPath(const MoveDef& moveDef, const CPathFinderDef& pfDef, float3 startPos, IPath::Path& path)
+{
+	PathingState& lowResPS = pathingStates[PATH_LOW_RES];
+	PathingState& medResPS = pathingStates[PATH_MED_RES];
+
+	startPos.ClampInBounds();
+
+	path.path.clear();
+	path.squares.clear();
+	path.pathCost = PATHCOST_INFINITY;
+
+	// the low-res cache is keyed the same way as for a low-res PE search,
+	// and SavePathCacheForPathId stores (hierarchy) low-res paths in it
+	const unsigned int lowResBlockPixelSize = lowResPS.GetBlockSize() * SQUARE_SIZE;
+	const int2 lowResStrtBlock = {int(startPos.x / lowResBlockPixelSize), int(startPos.z / lowResBlockPixelSize)};
+	const int2 lowResGoalBlock = {int(pfDef.wsGoalPos.x / lowResBlockPixelSize), int(pfDef.wsGoalPos.z / lowResBlockPixelSize)};
+
+	const CPathCache::CacheItem ci = lowResPS.GetCache(lowResStrtBlock, lowResGoalBlock, pfDef.sqGoalRadius, moveDef.pathType, pfDef.synced);
+
+	if (ci.pathType != -1) {
+		path = ci.path;
+		return ci.result;
+	}
+
+	const int2 numBlocks = medResPS.GetNumBlocks();
+	const unsigned int blockSize = medResPS.GetBlockSize();
+	const unsigned int blockPixelSize = blockSize * SQUARE_SIZE;
+
+	const int2 strtBlockPos = {Clamp(int(startPos.x / blockPixelSize), 0, numBlocks.x - 1), Clamp(int(startPos.z / blockPixelSize), 0, numBlocks.y - 1)};
+	const int2 goalBlockPos = {Clamp(int(pfDef.wsGoalPos.x / blockPixelSize), 0, numBlocks.x - 1), Clamp(int(pfDef.wsGoalPos.z / blockPixelSize), 0, numBlocks.y - 1)};
+	const int2 goalSqrOffset = pfDef.GoalSquareOffset(blockSize);
+
+	const std::vector<short2>& nodeOffsets = medResPS.GetNodeStateBuffer().peNodeOffsets[moveDef.pathType];
+
+	// same test as CPathEstimator::DoSearch, minus its block search
+	const auto IsGoalBlock = [&](const int2& blockPos) {
+		const short2 bSquare = nodeOffsets[medResPS.BlockPosToIdx(blockPos)];
+		const int2 gSquare = blockPos * blockSize + goalSqrOffset;
+
+		return (pfDef.IsGoal(bSquare.x, bSquare.y) || pfDef.IsGoal(gSquare.x, gSquare.y));
+	};
+
+	{
+		const short2 strtSquare = nodeOffsets[medResPS.BlockPosToIdx(strtBlockPos)];
+
+		// as in IPathFinder::InitSearch
+		if (pfDef.IsGoal(strtSquare.x, strtSquare.y) && pfDef.startInGoalRadius)
+			return IPath::CantGetCloser;
+	}
+
+	std::vector<int2> blockPath;
+
+	if (!pathHierarchy.FindPath(moveDef.pathType, strtBlockPos, goalBlockPos, blockPath, &path.pathCost))
+		return IPath::Error;
+
+	// stop at the first block within the goal radius, the goal block itself always is
+	const auto goalIt = std::find_if(blockPath.begin(), blockPath.end(), IsGoalBlock);
+
+	if (goalIt != blockPath.end())
+		blockPath.erase(goalIt + 1, blockPath.end());
+
+	if (pfDef.needPath) {
+		// estimator paths are stored back-to-front
+		path.path.reserve(blockPath.size());
+		path.squares.reserve(blockPath.size());
+
+		for (auto it = blockPath.rbegin(); it != blockPath.rend(); ++it) {
+			const short2 square = nodeOffsets[medResPS.BlockPosToIdx(*it)];
+
+			path.path.emplace_back(square.x * SQUARE_SIZE, CMoveMath::yLevel(moveDef, square.x, square.y), square.y * SQUARE_SIZE);
+			path.squares.emplace_back(square.x, square.y);
+		}
+
+		path.pathGoal = path.path[0];
+	}
+
+	// the MT pathing system caches its results separately, see IPathFinder::GetPath
+	if (!TKPFS::PathingSystemActive)
+		lowResPS.AddCache(&path, IPath::Ok, lowResStrtBlock, lowResGoalBlock, pfDef.sqGoalRadius, moveDef.pathType, pfDef.synced);
+
+	return IPath::Ok;
+}
+
 IPath::SearchResult CPathManager::ArrangePath(
 	MultiPath* newPath,
 	const MoveDef* moveDef,
@@ -325,7 +421,21 @@ IPath::SearchResult CPathManager::ArrangePath(
 				pfDef->DisableConstraint(!useConstraints[n]);
 				pfDef->AllowRawPathSearch(allowRawSearch[n]);
 
-				const IPath::SearchResult currResult = ownPathFinders[n]->GetPath(*moveDef, *pfDef, caller, startPos, *pathObjects[n], nodeLimits[n]);
+				IPath::SearchResult currResult = IPath::Error;
+				unsigned int currSearch = n;
+
+				if (n == PATH_LOW_RES && modInfo.enableHierarchicalPathing) {
+					currResult = GetHierarchyPath(*moveDef, *pfDef, startPos, *pathObjects[n]);
+
+					// the low-res PE holds no vertex costs in this mode, so fall
+					// back to the regular med-res search (unless it already ran)
+					if (currResult == IPath::Error && heurGoalDist2D > searchDistances[PATH_MED_RES]) {
+						currSearch = PATH_MED_RES;
+						currResult = ownPathFinders[currSearch]->GetPath(*moveDef, *pfDef, caller, startPos, *pathObjects[currSearch], nodeLimits[currSearch]);
+					}
+				} else {
+					currResult = ownPathFinders[n]->GetPath(*moveDef, *pfDef, caller, startPos, *pathObjects[n], nodeLimits[n]);
+				}
 
 				// if (debugLoggingActive == currentThread){
 				// 	LOG("PATH level %d Search Result is: %d",  n, currResult);
@@ -336,7 +446,7 @@ IPath::SearchResult CPathManager::ArrangePath(
 					continue;
 
 				bestResult = currResult;
-				bestSearch = n;
+				bestSearch = currSearch;
 
 				// if (debugLoggingActive == currentThread){
 				// 	LOG("PATH Best level %d Search Result is: %d",  bestSearch, bestResult);
@@ -366,7 +476,8 @@ IPath::SearchResult CPathManager::ArrangePath(
 	// constraints enabled, run a final unconstrained fallback
 	// MED search (unconstrained MAX search is not useful with
 	// current node limits and could kill performance without)
-	if (heurGoalDist2D > searchDistances[PATH_MED_RES]) {
+	// with hierarchical pathing, the fallback above was this search
+	if (heurGoalDist2D > searchDistances[PATH_MED_RES] && !modInfo.enableHierarchicalPathing) {
 		pfDef->DisableConstraint(true);
 
 		// we can only have a low-res result at this point
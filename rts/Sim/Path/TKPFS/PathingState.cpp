@@ -2,9 +2,6 @@
 
 #include "PathingState.h"
 
-#include "zlib.h"
-#include "minizip/zip.h"
-
 #include "Game/GlobalUnsynced.h"
 #include "Game/LoadScreen.h"
 #include "Net/Protocol/NetProtocol.h"
@@ -13,21 +10,22 @@
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
 #include "PathFinder.h"
+#include "PathHierarchy.h"
 #include "Sim/Path/Default/IPath.h"
 #include "PathConstants.h"
 #include "Sim/Path/Default/PathFinderDef.h"
 #include "Sim/Path/Default/PathLog.h"
+#include "Sim/Path/PathEstimatorFile.h"
 #include "Sim/Path/TKPFS/PathGlobal.h"
 #include "PathMemPool.h"
 
 #include "System/Config/ConfigHandler.h"
-#include "System/FileSystem/Archives/IArchive.h"
-#include "System/FileSystem/ArchiveLoader.h"
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/FileQueryFlags.h"
 #include "System/Platform/Threading.h"
 #include "System/StringUtil.h"
+#include "System/Sync/SHA512.hpp"
 #include "System/Threading/ThreadPool.h" // for_mt
 
 #define ENABLE_NETLOG_CHECKSUM 1
@@ -48,8 +46,13 @@ static const std::string GetPathCacheDir() {
 	return (FileSystem::GetCacheDir() + "/paths/");
 }
 
-static const std::string GetCacheFileName(const std::string& fileHashCode, const std::string& peFileName, const std::string& mapFileName) {
-	return (GetPathCacheDir() + mapFileName + "." + peFileName + "-" + fileHashCode + ".zip");
+static const std::string GetCacheFileName(
+	const std::string& fileHashCode,
+	const std::string& peFileName,
+	const std::string& mapFileName,
+	const char* fileExtension = PathEstimatorFile::FILE_EXTENSION
+) {
+	return (GetPathCacheDir() + mapFileName + "." + peFileName + "-" + fileHashCode + fileExtension);
 }
 
 void PathingState::KillStatic() { pathingStates = 0; }
@@ -60,10 +63,11 @@ PathingState::PathingState()
 	pathCache[1] = nullptr;
 }
 
-void PathingState::Init(std::vector<IPathFinder*> pathFinderlist, PathingState* parentState, unsigned int _BLOCK_SIZE, const std::string& peFileName, const std::string& mapFileName)
+void PathingState::Init(std::vector<IPathFinder*> pathFinderlist, PathingState* parentState, unsigned int _BLOCK_SIZE, const std::string& peFileName, const std::string& mapFileName, bool precalc)
 {
 	BLOCK_SIZE = _BLOCK_SIZE;
 	BLOCK_PIXEL_SIZE = BLOCK_SIZE * SQUARE_SIZE;
+	precalcVertexCosts = precalc;
 
 	{
 		// 56 x 16 elms for QuickSilver
@@ -212,7 +216,8 @@ void PathingState::InitEstimator(const std::string& peFileName, const std::strin
 	// Not much point in multithreading these...
 	InitBlocks();
 
-	if (!ReadFile(peFileName, mapFileName)) {
+	// vertex costs stay infinite (which the checksum also covers)
+	if (precalcVertexCosts && !ReadFile(peFileName, mapFileName)) {
 		char calcMsg[512];
 		const char* fmtStrs[4] = {
 			"[%s] creating PE%u cache with %u PF threads",
@@ -229,11 +234,10 @@ void PathingState::InitEstimator(const std::string& peFileName, const std::strin
 		// note: only really needed if numExtraThreads > 0
 		spring::barrier pathBarrier(numThreads);
 
-		TKPFS::PathingSystemActive = true;
 		for_mt(0, numThreads, [this, &pathBarrier](int i) {
+			TKPFS::ScopedPathingSystem pathingSystem;
 			CalcOffsetsAndPathCosts(i, &pathBarrier);
 		});
-		TKPFS::PathingSystemActive = false;
 
 		sprintf(calcMsg, fmtStrs[2], __func__, BLOCK_SIZE, peFileName.c_str(), fileHashCode);
 		loadscreen->SetLoadMessage(calcMsg, true);
@@ -513,57 +517,16 @@ bool PathingState::ReadFile(const std::string& peFileName, const std::string& ma
 	if (!FileSystem::FileExists(cacheFileName))
 		return false;
 
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
-
-	if (upfile == nullptr || !upfile->IsOpen()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
 	char calcMsg[512];
 	sprintf(calcMsg, "Reading Estimate PathCosts [%d]", BLOCK_SIZE);
 	loadscreen->SetLoadMessage(calcMsg);
 
-	const unsigned fid = upfile->FindFile("pathinfo");
-	if (fid >= upfile->NumFiles()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	std::vector<std::uint8_t> buffer;
-
-	if (!upfile->GetFile(fid, buffer) || buffer.size() < 4) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	const unsigned int filehash = *(reinterpret_cast<unsigned int*>(&buffer[0]));
-	const unsigned int blockSize = blockStates.GetSize() * sizeof(short2);
-	unsigned int pos = sizeof(unsigned);
-
-	if (filehash != fileHashCode) {
+	// mapped and copied straight into the estimator arrays, nothing to inflate
+	if (!PathEstimatorFile::Read(dataDirsAccess.LocateFile(cacheFileName), fileHashCode, blockStates.peNodeOffsets, vertexCosts)) {
 		FileSystem::Remove(cacheFileName);
 		return false;
 	}
 
-	if (buffer.size() < (pos + blockSize * moveDefHandler.GetNumMoveDefs())) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	// read center-offset data
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		std::memcpy(&blockStates.peNodeOffsets[pathType][0], &buffer[pos], blockSize);
-		pos += blockSize;
-	}
-
-	// read vertex-cost data
-	if (buffer.size() < (pos + vertexCosts.size() * sizeof(float))) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	std::memcpy(&vertexCosts[0], &buffer[pos], vertexCosts.size() * sizeof(float));
 	return true;
 }
 
@@ -582,38 +545,15 @@ bool PathingState::WriteFile(const std::string& peFileName, const std::string& m
 
 	LOG("[PathEstimator::%s] hash=%s file=\"%s\" (exists=%d)", __func__, hashHexString.c_str(), cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
 
-	// open file for writing in a suitable location
-	zipFile file = zipOpen(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE).c_str(), APPEND_STATUS_CREATE);
-
-	if (file == nullptr)
+	if (!PathEstimatorFile::Write(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE), fileHashCode, blockStates.peNodeOffsets, vertexCosts))
 		return false;
 
-	zipOpenNewFileInZip(file, "pathinfo", nullptr, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, Z_BEST_COMPRESSION);
-
-	// write hash-code (NOTE: this also affects the CRC!)
-	zipWriteInFileInZip(file, (const void*) &fileHashCode, 4);
-
-	// write center-offsets
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		zipWriteInFileInZip(file, (const void*) &blockStates.peNodeOffsets[pathType][0], blockStates.peNodeOffsets[pathType].size() * sizeof(short2));
-	}
-
-	// write vertex-costs
-	zipWriteInFileInZip(file, vertexCosts.data(), vertexCosts.size() * sizeof(float));
-
-	zipCloseFileInZip(file);
-	zipClose(file, nullptr);
+	// the old-format cache for the same hash is never read again
+	const std::string legacyFileName = GetCacheFileName(hashHexString, peFileName, mapFileName, PathEstimatorFile::LEGACY_FILE_EXTENSION);
 
+	if (FileSystem::FileExists(legacyFileName))
+		FileSystem::Remove(legacyFileName);
 
-	// get the CRC over the written path data
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
-
-	if (upfile == nullptr || !upfile->IsOpen()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	assert(upfile->FindFile("pathinfo") < upfile->NumFiles());
 	return true;
 }
 
@@ -745,15 +685,21 @@ void PathingState::UpdateVertexPathCosts(int blocksToUpdate)
 		std::atomic<std::int64_t> updateCostBlockNum = consumedBlocks.size();
 		const size_t threadsUsed = std::min(consumedBlocks.size(), (size_t)ThreadPool::GetNumThreads());
 
-		TKPFS::PathingSystemActive = true;
 		for_mt (0, threadsUsed, [this, &updateCostBlockNum](int threadNum){
+			TKPFS::ScopedPathingSystem pathingSystem;
 			std::int64_t n;
 			while ((n = --updateCostBlockNum) >= 0){
 				//LOG("TK PathingState::Update: PROC moveDef = %d %p (%p)", n, &consumedBlocks[n], consumedBlocks[n].moveDef);
 				CalcVertexPathCosts(*consumedBlocks[n].moveDef, consumedBlocks[n].blockPos, threadNum);
 			}
 		});
-		TKPFS::PathingSystemActive = false;
+	}
+
+	if (pathHierarchy != nullptr) {
+		// consumed in runs of numMoveDefs per block
+		for (size_t n = 0; n < consumedBlocks.size(); n += numMoveDefs) {
+			pathHierarchy->BlocksChanged(consumedBlocks[n].blockPos, consumedBlocks[n].blockPos);
+		}
 	}
 }
 
@@ -766,6 +712,9 @@ void PathingState::MapChanged(unsigned int x1, unsigned int z1, unsigned int x2,
 	assert(x2 >= x1);
 	assert(z2 >= z1);
 
+	if (!precalcVertexCosts)
+		return;
+
 	// find the upper and lower corner of the rectangular area
 	const int lowerX = Clamp(int(x1 / BLOCK_SIZE) - 1, 0, int(mapDimensionsInBlocks.x - 1));
 	const int upperX = Clamp(int(x2 / BLOCK_SIZE) + 1, 0, int(mapDimensionsInBlocks.x - 1));
@@ -20,13 +20,14 @@ namespace TKPFS {
 
 class CPathEstimator;
 class CPathFinder;
+class PathHierarchy;
 
 class PathingState {
 public:
 
 	PathingState();
 
-    void Init(std::vector<IPathFinder*> pathFinderlist, PathingState* parentState, unsigned int BLOCK_SIZE, const std::string& peFileName, const std::string& mapFileName);
+    void Init(std::vector<IPathFinder*> pathFinderlist, PathingState* parentState, unsigned int BLOCK_SIZE, const std::string& peFileName, const std::string& mapFileName, bool precalc = true);
 
     void Terminate();
 
@@ -164,6 +165,12 @@ private:
 
 	//IPathFinder* parentPathFinder; // parent (PF if BLOCK_SIZE is 16, PE[16] if 32)
     PathingState* nextPathState = nullptr;
+    // built on top of our blocks, informed when they are recalculated
+    PathHierarchy* pathHierarchy = nullptr;
+
+    // false if nothing searches this state (its levels are replaced by the
+    // hierarchy), which then skips calculating and updating vertex costs
+    bool precalcVertexCosts = true;
 
     CPathCache* pathCache[2]; // [0] = !synced, [1] = synced
 
@@ -45,6 +45,10 @@ public:
 	//Not inheritable - used for removing a projectile from Lua.
 	void Delete();
 	virtual void Update();
+	/// thread-safe variant of Update for synced projectiles; must leave the
+	/// projectile untouched and return false if this frame's update would
+	/// affect anything but the projectile itself (explosions, CEGs, etc.)
+	virtual bool UpdateMt() { return false; }
 	virtual void Init(const CUnit* owner, const float3& offset) override;
 
 	virtual void Draw() {}
@@ -5,6 +5,7 @@
 #include "Projectile.h"
 #include "ProjectileHandler.h"
 #include "ProjectileMemPool.h"
+#include "SyncedProjectileUpdate.h"
 #include "Game/GlobalUnsynced.h"
 #include "Game/TraceRay.h"
 #include "Map/Ground.h"
@@ -15,6 +16,7 @@
 #include "Sim/Misc/CollisionHandler.h"
 #include "Sim/Misc/CollisionVolume.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/QuadField.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Rendering/Env/Particles/Classes/NanoProjectile.h"
@@ -29,6 +31,7 @@
 #include "System/Log/ILog.h"
 #include "System/Cpp11Compat.hpp"
 #include "System/SpringMath.h"
+#include "System/Sync/SyncedPrimitiveBase.h"
 #include "System/TimeProfiler.h"
 #include "System/Threading/ThreadPool.h"
 
@@ -53,7 +56,9 @@ CR_REG_METADATA(CProjectileHandler, (
 	CR_MEMBER(maxNanoParticles),
 	CR_MEMBER(currentNanoParticles),
 	CR_MEMBER_UN(frameCurrentParticles),
-	CR_MEMBER_UN(frameProjectileCounts)
+	CR_MEMBER_UN(frameProjectileCounts),
+
+	CR_IGNORED(syncedUpdatedMT)
 ))
 
 
@@ -184,17 +189,17 @@ void CProjectileHandler::UpdateProjectilesImpl()
 
 	// WARNING: same as above but for p->Update()
 	if constexpr (synced) {
-		for (size_t i = 0; i < pc.size(); ++i) {
-			CProjectile* p = pc[i];
-			assert(p != nullptr);
+		const auto check = [](const CProjectile* p) { MAPPOS_SANITY_CHECK(p->pos); };
+		const auto moved = [](CProjectile* p) { quadField.MovedProjectile(p); };
 
-			MAPPOS_SANITY_CHECK(p->pos);
+		size_t numUpdatedMT = 0;
 
-			p->Update();
-			quadField.MovedProjectile(p);
-
-			MAPPOS_SANITY_CHECK(p->pos);
+		if (modInfo.enableParallelProjectileUpdate) {
+			SCOPED_TIMER("Sim::Projectiles::UpdateMT");
+			numUpdatedMT = SyncedProjectileUpdate::UpdateParallel(pc, syncedUpdatedMT, check);
 		}
+
+		SyncedProjectileUpdate::UpdateSerial(pc, syncedUpdatedMT, numUpdatedMT, check, moved);
 	}
 	else {
 		for_mt_chunk(0, pc.size(), [&pc](int i) {
@@ -405,18 +410,139 @@ static bool CheckProjectileCollisionFlags(const CProjectile* p, const CUnit* u)
 }
 
 
+template<typename DetectHitFunc>
+static bool DetectCandidateHit(
+	const ProjectileCollisionCandidates::HitTest* hitTests,
+	size_t candidateIdx,
+	CollisionQuery& cq,
+	const DetectHitFunc& detectHit
+) {
+	// no precomputed result for this candidate, test it now
+	if (hitTests == nullptr || hitTests[candidateIdx].result < 0)
+		return (detectHit());
+
+	cq.Reset(&hitTests[candidateIdx].cq);
+	return (hitTests[candidateIdx].result != 0);
+}
+
+static bool DetectShieldHit(const CPlasmaRepulser* repulser, const float3 ppos0, const float3 ppos1, CollisionQuery& cq)
+{
+	// we sometimes get false inside hits due to the movement of the shield
+	// a very hacky solution is to nudge the start of the intersecting ray
+	// back (proportional to how far the shield moved last frame) so as to
+	// increase its length.
+	// it's not 100% accurate so there's a bit of a FIXME here to do a real
+	// solution (keep track in the projectile which shields it's in)
+	const float3 rpvec  = ppos0 - ppos1;
+	const float3 rppos0 = ppos0 + rpvec * repulser->GetDeltaDist();
+	const float3 cvpos  = repulser->weaponMuzzlePos - repulser->owner->relMidPos;
+
+	// shield volumes are always spherical, transform directly
+	// (CollisionHandler will cancel out the relmidpos offset)
+	return (CCollisionHandler::DetectHit(repulser->owner, &repulser->collisionVolume, CMatrix44f{cvpos}, rppos0, ppos1, &cq));
+}
+
+// broad-phase and side-effect free narrow-phase for one projectile, safe to
+// call from any thread; the hit-tests only depend on geometry, all filters
+// that read mutable state are re-evaluated when the collisions are applied
+static void GatherCollisionCandidates(
+	const CProjectile* p,
+	ProjectileCollisionCandidates& cc,
+	const ProjectileCollisionCandidates::Buffers& buffers,
+	int thread
+) {
+	const float3 ppos0 = p->pos;
+	const float3 ppos1 = p->pos + p->speed;
+
+	std::vector<CUnit*>& units = *buffers.units;
+	std::vector<CFeature*>& features = *buffers.features;
+	std::vector<CPlasmaRepulser*>& repulsers = *buffers.repulsers;
+	std::vector<ProjectileCollisionCandidates::HitTest>& hitTests = *buffers.hitTests;
+
+	cc.thread = thread;
+	cc.pos = p->pos;
+	cc.speed = p->speed;
+
+	cc.unitsBeg = units.size();
+	cc.featuresBeg = features.size();
+	cc.repulsersBeg = repulsers.size();
+
+	quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, units, features, &repulsers, thread);
+
+	cc.numUnits = units.size() - cc.unitsBeg;
+	cc.numFeatures = features.size() - cc.featuresBeg;
+	cc.numRepulsers = repulsers.size() - cc.repulsersBeg;
+
+	cc.hitTestsBeg = hitTests.size();
+	hitTests.resize(hitTests.size() + cc.numUnits + cc.numFeatures + cc.numRepulsers);
+
+	ProjectileCollisionCandidates::HitTest* unitHitTests = hitTests.data() + cc.hitTestsBeg;
+	ProjectileCollisionCandidates::HitTest* featureHitTests = unitHitTests + cc.numUnits;
+	ProjectileCollisionCandidates::HitTest* repulserHitTests = featureHitTests + cc.numFeatures;
+
+	// piece-tree volumes are left untested, their matrices are updated lazily
+	if (p->weapon && static_cast<const CWeaponProjectile*>(p)->GetWeaponDef()->interceptedByShieldType != 0) {
+		for (size_t i = 0; i < cc.numRepulsers; i++) {
+			const CPlasmaRepulser* repulser = repulsers[cc.repulsersBeg + i];
+			auto& ht = repulserHitTests[i];
+
+			if (repulser->collisionVolume.DefaultToPieceTree())
+				continue;
+
+			ht.result = DetectShieldHit(repulser, ppos0, ppos1, ht.cq);
+		}
+	}
+
+	for (size_t i = 0; i < cc.numUnits; i++) {
+		const CUnit* unit = units[cc.unitsBeg + i];
+		auto& ht = unitHitTests[i];
+
+		if (unit == p->owner())
+			continue;
+		if (!unit->HasCollidableStateBit(CSolidObject::CSTATE_BIT_PROJECTILES))
+			continue;
+		if (!CheckProjectileCollisionFlags(p, unit))
+			continue;
+		if (unit->collisionVolume.DefaultToPieceTree())
+			continue;
+
+		// anything beyond the first hit is only visited if the filters change
+		if ((ht.result = CCollisionHandler::DetectHit(unit, unit->GetTransformMatrix(true), ppos0, ppos1, &ht.cq)))
+			break;
+	}
+
+	if ((p->GetCollisionFlags() & Collision::NOFEATURES) != 0)
+		return;
+
+	for (size_t i = 0; i < cc.numFeatures; i++) {
+		const CFeature* feature = features[cc.featuresBeg + i];
+		auto& ht = featureHitTests[i];
+
+		if (!feature->HasCollidableStateBit(CSolidObject::CSTATE_BIT_PROJECTILES))
+			continue;
+		if (feature->collisionVolume.DefaultToPieceTree())
+			continue;
+
+		if ((ht.result = CCollisionHandler::DetectHit(feature, feature->GetTransformMatrix(true), ppos0, ppos1, &ht.cq)))
+			break;
+	}
+}
+
+
 void CProjectileHandler::CheckUnitCollisions(
 	CProjectile* p,
 	std::vector<CUnit*>& tempUnits,
 	const float3 ppos0,
-	const float3 ppos1
+	const float3 ppos1,
+	const ProjectileCollisionCandidates::HitTest* hitTests
 ) {
 	if (!p->checkCol)
 		return;
 
 	CollisionQuery cq;
 
-	for (CUnit* unit: tempUnits) {
+	for (size_t i = 0; i < tempUnits.size(); i++) {
+		CUnit* unit = tempUnits[i];
 		assert(unit != nullptr);
 
 		// if this unit fired this projectile, always ignore
@@ -428,7 +554,9 @@ void CProjectileHandler::CheckUnitCollisions(
 		if (!CheckProjectileCollisionFlags(p, unit))
 			continue;
 
-		if (CCollisionHandler::DetectHit(unit, unit->GetTransformMatrix(true), ppos0, ppos1, &cq)) {
+		const auto detectHit = [&]() { return (CCollisionHandler::DetectHit(unit, unit->GetTransformMatrix(true), ppos0, ppos1, &cq)); };
+
+		if (DetectCandidateHit(hitTests, i, cq, detectHit)) {
 			if (cq.GetHitPiece() != nullptr)
 				unit->SetLastHitPiece(cq.GetHitPiece(), gs->frameNum, p->synced);
 
@@ -449,7 +577,8 @@ void CProjectileHandler::CheckFeatureCollisions(
 	CProjectile* p,
 	std::vector<CFeature*>& tempFeatures,
 	const float3 ppos0,
-	const float3 ppos1
+	const float3 ppos1,
+	const ProjectileCollisionCandidates::HitTest* hitTests
 ) {
 	// already collided with unit?
 	if (!p->checkCol)
@@ -460,13 +589,16 @@ void CProjectileHandler::CheckFeatureCollisions(
 
 	CollisionQuery cq;
 
-	for (CFeature* feature: tempFeatures) {
+	for (size_t i = 0; i < tempFeatures.size(); i++) {
+		CFeature* feature = tempFeatures[i];
 		assert(feature != nullptr);
 
 		if (!feature->HasCollidableStateBit(CSolidObject::CSTATE_BIT_PROJECTILES))
 			continue;
 
-		if (CCollisionHandler::DetectHit(feature, feature->GetTransformMatrix(true), ppos0, ppos1, &cq)) {
+		const auto detectHit = [&]() { return (CCollisionHandler::DetectHit(feature, feature->GetTransformMatrix(true), ppos0, ppos1, &cq)); };
+
+		if (DetectCandidateHit(hitTests, i, cq, detectHit)) {
 			if (cq.GetHitPiece() != nullptr)
 				feature->SetLastHitPiece(cq.GetHitPiece(), gs->frameNum, p->synced);
 
@@ -488,7 +620,8 @@ void CProjectileHandler::CheckShieldCollisions(
 	CProjectile* p,
 	std::vector<CPlasmaRepulser*>& tempRepulsers,
 	const float3 ppos0,
-	const float3 ppos1
+	const float3 ppos1,
+	const ProjectileCollisionCandidates::HitTest* hitTests
 ) {
 	if (!p->checkCol)
 		return;
@@ -508,25 +641,16 @@ void CProjectileHandler::CheckShieldCollisions(
 
 	CollisionQuery cq;
 
-	for (CPlasmaRepulser* repulser: tempRepulsers) {
+	for (size_t i = 0; i < tempRepulsers.size(); i++) {
+		CPlasmaRepulser* repulser = tempRepulsers[i];
 		assert(repulser != nullptr);
 
 		if (!repulser->CanIntercept(interceptType, projAllyTeam))
 			continue;
 
-		// we sometimes get false inside hits due to the movement of the shield
-		// a very hacky solution is to nudge the start of the intersecting ray
-		// back (proportional to how far the shield moved last frame) so as to
-		// increase its length.
-		// it's not 100% accurate so there's a bit of a FIXME here to do a real
-		// solution (keep track in the projectile which shields it's in)
-		const float3 rpvec  = ppos0 - ppos1;
-		const float3 rppos0 = ppos0 + rpvec * repulser->GetDeltaDist();
-		const float3 cvpos  = repulser->weaponMuzzlePos - repulser->owner->relMidPos;
-
-		// shield volumes are always spherical, transform directly
-		// (CollisionHandler will cancel out the relmidpos offset)
-		if (!CCollisionHandler::DetectHit(repulser->owner, &repulser->collisionVolume, CMatrix44f{cvpos}, rppos0, ppos1, &cq))
+		const auto detectHit = [&]() { return (DetectShieldHit(repulser, ppos0, ppos1, cq)); };
+
+		if (!DetectCandidateHit(hitTests, i, cq, detectHit))
 			continue;
 
 		if (cq.InsideHit() && repulser->IgnoreInteriorHit(wpro))
@@ -539,6 +663,11 @@ void CProjectileHandler::CheckShieldCollisions(
 
 void CProjectileHandler::CheckUnitFeatureCollisions(bool synced)
 {
+	if (modInfo.enableParallelProjectileCollisions) {
+		CheckUnitFeatureCollisionsMT(synced);
+		return;
+	}
+
 	static std::vector<CUnit*> tempUnits;
 	static std::vector<CFeature*> tempFeatures;
 	static std::vector<CPlasmaRepulser*> tempRepulsers;
@@ -562,6 +691,97 @@ void CProjectileHandler::CheckUnitFeatureCollisions(bool synced)
 	}
 }
 
+void CProjectileHandler::CheckUnitFeatureCollisionsMT(bool synced)
+{
+	static std::vector<CUnit*> tempUnits;
+	static std::vector<CFeature*> tempFeatures;
+	static std::vector<CPlasmaRepulser*> tempRepulsers;
+
+	auto& pc = projectiles[synced];
+	auto& cc = collisionCandidates;
+
+	const size_t numCandidates = pc.size();
+	const std::uint64_t gatherStamp = quadField.GetChangeStamp();
+
+	if (cc.size() < numCandidates)
+		cc.resize(numCandidates);
+
+	for (int t = 0; t < ThreadPool::GetNumThreads(); t++) {
+		candidateBuffers[t].units = candidateUnits[t].ReserveVector();
+		candidateBuffers[t].features = candidateFeatures[t].ReserveVector();
+		candidateBuffers[t].repulsers = candidateRepulsers[t].ReserveVector();
+		candidateBuffers[t].hitTests = candidateHitTests[t].ReserveVector();
+	}
+
+	{
+		SCOPED_TIMER("Sim::Projectiles::Collisions::GatherMT");
+
+		for_mt_chunk(0, numCandidates, [&](int i) {
+			const CProjectile* p = pc[i];
+			const int thread = ThreadPool::GetThreadNum();
+
+			cc[i].Clear();
+
+			if (!p->checkCol) return;
+			if ( p->deleteMe) return;
+
+			GatherCollisionCandidates(p, cc[i], candidateBuffers[thread], thread);
+		});
+	}
+
+	// Collision() callbacks run serially in container order. Candidates are
+	// only used if neither the projectile nor any quad it reads has changed
+	// since they were gathered; otherwise (a projectile added or moved, an
+	// earlier collision that spawned or removed a wreck or unit, ...) this
+	// queries the quadfield again like the single-threaded path does. The
+	// remaining difference: hit-tests are not redone for units or features
+	// whose position or collision volume changed without a quadfield update
+	// (e.g. MoveCtrl.SetPosition or SetUnitCollisionVolumeData from a Lua
+	// callin during this loop); all other filters are re-checked as usual.
+	for (size_t i = 0; i < pc.size(); ++i) {
+		CProjectile* p = pc[i];
+
+		if (!p->checkCol) continue;
+		if ( p->deleteMe) continue;
+
+		const float3 ppos0 = p->pos;
+		const float3 ppos1 = p->pos + p->speed;
+
+		if (i < numCandidates && cc[i].Gathered() && cc[i].pos.same(ppos0) && cc[i].speed.same(p->speed)) {
+			const ProjectileCollisionCandidates& c = cc[i];
+			const ProjectileCollisionCandidates::Buffers& b = candidateBuffers[c.thread];
+
+			if (!quadField.ChangedSince(ppos0, p->speed.w + p->radius, gatherStamp)) {
+				const ProjectileCollisionCandidates::HitTest* hitTests = b.hitTests->data() + c.hitTestsBeg;
+
+				tempUnits.assign(b.units->begin() + c.unitsBeg, b.units->begin() + c.unitsBeg + c.numUnits);
+				tempFeatures.assign(b.features->begin() + c.featuresBeg, b.features->begin() + c.featuresBeg + c.numFeatures);
+				tempRepulsers.assign(b.repulsers->begin() + c.repulsersBeg, b.repulsers->begin() + c.repulsersBeg + c.numRepulsers);
+
+				CheckShieldCollisions (p, tempRepulsers, ppos0, ppos1, hitTests + c.numUnits + c.numFeatures); tempRepulsers.clear();
+				CheckUnitCollisions   (p, tempUnits    , ppos0, ppos1, hitTests                            ); tempUnits.clear();
+				CheckFeatureCollisions(p, tempFeatures , ppos0, ppos1, hitTests + c.numUnits               ); tempFeatures.clear();
+				continue;
+			}
+		}
+
+		quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
+
+		CheckShieldCollisions (p, tempRepulsers, ppos0, ppos1); tempRepulsers.clear();
+		CheckUnitCollisions   (p, tempUnits    , ppos0, ppos1); tempUnits.clear();
+		CheckFeatureCollisions(p, tempFeatures , ppos0, ppos1); tempFeatures.clear();
+	}
+
+	for (int t = 0; t < ThreadPool::GetNumThreads(); t++) {
+		candidateUnits[t].ReleaseVector(candidateBuffers[t].units);
+		candidateFeatures[t].ReleaseVector(candidateBuffers[t].features);
+		candidateRepulsers[t].ReleaseVector(candidateBuffers[t].repulsers);
+		candidateHitTests[t].ReleaseVector(candidateBuffers[t].hitTests);
+
+		candidateBuffers[t] = {};
+	}
+}
+
 void CProjectileHandler::CheckGroundCollisions(bool synced)
 {
 	//can't use iterators here, because instructions inside the loop modify projectiles[synced]
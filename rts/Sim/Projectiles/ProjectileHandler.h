@@ -8,6 +8,8 @@
 
 #include "Rendering/Models/3DModel.h"
 #include "Rendering/Env/Particles/Classes/FlyingPiece.h"
+#include "Sim/Misc/CollisionHandler.h"
+#include "Sim/Misc/QuadField.h"
 #include "System/float3.h"
 #include "System/FreeListMap.h"
 
@@ -25,6 +27,46 @@ struct UnitDef;
 typedef std::vector<CGroundFlash*> GroundFlashContainer;
 typedef std::vector<FlyingPiece> FlyingPieceContainer;
 
+
+// broad-phase candidates of one projectile plus the narrow-phase hit-tests
+// precomputed for them by the parallel part of CheckUnitFeatureCollisions;
+// both are stored in the buffers of the thread that gathered them
+struct ProjectileCollisionCandidates {
+	struct HitTest {
+		CollisionQuery cq;
+		// 1 := hit, 0 := miss, -1 := not tested (done when the candidate is visited)
+		int result = -1;
+	};
+
+	// per-thread storage, reserved from QueryVectorCache's for one pass
+	struct Buffers {
+		std::vector<CUnit*>* units = nullptr;
+		std::vector<CFeature*>* features = nullptr;
+		std::vector<CPlasmaRepulser*>* repulsers = nullptr;
+		std::vector<HitTest>* hitTests = nullptr;
+	};
+
+	void Clear() { thread = -1; }
+	bool Gathered() const { return (thread >= 0); }
+
+	// index of the Buffers holding the candidates, -1 if none were gathered
+	int thread = -1;
+
+	// ranges into Buffers; the hit-tests for units, features and repulsers
+	// are stored back to back starting at hitTestsBeg
+	unsigned int unitsBeg = 0;
+	unsigned int numUnits = 0;
+	unsigned int featuresBeg = 0;
+	unsigned int numFeatures = 0;
+	unsigned int repulsersBeg = 0;
+	unsigned int numRepulsers = 0;
+	unsigned int hitTestsBeg = 0;
+
+	// projectile state the tests were computed for
+	float3 pos;
+	float3 speed;
+};
+
 class CProjectileHandler
 {
 	CR_DECLARE_STRUCT(CProjectileHandler)
@@ -43,10 +85,11 @@ public:
 		return projectiles[synced];
 	}
 
-	void CheckUnitCollisions(CProjectile*, std::vector<CUnit*>&, const float3, const float3);
-	void CheckFeatureCollisions(CProjectile*, std::vector<CFeature*>&, const float3, const float3);
-	void CheckShieldCollisions(CProjectile*, std::vector<CPlasmaRepulser*>&, const float3, const float3);
+	void CheckUnitCollisions(CProjectile*, std::vector<CUnit*>&, const float3, const float3, const ProjectileCollisionCandidates::HitTest* hitTests = nullptr);
+	void CheckFeatureCollisions(CProjectile*, std::vector<CFeature*>&, const float3, const float3, const ProjectileCollisionCandidates::HitTest* hitTests = nullptr);
+	void CheckShieldCollisions(CProjectile*, std::vector<CPlasmaRepulser*>&, const float3, const float3, const ProjectileCollisionCandidates::HitTest* hitTests = nullptr);
 	void CheckUnitFeatureCollisions(bool synced);
+	void CheckUnitFeatureCollisionsMT(bool synced);
 	void CheckGroundCollisions(bool synced);
 	void CheckCollisions();
 
@@ -115,6 +158,19 @@ private:
 	// [1] contains only projectiles that can     change simulation state
 	spring::FreeListMapCompact<CProjectile*, int> projectiles[2];
 
+	// per-frame flags for synced projectiles that were updated by UpdateMt
+	std::vector<uint8_t> syncedUpdatedMT;
+
+	// per-projectile candidate ranges and per-thread candidate storage
+	// for CheckUnitFeatureCollisionsMT
+	std::vector<ProjectileCollisionCandidates> collisionCandidates;
+	std::array<ProjectileCollisionCandidates::Buffers, ThreadPool::MAX_THREADS> candidateBuffers;
+
+	std::array< QueryVectorCache<CUnit*>, ThreadPool::MAX_THREADS > candidateUnits;
+	std::array< QueryVectorCache<CFeature*>, ThreadPool::MAX_THREADS > candidateFeatures;
+	std::array< QueryVectorCache<CPlasmaRepulser*>, ThreadPool::MAX_THREADS > candidateRepulsers;
+	std::array< QueryVectorCache<ProjectileCollisionCandidates::HitTest>, ThreadPool::MAX_THREADS > candidateHitTests;
+
 	static uint32_t UnsyncedRandInt(uint32_t N);
 	static uint32_t   SyncedRandInt(uint32_t N);
 
@@ -0,0 +1,70 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SYNCED_PROJECTILE_UPDATE_H
+#define SYNCED_PROJECTILE_UPDATE_H
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "System/Sync/SyncedPrimitiveBase.h"
+#include "System/Threading/ThreadPool.h"
+
+/*
+ * The two phases of CProjectileHandler's synced projectile update, on any
+ * container of pointers to a type that provides CProjectile's Update and
+ * UpdateMt (which lets the test compare both modes without a simulation).
+ */
+namespace SyncedProjectileUpdate {
+	// phase 1: projectiles whose update this frame has no side-effects beyond
+	// their own position and state advance in parallel; all the others are
+	// flagged in <updatedMT> and handled by UpdateSerial
+	// note: the sync checksum differs from a serial frame (parallel sections
+	// fold order-independent lane sums into it), so compare /DumpState output
+	// of two runs to check that the state does not
+	template<typename Container, typename Check>
+	size_t UpdateParallel(Container& pc, std::vector<std::uint8_t>& updatedMT, Check&& check)
+	{
+		SCOPED_SYNC_PARALLEL_SECTION();
+
+		updatedMT.clear();
+		updatedMT.resize(pc.size(), false);
+
+		for_mt_chunk(0, updatedMT.size(), [&](int i) {
+			SCOPED_SYNC_PARALLEL_ITEM(i);
+
+			auto* p = pc[i];
+			assert(p != nullptr);
+
+			check(p);
+			updatedMT[i] = p->UpdateMt();
+			check(p);
+		});
+
+		return (updatedMT.size());
+	}
+
+	// phase 2: serial Update()'s of the first <numUpdatedMT> projectiles that
+	// were not updated by UpdateParallel and all the ones after, then <moved>
+	// for every projectile in container order, identical to what a fully
+	// serial loop would have done (new projectiles spawned along the way are
+	// appended and also processed)
+	template<typename Container, typename Check, typename Moved>
+	void UpdateSerial(Container& pc, const std::vector<std::uint8_t>& updatedMT, size_t numUpdatedMT, Check&& check, Moved&& moved)
+	{
+		for (size_t i = 0; i < pc.size(); ++i) {
+			auto* p = pc[i];
+			assert(p != nullptr);
+
+			if (i >= numUpdatedMT || !updatedMT[i]) {
+				check(p);
+				p->Update();
+				check(p);
+			}
+
+			moved(p);
+		}
+	}
+}
+
+#endif // SYNCED_PROJECTILE_UPDATE_H
@@ -36,6 +36,19 @@ CEmgProjectile::CEmgProjectile(const ProjectileParams& params): CWeaponProjectil
 	}
 }
 
+bool CEmgProjectile::UpdateMt()
+{
+	// trailing a CEG this frame
+	if (ttl > 0 && explGenHandler.GetGenerator(cegID) != nullptr)
+		return false;
+	if (!CanUpdateMt())
+		return false;
+
+	// no CEG, bounce or interception left; Update only touches this
+	Update();
+	return true;
+}
+
 void CEmgProjectile::Update()
 {
 	// disable collisions when ttl reaches 0 since the
@@ -15,6 +15,7 @@ public:
 	CEmgProjectile(const ProjectileParams& params);
 
 	void Update() override;
+	bool UpdateMt() override;
 	void Draw() override;
 
 	int GetProjectilesCount() const override;
@@ -42,20 +42,25 @@ CExplosiveProjectile::CExplosiveProjectile(const ProjectileParams& params): CWea
 	}
 }
 
-void CExplosiveProjectile::Update()
+void CExplosiveProjectile::UpdateFlight()
 {
 	CProjectile::Update();
 
-	if (--ttl == 0) {
+	ttl -= 1;
+	curTime = std::min(curTime + invttl, 1.0f);
+}
+
+void CExplosiveProjectile::Update()
+{
+	UpdateFlight();
+
+	if (ttl == 0) {
 		Collision();
 	} else {
 		if (ttl > 0)
 			explGenHandler.GenExplosion(cegID, pos, speed, ttl, damages->damageAreaOfEffect, 0.0f, owner(), nullptr);
 	}
 
-	curTime += invttl;
-	curTime = std::min(curTime, 1.0f);
-
 	if (weaponDef->noExplode && TraveledRange()) {
 		CProjectile::Collision();
 		return;
@@ -65,6 +70,19 @@ void CExplosiveProjectile::Update()
 	UpdateInterception();
 }
 
+bool CExplosiveProjectile::UpdateMt()
+{
+	// expiring or trailing a CEG this frame
+	if (ttl == 1 || (ttl > 1 && explGenHandler.GetGenerator(cegID) != nullptr))
+		return false;
+	// range-expiry is left to the serial path as well
+	if (weaponDef->noExplode || !CanUpdateMt())
+		return false;
+
+	UpdateFlight();
+	return true;
+}
+
 void CExplosiveProjectile::Draw()
 {
 	// do not draw if a 3D model has been defined for us
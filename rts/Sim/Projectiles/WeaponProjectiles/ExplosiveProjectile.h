@@ -15,12 +15,17 @@ public:
 	CExplosiveProjectile(const ProjectileParams& params);
 
 	void Update() override;
+	bool UpdateMt() override;
 	void Draw() override;
 
 	int GetProjectilesCount() const override;
 
 	int ShieldRepulse(const float3& shieldPos, float shieldForce, float shieldMaxSpeed) override;
 
+private:
+	/// the part of Update shared with UpdateMt: movement, ttl and color-map time
+	void UpdateFlight();
+
 private:
 	float invttl;
 	float curTime;
@@ -74,6 +74,19 @@ void CLaserProjectile::Update()
 	deleteMe |= ((intensity <= 0.01f) && (!weaponDef->laserHardStop));
 }
 
+bool CLaserProjectile::UpdateMt()
+{
+	// trailing a CEG this frame
+	if (ttl > 0 && explGenHandler.GetGenerator(cegID) != nullptr)
+		return false;
+	if (!CanUpdateMt())
+		return false;
+
+	// no CEG, bounce or interception left; Update only touches this
+	Update();
+	return true;
+}
+
 void CLaserProjectile::UpdateIntensity() {
 	if (ttl > 0) {
 		explGenHandler.GenExplosion(cegID, pos, speed, ttl, intensity, 0.0f, owner(), nullptr);
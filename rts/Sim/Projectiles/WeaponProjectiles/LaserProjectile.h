@@ -16,6 +16,7 @@ public:
 
 	void Draw() override;
 	void Update() override;
+	bool UpdateMt() override;
 	void Collision(CUnit* unit) override;
 	void Collision(CFeature* feature) override;
 	void Collision() override;
@@ -269,6 +269,16 @@ void CWeaponProjectile::Update()
 }
 
 
+bool CWeaponProjectile::CanUpdateMt() const
+{
+	// bounce and interception are left to the serial path; targetable
+	// projectiles can be read by interceptors during that path
+	if (weaponDef->groundBounce || weaponDef->waterBounce || weaponDef->targetable)
+		return false;
+
+	return (dynamic_cast<const CWeaponProjectile*>(target) == nullptr);
+}
+
 void CWeaponProjectile::UpdateInterception()
 {
 	if (target == nullptr)
@@ -76,6 +76,8 @@ public:
 
 protected:
 	CWeaponProjectile() { }
+	/// false if this frame's Update could bounce, intercept or be read by an interceptor
+	bool CanUpdateMt() const;
 	void UpdateInterception();
 	virtual void UpdateGroundBounce();
 
@@ -0,0 +1,272 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "CobDecoder.h"
+
+
+// Command documentation from http://visualta.tauniverse.com/Downloads/cob-commands.txt
+// And some information from basm0.8 source (basm ops.txt)
+
+// Model interaction
+constexpr int MOVE       = 0x10001000;
+constexpr int TURN       = 0x10002000;
+constexpr int SPIN       = 0x10003000;
+constexpr int STOP_SPIN  = 0x10004000;
+constexpr int SHOW       = 0x10005000;
+constexpr int HIDE       = 0x10006000;
+constexpr int CACHE      = 0x10007000;
+constexpr int DONT_CACHE = 0x10008000;
+constexpr int MOVE_NOW   = 0x1000B000;
+constexpr int TURN_NOW   = 0x1000C000;
+constexpr int SHADE      = 0x1000D000;
+constexpr int DONT_SHADE = 0x1000E000;
+constexpr int EMIT_SFX   = 0x1000F000;
+
+// Blocking operations
+constexpr int WAIT_TURN  = 0x10011000;
+constexpr int WAIT_MOVE  = 0x10012000;
+constexpr int SLEEP      = 0x10013000;
+
+// Stack manipulation
+constexpr int PUSH_CONSTANT    = 0x10021001;
+constexpr int PUSH_LOCAL_VAR   = 0x10021002;
+constexpr int PUSH_STATIC      = 0x10021004;
+constexpr int CREATE_LOCAL_VAR = 0x10022000;
+constexpr int POP_LOCAL_VAR    = 0x10023002;
+constexpr int POP_STATIC       = 0x10023004;
+constexpr int POP_STACK        = 0x10024000; ///< Not sure what this is supposed to do
+
+// Arithmetic operations
+constexpr int ADD         = 0x10031000;
+constexpr int SUB         = 0x10032000;
+constexpr int MUL         = 0x10033000;
+constexpr int DIV         = 0x10034000;
+constexpr int MOD		  = 0x10034001; ///< spring specific
+constexpr int BITWISE_AND = 0x10035000;
+constexpr int BITWISE_OR  = 0x10036000;
+constexpr int BITWISE_XOR = 0x10037000;
+constexpr int BITWISE_NOT = 0x10038000;
+
+// Native function calls
+constexpr int RAND           = 0x10041000;
+constexpr int GET_UNIT_VALUE = 0x10042000;
+constexpr int GET            = 0x10043000;
+
+// Comparison
+constexpr int SET_LESS             = 0x10051000;
+constexpr int SET_LESS_OR_EQUAL    = 0x10052000;
+constexpr int SET_GREATER          = 0x10053000;
+constexpr int SET_GREATER_OR_EQUAL = 0x10054000;
+constexpr int SET_EQUAL            = 0x10055000;
+constexpr int SET_NOT_EQUAL        = 0x10056000;
+constexpr int LOGICAL_AND          = 0x10057000;
+constexpr int LOGICAL_OR           = 0x10058000;
+constexpr int LOGICAL_XOR          = 0x10059000;
+constexpr int LOGICAL_NOT          = 0x1005A000;
+
+// Flow control
+constexpr int START           = 0x10061000;
+constexpr int CALL            = 0x10062000; ///< resolved when decoded
+constexpr int REAL_CALL       = 0x10062001; ///< spring custom
+constexpr int LUA_CALL        = 0x10062002; ///< spring custom
+constexpr int JUMP            = 0x10064000;
+constexpr int RETURN          = 0x10065000;
+constexpr int JUMP_NOT_EQUAL  = 0x10066000;
+constexpr int SIGNAL          = 0x10067000;
+constexpr int SET_SIGNAL_MASK = 0x10068000;
+
+// Piece destruction
+constexpr int EXPLODE    = 0x10071000;
+constexpr int PLAY_SOUND = 0x10072000;
+
+// Special functions
+constexpr int SET    = 0x10082000;
+constexpr int ATTACH = 0x10083000;
+constexpr int DROP   = 0x10084000;
+
+
+
+// returns the number of operands following <opcode>, or -1 if it is unknown
+static int DecodeOpcode(int opcode, std::uint8_t& op)
+{
+	switch (opcode) {
+		case MOVE      : { op = CobInstruction::OP_MOVE     ; return 2; } break;
+		case TURN      : { op = CobInstruction::OP_TURN     ; return 2; } break;
+		case SPIN      : { op = CobInstruction::OP_SPIN     ; return 2; } break;
+		case STOP_SPIN : { op = CobInstruction::OP_STOP_SPIN; return 2; } break;
+		case SHOW      : { op = CobInstruction::OP_SHOW     ; return 1; } break;
+		case HIDE      : { op = CobInstruction::OP_HIDE     ; return 1; } break;
+		case CACHE     : { op = CobInstruction::OP_NOP      ; return 1; } break;
+		case DONT_CACHE: { op = CobInstruction::OP_NOP      ; return 1; } break;
+		case MOVE_NOW  : { op = CobInstruction::OP_MOVE_NOW ; return 2; } break;
+		case TURN_NOW  : { op = CobInstruction::OP_TURN_NOW ; return 2; } break;
+		case SHADE     : { op = CobInstruction::OP_NOP      ; return 1; } break;
+		case DONT_SHADE: { op = CobInstruction::OP_NOP      ; return 1; } break;
+		case EMIT_SFX  : { op = CobInstruction::OP_EMIT_SFX ; return 1; } break;
+
+		case WAIT_TURN: { op = CobInstruction::OP_WAIT_TURN; return 2; } break;
+		case WAIT_MOVE: { op = CobInstruction::OP_WAIT_MOVE; return 2; } break;
+		case SLEEP    : { op = CobInstruction::OP_SLEEP    ; return 0; } break;
+
+		case PUSH_CONSTANT   : { op = CobInstruction::OP_PUSH_CONSTANT   ; return 1; } break;
+		case PUSH_LOCAL_VAR  : { op = CobInstruction::OP_PUSH_LOCAL_VAR  ; return 1; } break;
+		case PUSH_STATIC     : { op = CobInstruction::OP_PUSH_STATIC     ; return 1; } break;
+		case CREATE_LOCAL_VAR: { op = CobInstruction::OP_CREATE_LOCAL_VAR; return 0; } break;
+		case POP_LOCAL_VAR   : { op = CobInstruction::OP_POP_LOCAL_VAR   ; return 1; } break;
+		case POP_STATIC      : { op = CobInstruction::OP_POP_STATIC      ; return 1; } break;
+		case POP_STACK       : { op = CobInstruction::OP_POP_STACK       ; return 0; } break;
+
+		case ADD        : { op = CobInstruction::OP_ADD        ; return 0; } break;
+		case SUB        : { op = CobInstruction::OP_SUB        ; return 0; } break;
+		case MUL        : { op = CobInstruction::OP_MUL        ; return 0; } break;
+		case DIV        : { op = CobInstruction::OP_DIV        ; return 0; } break;
+		case MOD        : { op = CobInstruction::OP_MOD        ; return 0; } break;
+		case BITWISE_AND: { op = CobInstruction::OP_BITWISE_AND; return 0; } break;
+		case BITWISE_OR : { op = CobInstruction::OP_BITWISE_OR ; return 0; } break;
+		case BITWISE_XOR: { op = CobInstruction::OP_BITWISE_XOR; return 0; } break;
+		case BITWISE_NOT: { op = CobInstruction::OP_BITWISE_NOT; return 0; } break;
+
+		case RAND          : { op = CobInstruction::OP_RAND          ; return 0; } break;
+		case GET_UNIT_VALUE: { op = CobInstruction::OP_GET_UNIT_VALUE; return 0; } break;
+		case GET           : { op = CobInstruction::OP_GET           ; return 0; } break;
+
+		case SET_LESS            : { op = CobInstruction::OP_SET_LESS            ; return 0; } break;
+		case SET_LESS_OR_EQUAL   : { op = CobInstruction::OP_SET_LESS_OR_EQUAL   ; return 0; } break;
+		case SET_GREATER         : { op = CobInstruction::OP_SET_GREATER         ; return 0; } break;
+		case SET_GREATER_OR_EQUAL: { op = CobInstruction::OP_SET_GREATER_OR_EQUAL; return 0; } break;
+		case SET_EQUAL           : { op = CobInstruction::OP_SET_EQUAL           ; return 0; } break;
+		case SET_NOT_EQUAL       : { op = CobInstruction::OP_SET_NOT_EQUAL       ; return 0; } break;
+		case LOGICAL_AND         : { op = CobInstruction::OP_LOGICAL_AND         ; return 0; } break;
+		case LOGICAL_OR          : { op = CobInstruction::OP_LOGICAL_OR          ; return 0; } break;
+		case LOGICAL_XOR         : { op = CobInstruction::OP_LOGICAL_XOR         ; return 0; } break;
+		case LOGICAL_NOT         : { op = CobInstruction::OP_LOGICAL_NOT         ; return 0; } break;
+
+		case START          : { op = CobInstruction::OP_START          ; return 2; } break;
+		case CALL           : { op = CobInstruction::OP_CALL           ; return 2; } break;
+		case REAL_CALL      : { op = CobInstruction::OP_CALL           ; return 2; } break;
+		case LUA_CALL       : { op = CobInstruction::OP_LUA_CALL       ; return 2; } break;
+		case JUMP           : { op = CobInstruction::OP_JUMP           ; return 1; } break;
+		case RETURN         : { op = CobInstruction::OP_RETURN         ; return 0; } break;
+		case JUMP_NOT_EQUAL : { op = CobInstruction::OP_JUMP_NOT_EQUAL ; return 1; } break;
+		case SIGNAL         : { op = CobInstruction::OP_SIGNAL         ; return 0; } break;
+		case SET_SIGNAL_MASK: { op = CobInstruction::OP_SET_SIGNAL_MASK; return 0; } break;
+
+		case EXPLODE   : { op = CobInstruction::OP_EXPLODE   ; return 1; } break;
+		case PLAY_SOUND: { op = CobInstruction::OP_PLAY_SOUND; return 1; } break;
+
+		case SET   : { op = CobInstruction::OP_SET   ; return 0; } break;
+		case ATTACH: { op = CobInstruction::OP_ATTACH; return 0; } break;
+		case DROP  : { op = CobInstruction::OP_DROP  ; return 0; } break;
+
+		default: {
+		} break;
+	}
+
+	op = CobInstruction::OP_INVALID;
+	return -1;
+}
+
+
+void CobDecoder::Decode(
+	const std::vector<int>& code,
+	const std::vector<std::string>& scriptNames,
+	const std::vector<int>& scriptOffsets,
+	const std::vector<int>& scriptLengths,
+	int numStaticVars,
+	std::vector<CobInstruction>& instructions
+) {
+	const int numWords = code.size();
+	const int numScripts = scriptNames.size();
+
+	const auto IsValidAddr = [&](int addr) { return (addr >= 0 && addr < numWords); };
+	const auto IsValidFunc = [&](int func) { return (func >= 0 && func < numScripts); };
+
+	instructions.clear();
+	instructions.resize(numWords + 1);
+
+	for (int pc = 0; pc < numWords; pc++) {
+		CobInstruction& instr = instructions[pc];
+
+		const int numArgs = DecodeOpcode(code[pc], instr.op);
+
+		// unknown opcodes kill the thread, <next> is only used for reporting
+		if (numArgs < 0) {
+			instr.next = pc + 1;
+			continue;
+		}
+		if (!IsValidAddr(pc + numArgs)) {
+			instr.op = CobInstruction::OP_OUT_OF_RANGE;
+			instr.next = pc + 1;
+			continue;
+		}
+
+		instr.next = pc + 1 + numArgs;
+
+		for (int i = 0; i < numArgs; i++) {
+			instr.args[i] = code[pc + 1 + i];
+		}
+
+		switch (instr.op) {
+			case CobInstruction::OP_CALL:
+			case CobInstruction::OP_START: {
+				const int func = instr.args[0];
+
+				if (!IsValidFunc(func)) {
+					instr.op = CobInstruction::OP_INVALID;
+					instr.next = pc + 1;
+					break;
+				}
+
+				// the target of an unconverted CALL depends on its name
+				if (code[pc] == CALL && scriptNames[func].find("lua_") == 0) {
+					instr.op = CobInstruction::OP_LUA_CALL;
+					break;
+				}
+
+				// do not call or start zero-length functions
+				if (scriptLengths[func] == 0) {
+					instr.op = CobInstruction::OP_NOP;
+					break;
+				}
+
+				if (!IsValidAddr(scriptOffsets[func]))
+					instr.op = CobInstruction::OP_OUT_OF_RANGE;
+			} break;
+
+			case CobInstruction::OP_JUMP:
+			case CobInstruction::OP_JUMP_NOT_EQUAL: {
+				if (!IsValidAddr(instr.args[0]))
+					instr.args[0] = numWords;
+			} break;
+
+			case CobInstruction::OP_PUSH_STATIC: {
+				if (static_cast<unsigned int>(instr.args[0]) >= static_cast<unsigned int>(numStaticVars))
+					instr.op = CobInstruction::OP_NOP;
+			} break;
+			case CobInstruction::OP_POP_STATIC: {
+				if (static_cast<unsigned int>(instr.args[0]) >= static_cast<unsigned int>(numStaticVars))
+					instr.op = CobInstruction::OP_POP_STACK;
+			} break;
+
+			default: {
+			} break;
+		}
+	}
+
+	instructions[numWords].op = CobInstruction::OP_OUT_OF_RANGE;
+	instructions[numWords].next = numWords;
+}
+
+
+const char* CobDecoder::GetOpName(unsigned int op)
+{
+	static const char* opNames[] = {
+		#define COB_DECODED_OP_NAME(name) #name,
+		COB_DECODED_OPS(COB_DECODED_OP_NAME)
+		#undef COB_DECODED_OP_NAME
+	};
+
+	if (op >= CobInstruction::NUM_OPS)
+		return "UNKNOWN";
+
+	return opNames[op];
+}
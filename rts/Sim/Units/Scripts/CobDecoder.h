@@ -0,0 +1,71 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COB_DECODER_H
+#define COB_DECODER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// operations of decoded instructions; CACHE, SHADE, etc. and calls to
+// zero-length functions become NOP's, CALL's to "lua_" functions become
+// LUA_CALL's
+#define COB_DECODED_OPS(OP)                                                               \
+	OP(NOP) OP(OUT_OF_RANGE) OP(INVALID)                                                  \
+	OP(MOVE) OP(TURN) OP(SPIN) OP(STOP_SPIN) OP(SHOW) OP(HIDE)                            \
+	OP(MOVE_NOW) OP(TURN_NOW) OP(EMIT_SFX)                                                \
+	OP(WAIT_TURN) OP(WAIT_MOVE) OP(SLEEP)                                                 \
+	OP(PUSH_CONSTANT) OP(PUSH_LOCAL_VAR) OP(PUSH_STATIC) OP(CREATE_LOCAL_VAR)             \
+	OP(POP_LOCAL_VAR) OP(POP_STATIC) OP(POP_STACK)                                        \
+	OP(ADD) OP(SUB) OP(MUL) OP(DIV) OP(MOD)                                               \
+	OP(BITWISE_AND) OP(BITWISE_OR) OP(BITWISE_XOR) OP(BITWISE_NOT)                        \
+	OP(RAND) OP(GET_UNIT_VALUE) OP(GET)                                                   \
+	OP(SET_LESS) OP(SET_LESS_OR_EQUAL) OP(SET_GREATER) OP(SET_GREATER_OR_EQUAL)           \
+	OP(SET_EQUAL) OP(SET_NOT_EQUAL)                                                       \
+	OP(LOGICAL_AND) OP(LOGICAL_OR) OP(LOGICAL_XOR) OP(LOGICAL_NOT)                        \
+	OP(START) OP(CALL) OP(LUA_CALL) OP(JUMP) OP(RETURN) OP(JUMP_NOT_EQUAL)                \
+	OP(SIGNAL) OP(SET_SIGNAL_MASK)                                                        \
+	OP(EXPLODE) OP(PLAY_SOUND)                                                            \
+	OP(SET) OP(ATTACH) OP(DROP)
+
+
+/**
+ * A COB instruction with its operands fetched and validated at load-time.
+ * Decoded instructions are stored at the same index as their opcode in the
+ * raw code, so program counters (and return addresses) keep referring to
+ * the raw code; <next> is the index following the instruction's operands.
+ */
+struct CobInstruction {
+	enum Op: std::uint8_t {
+		#define COB_DECODED_OP_ENUM(name) OP_##name,
+		COB_DECODED_OPS(COB_DECODED_OP_ENUM)
+		#undef COB_DECODED_OP_ENUM
+		NUM_OPS
+	};
+
+	std::uint8_t op = OP_OUT_OF_RANGE;
+	std::int32_t next = 0;
+	std::int32_t args[2] = {0, 0};
+};
+
+
+namespace CobDecoder {
+	/**
+	 * Decodes an instruction at every index of <code>, plus one OUT_OF_RANGE
+	 * sentinel at the end which invalid jump- and call-targets are mapped to.
+	 * Instructions whose operands lie past the end of <code> also decode to
+	 * OUT_OF_RANGE, which throws when executed (like fetching them used to).
+	 */
+	void Decode(
+		const std::vector<int>& code,
+		const std::vector<std::string>& scriptNames,
+		const std::vector<int>& scriptOffsets,
+		const std::vector<int>& scriptLengths,
+		int numStaticVars,
+		std::vector<CobInstruction>& instructions
+	);
+
+	const char* GetOpName(unsigned int op);
+}
+
+#endif // COB_DECODER_H
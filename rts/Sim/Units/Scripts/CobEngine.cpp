@@ -9,7 +9,9 @@
 CR_BIND(CCobEngine, )
 
 CR_REG_METADATA(CCobEngine, (
-	CR_MEMBER(threadInstances),
+	CR_MEMBER(threadSlab),
+	CR_MEMBER(threadRefCounts),
+	CR_MEMBER(freeThreadIDs),
 	CR_MEMBER(tickAddedThreads),
 
 	CR_MEMBER(runningThreadIDs),
@@ -19,8 +21,7 @@ CR_REG_METADATA(CCobEngine, (
 
 	CR_IGNORED(curThread),
 
-	CR_MEMBER(currentTime),
-	CR_MEMBER(threadCounter)
+	CR_MEMBER(currentTime)
 ))
 
 CR_BIND(CCobEngine::SleepingThread, )
@@ -30,19 +31,52 @@ CR_REG_METADATA(CCobEngine::SleepingThread, (
 ))
 
 
-int CCobEngine::AddThread(CCobThread&& thread)
+int CCobEngine::AllocThread(CCobInstance* owner)
 {
-	if (thread.GetID() == -1)
-		thread.SetID(GenThreadID());
+	int threadID = threadSlab.size();
+
+	if (freeThreadIDs.empty()) {
+		threadSlab.emplace_back();
+		threadRefCounts.push_back(0);
+	} else {
+		threadID = freeThreadIDs.back();
+		freeThreadIDs.pop_back();
+	}
+
+	CCobThread& t = threadSlab[threadID];
+
+	t.Reset(owner);
+	t.SetID(threadID);
+
+	assert(threadRefCounts[threadID] == 0);
+	threadRefCounts[threadID] = 1;
+	return threadID;
+}
+
+int CCobEngine::AddThread(int threadID)
+{
+	CCobThread& t = threadSlab[threadID];
+
+	t.cobInst->AddThreadID(threadID);
+	return threadID;
+}
+
+bool CCobEngine::RemoveThread(int threadID)
+{
+	if (static_cast<size_t>(threadID) >= threadSlab.size())
+		return false;
+
+	CCobThread& t = threadSlab[threadID];
 
-	CCobInstance* o = thread.cobInst;
-	CCobThread& t = threadInstances[thread.GetID()];
+	if (t.GetID() != threadID)
+		return false;
 
-	// move thread into registry, hand its ID to owner
-	t = std::move(thread);
-	o->AddThreadID(t.GetID());
+	// runs the callback (unless garbage) and releases the ID from its owner
+	t.Stop();
+	t.SetID(-1);
 
-	return (t.GetID());
+	UnrefThread(threadID);
+	return true;
 }
 
 
@@ -52,9 +86,11 @@ void CCobEngine::ScheduleThread(const CCobThread* thread)
 	switch (thread->GetState()) {
 		case CCobThread::Run: {
 			waitingThreadIDs.push_back(thread->GetID());
+			RefThread(thread->GetID());
 		} break;
 		case CCobThread::Sleep: {
 			sleepingThreadIDs.push(SleepingThread{thread->GetID(), thread->GetWakeTime()});
+			RefThread(thread->GetID());
 		} break;
 		default: {
 			LOG_L(L_ERROR, "[COBEngine::%s] unknown state %d for thread %d", __func__, thread->GetState(), thread->GetID());
@@ -66,12 +102,12 @@ void CCobEngine::SanityCheckThreads(const CCobInstance* owner)
 {
 	if (false) {
 		// no threads belonging to owner should be left
-		for (const auto& p: threadInstances) {
-			assert(p.second.cobInst != owner);
-		}
-		for (const CCobThread& t: tickAddedThreads) {
+		for (const CCobThread& t: threadSlab) {
 			assert(t.cobInst != owner);
 		}
+		for (const int threadID: tickAddedThreads) {
+			assert(threadSlab[threadID].cobInst != owner);
+		}
 	}
 }
 
@@ -92,10 +128,13 @@ void CCobEngine::WakeSleepingThreads()
 {
 	// check on the sleeping threads, remove any whose owner died
 	while (!sleepingThreadIDs.empty()) {
-		CCobThread* zzzThread = GetThread((sleepingThreadIDs.top()).id);
+		const int zzzThreadID = (sleepingThreadIDs.top()).id;
+
+		CCobThread* zzzThread = GetThread(zzzThreadID);
 
 		if (zzzThread == nullptr) {
 			sleepingThreadIDs.pop();
+			UnrefThread(zzzThreadID);
 			continue;
 		}
 
@@ -121,6 +160,8 @@ void CCobEngine::WakeSleepingThreads()
 				LOG_L(L_ERROR, "[COBEngine::%s] unknown state %d for thread %d", __func__, zzzThread->GetState(), zzzThread->GetID());
 			} break;
 		}
+
+		UnrefThread(zzzThreadID);
 	}
 }
 
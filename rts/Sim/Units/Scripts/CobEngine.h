@@ -8,12 +8,13 @@
  * It also manages reading and caching of the actual .cob files.
  */
 
+#include <deque>
 #include <vector>
 
 #include "CobThread.h"
 #include "System/creg/creg_cond.h"
+#include "System/creg/STL_Deque.h"
 #include "System/creg/STL_Queue.h"
-#include "System/creg/STL_Map.h"
 #include "System/Cpp11Compat.hpp"
 
 
@@ -43,19 +44,17 @@ private:
 
 public:
 	void Init() {
-		threadInstances.reserve(2048);
+		threadRefCounts.reserve(2048);
+		freeThreadIDs.reserve(2048);
 		tickAddedThreads.reserve(128);
 
 		runningThreadIDs.reserve(512);
 		waitingThreadIDs.reserve(512);
-
-		threadCounter = 0;
 	}
 	void Kill() {
-		// threadInstances is never explicitly iterated, so
-		// calling clear_unordered_map (between reloads) is
-		// unnecessary here
-		threadInstances.clear();
+		threadSlab.clear();
+		threadRefCounts.clear();
+		freeThreadIDs.clear();
 		tickAddedThreads.clear();
 
 		runningThreadIDs.clear();
@@ -70,37 +69,37 @@ public:
 	void ShowScriptError(const std::string& msg);
 
 
+	// thread ID's are slab indices, valid until the thread is removed
 	CCobThread* GetThread(int threadID) {
-		const auto it = threadInstances.find(threadID);
-
-		if (it == threadInstances.end())
+		if (static_cast<size_t>(threadID) >= threadSlab.size())
 			return nullptr;
 
-		return &(it->second);
-	}
+		CCobThread* thread = &threadSlab[threadID];
 
-	bool RemoveThread(int threadID) {
-		const auto it = threadInstances.find(threadID);
-
-		if (it != threadInstances.end()) {
-			threadInstances.erase(it);
-			return true;
-		}
+		if (thread->GetID() != threadID || thread->IsGarbage())
+			return nullptr;
 
-		return false;
+		return thread;
 	}
 
-	int AddThread(CCobThread&& thread);
-	int GenThreadID() { return (threadCounter++); }
+	bool RemoveThread(int threadID);
+
+	/**
+	 * Creates a thread for <owner> in the slab and returns its ID; slab
+	 * threads never move, so this is also safe while another is ticking.
+	 */
+	int AllocThread(CCobInstance* owner);
+	// hands a thread created by AllocThread to its owner
+	int AddThread(int threadID);
 	int GetCurrentTime() const { return currentTime; }
 
-	void QueueAddThread(CCobThread&& thread) { tickAddedThreads.emplace_back(std::move(thread)); }
+	void QueueAddThread(int threadID) { tickAddedThreads.push_back(threadID); }
 	void AddQueuedThreads() {
-		// move new threads spawned by START into threadInstances;
-		// their ID's will already have been scheduled into either
+		// hand new threads spawned by START to their owners; their
+		// ID's will already have been scheduled into either
 		// waitingThreadIDs or sleepingThreadIDs
-		for (CCobThread& t: tickAddedThreads) {
-			AddThread(std::move(t));
+		for (const int threadID: tickAddedThreads) {
+			AddThread(threadID);
 		}
 
 		tickAddedThreads.clear();
@@ -112,11 +111,21 @@ public:
 private:
 	void TickThread(CCobThread* thread);
 
+	// slots are only reused once no scheduler entry refers to them anymore
+	void RefThread(int threadID) { threadRefCounts[threadID] += 1; }
+	void UnrefThread(int threadID) {
+		assert(threadRefCounts[threadID] > 0);
+
+		if ((threadRefCounts[threadID] -= 1) == 0)
+			freeThreadIDs.push_back(threadID);
+	}
+
 	void WakeSleepingThreads();
 	void TickRunningThreads() {
 		// advance all currently running threads
 		for (const int threadID: runningThreadIDs) {
 			TickThread(GetThread(threadID));
+			UnrefThread(threadID);
 		}
 
 		// a thread can never go from running->running, so clear the list
@@ -130,10 +139,14 @@ private:
 	}
 
 private:
-	// registry of every thread across all script instances
-	spring::unordered_map<int, CCobThread> threadInstances;
+	// every thread across all script instances; a deque never moves its
+	// elements when growing, and threads are recycled through freeThreadIDs
+	std::deque<CCobThread> threadSlab;
+	// per slot; one for the thread itself plus one per scheduler entry
+	std::vector<int> threadRefCounts;
+	std::vector<int> freeThreadIDs;
 	// threads that are spawned during Tick
-	std::vector<CCobThread> tickAddedThreads;
+	std::vector<int> tickAddedThreads;
 
 	std::vector<int> runningThreadIDs;
 	std::vector<int> waitingThreadIDs;
@@ -145,7 +158,6 @@ private:
 	CCobThread* curThread = nullptr;
 
 	int currentTime = 0;
-	int threadCounter = 0;
 };
 
 
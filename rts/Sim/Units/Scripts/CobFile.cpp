@@ -196,6 +196,8 @@ CCobFile::CCobFile(CFileHandler& in, const std::string& scriptName)
 
 		scriptIndex[pair.second] = fn;
 	}
+
+	CobDecoder::Decode(code, scriptNames, scriptOffsets, scriptLengths, numStaticVars, instructions);
 }
 
 
@@ -516,17 +516,18 @@ int CCobInstance::RealCall(int functionId, std::array<int, 1 + MAX_COB_ARGS>& ar
 
 	// LOG_L(L_DEBUG, "Calling %s:%s", cobFile->name.c_str(), cobFile->scriptNames[functionId].c_str());
 
-	// tick the thread locally in case we're recursively running this function and then the threads may reallocate
-	CCobThread newThread(this);
-	newThread.SetID(cobEngine->GenThreadID());
+	// tick the thread locally in case we're recursively running this function; slab threads do not move
+	CCobThread* newThread = cobEngine->GetThread(cobEngine->AllocThread(this));
+
+	const int newThreadID = newThread->GetID();
 
 	// make sure this is run even if the call terminates instantly
 	if (cb != CBNone)
-		newThread.SetCallback(cb, cbParam);
+		newThread->SetCallback(cb, cbParam);
 
-	newThread.Start(functionId, 0, args, false);
+	newThread->Start(functionId, 0, args, false);
 
-	if ((ret = newThread.Tick()) == 0) {
+	if ((ret = newThread->Tick()) == 0) {
 		// thread died already after one tick
 		// NOTE:
 		//   ticking can trigger recursion, for example FireWeapon ->
@@ -540,25 +541,29 @@ int CCobInstance::RealCall(int functionId, std::array<int, 1 + MAX_COB_ARGS>& ar
 		//
 		//   args[0] holds the number of input args
 		const unsigned int numArgs = args[0];
-		const unsigned int retArgs = newThread.CheckStack(numArgs, functionId != cobFile->scriptIndex[COBFN_StartMoving]);
+		const unsigned int retArgs = newThread->CheckStack(numArgs, functionId != cobFile->scriptIndex[COBFN_StartMoving]);
 
 		// retrieve output parameter values from stack
 		for (unsigned int i = 0, n = std::min(retArgs, MAX_COB_ARGS); i < n; ++i)
-			args[i] = newThread.GetStackVal(i);
+			args[i] = newThread->GetStackVal(i);
 
 		// set erroneous parameters to 0
 		for (unsigned int i = std::min(retArgs, MAX_COB_ARGS); i < numArgs; ++i)
 			args[i] = 0;
 
-		// dtor runs the callback
 		if (retCode != nullptr)
-			*retCode = newThread.GetRetCode();
+			*retCode = newThread->GetRetCode();
 	} else {
-		cobEngine->AddThread(std::move(newThread));
+		cobEngine->AddThread(newThreadID);
 	}
 
 	// handle any spawned threads
 	cobEngine->AddQueuedThreads();
+
+	// removal runs the callback of a dead thread
+	if (ret == 0)
+		cobEngine->RemoveThread(newThreadID);
+
 	return ret;
 }
 
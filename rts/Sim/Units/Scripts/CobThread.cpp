@@ -8,6 +8,8 @@
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/GlobalSynced.h"
 
+#include <stdexcept>
+
 CR_BIND(CCobThread, )
 
 CR_REG_METADATA(CCobThread, (
@@ -48,13 +50,14 @@ CR_REG_METADATA_SUB(CCobThread, CallInfo,(
 ))
 
 
+// initial stack sizes; deeper stacks are rare
+static constexpr unsigned int INIT_CALL_STACK_SIZE =  4;
+static constexpr unsigned int INIT_DATA_STACK_SIZE = 16;
+
+
 CCobThread::CCobThread(CCobInstance* _cobInst)
-	: cobInst(_cobInst)
-	, cobFile(_cobInst->cobFile)
 {
-	memset(&luaArgs[0], 0, MAX_LUA_COB_ARGS * sizeof(luaArgs[0]));
-	callStack.fill({});
-	dataStack.fill(0);
+	Reset(_cobInst);
 }
 
 
@@ -76,8 +79,8 @@ CCobThread& CCobThread::operator = (CCobThread&& t) {
 
 	std::memcpy(luaArgs, t.luaArgs, sizeof(luaArgs));
 
-	std::memcpy(callStack.data(), t.callStack.data(), callStackSize * sizeof(callStack[0]));
-	std::memcpy(dataStack.data(), t.dataStack.data(), dataStackSize * sizeof(dataStack[0]));
+	callStack = std::move(t.callStack);
+	dataStack = std::move(t.dataStack);
 	// execTrace = std::move(t.execTrace);
 
 	state = t.state;
@@ -106,8 +109,8 @@ CCobThread& CCobThread::operator = (const CCobThread& t) {
 
 	std::memcpy(luaArgs, t.luaArgs, sizeof(luaArgs));
 
-	std::memcpy(callStack.data(), t.callStack.data(), callStackSize * sizeof(callStack[0]));
-	std::memcpy(dataStack.data(), t.dataStack.data(), dataStackSize * sizeof(dataStack[0]));
+	callStack = t.callStack;
+	dataStack = t.dataStack;
 	// execTrace = t.execTrace;
 
 	state = t.state;
@@ -137,7 +140,7 @@ void CCobThread::Start(int functionId, int sigMask, const std::array<int, 1 + MA
 	// copy arguments; args[0] holds the count
 	// handled by InitStack if thread has a parent that STARTs it,
 	// in which case args[0] is 0 and stack already contains data
-	if (paramCount > 0)
+	if (paramCount > 0 && ReserveDataStack(paramCount))
 		std::memcpy(dataStack.data(), args.data() + 1, (dataStackSize = paramCount) * sizeof(args[0]));
 
 	// add to scheduler
@@ -160,6 +163,63 @@ void CCobThread::Stop()
 	cobFile = nullptr;
 }
 
+void CCobThread::Reset(CCobInstance* _cobInst)
+{
+	id = -1;
+	pc = 0;
+
+	wakeTime = 0;
+	paramCount = 0;
+	retCode = -1;
+	cbParam = 0;
+	signalMask = 0;
+
+	waitAxis = -1;
+	waitPiece = -1;
+
+	callStackSize = 0;
+	dataStackSize = 0;
+
+	errorCounter = 100;
+
+	memset(&luaArgs[0], 0, MAX_LUA_COB_ARGS * sizeof(luaArgs[0]));
+
+	// scripts can read stack slots they never wrote, keep those zero
+	callStack.resize(std::max(callStack.size(), size_t(INIT_CALL_STACK_SIZE)));
+	dataStack.resize(std::max(dataStack.size(), size_t(INIT_DATA_STACK_SIZE)));
+	std::fill(callStack.begin(), callStack.end(), CallInfo{});
+	std::fill(dataStack.begin(), dataStack.end(), 0);
+
+	state = Init;
+	cbType = CCobInstance::CBNone;
+
+	cobInst = _cobInst;
+	cobFile = _cobInst->cobFile;
+}
+
+
+bool CCobThread::ReserveCallStack(unsigned int n)
+{
+	if (n <= callStack.size())
+		return true;
+	if (n > MAX_CALL_STACK_SIZE)
+		return false;
+
+	callStack.resize(std::min(std::max(n, unsigned(callStack.size() * 2)), MAX_CALL_STACK_SIZE));
+	return true;
+}
+
+bool CCobThread::ReserveDataStack(unsigned int n)
+{
+	if (n <= dataStack.size())
+		return true;
+	if (n > MAX_DATA_STACK_SIZE)
+		return false;
+
+	dataStack.resize(std::min(std::max(n, unsigned(dataStack.size() * 2)), MAX_DATA_STACK_SIZE), 0);
+	return true;
+}
+
 
 const std::string& CCobThread::GetName()
 {
@@ -188,7 +248,7 @@ int CCobThread::CheckStack(unsigned int size, bool warn)
 void CCobThread::InitStack(unsigned int n, CCobThread* t)
 {
 	assert(dataStackSize == 0);
-	dataStack.fill(0);
+	std::fill(dataStack.begin(), dataStack.end(), 0);
 
 	// move n arguments from caller's stack onto our own
 	for (unsigned int i = 0; i < n; ++i) {
@@ -198,86 +258,6 @@ void CCobThread::InitStack(unsigned int n, CCobThread* t)
 
 
 
-// Command documentation from http://visualta.tauniverse.com/Downloads/cob-commands.txt
-// And some information from basm0.8 source (basm ops.txt)
-
-// Model interaction
-constexpr int MOVE       = 0x10001000;
-constexpr int TURN       = 0x10002000;
-constexpr int SPIN       = 0x10003000;
-constexpr int STOP_SPIN  = 0x10004000;
-constexpr int SHOW       = 0x10005000;
-constexpr int HIDE       = 0x10006000;
-constexpr int CACHE      = 0x10007000;
-constexpr int DONT_CACHE = 0x10008000;
-constexpr int MOVE_NOW   = 0x1000B000;
-constexpr int TURN_NOW   = 0x1000C000;
-constexpr int SHADE      = 0x1000D000;
-constexpr int DONT_SHADE = 0x1000E000;
-constexpr int EMIT_SFX   = 0x1000F000;
-
-// Blocking operations
-constexpr int WAIT_TURN  = 0x10011000;
-constexpr int WAIT_MOVE  = 0x10012000;
-constexpr int SLEEP      = 0x10013000;
-
-// Stack manipulation
-constexpr int PUSH_CONSTANT    = 0x10021001;
-constexpr int PUSH_LOCAL_VAR   = 0x10021002;
-constexpr int PUSH_STATIC      = 0x10021004;
-constexpr int CREATE_LOCAL_VAR = 0x10022000;
-constexpr int POP_LOCAL_VAR    = 0x10023002;
-constexpr int POP_STATIC       = 0x10023004;
-constexpr int POP_STACK        = 0x10024000; ///< Not sure what this is supposed to do
-
-// Arithmetic operations
-constexpr int ADD         = 0x10031000;
-constexpr int SUB         = 0x10032000;
-constexpr int MUL         = 0x10033000;
-constexpr int DIV         = 0x10034000;
-constexpr int MOD		  = 0x10034001; ///< spring specific
-constexpr int BITWISE_AND = 0x10035000;
-constexpr int BITWISE_OR  = 0x10036000;
-constexpr int BITWISE_XOR = 0x10037000;
-constexpr int BITWISE_NOT = 0x10038000;
-
-// Native function calls
-constexpr int RAND           = 0x10041000;
-constexpr int GET_UNIT_VALUE = 0x10042000;
-constexpr int GET            = 0x10043000;
-
-// Comparison
-constexpr int SET_LESS             = 0x10051000;
-constexpr int SET_LESS_OR_EQUAL    = 0x10052000;
-constexpr int SET_GREATER          = 0x10053000;
-constexpr int SET_GREATER_OR_EQUAL = 0x10054000;
-constexpr int SET_EQUAL            = 0x10055000;
-constexpr int SET_NOT_EQUAL        = 0x10056000;
-constexpr int LOGICAL_AND          = 0x10057000;
-constexpr int LOGICAL_OR           = 0x10058000;
-constexpr int LOGICAL_XOR          = 0x10059000;
-constexpr int LOGICAL_NOT          = 0x1005A000;
-
-// Flow control
-constexpr int START           = 0x10061000;
-constexpr int CALL            = 0x10062000; ///< converted when executed
-constexpr int REAL_CALL       = 0x10062001; ///< spring custom
-constexpr int LUA_CALL        = 0x10062002; ///< spring custom
-constexpr int JUMP            = 0x10064000;
-constexpr int RETURN          = 0x10065000;
-constexpr int JUMP_NOT_EQUAL  = 0x10066000;
-constexpr int SIGNAL          = 0x10067000;
-constexpr int SET_SIGNAL_MASK = 0x10068000;
-
-// Piece destruction
-constexpr int EXPLODE    = 0x10071000;
-constexpr int PLAY_SOUND = 0x10072000;
-
-// Special functions
-constexpr int SET    = 0x10082000;
-constexpr int ATTACH = 0x10083000;
-constexpr int DROP   = 0x10084000;
-
 // Indices for SET, GET, and GET_UNIT_VALUE for LUA return values
 #define LUA0 110 // (LUA0 returns the lua call status, 0 or 1)
 #define LUA1 111
@@ -290,91 +270,30 @@ constexpr int DROP   = 0x10084000;
 #define LUA8 118
 #define LUA9 119
 
-#if 0
-#define GET_LONG_PC() (cobFile->code[pc++])
+
+// instructions are decoded at load-time (see CobDecoder), so dispatching
+// one only takes an indirect jump; GCC and clang jump straight from every
+// instruction to the next through a table of label addresses, other
+// compilers fall back to a switch
+#if defined(__GNUC__)
+	#define COB_DIRECT_THREADED 1
 #else
-// mantis #5981
-#define GET_LONG_PC() (cobFile->code.at(pc++))
+	#define COB_DIRECT_THREADED 0
 #endif
 
-
-#if 0
-static const char* GetOpcodeName(int opcode)
-{
-	switch (opcode) {
-		case MOVE: return "move";
-		case TURN: return "turn";
-		case SPIN: return "spin";
-		case STOP_SPIN: return "stop-spin";
-		case SHOW: return "show";
-		case HIDE: return "hide";
-		case CACHE: return "cache";
-		case DONT_CACHE: return "dont-cache";
-		case TURN_NOW: return "turn-now";
-		case MOVE_NOW: return "move-now";
-		case SHADE: return "shade";
-		case DONT_SHADE: return "dont-shade";
-		case EMIT_SFX: return "sfx";
-
-		case WAIT_TURN: return "wait-for-turn";
-		case WAIT_MOVE: return "wait-for-move";
-		case SLEEP: return "sleep";
-
-		case PUSH_CONSTANT: return "pushc";
-		case PUSH_LOCAL_VAR: return "pushl";
-		case PUSH_STATIC: return "pushs";
-		case CREATE_LOCAL_VAR: return "clv";
-		case POP_LOCAL_VAR: return "popl";
-		case POP_STATIC: return "pops";
-		case POP_STACK: return "pop-stack";
-
-		case ADD: return "add";
-		case SUB: return "sub";
-		case MUL: return "mul";
-		case DIV: return "div";
-		case MOD: return "mod";
-		case BITWISE_AND: return "and";
-		case BITWISE_OR: return "or";
-		case BITWISE_XOR: return "xor";
-		case BITWISE_NOT: return "not";
-
-		case RAND: return "rand";
-		case GET_UNIT_VALUE: return "getuv";
-		case GET: return "get";
-
-		case SET_LESS: return "setl";
-		case SET_LESS_OR_EQUAL: return "setle";
-		case SET_GREATER: return "setg";
-		case SET_GREATER_OR_EQUAL: return "setge";
-		case SET_EQUAL: return "sete";
-		case SET_NOT_EQUAL: return "setne";
-		case LOGICAL_AND: return "land";
-		case LOGICAL_OR: return "lor";
-		case LOGICAL_XOR: return "lxor";
-		case LOGICAL_NOT: return "neg";
-
-		case START: return "start";
-		case CALL: return "call";
-		case REAL_CALL: return "call";
-		case LUA_CALL: return "lua_call";
-		case JUMP: return "jmp";
-		case RETURN: return "return";
-		case JUMP_NOT_EQUAL: return "jne";
-		case SIGNAL: return "signal";
-		case SET_SIGNAL_MASK: return "mask";
-
-		case EXPLODE: return "explode";
-		case PLAY_SOUND: return "play-sound";
-
-		case SET: return "set";
-		case ATTACH: return "attach";
-		case DROP: return "drop";
-	}
-
-	return "unknown";
-}
+#if (COB_DIRECT_THREADED == 1)
+	#define COB_INSTR(name) op_##name:
+	#define COB_DISPATCH() { instr = &instrs[pc]; pc = instr->next; goto *dispatchTable[instr->op]; }
+#else
+	#define COB_INSTR(name) case CobInstruction::OP_##name:
+	#define COB_DISPATCH() { continue; }
 #endif
 
+// instructions that can not change the thread's state dispatch the next
+// one directly, all others first check if the thread should keep running
+#define COB_NEXT_INSTR() COB_DISPATCH()
+#define COB_NEXT_INSTR_CHECKED() { if (state != Run) goto tick_end; COB_DISPATCH(); }
+
 
 bool CCobThread::Tick()
 {
@@ -386,39 +305,79 @@ bool CCobThread::Tick()
 
 	state = Run;
 
+	const CobInstruction* instrs = cobFile->instructions.data();
+	const CobInstruction* instr = nullptr;
+
 	int r1, r2, r3, r4, r5, r6;
 
-	while (state == Run) {
-		const int opcode = GET_LONG_PC();
+	// mantis #5981; only needs to be checked here, decoded jump-targets are valid
+	if (static_cast<size_t>(pc) >= cobFile->instructions.size())
+		throw std::out_of_range("[COBThread::Tick] program counter out of range");
+
+	#if (COB_DIRECT_THREADED == 1)
+	static const void* dispatchTable[] = {
+		#define COB_DECODED_OP_LABEL(name) &&op_##name,
+		COB_DECODED_OPS(COB_DECODED_OP_LABEL)
+		#undef COB_DECODED_OP_LABEL
+	};
+
+	static_assert((sizeof(dispatchTable) / sizeof(dispatchTable[0])) == CobInstruction::NUM_OPS, "");
+
+	COB_DISPATCH();
+	{
+	#else
+	for (;;) {
+		instr = &instrs[pc];
+		pc = instr->next;
+
+		switch (instr->op) {
+	#endif
+			COB_INSTR(NOP) {
+			} COB_NEXT_INSTR();
+			COB_INSTR(OUT_OF_RANGE) {
+				throw std::out_of_range("[COBThread::Tick] code address out of range");
+			} COB_NEXT_INSTR();
+			COB_INSTR(INVALID) {
+				const char* name = cobFile->name.c_str();
+				const char* func = cobFile->scriptNames[LocalFunctionID()].c_str();
 
-		switch (opcode) {
-			case PUSH_CONSTANT: {
-				r1 = GET_LONG_PC();
-				PushDataStack(r1);
-			} break;
-			case SLEEP: {
+				LOG_L(L_ERROR, "[COBThread::%s] unknown opcode %x (in %s:%s at %x)", __func__, cobFile->code[pc - 1], name, func, pc - 1);
+
+				#if 0
+				auto ei = execTrace.begin();
+				while (ei != execTrace.end()) {
+					LOG_L(L_ERROR, "\tprogctr: %3x  opcode: %s", __func__, *ei, CobDecoder::GetOpName(instrs[*ei].op));
+					++ei;
+				}
+				#endif
+
+				state = Dead;
+				return false;
+			} COB_NEXT_INSTR();
+
+
+			COB_INSTR(PUSH_CONSTANT) {
+				PushDataStack(instr->args[0]);
+			} COB_NEXT_INSTR();
+			COB_INSTR(SLEEP) {
 				r1 = PopDataStack();
 				wakeTime = cobEngine->GetCurrentTime() + r1;
 				state = Sleep;
 
 				cobEngine->ScheduleThread(this);
 				return true;
-			} break;
-			case SPIN: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			} COB_NEXT_INSTR();
+			COB_INSTR(SPIN) {
 				r3 = PopDataStack();         // speed
 				r4 = PopDataStack();         // accel
-				cobInst->Spin(r1, r2, r3, r4);
-			} break;
-			case STOP_SPIN: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+				cobInst->Spin(instr->args[0], instr->args[1], r3, r4);
+			} COB_NEXT_INSTR_CHECKED();
+			COB_INSTR(STOP_SPIN) {
 				r3 = PopDataStack();         // decel
 
-				cobInst->StopSpin(r1, r2, r3);
-			} break;
-			case RETURN: {
+				cobInst->StopSpin(instr->args[0], instr->args[1], r3);
+			} COB_NEXT_INSTR_CHECKED();
+			COB_INSTR(RETURN) {
 				retCode = PopDataStack();
 
 				if (LocalReturnAddr() == -1) {
@@ -433,44 +392,12 @@ bool CCobThread::Tick()
 				pc = LocalReturnAddr();
 				dataStackSize = std::min(dataStackSize, LocalStackFrame());
 				callStackSize -= 1;
-			} break;
-
-
-			case SHADE: {
-				r1 = GET_LONG_PC();
-			} break;
-			case DONT_SHADE: {
-				r1 = GET_LONG_PC();
-			} break;
-			case CACHE: {
-				r1 = GET_LONG_PC();
-			} break;
-			case DONT_CACHE: {
-				r1 = GET_LONG_PC();
-			} break;
-
+			} COB_NEXT_INSTR();
 
-			case CALL: {
-				r1 = GET_LONG_PC();
-				pc--;
-
-				if (cobFile->scriptNames[r1].find("lua_") == 0) {
-					cobFile->code[pc - 1] = LUA_CALL;
-					LuaCall();
-					break;
-				}
 
-				cobFile->code[pc - 1] = REAL_CALL;
-
-				// fall-through
-			}
-			case REAL_CALL: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-
-				// do not call zero-length functions
-				if (cobFile->scriptLengths[r1] == 0)
-					break;
+			COB_INSTR(CALL) {
+				r1 = instr->args[0];
+				r2 = instr->args[1];
 
 				CallInfo& ci = PushCallStackRef();
 				ci.functionId = r1;
@@ -481,228 +408,212 @@ bool CCobThread::Tick()
 
 				// call cobFile->scriptNames[r1]
 				pc = cobFile->scriptOffsets[r1];
-			} break;
-			case LUA_CALL: {
-				LuaCall();
-			} break;
+			} COB_NEXT_INSTR();
+			COB_INSTR(LUA_CALL) {
+				LuaCall(instr->args[0], instr->args[1]);
+			} COB_NEXT_INSTR_CHECKED();
 
 
-			case POP_STATIC: {
-				r1 = GET_LONG_PC();
-				r2 = PopDataStack();
-
-				if (static_cast<size_t>(r1) < cobInst->staticVars.size())
-					cobInst->staticVars[r1] = r2;
-			} break;
-			case POP_STACK: {
+			COB_INSTR(POP_STATIC) {
+				assert(static_cast<size_t>(instr->args[0]) < cobInst->staticVars.size());
+				cobInst->staticVars[instr->args[0]] = PopDataStack();
+			} COB_NEXT_INSTR();
+			COB_INSTR(POP_STACK) {
 				PopDataStack();
-			} break;
-
+			} COB_NEXT_INSTR();
 
-			case START: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
 
-				if (cobFile->scriptLengths[r1] == 0)
-					break;
+			COB_INSTR(START) {
+				CCobThread* t = cobEngine->GetThread(cobEngine->AllocThread(cobInst));
 
+				t->InitStack(instr->args[1], this);
+				t->Start(instr->args[0], signalMask, {{0}}, true);
 
-				CCobThread t(cobInst);
+				// hand the thread to our owner after this tick
+				cobEngine->QueueAddThread(t->GetID());
+			} COB_NEXT_INSTR_CHECKED();
 
-				t.SetID(cobEngine->GenThreadID());
-				t.InitStack(r2, this);
-				t.Start(r1, signalMask, {{0}}, true);
-
-				// calling AddThread directly might move <this>, defer it
-				cobEngine->QueueAddThread(std::move(t));
-			} break;
-
-			case CREATE_LOCAL_VAR: {
+			COB_INSTR(CREATE_LOCAL_VAR) {
 				if (paramCount == 0) {
 					PushDataStack(0);
 				} else {
 					paramCount--;
 				}
-			} break;
-			case GET_UNIT_VALUE: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(GET_UNIT_VALUE) {
 				r1 = PopDataStack();
+
 				if ((r1 >= LUA0) && (r1 <= LUA9)) {
 					PushDataStack(luaArgs[r1 - LUA0]);
-					break;
+				} else {
+					PushDataStack(cobInst->GetUnitVal(r1, 0, 0, 0, 0));
 				}
-				r1 = cobInst->GetUnitVal(r1, 0, 0, 0, 0);
-				PushDataStack(r1);
-			} break;
+			} COB_NEXT_INSTR_CHECKED();
 
 
-			case JUMP_NOT_EQUAL: {
-				r1 = GET_LONG_PC();
-				r2 = PopDataStack();
+			COB_INSTR(JUMP_NOT_EQUAL) {
+				if (PopDataStack() == 0)
+					pc = instr->args[0];
 
-				if (r2 == 0)
-					pc = r1;
-
-			} break;
-			case JUMP: {
-				r1 = GET_LONG_PC();
+			} COB_NEXT_INSTR();
+			COB_INSTR(JUMP) {
 				// this seem to be an error in the docs..
 				//r2 = cobFile->scriptOffsets[LocalFunctionID()] + r1;
-				pc = r1;
-			} break;
+				pc = instr->args[0];
+			} COB_NEXT_INSTR();
+
 
+			COB_INSTR(POP_LOCAL_VAR) {
+				int* var = GetLocalVar(instr->args[0]);
 
-			case POP_LOCAL_VAR: {
-				r1 = GET_LONG_PC();
 				r2 = PopDataStack();
-				dataStack[LocalStackFrame() + r1] = r2;
-			} break;
-			case PUSH_LOCAL_VAR: {
-				r1 = GET_LONG_PC();
-				r2 = dataStack[LocalStackFrame() + r1];
+
+				if (var != nullptr)
+					*var = r2;
+			} COB_NEXT_INSTR();
+			COB_INSTR(PUSH_LOCAL_VAR) {
+				const int* var = GetLocalVar(instr->args[0]);
+
+				r2 = (var != nullptr)? *var: 0;
 				PushDataStack(r2);
-			} break;
+			} COB_NEXT_INSTR();
 
 
-			case BITWISE_AND: {
+			COB_INSTR(BITWISE_AND) {
 				r1 = PopDataStack();
 				r2 = PopDataStack();
 				PushDataStack(r1 & r2);
-			} break;
-			case BITWISE_OR: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(BITWISE_OR) {
 				r1 = PopDataStack();
 				r2 = PopDataStack();
 				PushDataStack(r1 | r2);
-			} break;
-			case BITWISE_XOR: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(BITWISE_XOR) {
 				r1 = PopDataStack();
 				r2 = PopDataStack();
 				PushDataStack(r1 ^ r2);
-			} break;
-			case BITWISE_NOT: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(BITWISE_NOT) {
 				r1 = PopDataStack();
 				PushDataStack(~r1);
-			} break;
+			} COB_NEXT_INSTR();
 
-			case EXPLODE: {
-				r1 = GET_LONG_PC();
+			COB_INSTR(EXPLODE) {
 				r2 = PopDataStack();
-				cobInst->Explode(r1, r2);
-			} break;
+				cobInst->Explode(instr->args[0], r2);
+			} COB_NEXT_INSTR_CHECKED();
 
-			case PLAY_SOUND: {
-				r1 = GET_LONG_PC();
+			COB_INSTR(PLAY_SOUND) {
 				r2 = PopDataStack();
-				cobInst->PlayUnitSound(r1, r2);
-			} break;
+				cobInst->PlayUnitSound(instr->args[0], r2);
+			} COB_NEXT_INSTR_CHECKED();
 
-			case PUSH_STATIC: {
-				r1 = GET_LONG_PC();
-
-				if (static_cast<size_t>(r1) < cobInst->staticVars.size())
-					PushDataStack(cobInst->staticVars[r1]);
-			} break;
+			COB_INSTR(PUSH_STATIC) {
+				assert(static_cast<size_t>(instr->args[0]) < cobInst->staticVars.size());
+				PushDataStack(cobInst->staticVars[instr->args[0]]);
+			} COB_NEXT_INSTR();
 
-			case SET_NOT_EQUAL: {
+			COB_INSTR(SET_NOT_EQUAL) {
 				r1 = PopDataStack();
 				r2 = PopDataStack();
 
 				PushDataStack(int(r1 != r2));
-			} break;
-			case SET_EQUAL: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(SET_EQUAL) {
 				r1 = PopDataStack();
 				r2 = PopDataStack();
 
 				PushDataStack(int(r1 == r2));
-			} break;
+			} COB_NEXT_INSTR();
 
-			case SET_LESS: {
+			COB_INSTR(SET_LESS) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 
 				PushDataStack(int(r1 < r2));
-			} break;
-			case SET_LESS_OR_EQUAL: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(SET_LESS_OR_EQUAL) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 
 				PushDataStack(int(r1 <= r2));
-			} break;
+			} COB_NEXT_INSTR();
 
-			case SET_GREATER: {
+			COB_INSTR(SET_GREATER) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 
 				PushDataStack(int(r1 > r2));
-			} break;
-			case SET_GREATER_OR_EQUAL: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(SET_GREATER_OR_EQUAL) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 
 				PushDataStack(int(r1 >= r2));
-			} break;
+			} COB_NEXT_INSTR();
 
-			case RAND: {
+			COB_INSTR(RAND) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 				r3 = gsRNG.NextInt(r2 - r1 + 1) + r1;
 				PushDataStack(r3);
-			} break;
-			case EMIT_SFX: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(EMIT_SFX) {
 				r1 = PopDataStack();
-				r2 = GET_LONG_PC();
-				cobInst->EmitSfx(r1, r2);
-			} break;
-			case MUL: {
+				cobInst->EmitSfx(r1, instr->args[0]);
+			} COB_NEXT_INSTR_CHECKED();
+			COB_INSTR(MUL) {
 				r1 = PopDataStack();
 				r2 = PopDataStack();
 				PushDataStack(r1 * r2);
-			} break;
+			} COB_NEXT_INSTR();
 
 
-			case SIGNAL: {
+			COB_INSTR(SIGNAL) {
 				r1 = PopDataStack();
 				cobInst->Signal(r1);
-			} break;
-			case SET_SIGNAL_MASK: {
+			} COB_NEXT_INSTR_CHECKED();
+			COB_INSTR(SET_SIGNAL_MASK) {
 				r1 = PopDataStack();
 				signalMask = r1;
-			} break;
+			} COB_NEXT_INSTR();
 
 
-			case TURN: {
+			COB_INSTR(TURN) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
-				r3 = GET_LONG_PC(); // piece
-				r4 = GET_LONG_PC(); // axis
 
-				cobInst->Turn(r3, r4, r1, r2);
-			} break;
-			case GET: {
+				// piece, axis
+				cobInst->Turn(instr->args[0], instr->args[1], r1, r2);
+			} COB_NEXT_INSTR_CHECKED();
+			COB_INSTR(GET) {
 				r5 = PopDataStack();
 				r4 = PopDataStack();
 				r3 = PopDataStack();
 				r2 = PopDataStack();
 				r1 = PopDataStack();
+
 				if ((r1 >= LUA0) && (r1 <= LUA9)) {
 					PushDataStack(luaArgs[r1 - LUA0]);
-					break;
+				} else {
+					r6 = cobInst->GetUnitVal(r1, r2, r3, r4, r5);
+					PushDataStack(r6);
 				}
-				r6 = cobInst->GetUnitVal(r1, r2, r3, r4, r5);
-				PushDataStack(r6);
-			} break;
-			case ADD: {
+			} COB_NEXT_INSTR_CHECKED();
+			COB_INSTR(ADD) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 				PushDataStack(r1 + r2);
-			} break;
-			case SUB: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(SUB) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 				r3 = r1 - r2;
 				PushDataStack(r3);
-			} break;
+			} COB_NEXT_INSTR();
 
-			case DIV: {
+			COB_INSTR(DIV) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 
@@ -713,8 +624,8 @@ bool CCobThread::Tick()
 					ShowError("division by zero");
 				}
 				PushDataStack(r3);
-			} break;
-			case MOD: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(MOD) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 
@@ -724,33 +635,27 @@ bool CCobThread::Tick()
 					PushDataStack(0);
 					ShowError("modulo division by zero");
 				}
-			} break;
+			} COB_NEXT_INSTR();
 
 
-			case MOVE: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			COB_INSTR(MOVE) {
 				r4 = PopDataStack();
 				r3 = PopDataStack();
-				cobInst->Move(r1, r2, r3, r4);
-			} break;
-			case MOVE_NOW: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+				cobInst->Move(instr->args[0], instr->args[1], r3, r4);
+			} COB_NEXT_INSTR_CHECKED();
+			COB_INSTR(MOVE_NOW) {
 				r3 = PopDataStack();
-				cobInst->MoveNow(r1, r2, r3);
-			} break;
-			case TURN_NOW: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+				cobInst->MoveNow(instr->args[0], instr->args[1], r3);
+			} COB_NEXT_INSTR_CHECKED();
+			COB_INSTR(TURN_NOW) {
 				r3 = PopDataStack();
-				cobInst->TurnNow(r1, r2, r3);
-			} break;
+				cobInst->TurnNow(instr->args[0], instr->args[1], r3);
+			} COB_NEXT_INSTR_CHECKED();
 
 
-			case WAIT_TURN: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			COB_INSTR(WAIT_TURN) {
+				r1 = instr->args[0];
+				r2 = instr->args[1];
 
 				if (cobInst->NeedsWait(CCobInstance::ATurn, r1, r2)) {
 					state = WaitTurn;
@@ -758,10 +663,10 @@ bool CCobThread::Tick()
 					waitAxis = r2;
 					return true;
 				}
-			} break;
-			case WAIT_MOVE: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			} COB_NEXT_INSTR_CHECKED();
+			COB_INSTR(WAIT_MOVE) {
+				r1 = instr->args[0];
+				r2 = instr->args[1];
 
 				if (cobInst->NeedsWait(CCobInstance::AMove, r1, r2)) {
 					state = WaitMove;
@@ -769,63 +674,59 @@ bool CCobThread::Tick()
 					waitAxis = r2;
 					return true;
 				}
-			} break;
+			} COB_NEXT_INSTR_CHECKED();
 
 
-			case SET: {
+			COB_INSTR(SET) {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 
 				if ((r1 >= LUA0) && (r1 <= LUA9)) {
 					luaArgs[r1 - LUA0] = r2;
-					break;
+				} else {
+					cobInst->SetUnitVal(r1, r2);
 				}
-
-				cobInst->SetUnitVal(r1, r2);
-			} break;
+			} COB_NEXT_INSTR_CHECKED();
 
 
-			case ATTACH: {
+			COB_INSTR(ATTACH) {
 				r3 = PopDataStack();
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 				cobInst->AttachUnit(r2, r1);
-			} break;
-			case DROP: {
+			} COB_NEXT_INSTR_CHECKED();
+			COB_INSTR(DROP) {
 				r1 = PopDataStack();
 				cobInst->DropUnit(r1);
-			} break;
+			} COB_NEXT_INSTR_CHECKED();
 
 			// like bitwise ops, but only on values 1 and 0
-			case LOGICAL_NOT: {
+			COB_INSTR(LOGICAL_NOT) {
 				r1 = PopDataStack();
 				PushDataStack(int(r1 == 0));
-			} break;
-			case LOGICAL_AND: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(LOGICAL_AND) {
 				r1 = PopDataStack();
 				r2 = PopDataStack();
 				PushDataStack(int(r1 && r2));
-			} break;
-			case LOGICAL_OR: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(LOGICAL_OR) {
 				r1 = PopDataStack();
 				r2 = PopDataStack();
 				PushDataStack(int(r1 || r2));
-			} break;
-			case LOGICAL_XOR: {
+			} COB_NEXT_INSTR();
+			COB_INSTR(LOGICAL_XOR) {
 				r1 = PopDataStack();
 				r2 = PopDataStack();
 				PushDataStack(int((!!r1) ^ (!!r2)));
-			} break;
+			} COB_NEXT_INSTR();
 
 
-			case HIDE: {
-				r1 = GET_LONG_PC();
-				cobInst->SetVisibility(r1, false);
-			} break;
-
-			case SHOW: {
-				r1 = GET_LONG_PC();
+			COB_INSTR(HIDE) {
+				cobInst->SetVisibility(instr->args[0], false);
+			} COB_NEXT_INSTR_CHECKED();
 
+			COB_INSTR(SHOW) {
 				int i;
 				for (i = 0; i < MAX_WEAPONS_PER_UNIT; ++i)
 					if (LocalFunctionID() == cobFile->scriptIndex[COBFN_FirePrimary + COBFN_Weapon_Funcs * i])
@@ -833,36 +734,32 @@ bool CCobThread::Tick()
 
 				// if true, we are in a Fire-script and should show a special flare effect
 				if (i < MAX_WEAPONS_PER_UNIT) {
-					cobInst->ShowFlare(r1);
+					cobInst->ShowFlare(instr->args[0]);
 				} else {
-					cobInst->SetVisibility(r1, true);
+					cobInst->SetVisibility(instr->args[0], true);
 				}
-			} break;
+			} COB_NEXT_INSTR_CHECKED();
 
+	#if (COB_DIRECT_THREADED == 1)
+	}
+	#else
 			default: {
-				const char* name = cobFile->name.c_str();
-				const char* func = cobFile->scriptNames[LocalFunctionID()].c_str();
-
-				LOG_L(L_ERROR, "[COBThread::%s] unknown opcode %x (in %s:%s at %x)", __func__, opcode, name, func, pc - 1);
-
-				#if 0
-				auto ei = execTrace.begin();
-				while (ei != execTrace.end()) {
-					LOG_L(L_ERROR, "\tprogctr: %3x  opcode: %s", __func__, *ei, GetOpcodeName(cobFile->code[*ei]));
-					++ei;
-				}
-				#endif
-
-				state = Dead;
-				return false;
+				assert(false);
 			} break;
 		}
 	}
+	#endif
 
+tick_end:
 	// can arrive here as dead, through CCobInstance::Signal()
 	return (state != Dead);
 }
 
+#undef COB_NEXT_INSTR_CHECKED
+#undef COB_NEXT_INSTR
+#undef COB_DISPATCH
+#undef COB_INSTR
+
 void CCobThread::ShowError(const char* msg)
 {
 	if ((errorCounter = std::max(errorCounter - 1, 0)) == 0)
@@ -880,25 +777,22 @@ void CCobThread::ShowError(const char* msg)
 }
 
 
-void CCobThread::LuaCall()
+void CCobThread::LuaCall(int scriptId, int numArgs)
 {
-	const int r1 = GET_LONG_PC(); // script id
-	const int r2 = GET_LONG_PC(); // arg count
-
 	// setup the parameter array
 	const int size = dataStackSize;
-	const int argCount = std::min(r2, MAX_LUA_COB_ARGS);
-	const int start = std::max(0, size - r2);
+	const int argCount = std::min(numArgs, MAX_LUA_COB_ARGS);
+	const int start = std::max(0, size - numArgs);
 	const int end = std::min(size, start + argCount);
 
 	for (int a = 0, i = start; i < end; i++) {
 		luaArgs[a++] = dataStack[i];
 	}
 
-	if (r2 >= size) {
+	if (numArgs >= size) {
 		dataStackSize = 0;
 	} else {
-		dataStackSize = size - r2;
+		dataStackSize = size - numArgs;
 	}
 
 	if (!luaRules) {
@@ -907,13 +801,13 @@ void CCobThread::LuaCall()
 	}
 
 	// check script index validity
-	if (static_cast<size_t>(r1) >= cobFile->luaScripts.size()) {
+	if (static_cast<size_t>(scriptId) >= cobFile->luaScripts.size()) {
 		luaArgs[0] = 0; // failure
 		return;
 	}
 
 	int argsCount = argCount;
-	luaRules->Cob2Lua(cobFile->luaScripts[r1], cobInst->GetUnit(), argsCount, luaArgs);
+	luaRules->Cob2Lua(cobFile->luaScripts[scriptId], cobInst->GetUnit(), argsCount, luaArgs);
 	retCode = luaArgs[0];
 }
 
@@ -5,6 +5,7 @@
 
 #include <string>
 #include <array>
+#include <vector>
 
 #include "CobInstance.h"
 #include "Lua/LuaRules.h"
@@ -19,7 +20,11 @@ class CCobThread
 	CR_DECLARE_SUB(CallInfo)
 
 public:
-	// default and copy-ctor are creg only
+	// stacks start small and grow on demand up to these sizes
+	static constexpr unsigned int MAX_CALL_STACK_SIZE =   64;
+	static constexpr unsigned int MAX_DATA_STACK_SIZE = 1024;
+
+	// default and copy-ctor are creg (and CCobEngine's slab) only
 	CCobThread() {}
 
 	CCobThread(CCobInstance* _cobInst);
@@ -44,6 +49,12 @@ public:
 	 */
 	void Start(int functionId, int sigMask, const std::array<int, 1 + MAX_COB_ARGS>& args, bool schedule);
 	void Stop();
+	/**
+	 * Turns this into a new thread for <_cobInst>; the capacity of the
+	 * stacks is kept such that threads recycled by CCobEngine do not have
+	 * to allocate.
+	 */
+	void Reset(CCobInstance* _cobInst);
 
 	void SetID(int threadID) { id = threadID; }
 	void SetState(State s) { state = s; }
@@ -105,16 +116,20 @@ protected:
 		int stackTop = -1;
 	};
 
-	void LuaCall();
+	void LuaCall(int scriptId, int numArgs);
+
+	// grow the stacks s.t. they can hold at least n elements, if allowed
+	bool ReserveCallStack(unsigned int n);
+	bool ReserveDataStack(unsigned int n);
 
-	bool PushCallStack(CallInfo v) { return (callStackSize < callStack.size() && PushCallStackRaw(v)); }
-	bool PushDataStack(     int v) { return (dataStackSize < dataStack.size() && PushDataStackRaw(v)); }
+	bool PushCallStack(CallInfo v) { return (ReserveCallStack(callStackSize + 1) && PushCallStackRaw(v)); }
+	bool PushDataStack(     int v) { return (ReserveDataStack(dataStackSize + 1) && PushDataStackRaw(v)); }
 
 	bool PushCallStackRaw(CallInfo v) { assert(callStackSize < callStack.size()); callStack[callStackSize++] = v; return true; }
 	bool PushDataStackRaw(     int v) { assert(dataStackSize < dataStack.size()); dataStack[dataStackSize++] = v; return true; }
 
 	CallInfo& PushCallStackRef() {
-		if (callStackSize < callStack.size())
+		if (ReserveCallStack(callStackSize + 1))
 			return (PushCallStackRefRaw());
 		return callStack[0];
 	}
@@ -123,6 +138,16 @@ protected:
 		return callStack[callStackSize++];
 	}
 
+	// local variables can lie beyond the top of the stack in broken scripts
+	int* GetLocalVar(int varIdx) {
+		const unsigned int stackIdx = LocalStackFrame() + varIdx;
+
+		if (stackIdx >= MAX_DATA_STACK_SIZE || !ReserveDataStack(stackIdx + 1))
+			return nullptr;
+
+		return &dataStack[stackIdx];
+	}
+
 	int LocalFunctionID() const { return callStack[callStackSize - (callStackSize > 0)].functionId; }
 	int LocalReturnAddr() const { return callStack[callStackSize - (callStackSize > 0)].returnAddr; }
 	int LocalStackFrame() const { return callStack[callStackSize - (callStackSize > 0)].stackTop  ; }
@@ -155,8 +180,9 @@ protected:
 	int luaArgs[MAX_LUA_COB_ARGS] = {0};
 
 
-	std::array<CallInfo, 64> callStack;
-	std::array<int, 1024> dataStack;
+	// sizes are the allocated capacity, {call,data}StackSize the used part
+	std::vector<CallInfo> callStack;
+	std::vector<int> dataStack;
 	// std::vector<int> execTrace;
 
 	State state = Init;
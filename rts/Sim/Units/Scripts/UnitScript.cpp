@@ -53,6 +53,8 @@ CR_REG_METADATA(CUnitScript, (
 	CR_MEMBER(unit),
 	CR_MEMBER(busy),
 	CR_MEMBER(anims),
+	// always empty when saving
+	CR_IGNORED(doneAnims),
 
 	//Populated by children
 	CR_IGNORED(pieces),
@@ -85,8 +87,8 @@ CUnitScript::CUnitScript(CUnit* unit)
 
 CUnitScript::~CUnitScript()
 {
-	// Remove us from possible animation ticking
-	if (!HaveAnimations())
+	// Remove us from possible animation ticking (and callback dispatch)
+	if (!HaveAnimations() && !HaveFinishedAnimations())
 		return;
 
 	unitScriptEngine->RemoveInstance(this);
@@ -199,16 +201,24 @@ void CUnitScript::TickAnims(int tickRate, const TickAnimFunc& tickAnimFunc, Anim
  */
 bool CUnitScript::Tick(int deltaTime)
 {
-	// vector of indexes of finished animations,
-	// so we can get rid of them in constant time
-	static AnimContainerType doneAnims[AMove + 1];
+	TickAnimations(deltaTime);
+	DispatchFinishedAnims();
+
+	return (HaveAnimations());
+}
+
+void CUnitScript::TickAnimations(int deltaTime)
+{
 	// tick-functions; these never change address
 	static constexpr TickAnimFunc tickAnimFuncs[AMove + 1] = {&CUnitScript::TickTurnAnim, &CUnitScript::TickSpinAnim, &CUnitScript::TickMoveAnim};
 
 	for (int animType = ATurn; animType <= AMove; animType++) {
 		TickAnims(1000 / deltaTime, tickAnimFuncs[animType], anims[animType], doneAnims[animType]);
 	}
+}
 
+void CUnitScript::DispatchFinishedAnims()
+{
 	// Tell listeners to unblock, and remove finished animations from the unit/script.
 	for (int animType = ATurn; animType <= AMove; animType++) {
 		for (AnimInfo& ai: doneAnims[animType]) {
@@ -217,8 +227,6 @@ bool CUnitScript::Tick(int deltaTime)
 
 		doneAnims[animType].clear();
 	}
-
-	return (HaveAnimations());
 }
 
 
@@ -246,8 +254,9 @@ void CUnitScript::RemoveAnim(AnimType type, const AnimContainerTypeIt& animInfoI
 	anims[type].pop_back();
 
 	// If this was the last animation, remove from currently animating list
+	// (unless finished ones still await dispatch, see TickParallel)
 	// FIXME: this could be done in a cleaner way
-	if (HaveAnimations())
+	if (HaveAnimations() || HaveFinishedAnimations())
 		return;
 
 	unitScriptEngine->RemoveInstance(this);
@@ -308,8 +317,9 @@ void CUnitScript::AddAnim(AnimType type, int piece, int axis, float speed, float
 
 	if (animInfoIt == anims[type].end()) {
 		// If we were not animating before, inform the engine of this so it can schedule us
+		// (pending finished animations mean we are still scheduled, see RemoveAnim)
 		// FIXME: this could be done in a cleaner way
-		if (!HaveAnimations())
+		if (!HaveAnimations() && !HaveFinishedAnimations())
 			unitScriptEngine->AddInstance(this);
 
 		anims[type].emplace_back();
@@ -43,6 +43,8 @@ protected:
 	typedef bool(CUnitScript::*TickAnimFunc)(int, LocalModelPiece&, AnimInfo&);
 
 	AnimContainerType anims[AMove + 1];
+	// finished animations with waiting threads, until their callbacks ran
+	AnimContainerType doneAnims[AMove + 1];
 
 
 	bool hasSetSFXOccupy;
@@ -107,6 +109,10 @@ public:
 	const CUnit* GetUnit() const { return unit; }
 
 	bool Tick(int tickRate);
+	// the two halves of Tick; TickAnimations only modifies this script's
+	// own pieces, so different scripts can be ticked concurrently
+	void TickAnimations(int deltaTime);
+	void DispatchFinishedAnims();
 	// note: must copy-and-set here (LMP dirty flag, etc)
 	bool TickMoveAnim(int tickRate, LocalModelPiece& lmp, AnimInfo& ai) { float3 pos = lmp.GetPosition(); const bool ret = MoveToward(pos[ai.axis], ai.dest, ai.speed / tickRate); lmp.SetPosition(pos); return ret; }
 	bool TickTurnAnim(int tickRate, LocalModelPiece& lmp, AnimInfo& ai) { float3 rot = lmp.GetRotation(); const bool ret = TurnToward(rot[ai.axis], ai.dest, ai.speed / tickRate); lmp.SetRotation(rot); return ret; }
@@ -144,6 +150,10 @@ public:
 	bool HaveAnimations() const {
 		return (!anims[ATurn].empty() || !anims[ASpin].empty() || !anims[AMove].empty());
 	}
+	// finished but not yet dispatched, only between TickAnimations and DispatchFinishedAnims
+	bool HaveFinishedAnimations() const {
+		return (!doneAnims[ATurn].empty() || !doneAnims[ASpin].empty() || !doneAnims[AMove].empty());
+	}
 
 	// checks for callin existence
 	bool HasSetSFXOccupy () const { return hasSetSFXOccupy; }
@@ -8,11 +8,14 @@
 #include "CobFileHandler.h"
 #include "UnitScript.h"
 #include "UnitScriptFactory.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitDef.h"
 #include "Sim/Units/UnitHandler.h"
+#include "UnitScriptTicks.h"
 #include "System/ContainerUtil.h"
 #include "System/SafeUtil.h"
+#include "System/TimeProfiler.h"
 
 static CCobEngine gCobEngine;
 static CCobFileHandler gCobFileHandler;
@@ -28,8 +31,9 @@ CR_BIND(CUnitScriptEngine, )
 CR_REG_METADATA(CUnitScriptEngine, (
 	CR_MEMBER(animating),
 
-	// always null when saving
-	CR_IGNORED(currentScript)
+	// always null/empty when saving
+	CR_IGNORED(currentScript),
+	CR_IGNORED(tickedScripts)
 ))
 
 
@@ -110,27 +114,29 @@ void CUnitScriptEngine::RemoveInstance(CUnitScript* instance)
 	if (instance == currentScript)
 		return;
 
-	spring::VectorErase(animating, instance);
+	UnitScriptTicks::RemoveInstance(animating, tickedScripts, instance);
 }
 
 
 void CUnitScriptEngine::Tick(int deltaTime)
 {
-	cobEngine->Tick(deltaTime);
-
-	// tick all (COB or LUS) script instances that have registered themselves as animating
-	for (size_t i = 0; i < animating.size(); ) {
-		currentScript = animating[i];
-
-		if (!currentScript->Tick(deltaTime)) {
-			animating[i] = animating.back();
-			animating.pop_back();
-			continue;
-		}
+	{
+		// COB threads only, callins run them as part of their callers
+		SCOPED_TIMER("Sim::Script::COB");
+		cobEngine->Tick(deltaTime);
+	}
 
-		i++;
+	if (modInfo.enableParallelPieceAnims) {
+		TickParallel(deltaTime);
+		return;
 	}
 
-	currentScript = nullptr;
+	// tick all (COB or LUS) script instances that have registered themselves as animating
+	UnitScriptTicks::Tick(animating, currentScript, deltaTime);
 }
 
+void CUnitScriptEngine::TickParallel(int deltaTime)
+{
+	// callbacks can add or remove instances, this works on a copy
+	UnitScriptTicks::TickParallel(animating, tickedScripts, deltaTime);
+}
@@ -24,9 +24,12 @@ public:
 	void ReloadScripts(const UnitDef* udef);
 
 	void Tick(int deltaTime);
+	// ticks the animations of all instances concurrently, then runs their
+	// AnimFinished callbacks in order (modrule enableParallelPieceAnims)
+	void TickParallel(int deltaTime);
 
-	void Init() { animating.reserve(256); }
-	void Kill() { animating.clear(); }
+	void Init() { animating.reserve(256); tickedScripts.reserve(256); }
+	void Kill() { animating.clear(); tickedScripts.clear(); }
 
 	static void InitStatic();
 	static void KillStatic();
@@ -35,6 +38,8 @@ private:
 	CUnitScript* currentScript = nullptr;
 
 	std::vector<CUnitScript*> animating;
+	// snapshot of <animating> taken before ticking it in parallel
+	std::vector<CUnitScript*> tickedScripts;
 };
 
 extern CUnitScriptEngine* unitScriptEngine;
@@ -0,0 +1,84 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef UNIT_SCRIPT_TICKS_H
+#define UNIT_SCRIPT_TICKS_H
+
+#include <algorithm>
+#include <vector>
+
+#include "System/ContainerUtil.h"
+#include "System/Threading/ThreadPool.h"
+
+/*
+ * The animation ticking done by CUnitScriptEngine, on any type that provides
+ * CUnitScript's Tick, TickAnimations, DispatchFinishedAnims and HaveAnimations
+ * (which lets the test compare both modes without creating units).
+ */
+namespace UnitScriptTicks {
+	// ticks each instance and runs its AnimFinished callbacks right away; the
+	// instance being ticked is <currentScript> and may not be added or removed
+	template<typename Script>
+	void Tick(std::vector<Script*>& animating, Script*& currentScript, int deltaTime)
+	{
+		for (size_t i = 0; i < animating.size(); ) {
+			currentScript = animating[i];
+
+			if (!currentScript->Tick(deltaTime)) {
+				animating[i] = animating.back();
+				animating.pop_back();
+				continue;
+			}
+
+			i++;
+		}
+
+		currentScript = nullptr;
+	}
+
+	// ticks the animations of all instances concurrently, then runs their
+	// AnimFinished callbacks in list order; a callback can remove (or even
+	// destroy) any other instance, which RemoveInstance clears from the
+	// <tickedScripts> snapshot
+	template<typename Script>
+	void TickParallel(std::vector<Script*>& animating, std::vector<Script*>& tickedScripts, int deltaTime)
+	{
+		tickedScripts.clear();
+		tickedScripts.insert(tickedScripts.end(), animating.begin(), animating.end());
+
+		// piece animations only modify the pieces of their own script
+		for_mt(0, tickedScripts.size(), [&](const int i) {
+			tickedScripts[i]->TickAnimations(deltaTime);
+		});
+
+		for (size_t i = 0; i < tickedScripts.size(); i++) {
+			if (tickedScripts[i] == nullptr)
+				continue;
+
+			tickedScripts[i]->DispatchFinishedAnims();
+		}
+
+		// remove instances whose animations all finished while ticking
+		for (size_t i = 0; i < animating.size(); ) {
+			if (!animating[i]->HaveAnimations()) {
+				animating[i] = animating.back();
+				animating.pop_back();
+				continue;
+			}
+
+			i++;
+		}
+
+		tickedScripts.clear();
+	}
+
+	template<typename Script>
+	void RemoveInstance(std::vector<Script*>& animating, std::vector<Script*>& tickedScripts, Script* instance)
+	{
+		// only non-empty while TickParallel runs callbacks
+		std::replace(tickedScripts.begin(), tickedScripts.end(), instance, static_cast<Script*>(nullptr));
+
+		spring::VectorErase(animating, instance);
+	}
+}
+
+#endif // UNIT_SCRIPT_TICKS_H
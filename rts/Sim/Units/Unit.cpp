@@ -511,6 +511,12 @@ void CUnit::ForcedKillUnit(CUnit* attacker, bool selfDestruct, bool reclaimed, b
 }
 
 
+void CUnit::Move(const float3& v, bool relative)
+{
+	CSolidObject::Move(v, relative);
+	quadField.UpdateUnitSnapshot(this);
+}
+
 void CUnit::ForcedMove(const float3& newPos)
 {
 	UnBlock();
@@ -859,7 +865,7 @@ void CUnit::SetLosStatus(int at, unsigned short newStatus)
 }
 
 
-unsigned short CUnit::CalcLosStatus(int at)
+unsigned short CUnit::CalcLosStatus(int at) const
 {
 	const unsigned short currStatus = losStatus[at];
 
@@ -891,6 +897,15 @@ void CUnit::UpdateLosStatus(int at)
 	SetLosStatus(at, CalcLosStatus(at));
 }
 
+bool CUnit::NeedsLosStatusUpdate(int at) const
+{
+	const unsigned short currStatus = losStatus[at];
+	if ((currStatus & LOS_ALL_MASK_BITS) == LOS_ALL_MASK_BITS)
+		return false;
+
+	return (CalcLosStatus(at) != currStatus);
+}
+
 
 void CUnit::SetStunned(bool stun) {
 	stunned = stun;
@@ -2810,6 +2825,7 @@ CR_REG_METADATA(CUnit, (
 	CR_MEMBER(losStatus),
 	CR_MEMBER(posErrorMask),
 	CR_MEMBER(quads),
+	CR_IGNORED(quadSlots),
 
 
 	CR_MEMBER(loadingTransportId),
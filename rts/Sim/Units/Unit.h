@@ -108,6 +108,8 @@ public:
 	void Deactivate();
 
 	void ForcedMove(const float3& newPos);
+	// hides CSolidObject::Move, also refreshes the QuadField snapshots
+	void Move(const float3& v, bool relative);
 
 	void DeleteScript();
 	void EnableScriptMoveType();
@@ -191,8 +193,10 @@ public:
 	bool IsInLosForAllyTeam(int allyTeam) const { return ((losStatus[allyTeam] & LOS_INLOS) != 0); }
 
 	void SetLosStatus(int allyTeam, unsigned short newStatus);
-	unsigned short CalcLosStatus(int allyTeam);
+	unsigned short CalcLosStatus(int allyTeam) const;
 	void UpdateLosStatus(int allyTeam);
+	// true if UpdateLosStatus would change anything, safe to call from multiple threads
+	bool NeedsLosStatusUpdate(int allyTeam) const;
 
 	void UpdateWeapons();
 
@@ -342,6 +346,9 @@ public:
 
 	// quads the unit is part of
 	std::vector<int> quads;
+	// index of the unit in each quad's units vector (parallel to quads),
+	// only maintained if the QuadField keeps SoA snapshots
+	std::vector<int> quadSlots;
 
 	std::vector<TransportedUnit> transportedUnits;
 	// incoming projectiles for which flares can cause retargeting
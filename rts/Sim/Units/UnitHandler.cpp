@@ -1,5 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <cassert>
 
 #include "UnitHandler.h"
@@ -12,6 +13,7 @@
 
 #include "CommandAI/BuilderCAI.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/MoveType.h"
 #include "Sim/Path/IPathManager.h"
@@ -19,6 +21,7 @@
 #include "System/EventHandler.h"
 #include "System/Log/ILog.h"
 #include "System/SpringMath.h"
+#include "System/Sync/SyncedPrimitiveBase.h"
 #include "System/Threading/ThreadPool.h"
 #include "System/TimeProfiler.h"
 #include "System/creg/STL_Deque.h"
@@ -99,6 +102,7 @@ void CUnitHandler::Init() {
 	}
 	{
 		activeSlowUpdateUnit = 0;
+		asyncPathFrameNum = -1;
 		activeUpdateUnit = 0;
 	}
 	{
@@ -121,6 +125,8 @@ void CUnitHandler::Init() {
 
 void CUnitHandler::Kill()
 {
+	FinishAsyncPathRequests(false);
+
 	for (CUnit* u: activeUnits) {
 		// ~CUnit dereferences featureHandler which is destroyed already
 		u->KilledScriptFinished(-1);
@@ -348,7 +354,15 @@ void CUnitHandler::UpdateUnitMoveTypes()
 	}
 	}
 
-	{
+	if (modInfo.enableParallelMoveTypeUpdate) {
+		UpdateUnitMoveTypesMT();
+	} else {
+		UpdateUnitMoveTypesST();
+	}
+}
+
+void CUnitHandler::UpdateUnitMoveTypesST()
+{
 	SCOPED_TIMER("Sim::Unit::MoveType::5::UpdateST");
 	for (activeUpdateUnit = 0; activeUpdateUnit < activeUnits.size(); ++activeUpdateUnit) {
 		CUnit* unit = activeUnits[activeUpdateUnit];
@@ -365,11 +379,93 @@ void CUnitHandler::UpdateUnitMoveTypes()
 		unit->SanityCheck();
 		assert(activeUnits[activeUpdateUnit] == unit);
 	}
+}
+
+void CUnitHandler::UpdateUnitMoveTypesMT()
+{
+	{
+	SCOPED_TIMER("Sim::Unit::MoveType::5::UpdateMT");
+	SCOPED_SYNC_PARALLEL_SECTION();
+	for_mt(0, activeUnits.size(), [this](const int i){
+		SCOPED_SYNC_PARALLEL_ITEM(i);
+
+		CUnit* unit = activeUnits[i];
+		AMoveType* moveType = unit->moveType;
+
+		auto& events = threadMoveTypeEvents[ThreadPool::GetThreadNum()];
+
+		if (!moveType->CanUpdateMt()) {
+			events.push_back({unit, static_cast<unsigned int>(i), MOVETYPE_UPDATE_SERIAL});
+			return;
+		}
+
+		unsigned int flags = MOVETYPE_UPDATE_DEFERRED;
+
+		if (moveType->UpdateMt())
+			flags |= MOVETYPE_UPDATE_MOVED;
+		if (!unit->pos.IsInBounds() && (unit->speed.w > MAX_UNIT_SPEED))
+			flags |= MOVETYPE_UPDATE_KILL;
+
+		unit->SanityCheck();
+		events.push_back({unit, static_cast<unsigned int>(i), flags});
+	});
+	}
+
+	{
+	SCOPED_TIMER("Sim::Unit::MoveType::6::UpdateDeferredST");
+
+	moveTypeEvents.clear();
+	moveTypeEvents.reserve(activeUnits.size());
+
+	for (auto& events: threadMoveTypeEvents) {
+		moveTypeEvents.insert(moveTypeEvents.end(), events.begin(), events.end());
+		events.clear();
+	}
+
+	// which thread recorded an event is not deterministic, its unit is; this
+	// keeps the order of UpdateUnitMoveTypesST, except that serial movetypes
+	// now run after all parallel ones have moved their units (whose synced
+	// mid- and aim-positions only catch up when their own event is applied)
+	std::sort(moveTypeEvents.begin(), moveTypeEvents.end(), [](const MoveTypeUpdateEvent& a, const MoveTypeUpdateEvent& b) {
+		return (a.unitIdx < b.unitIdx);
+	});
+
+	for (const MoveTypeUpdateEvent& event: moveTypeEvents) {
+		CUnit* unit = event.unit;
+		AMoveType* moveType = unit->moveType;
+
+		unsigned int flags = event.flags;
+
+		if ((flags & MOVETYPE_UPDATE_SERIAL) != 0) {
+			if (moveType->Update())
+				flags |= MOVETYPE_UPDATE_MOVED;
+			if (!unit->pos.IsInBounds() && (unit->speed.w > MAX_UNIT_SPEED))
+				flags |= MOVETYPE_UPDATE_KILL;
+		}
+
+		if ((flags & MOVETYPE_UPDATE_DEFERRED) != 0)
+			moveType->UpdateMtDeferred();
+
+		if ((flags & MOVETYPE_UPDATE_MOVED) != 0)
+			eventHandler.UnitMoved(unit);
+
+		// this unit is not coming back, kill it now without any death
+		// sequence (s.t. deathScriptFinished becomes true immediately)
+		if ((flags & MOVETYPE_UPDATE_KILL) != 0)
+			unit->ForcedKillUnit(nullptr, false, true, false);
+
+		unit->SanityCheck();
+	}
 	}
 }
 
 void CUnitHandler::UpdateUnitLosStates()
 {
+	if (modInfo.enableParallelLosStatusUpdate) {
+		UpdateUnitLosStatesMT();
+		return;
+	}
+
 	for (CUnit* unit: activeUnits) {
 		for (int at = 0; at < teamHandler.ActiveAllyTeams(); ++at) {
 			unit->UpdateLosStatus(at);
@@ -377,6 +473,49 @@ void CUnitHandler::UpdateUnitLosStates()
 	}
 }
 
+void CUnitHandler::UpdateUnitLosStatesMT()
+{
+	{
+	SCOPED_TIMER("Sim::Unit::LosStatus::1::FindChangesMT");
+	// every allyteam only reads its own losStatus slot of each unit
+	for_mt(0, teamHandler.ActiveAllyTeams(), [this](const int at) {
+		auto& changes = allyTeamLosChanges[at];
+
+		changes.clear();
+
+		for (unsigned int i = 0, n = activeUnits.size(); i < n; ++i) {
+			const CUnit* unit = activeUnits[i];
+
+			if (!unit->NeedsLosStatusUpdate(at))
+				continue;
+
+			changes.push_back({i, at});
+		}
+	});
+	}
+
+	{
+	SCOPED_TIMER("Sim::Unit::LosStatus::2::ApplyChangesST");
+
+	losStatusChanges.clear();
+
+	for (int at = 0; at < teamHandler.ActiveAllyTeams(); ++at) {
+		losStatusChanges.insert(losStatusChanges.end(), allyTeamLosChanges[at].begin(), allyTeamLosChanges[at].end());
+	}
+
+	// same (unit, allyteam) order as the serial loop, so events are sent in the same sequence
+	std::sort(losStatusChanges.begin(), losStatusChanges.end());
+
+	// status is recalculated here rather than taken from the parallel pass
+	// since callins for earlier units could have changed it (e.g. through
+	// SetUnitLosMask); changes that only appear as a result of that will
+	// be picked up next frame
+	for (const LosStatusChange& change: losStatusChanges) {
+		activeUnits[change.unitIdx]->UpdateLosStatus(change.allyTeam);
+	}
+	}
+}
+
 
 void CUnitHandler::SlowUpdateUnits()
 {
@@ -415,7 +554,21 @@ void CUnitHandler::SlowUpdateUnits()
 void CUnitHandler::UpdateUnitPathing(const size_t idxBeg, const size_t idxEnd)
 {
 	SCOPED_TIMER("Sim::Unit::RequestPath");
-	TKPFS::PathingSystemActive = true;
+
+	if (UseAsyncPathRequests()) {
+		// searched after this frame, see LaunchAsyncPathRequests
+		assert(asyncPathUnits.empty());
+		assert(asyncPathTasks.empty());
+
+		GetUnitsWithPathRequests(asyncPathUnits, idxBeg, idxEnd);
+
+		if (!asyncPathUnits.empty())
+			asyncPathFrameNum = gs->frameNum;
+
+		return;
+	}
+
+	TKPFS::ScopedPathingSystem pathingSystem;
 
 	std::vector<CUnit*> unitsToMove;
 	unitsToMove.reserve(activeUnits.size());
@@ -426,8 +579,11 @@ void CUnitHandler::UpdateUnitPathing(const size_t idxBeg, const size_t idxEnd)
 		MultiThreadPathRequests(unitsToMove);
 	else
 		SingleThreadPathRequests(unitsToMove);
+}
 
-	TKPFS::PathingSystemActive = false;
+bool CUnitHandler::UseAsyncPathRequests() const
+{
+	return (modInfo.enableAsyncPathRequests && pathManager->SupportsMultiThreadedRequests());
 }
 
 void CUnitHandler::GetUnitsWithPathRequests(std::vector<CUnit*>& unitsToMove, const size_t idxBeg, const size_t idxEnd)
@@ -458,10 +614,18 @@ void CUnitHandler::MultiThreadPathRequests(std::vector<CUnit*>& unitsToMove)
 
 	// Carry out the pathing requests without heatmap updates.
 	for_mt(0, unitsToMoveCount, [&unitsToMove](const int i){
+		TKPFS::ScopedPathingSystem pathingSystem;
 		CUnit* unit = unitsToMove[i];
-		unit->moveType->DelayedReRequestPath();
+		unit->moveType->DelayedReRequestPath(true);
 	});
 
+	ApplyPathRequests(unitsToMove);
+}
+
+void CUnitHandler::ApplyPathRequests(std::vector<CUnit*>& unitsToMove)
+{
+	size_t unitsToMoveCount = unitsToMove.size();
+
 	// update cache
 	for (size_t i = 0; i<unitsToMoveCount; ++i){
 		CUnit* unit = unitsToMove[i];
@@ -484,13 +648,61 @@ void CUnitHandler::MultiThreadPathRequests(std::vector<CUnit*>& unitsToMove)
 	}
 }
 
+void CUnitHandler::LaunchAsyncPathRequests()
+{
+	if (asyncPathUnits.empty())
+		return;
+
+	SCOPED_TIMER("Sim::Unit::RequestPath::Launch");
+
+	// the searches only read state that can not change before they are
+	// finished (nothing synced runs in between), so the frame they start
+	// in determines their results no matter how long they take
+	asyncPathUnitIdx.store(0);
+
+	const int numTasks = std::min(int(asyncPathUnits.size()), std::max(ThreadPool::GetNumThreads() - 1, 1));
+
+	for (int i = 0; i < numTasks; i++) {
+		asyncPathTasks.push_back(ThreadPool::Enqueue([this]() {
+			// only on this worker, the main thread keeps caching its own searches
+			TKPFS::ScopedPathingSystem pathingSystem;
+
+			for (size_t j = 0; (j = asyncPathUnitIdx.fetch_add(1)) < asyncPathUnits.size(); ) {
+				asyncPathUnits[j]->moveType->DelayedReRequestPath(true);
+			}
+		}));
+	}
+}
+
+void CUnitHandler::FinishAsyncPathRequests(bool deliver)
+{
+	if (asyncPathUnits.empty())
+		return;
+
+	SCOPED_TIMER("Sim::Unit::RequestPath::Finish");
+
+	for (const auto& task: asyncPathTasks) {
+		task->wait();
+	}
+
+	asyncPathTasks.clear();
+
+	// same order and state as the synchronous requests
+	if (deliver) {
+		TKPFS::ScopedPathingSystem pathingSystem;
+		ApplyPathRequests(asyncPathUnits);
+	}
+
+	asyncPathUnits.clear();
+}
+
 void CUnitHandler::SingleThreadPathRequests(std::vector<CUnit*>& unitsToMove)
 {
 	size_t unitsToMoveCount = unitsToMove.size();
 
 	for (size_t i = 0; i<unitsToMoveCount; ++i){
 		CUnit* unit = unitsToMove[i];
-		unit->moveType->DelayedReRequestPath();
+		unit->moveType->DelayedReRequestPath(false);
 
 		// Update heatmap inline with request to keep as close as possible to the original
 		// behaviour.
@@ -4,10 +4,14 @@
 #define UNITHANDLER_H
 
 #include <array>
+#include <atomic>
+#include <future>
+#include <memory>
 #include <vector>
 
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/SimObjectIDPool.h"
+#include "System/Threading/ThreadPool.h"
 #include "System/creg/STL_Map.h"
 
 struct UnitDef;
@@ -29,6 +33,17 @@ public:
 	void Update();
 	bool AddUnit(CUnit* unit);
 
+	/// executes the path requests gathered during this frame on the worker
+	/// threads (modInfo.enableAsyncPathRequests), called after the sim frame
+	void LaunchAsyncPathRequests();
+	/// waits for the launched requests and applies their results if <deliver>
+	/// must be called before any synced code runs again, i.e. at the latest
+	/// when the next frame starts, so all clients see the same results
+	void FinishAsyncPathRequests(bool deliver = true);
+	/// last frame whose path requests were searched asynchronously; they are
+	/// applied (and sync-checked) only after that frame's sync response
+	int GetAsyncPathFrameNum() const { return asyncPathFrameNum; }
+
 	bool CanAddUnit(int id) const {
 		// do we want to be assigned a random ID and are any left in pool?
 		if (id < 0)
@@ -82,13 +97,42 @@ private:
 	void SlowUpdateUnits();
 	void UpdateUnitPathing(const size_t idxBeg, const size_t idxEnd);
 	void UpdateUnitMoveTypes();
+	void UpdateUnitMoveTypesST();
+	void UpdateUnitMoveTypesMT();
 	void UpdateUnitLosStates();
+	void UpdateUnitLosStatesMT();
 	void UpdateUnits();
 	void UpdateUnitWeapons();
 
 	void GetUnitsWithPathRequests(std::vector<CUnit*>& unitsToMove, const size_t idxBeg, const size_t idxEnd);
 	void MultiThreadPathRequests(std::vector<CUnit*>& unitsToMove);
 	void SingleThreadPathRequests(std::vector<CUnit*>& unitsToMove);
+	void ApplyPathRequests(std::vector<CUnit*>& unitsToMove);
+
+	bool UseAsyncPathRequests() const;
+
+private:
+	enum {
+		MOVETYPE_UPDATE_SERIAL   = (1 << 0), ///< movetype does not support UpdateMt, call Update
+		MOVETYPE_UPDATE_DEFERRED = (1 << 1), ///< call UpdateMtDeferred
+		MOVETYPE_UPDATE_MOVED    = (1 << 2), ///< send UnitMoved
+		MOVETYPE_UPDATE_KILL     = (1 << 3), ///< unit left the map too fast, kill it
+	};
+
+	struct MoveTypeUpdateEvent {
+		CUnit* unit;
+		unsigned int unitIdx; ///< index into activeUnits
+		unsigned int flags;
+	};
+
+	struct LosStatusChange {
+		unsigned int unitIdx; ///< index into activeUnits
+		int allyTeam;
+
+		bool operator < (const LosStatusChange& c) const {
+			return ((unitIdx < c.unitIdx) || (unitIdx == c.unitIdx && allyTeam < c.allyTeam));
+		}
+	};
 
 private:
 	SimObjectIDPool idPool;
@@ -101,6 +145,19 @@ private:
 
 	spring::unordered_map<unsigned int, CBuilderCAI*> builderCAIs;
 
+	///< per-thread events recorded by UpdateUnitMoveTypesMT, merged in activeUnits order
+	std::array<std::vector<MoveTypeUpdateEvent>, ThreadPool::MAX_THREADS> threadMoveTypeEvents;
+	std::vector<MoveTypeUpdateEvent> moveTypeEvents;
+
+	///< per-allyteam LOS status changes found by UpdateUnitLosStatesMT, applied in (unit, allyteam) order
+	std::array<std::vector<LosStatusChange>, MAX_TEAMS> allyTeamLosChanges;
+	std::vector<LosStatusChange> losStatusChanges;
+
+	///< units whose path requests are searched in between two frames
+	std::vector<CUnit*> asyncPathUnits;
+	std::vector<std::shared_ptr<std::future<void>>> asyncPathTasks;
+	std::atomic<size_t> asyncPathUnitIdx = {0};
+	int asyncPathFrameNum = -1;
 
 	size_t activeSlowUpdateUnit = 0;  ///< first unit of batch that will be SlowUpdate'd this frame
 	size_t activeUpdateUnit = 0;      ///< first unit of batch that will be SlowUpdate'd this frame
@@ -5,7 +5,9 @@
 
 #include "Weapon.h"
 #include "Sim/Misc/CollisionVolume.h"
+#include "System/Threading/ThreadPool.h"
 
+#include <array>
 #include <vector>
 
 class CPlasmaRepulser: public CWeapon
@@ -66,6 +68,8 @@ public:
 	int tempNum = 0;
 	int scIndex = 0;
 
+	std::array<int, ThreadPool::MAX_THREADS> mtTempNum = {};
+
 private:
 	int hitFrameCount = 0;
 	int rechargeDelay = 0;
@@ -4,6 +4,7 @@
 #include "GZFileHandler.h"
 
 #include <cassert>
+#include <cstdio>
 #include <string>
 #include <zlib.h>
 
@@ -38,28 +39,32 @@ bool CGZFileHandler::ReadToBuffer(const std::string& path)
 {
 	assert(fileBuffer.empty());
 
-	gzFile file = gzopen(path.c_str(), "rb");
-	if (file == Z_NULL)
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
 		return false;
 
-	std::uint8_t unzipBuffer[BUFFER_SIZE];
+	std::uint8_t readBuffer[BUFFER_SIZE];
 
-	while (true) {
-		int unzippedBytes = gzread(file, unzipBuffer, BUFFER_SIZE);
-		if (unzippedBytes < 0) {
-			fileBuffer.clear();
-			fileSize = -1;
-			gzclose(file);
-			return false;
-		}
-		if (unzippedBytes == 0)
-			break;
-		fileBuffer.insert(fileBuffer.end(), unzipBuffer, unzipBuffer + unzippedBytes);
+	for (size_t readBytes = 0; (readBytes = fread(readBuffer, 1, BUFFER_SIZE, file)) > 0; ) {
+		fileBuffer.insert(fileBuffer.end(), readBuffer, readBuffer + readBytes);
 	}
-	gzclose(file);
 
-	fileSize = fileBuffer.size();
-	return true;
+	const bool readError = (ferror(file) != 0);
+	fclose(file);
+
+	if (readError) {
+		fileBuffer.clear();
+		fileSize = -1;
+		return false;
+	}
+
+	// like gzread, pass files that are not gzip-compressed through unchanged
+	if (fileBuffer.size() < 2 || fileBuffer[0] != 0x1f || fileBuffer[1] != 0x8b) {
+		fileSize = fileBuffer.size();
+		return true;
+	}
+
+	return UncompressBuffer();
 }
 
 bool CGZFileHandler::UncompressBuffer()
@@ -77,16 +82,29 @@ bool CGZFileHandler::UncompressBuffer()
 	//+16 marks it's a gzip header
 	inflateInit2(&zstream, 15 + 16);
 
-	zstream.next_in   = &compressed[0];
+	zstream.next_in   = compressed.data();
 	zstream.avail_in  = compressed.size();
 
 	std::uint8_t unzipBuffer[BUFFER_SIZE];
 
+	// size of the data of all complete members
+	size_t completeSize = 0;
+
 	while (true) {
 		zstream.avail_out = BUFFER_SIZE;
 		zstream.next_out = unzipBuffer;
 		const int ret = inflate(&zstream, Z_NO_FLUSH);
-		if (ret != Z_OK) {
+		if (ret != Z_OK && ret != Z_STREAM_END) {
+			inflateEnd(&zstream);
+
+			// the input ends within a member (e.g. a streamed demo whose
+			// writer crashed), keep what the complete members before it hold
+			if (ret == Z_BUF_ERROR && zstream.avail_in == 0 && completeSize > 0) {
+				fileBuffer.resize(completeSize);
+				fileSize = fileBuffer.size();
+				return true;
+			}
+
 			fileBuffer.clear();
 			fileSize = -1;
 			return false;
@@ -95,8 +113,16 @@ bool CGZFileHandler::UncompressBuffer()
 		const size_t unzippedBytes = BUFFER_SIZE - zstream.avail_out;
 		fileBuffer.insert(fileBuffer.end(), unzipBuffer, unzipBuffer + unzippedBytes);
 
-		if (ret == Z_STREAM_END)
+		if (ret != Z_STREAM_END)
+			continue;
+
+		completeSize = fileBuffer.size();
+
+		// gzip-files can consist of multiple members (e.g. streamed demos); like gzread, read all of them
+		if (zstream.avail_in == 0)
 			break;
+
+		inflateReset(&zstream);
 	}
 
 	inflateEnd(&zstream);
@@ -10,6 +10,8 @@
 #include "VFSModes.h"
 /**
  * Uncompresses the entire file to memory, so don't use with huge files.
+ * Files may consist of multiple gzip members; if the last one is cut off
+ * (e.g. by a crash while it was written) only the complete ones are read.
  */
 class CGZFileHandler : public CFileHandler
 {
@@ -0,0 +1,104 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "MemoryMappedFile.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+bool CMemoryMappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	#ifdef _WIN32
+	HANDLE hFile = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart <= 0) {
+		CloseHandle(hFile);
+		return false;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (hMapping == nullptr) {
+		CloseHandle(hFile);
+		return false;
+	}
+
+	void* view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (view == nullptr) {
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+
+	fileHandle = hFile;
+	mappingHandle = hMapping;
+
+	data = static_cast<const std::uint8_t*>(view);
+	size = static_cast<size_t>(fileSize.QuadPart);
+
+	#else
+	const int fd = open(filePath.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+
+	// mapping zero bytes is an error
+	if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// the mapping keeps its own reference to the file
+	close(fd);
+
+	if (view == MAP_FAILED)
+		return false;
+
+	// callers read front-to-back, let the kernel start fetching
+	madvise(view, info.st_size, MADV_SEQUENTIAL);
+	madvise(view, info.st_size, MADV_WILLNEED);
+
+	data = static_cast<const std::uint8_t*>(view);
+	size = static_cast<size_t>(info.st_size);
+	#endif
+
+	return true;
+}
+
+void CMemoryMappedFile::Close()
+{
+	if (data == nullptr)
+		return;
+
+	#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+	#else
+	munmap(const_cast<std::uint8_t*>(data), size);
+	#endif
+
+	data = nullptr;
+	size = 0;
+}
@@ -0,0 +1,42 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _MEMORY_MAPPED_FILE_H
+#define _MEMORY_MAPPED_FILE_H
+
+#include <string>
+#include <cinttypes>
+
+/**
+ * Read-only view of an entire file in the (real) filesystem, backed by
+ * the OS page cache; nothing is copied until the pages are touched.
+ * Takes an absolute path, resolve it through dataDirsAccess first.
+ */
+class CMemoryMappedFile
+{
+public:
+	CMemoryMappedFile() = default;
+	CMemoryMappedFile(const std::string& filePath) { Open(filePath); }
+	CMemoryMappedFile(const CMemoryMappedFile&) = delete;
+	~CMemoryMappedFile() { Close(); }
+
+	CMemoryMappedFile& operator = (const CMemoryMappedFile&) = delete;
+
+	bool Open(const std::string& filePath);
+	void Close();
+
+	bool IsOpen() const { return (data != nullptr); }
+
+	const std::uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	const std::uint8_t* data = nullptr;
+	size_t size = 0;
+
+	#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	#endif
+};
+
+#endif // _MEMORY_MAPPED_FILE_H
@@ -11,6 +11,7 @@
 #include "Game/GameSetup.h"
 #include "Game/GameVersion.h"
 #include "Game/GlobalUnsynced.h"
+#include "Game/Players/PlayerHandler.h"
 #include "Game/WaitCommandsAI.h"
 #include "Game/SelectedUnitsHandler.h"
 #include "Game/UI/Groups/GroupHandler.h"
@@ -28,6 +29,7 @@
 #include "Sim/Misc/CategoryHandler.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/Misc/TeamHandler.h"
+#include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/Wind.h"
 #include "Sim/Projectiles/ProjectileHandler.h"
 #include "Sim/Units/CommandAI/CommandDescription.h"
@@ -45,6 +47,7 @@
 #include "System/creg/Serializer.h"
 #include "System/Exceptions.h"
 #include "System/Log/ILog.h"
+#include "System/Sync/SyncChecker.h"
 
 #define MAX_STRING_SIZE (1 << 19) // 512kB excluding null-term
 
@@ -63,10 +66,15 @@ public:
 	CGameStateCollector() = default;
 
 	void Serialize(creg::ISerializer* s);
+
+public:
+	// keyframes have to continue the exact same simulation
+	bool keyframe = false;
 };
 
 CR_BIND(CGameStateCollector, )
 CR_REG_METADATA(CGameStateCollector, (
+	CR_MEMBER(keyframe),
 	CR_SERIALIZER(Serialize)
 ))
 
@@ -104,6 +112,19 @@ void CGameStateCollector::Serialize(creg::ISerializer* s)
 	s->SerializeObjectInstance(eoh, eoh->GetClass());
 	std::unique_ptr<creg::IType> mapType = creg::DeduceType<decltype(CSplitLuaHandle::gameParams)>::Get();
 	mapType->Serialize(s, &CSplitLuaHandle::gameParams);
+
+	if (!keyframe)
+		return;
+
+	// saved games are reseeded on load, keyframes are not
+	std::uint64_t rngState = gsRNG.GetGenState();
+	s->SerializeInt(&rngState, sizeof(rngState));
+
+	if (!s->IsWriting())
+		gsRNG.SetGenState(rngState);
+
+	// saved games take their players from the new setup
+	playerHandler.SerializePlayers(s);
 }
 
 
@@ -233,6 +254,48 @@ static void LoadLuaState(CSplitLuaHandle* handle, creg::CInputStreamSerializer&
 }
 
 
+#ifdef USING_CREG
+// keyframes are written to demos periodically and sent to mid-game joiners,
+// they skip the AI state (which is local to the AI's host) and do not spam
+// the log with their sizes
+static void SaveGameState(std::stringstream& oss, bool keyframe)
+{
+	creg::COutputStreamSerializer os;
+
+	// save lua state first as lua unit scripts depend on it
+	const int luaStart = oss.tellp();
+	SaveLuaState(luaGaia, os, oss);
+	SaveLuaState(luaRules, os, oss);
+
+	// save creg state
+	const int gameStart = oss.tellp();
+	CGameStateCollector gsc;
+	gsc.keyframe = keyframe;
+	os.SavePackage(&oss, &gsc, gsc.GetClass());
+
+	if (keyframe)
+		return;
+
+	PrintSize("Lua", gameStart - luaStart);
+	PrintSize("Game", ((int)oss.tellp()) - gameStart);
+
+	// save AI state
+	const int aiStart = oss.tellp();
+
+	for (const auto& ai: skirmishAIHandler.GetAllSkirmishAIs()) {
+		std::stringstream aiData;
+		eoh->Save(&aiData, ai.first);
+
+		std::uint64_t aiSize = aiData.tellp();
+		creg::WriteUInt(&oss, aiSize);
+		if (aiSize > 0)
+			oss << aiData.rdbuf();
+	}
+	PrintSize("AIs", ((int)oss.tellp()) - aiStart);
+}
+#endif //USING_CREG
+
+
 void CCregLoadSaveHandler::SaveGame(const std::string& path)
 {
 #ifdef USING_CREG
@@ -241,6 +304,8 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 	// NB: Selection leaves CObject reference as Unit's listener,
 	//     But isn't serialized - leak on load.
 	selectedUnitsHandler.ClearSelected();
+	// the searches write to unit movetypes, finish them before serializing
+	unitHandler.FinishAsyncPathRequests();
 
 	try {
 		std::stringstream oss;
@@ -251,37 +316,7 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 		WriteString(oss, modName);
 		WriteString(oss, mapName);
 
-
-		{
-			creg::COutputStreamSerializer os;
-
-			// save lua state first as lua unit scripts depend on it
-			const int luaStart = oss.tellp();
-			SaveLuaState(luaGaia, os, oss);
-			SaveLuaState(luaRules, os, oss);
-			PrintSize("Lua", ((int)oss.tellp()) - luaStart);
-
-			// save creg state
-			const int gameStart = oss.tellp();
-			CGameStateCollector gsc;
-			os.SavePackage(&oss, &gsc, gsc.GetClass());
-			PrintSize("Game", ((int)oss.tellp()) - gameStart);
-
-
-			// save AI state
-			const int aiStart = oss.tellp();
-
-			for (const auto& ai: skirmishAIHandler.GetAllSkirmishAIs()) {
-				std::stringstream aiData;
-				eoh->Save(&aiData, ai.first);
-
-				std::uint64_t aiSize = aiData.tellp();
-				creg::WriteUInt(&oss, aiSize);
-				if (aiSize > 0)
-					oss << aiData.rdbuf();
-			}
-			PrintSize("AIs", ((int)oss.tellp()) - aiStart);
-		}
+		SaveGameState(oss, false);
 
 		{
 			gzFile file = gzopen(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE).c_str(), "wb5");
@@ -320,6 +355,52 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 #endif //USING_CREG
 }
 
+bool CCregLoadSaveHandler::SaveKeyframe(std::string& saveData)
+{
+#ifdef USING_CREG
+	// unlike SaveGame this runs during a game being played, so the
+	// selection is restored afterwards (a selected group as a whole)
+	const std::vector<int> selectedUnitIDs(selectedUnitsHandler.selectedUnits.begin(), selectedUnitsHandler.selectedUnits.end());
+	const int selectedGroup = selectedUnitsHandler.GetSelectedGroup();
+
+	selectedUnitsHandler.ClearSelected();
+	unitHandler.FinishAsyncPathRequests();
+
+	bool ret = false;
+
+	try {
+		std::stringstream oss;
+
+		SaveGameState(oss, true);
+
+		saveData = std::move(oss.str());
+		ret = true;
+	} catch (const content_error& ex) {
+		LOG_L(L_ERROR, "[LSH::%s] content error \"%s\"", __func__, ex.what());
+	} catch (const std::exception& ex) {
+		LOG_L(L_ERROR, "[LSH::%s] exception \"%s\"", __func__, ex.what());
+	} catch (...) {
+		LOG_L(L_ERROR, "[LSH::%s] unknown error", __func__);
+	}
+
+	if (selectedGroup != -1) {
+		selectedUnitsHandler.SelectGroup(selectedGroup);
+	} else {
+		for (const int unitID: selectedUnitIDs) {
+			CUnit* unit = unitHandler.GetUnit(unitID);
+
+			if (unit != nullptr)
+				selectedUnitsHandler.AddUnit(unit);
+		}
+	}
+
+	return ret;
+#else //USING_CREG
+	LOG_L(L_ERROR, "[LSH::%s] creg is disabled", __func__);
+	return false;
+#endif //USING_CREG
+}
+
 /// loads the data (map&mod-name,setup-script) needed by PreGame
 bool CCregLoadSaveHandler::LoadGameStartInfo(const std::string& path)
 {
@@ -351,10 +432,25 @@ bool CCregLoadSaveHandler::LoadGameStartInfo(const std::string& path)
 	return (saveVersion == syncVersion);
 }
 
+void CCregLoadSaveHandler::LoadKeyframe(const std::string& saveData, unsigned int syncChecksum)
+{
+	// keyframes carry no header, the setup-script comes from the demo
+	iss.str(saveData);
+
+	keyframeChecksum = syncChecksum;
+	isKeyframe = true;
+}
+
 /// this should be called on frame 0 when the game has started
 void CCregLoadSaveHandler::LoadGame()
 {
 #ifdef USING_CREG
+	// keyframes are recorded by one of the players, but loaded by a demo
+	// spectator or a mid-game joiner who should not become that player
+	const int myPlayerNum = gu->myPlayerNum;
+	const int myTeams[] = {gu->myTeam, gu->myAllyTeam, gu->myPlayingTeam, gu->myPlayingAllyTeam};
+	const bool mySpecState[] = {gu->spectating, gu->spectatingFullView, gu->spectatingFullSelect};
+
 	ENTER_SYNCED_CODE();
 	{
 		creg::CInputStreamSerializer inputStream;
@@ -375,6 +471,26 @@ void CCregLoadSaveHandler::LoadGame()
 		spring::SafeDelete(gsc);
 	}
 
+	if (isKeyframe) {
+		// LoadAIData is not called for demos and has nothing to load
+		iss.str("");
+
+		gu->myPlayerNum = myPlayerNum;
+		gu->myTeam = myTeams[0];
+		gu->myAllyTeam = myTeams[1];
+		gu->myPlayingTeam = myTeams[2];
+		gu->myPlayingAllyTeam = myTeams[3];
+		gu->spectating = mySpecState[0];
+		gu->spectatingFullView = mySpecState[1];
+		gu->spectatingFullSelect = mySpecState[2];
+
+#ifdef SYNCCHECK
+		// continue from the keyframe's checksum so that the sync-responses
+		// (recorded in a demo or sent to the server) cover the frames after it
+		CSyncChecker::SetChecksum(keyframeChecksum);
+#endif
+	}
+
 	LEAVE_SYNCED_CODE();
 #else //USING_CREG
 	LOG_L(L_ERROR, "Load failed: creg is disabled");
@@ -385,6 +501,10 @@ void CCregLoadSaveHandler::LoadGame()
 void CCregLoadSaveHandler::LoadAIData()
 {
 #ifdef USING_CREG
+	// keyframes carry no AI state and continue a running game as-is
+	if (isKeyframe)
+		return;
+
 	ENTER_SYNCED_CODE();
 
 	// load ai state
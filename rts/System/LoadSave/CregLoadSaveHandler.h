@@ -18,8 +18,16 @@ public:
 	void LoadAIData() override;
 	void SaveGame(const std::string& path) override;
 
+	/// serializes the running game (without AI state) for a demo keyframe or a mid-game join
+	static bool SaveKeyframe(std::string& saveData);
+	/// prepares LoadGame to restore a keyframe instead of a save-file
+	void LoadKeyframe(const std::string& saveData, unsigned int syncChecksum);
+
 protected:
 	std::stringstream iss;
+
+	unsigned int keyframeChecksum = 0;
+	bool isKeyframe = false;
 };
 
 #endif // CREG_LOAD_SAVE_HANDLER_H
@@ -0,0 +1,84 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "DemoKeyframes.h"
+#include "demofile.h"
+#include "Net/Protocol/NetMessageTypes.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace DemoKeyframes {
+	void PackHeader(std::uint8_t (&header)[HEADER_SIZE], int frameNum, unsigned int syncChecksum)
+	{
+		const std::int32_t frameNum32 = frameNum;
+		const std::uint32_t syncChecksum32 = syncChecksum;
+
+		header[0] = NETMSG_DEMO_KEYFRAME;
+		memcpy(&header[1                        ], &frameNum32, sizeof(frameNum32));
+		memcpy(&header[1 + sizeof(std::int32_t)], &syncChecksum32, sizeof(syncChecksum32));
+	}
+
+	int GetFrameNum(const std::uint8_t* data, unsigned int length)
+	{
+		std::int32_t frameNum = -1;
+
+		if (length >= (sizeof(std::uint8_t) + sizeof(frameNum)))
+			memcpy(&frameNum, &data[1], sizeof(frameNum));
+
+		return frameNum;
+	}
+
+
+	void Scan(const ReadFunc& read, int streamBeg, int streamEnd, std::vector<DemoKeyframe>& keyframes)
+	{
+		for (int chunkPos = streamBeg; (chunkPos + int(sizeof(DemoStreamChunkHeader))) <= streamEnd; ) {
+			DemoStreamChunkHeader header;
+			std::uint8_t keyframeHeader[HEADER_SIZE];
+
+			if (read(chunkPos, (char*)&header, sizeof(header)) < int(sizeof(header)))
+				break;
+
+			header.swab();
+
+			const int dataPos = chunkPos + sizeof(header);
+
+			if (header.length > unsigned(streamEnd - dataPos))
+				break;
+
+			chunkPos = dataPos + header.length;
+
+			// only the keyframe headers have to be inspected
+			if (header.length < HEADER_SIZE)
+				continue;
+			if (read(dataPos, (char*)keyframeHeader, 1) < 1 || keyframeHeader[0] != NETMSG_DEMO_KEYFRAME)
+				continue;
+			if (read(dataPos + 1, (char*)&keyframeHeader[1], HEADER_SIZE - 1) < (HEADER_SIZE - 1))
+				break;
+
+			DemoKeyframe keyframe;
+
+			memcpy(&keyframe.frameNum, &keyframeHeader[1], sizeof(std::int32_t));
+			memcpy(&keyframe.syncChecksum, &keyframeHeader[1 + sizeof(std::int32_t)], sizeof(std::uint32_t));
+
+			keyframe.saveDataSize = header.length - HEADER_SIZE;
+			keyframe.saveDataPos = dataPos + HEADER_SIZE;
+
+			if (!keyframes.empty() && keyframes.back().frameNum >= keyframe.frameNum)
+				continue;
+
+			keyframes.push_back(keyframe);
+		}
+	}
+
+	const DemoKeyframe* Find(const std::vector<DemoKeyframe>& keyframes, int frameNum)
+	{
+		const auto pred = [](int frame, const DemoKeyframe& kf) { return (frame < kf.frameNum); };
+		const auto iter = std::upper_bound(keyframes.begin(), keyframes.end(), frameNum, pred);
+
+		if (iter == keyframes.begin())
+			return nullptr;
+
+		return &(*(iter - 1));
+	}
+}
@@ -0,0 +1,44 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEMO_KEYFRAMES_H
+#define DEMO_KEYFRAMES_H
+
+#include <cinttypes>
+#include <functional>
+#include <vector>
+
+/// a NETMSG_DEMO_KEYFRAME chunk, holds the savestate taken after <frameNum> was simulated
+struct DemoKeyframe {
+	int frameNum;
+	unsigned int syncChecksum;
+	unsigned int saveDataSize;
+	int saveDataPos;
+};
+
+/**
+ * Layout and indexing of the savestate keyframes embedded in demo streams.
+ * A keyframe chunk holds a NETMSG_DEMO_KEYFRAME header (message id, frame
+ * number and sync checksum) followed by the raw savestate.
+ */
+namespace DemoKeyframes {
+	static constexpr int HEADER_SIZE = sizeof(std::uint8_t) + sizeof(std::int32_t) + sizeof(std::uint32_t);
+
+	void PackHeader(std::uint8_t (&header)[HEADER_SIZE], int frameNum, unsigned int syncChecksum);
+	/// @return the frame number of a keyframe message, or -1 if it is truncated
+	int GetFrameNum(const std::uint8_t* data, unsigned int length);
+
+	/// reads up to <size> bytes at absolute file position <pos>, returns the number read
+	typedef std::function<int(int pos, char* buf, int size)> ReadFunc;
+
+	/**
+	 * Hops from one chunk header of the demo stream [streamBeg, streamEnd)
+	 * to the next and appends every keyframe to <keyframes>, ordered by frame
+	 * number. Stops at the first truncated chunk.
+	 */
+	void Scan(const ReadFunc& read, int streamBeg, int streamEnd, std::vector<DemoKeyframe>& keyframes);
+
+	/// @return the last keyframe at or before <frameNum>, or nullptr if there is none
+	const DemoKeyframe* Find(const std::vector<DemoKeyframe>& keyframes, int frameNum);
+}
+
+#endif // DEMO_KEYFRAMES_H
@@ -200,3 +200,46 @@ void CDemoReader::LoadStats()
 
 	playbackDemo->Seek(curPos);
 }
+
+
+const std::vector<DemoKeyframe>& CDemoReader::GetKeyframes()
+{
+	if (scannedKeyframes)
+		return keyframes;
+
+	scannedKeyframes = true;
+
+	// the whole file is held in memory, so hopping from one chunk header to
+	// the next is cheap
+	const int curPos = playbackDemo->GetPos();
+	const int streamBeg = fileHeader.headerSize + fileHeader.scriptSize;
+	const int streamEnd = (fileHeader.demoStreamSize != 0)? (streamBeg + fileHeader.demoStreamSize): playbackDemoSize;
+
+	DemoKeyframes::Scan([&](int pos, char* buf, int size) {
+		playbackDemo->Seek(pos);
+		return (playbackDemo->Read(buf, size));
+	}, streamBeg, streamEnd, keyframes);
+
+	playbackDemo->Seek(curPos);
+	return keyframes;
+}
+
+const DemoKeyframe* CDemoReader::FindKeyframe(int frameNum)
+{
+	return (DemoKeyframes::Find(GetKeyframes(), frameNum));
+}
+
+bool CDemoReader::ReadKeyframe(const DemoKeyframe& keyframe, std::string& saveData)
+{
+	const int curPos = playbackDemo->GetPos();
+
+	saveData.clear();
+	saveData.resize(keyframe.saveDataSize);
+
+	playbackDemo->Seek(keyframe.saveDataPos);
+
+	const bool ret = (playbackDemo->Read(&saveData[0], saveData.size()) == int(saveData.size()));
+
+	playbackDemo->Seek(curPos);
+	return ret;
+}
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "Demo.h"
+#include "DemoKeyframes.h"
 
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
@@ -55,6 +56,16 @@ public:
 	/// Not needed for normal demo watching
 	void LoadStats();
 
+	/**
+	@brief scans the demo stream for keyframes (only once)
+	@return all keyframes in the stream, ordered by frame number
+	*/
+	const std::vector<DemoKeyframe>& GetKeyframes();
+	/// @return the last keyframe at or before <frameNum>, or nullptr if there is none
+	const DemoKeyframe* FindKeyframe(int frameNum);
+	/// reads the savestate of <keyframe>
+	bool ReadKeyframe(const DemoKeyframe& keyframe, std::string& saveData);
+
 private:
 	CFileHandler* playbackDemo;
 
@@ -70,6 +81,9 @@ private:
 	std::vector<PlayerStatistics> playerStats; // one stat per player
 	std::vector< std::vector<TeamStatistics> > teamStats; // many stats per team
 	std::vector<unsigned char> winningAllyTeams;
+
+	std::vector<DemoKeyframe> keyframes;
+	bool scannedKeyframes = false;
 };
 
 #endif
@@ -6,16 +6,17 @@
 #include <memory>
 
 #include "DemoRecorder.h"
+#include "DemoKeyframes.h"
 #include "Game/GameVersion.h"
 #include "Sim/Misc/TeamStatistics.h"
 #include "System/TimeUtil.h"
 #include "System/StringUtil.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileHandler.h"
 #include "System/Log/ILog.h"
-#include "System/Threading/ThreadPool.h"
 
 #ifdef CreateDirectory
 #undef CreateDirectory
@@ -26,40 +27,41 @@
 #endif
 
 
-// server and client memory-streams
-static std::string demoStreams[2];
-static spring::mutex demoMutex;
+CONFIG(int, DemoFlushInterval).defaultValue(5000).minimumValue(100).description("Interval (in milliseconds) at which recorded demo data is compressed and appended to the demo file. At most this much of a demo is lost if Spring crashes.");
+CONFIG(int, DemoBufferSize).defaultValue(2048).minimumValue(64).description("Amount of uncompressed demo data (in KB) buffered per demo before it is flushed early. Recording stalls if the file can not be written as fast.");
 
 
 CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo): isServerDemo(serverDemo)
 {
-	std::lock_guard<spring::mutex> lock(demoMutex);
-
-	SetStream();
 	SetName(mapName, modName);
 	SetFileHeader();
-	WriteFileHeader(false);
 
-	file = gzopen(demoName.c_str(), "wb9");
+	const DemoFileHeader tmpHeader = GetSwabbedFileHeader(false);
+	const unsigned int flushInterval = configHandler->GetInt("DemoFlushInterval");
+	const unsigned int bufferSize = configHandler->GetInt("DemoBufferSize") * 1024;
+
+	writer.reset(new CDemoStreamWriter(demoName, &tmpHeader, sizeof(tmpHeader), flushInterval, bufferSize));
+
+	if (writer->IsOpen())
+		return;
+
+	writer.reset();
 }
 
 CDemoRecorder::~CDemoRecorder()
 {
-	if (file == nullptr)
+	if (writer == nullptr)
 		return;
 
 	WriteWinnerList();
 	WritePlayerStats();
 	WriteTeamStats();
 	WriteFileHeader(true);
-	WriteDemoFile();
-}
 
+	LOG("[DemoRecorder::%s] finishing %s-demo \"%s\" (%d bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize);
 
-void CDemoRecorder::SetStream()
-{
-	demoStreams[isServerDemo].clear();
-	demoStreams[isServerDemo].reserve(8 * 1024 * 1024);
+	// flushes the remaining data
+	writer->Close();
 }
 
 void CDemoRecorder::SetFileHeader()
@@ -76,56 +78,60 @@ void CDemoRecorder::SetFileHeader()
 	fileHeader.winningAllyTeamsSize = 0;
 }
 
-void CDemoRecorder::WriteDemoFile()
-{
-	// zlib FAQ claims the lib is thread-safe, "however any library routines that zlib uses and
-	// any application-provided memory allocation routines must also be thread-safe. zlib's gz*
-	// functions use stdio library routines, and most of zlib's functions use the library memory
-	// allocation routines by default" (so code below should be OK)
-	// gz* should usually be finished before ctor runs again when reloading, but take no chances
-	std::string& data = demoStreams[isServerDemo];
-	std::function<void(gzFile, std::string&)> func = [](gzFile file, std::string& data) {
-		std::lock_guard<spring::mutex> lock(demoMutex);
-
-		gzwrite(file, data.c_str(), data.size());
-		gzflush(file, Z_FINISH);
-		gzclose(file);
-	};
-
-	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (" _STPF_ " bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), data.size());
-
-	#ifndef _WIN32
-	// NOTE: can not use ThreadPool for this directly here, workers are already gone
-	// FIXME: does not currently (august 2017) compile on Windows mingw buildbots
-	ThreadPool::AddExtJob(spring::thread(std::move(func), file, std::ref(data)));
-	#else
-	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::ref(data))));
-	#endif
-}
-
 void CDemoRecorder::WriteSetupText(const std::string& text)
 {
+	if (writer == nullptr)
+		return;
+
 	int length = text.length();
 	while (text[length - 1] == '\0') {
 		--length;
 	}
 
+	// must precede the demo stream
+	assert(fileHeader.demoStreamSize == 0);
+
 	fileHeader.scriptSize = length;
-	demoStreams[isServerDemo].append(text.c_str(), length);
+	writer->Write(text.c_str(), length);
+
+	WriteFileHeader(false);
 }
 
 void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime)
 {
+	if (writer == nullptr)
+		return;
+
 	DemoStreamChunkHeader chunkHeader;
 
 	chunkHeader.modGameTime = modGameTime;
 	chunkHeader.length = length;
 	chunkHeader.swab();
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(buf), length);
+	writer->Write(&chunkHeader, sizeof(chunkHeader));
+	writer->Write(buf, length);
 	fileHeader.demoStreamSize += (length + sizeof(chunkHeader));
 }
 
+void CDemoRecorder::SaveKeyframe(int frameNum, unsigned int syncChecksum, const std::string& saveData, const float modGameTime)
+{
+	if (writer == nullptr)
+		return;
+
+	// same layout as a regular packet, but the savestate is not copied into one
+	std::uint8_t keyframeHeader[DemoKeyframes::HEADER_SIZE];
+	DemoStreamChunkHeader chunkHeader;
+
+	DemoKeyframes::PackHeader(keyframeHeader, frameNum, syncChecksum);
+
+	chunkHeader.modGameTime = modGameTime;
+	chunkHeader.length = sizeof(keyframeHeader) + saveData.size();
+	chunkHeader.swab();
+	writer->Write(&chunkHeader, sizeof(chunkHeader));
+	writer->Write(keyframeHeader, sizeof(keyframeHeader));
+	writer->Write(saveData.data(), saveData.size());
+	fileHeader.demoStreamSize += (sizeof(keyframeHeader) + saveData.size() + sizeof(chunkHeader));
+}
+
 void CDemoRecorder::SetName(const std::string& mapName, const std::string& modName)
 {
 	// Returns the current UTC time as "JJJJMMDD_HHmmSS", eg: "20091231_115959"
@@ -215,42 +221,43 @@ void CDemoRecorder::SetWinningAllyTeams(const std::vector<unsigned char>& winnin
 	winningAllyTeams = winningAllyTeamIDs;
 }
 
-/** @brief Write DemoFileHeader
-Write the DemoFileHeader at the start of the file and restores the original
-position in the file afterwards. */
-unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
+DemoFileHeader CDemoRecorder::GetSwabbedFileHeader(bool updateStreamLength) const
 {
 	DemoFileHeader tmpHeader;
 	memcpy(&tmpHeader, &fileHeader, sizeof(fileHeader));
 
+	// a zero size makes readers replay until EOF, which is
+	// all the file holds until recording has finished
 	if (!updateStreamLength)
 		tmpHeader.demoStreamSize = 0;
 
 	// to little endian
 	tmpHeader.swab();
+	return tmpHeader;
+}
 
-	if (demoStreams[isServerDemo].empty()) {
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader));
-	} else {
-		assert(demoStreams[isServerDemo].size() >= sizeof(tmpHeader));
-		memcpy(&demoStreams[isServerDemo][0], reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader)); // no non-const .data() until C++17
-	}
+/** @brief Write DemoFileHeader
+Rewrites the DemoFileHeader at the start of the file (on the next flush). */
+void CDemoRecorder::WriteFileHeader(bool updateStreamLength)
+{
+	if (writer == nullptr)
+		return;
+
+	const DemoFileHeader tmpHeader = GetSwabbedFileHeader(updateStreamLength);
 
-	return (demoStreams[isServerDemo].size());
+	writer->WriteHeader(&tmpHeader);
 }
 
 /** @brief Write the CPlayer::Statistics at the current position in the file. */
 void CDemoRecorder::WritePlayerStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
-
 	for (PlayerStatistics& stats: playerStats) {
 		stats.swab();
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(PlayerStatistics));
+		writer->Write(&stats, sizeof(PlayerStatistics));
 	}
 
 	fileHeader.numPlayers = playerStats.size();
-	fileHeader.playerStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.playerStatSize = int(playerStats.size() * sizeof(PlayerStatistics));
 
 	playerStats.clear();
 }
@@ -263,38 +270,36 @@ void CDemoRecorder::WriteWinnerList()
 	if (fileHeader.numTeams == 0)
 		return;
 
-	const size_t pos = demoStreams[isServerDemo].size();
-
 	// Write the array of winningAllyTeams.
-	for (size_t i = 0; i < winningAllyTeams.size(); i++) { // NOLINT{modernize-loop-convert}
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&winningAllyTeams[i]), sizeof(unsigned char));
-	}
+	writer->Write(winningAllyTeams.data(), winningAllyTeams.size() * sizeof(unsigned char));
 
-	winningAllyTeams.clear();
+	fileHeader.winningAllyTeamsSize = int(winningAllyTeams.size() * sizeof(unsigned char));
 
-	fileHeader.winningAllyTeamsSize = int(demoStreams[isServerDemo].size() - pos);
+	winningAllyTeams.clear();
 }
 
 /** @brief Write the TeamStatistics at the current position in the file. */
 void CDemoRecorder::WriteTeamStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
+	size_t size = 0;
 
 	// Write array of dwords indicating number of TeamStatistics per team.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		unsigned int c = swabDWord(history.size());
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&c), sizeof(unsigned int));
+		writer->Write(&c, sizeof(unsigned int));
+		size += sizeof(unsigned int);
 	}
 
 	// Write big array of TeamStatistics.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		for (TeamStatistics& stats: history) {
 			stats.swab();
-			demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(TeamStatistics));
+			writer->Write(&stats, sizeof(TeamStatistics));
+			size += sizeof(TeamStatistics);
 		}
 	}
 
-	fileHeader.teamStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.teamStatSize = int(size);
 
 	teamStats.clear();
 }
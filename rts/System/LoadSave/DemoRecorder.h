@@ -3,17 +3,22 @@
 #ifndef DEMO_RECORDER
 #define DEMO_RECORDER
 
+#include <memory>
 #include <vector>
 #include <sstream>
-#include <zlib.h>
 
 #include "Demo.h"
+#include "DemoStreamWriter.h"
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
 
 
 /**
  * @brief Used to record demos
+ *
+ * Recorded data is streamed to disk by a CDemoStreamWriter; the demo stream
+ * size is only filled in when recording ends, until then readers treat the
+ * file like the demo of a crashed game and replay it until EOF.
  */
 class CDemoRecorder : public CDemo
 {
@@ -32,7 +37,7 @@ public:
 		memcpy(&fileHeader, &r.fileHeader, sizeof(fileHeader));
 		memset(&r.fileHeader, 0, sizeof(fileHeader));
 
-		std::swap(file, r.file);
+		std::swap(writer, r.writer);
 
 		std::swap(demoName, r.demoName);
 		std::swap(playerStats, r.playerStats);
@@ -44,12 +49,13 @@ public:
 	}
 
 
-	bool IsValid() const { return (file != nullptr); }
+	bool IsValid() const { return (writer != nullptr); }
 
 	void WriteSetupText(const std::string& text);
 	void SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime);
+	/// appends a NETMSG_DEMO_KEYFRAME chunk holding <saveData>, see CDemoReader::GetKeyframes
+	void SaveKeyframe(int frameNum, unsigned int syncChecksum, const std::string& saveData, const float modGameTime);
 
-	void SetStream();
 	void SetName(const std::string& mapName, const std::string& modName);
 	const std::string& GetName() const { return demoName; }
 
@@ -63,15 +69,15 @@ public:
 	void SetWinningAllyTeams(const std::vector<unsigned char>& winningAllyTeams);
 
 private:
-	unsigned int WriteFileHeader(bool updateStreamLength);
+	DemoFileHeader GetSwabbedFileHeader(bool updateStreamLength) const;
+	void WriteFileHeader(bool updateStreamLength);
 	void SetFileHeader();
 	void WritePlayerStats();
 	void WriteTeamStats();
 	void WriteWinnerList();
-	void WriteDemoFile();
 
 private:
-	gzFile file = nullptr;
+	std::unique_ptr<CDemoStreamWriter> writer;
 
 	std::vector<PlayerStatistics> playerStats;
 	std::vector< std::vector<TeamStatistics> > teamStats;
@@ -0,0 +1,194 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cassert>
+#include <cstring>
+#include <chrono>
+
+#include "DemoStreamWriter.h"
+#include "System/Log/ILog.h"
+#include "System/Platform/Threading.h"
+
+
+CDemoStreamWriter::CDemoStreamWriter(
+	const std::string& fileName,
+	const void* header,
+	unsigned int headerSize_,
+	unsigned int flushInterval_,
+	unsigned int bufferSize_
+)
+	: headerSize(headerSize_)
+	, flushInterval(flushInterval_)
+	, bufferSize(bufferSize_)
+{
+	memset(&dataStream, 0, sizeof(dataStream));
+	memset(&headerStream, 0, sizeof(headerStream));
+
+	// +16 selects a gzip instead of a zlib wrapper
+	if (deflateInit2(&dataStream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return;
+	// the header is stored, so its member always has the same size
+	if (deflateInit2(&headerStream, Z_NO_COMPRESSION, Z_DEFLATED, 9 + 16, 1, Z_DEFAULT_STRATEGY) != Z_OK) {
+		deflateEnd(&dataStream);
+		return;
+	}
+
+	if ((file = fopen(fileName.c_str(), "wb")) == nullptr) {
+		LOG_L(L_ERROR, "[DemoStreamWriter::%s] could not open \"%s\" for writing", __func__, fileName.c_str());
+		deflateEnd(&headerStream);
+		deflateEnd(&dataStream);
+		return;
+	}
+
+	writingHeader.assign(reinterpret_cast<const std::uint8_t*>(header), reinterpret_cast<const std::uint8_t*>(header) + headerSize);
+
+	if (!WriteMember(headerStream, writingHeader)) {
+		fclose(file);
+		file = nullptr;
+		deflateEnd(&headerStream);
+		deflateEnd(&dataStream);
+		return;
+	}
+
+	headerMemberSize = compressedData.size();
+	writingHeader.clear();
+
+	fflush(file);
+
+	writerThread = spring::thread(&CDemoStreamWriter::WriterThread, this);
+}
+
+
+void CDemoStreamWriter::Write(const void* data, unsigned int size)
+{
+	if (file == nullptr)
+		return;
+
+	std::unique_lock<spring::mutex> lock(bufferMutex);
+
+	// the writer thread is still busy with the previous buffer
+	spaceCond.wait(lock, [&]() { return (pendingData.size() < bufferSize); });
+
+	pendingData.insert(pendingData.end(), reinterpret_cast<const std::uint8_t*>(data), reinterpret_cast<const std::uint8_t*>(data) + size);
+
+	if (pendingData.size() >= (bufferSize / 2))
+		dataCond.notify_one();
+}
+
+void CDemoStreamWriter::WriteHeader(const void* header)
+{
+	if (file == nullptr)
+		return;
+
+	std::lock_guard<spring::mutex> lock(bufferMutex);
+
+	// only the latest header matters, no need to wake up the writer
+	pendingHeader.assign(reinterpret_cast<const std::uint8_t*>(header), reinterpret_cast<const std::uint8_t*>(header) + headerSize);
+}
+
+
+void CDemoStreamWriter::Flush()
+{
+	if (file == nullptr)
+		return;
+
+	std::unique_lock<spring::mutex> lock(bufferMutex);
+
+	const unsigned int flushNum = ++numFlushRequests;
+
+	dataCond.notify_one();
+	flushCond.wait(lock, [&]() { return numFlushesDone >= flushNum; });
+}
+
+
+void CDemoStreamWriter::Close()
+{
+	if (file == nullptr)
+		return;
+
+	{
+		std::lock_guard<spring::mutex> lock(bufferMutex);
+		closing = true;
+	}
+
+	dataCond.notify_one();
+	writerThread.join();
+
+	deflateEnd(&headerStream);
+	deflateEnd(&dataStream);
+
+	if (fclose(file) != 0)
+		writeError = true;
+
+	file = nullptr;
+
+	if (writeError)
+		LOG_L(L_ERROR, "[DemoStreamWriter::%s] error while writing demo-file, it may be incomplete", __func__);
+}
+
+
+void CDemoStreamWriter::WriterThread()
+{
+	Threading::SetThreadName("demo-writer");
+
+	std::unique_lock<spring::mutex> lock(bufferMutex);
+
+	while (true) {
+		dataCond.wait_for(lock, std::chrono::milliseconds(flushInterval), [&]() { return (closing || pendingData.size() >= (bufferSize / 2) || numFlushRequests != numFlushesDone); });
+
+		const bool closed = closing;
+		const unsigned int flushNum = numFlushRequests;
+
+		std::swap(pendingData, writingData);
+		std::swap(pendingHeader, writingHeader);
+
+		lock.unlock();
+		spaceCond.notify_all();
+
+		if (!writingData.empty())
+			writeError |= !WriteMember(dataStream, writingData);
+
+		if (!writingHeader.empty()) {
+			// the header member is at the start of the file and never changes size
+			writeError |= (fseek(file, 0, SEEK_SET) != 0);
+			writeError |= !WriteMember(headerStream, writingHeader);
+			writeError |= (fseek(file, 0, SEEK_END) != 0);
+
+			assert(compressedData.size() == headerMemberSize);
+		}
+
+		if (!writingData.empty() || !writingHeader.empty())
+			writeError |= (fflush(file) != 0);
+
+		writingData.clear();
+		writingHeader.clear();
+
+		lock.lock();
+
+		numFlushesDone = flushNum;
+		flushCond.notify_all();
+
+		if (closed)
+			break;
+	}
+}
+
+bool CDemoStreamWriter::WriteMember(z_stream& stream, const std::vector<std::uint8_t>& data)
+{
+	// a deflateBound sized buffer lets a single Z_FINISH call complete the member
+	compressedData.resize(deflateBound(&stream, data.size()));
+
+	stream.next_in = const_cast<std::uint8_t*>(data.data());
+	stream.avail_in = data.size();
+	stream.next_out = compressedData.data();
+	stream.avail_out = compressedData.size();
+
+	const int ret = deflate(&stream, Z_FINISH);
+
+	compressedData.resize(compressedData.size() - stream.avail_out);
+	deflateReset(&stream);
+
+	if (ret != Z_STREAM_END)
+		return false;
+
+	return (fwrite(compressedData.data(), 1, compressedData.size(), file) == compressedData.size());
+}
@@ -0,0 +1,99 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEMO_STREAM_WRITER_H
+#define DEMO_STREAM_WRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "System/Threading/SpringThreading.h"
+
+
+/**
+ * @brief Appends demo data to a gzip file from a background thread
+ *
+ * The file is a sequence of gzip members, which gzread decodes as a single
+ * stream: the first one holds only the (stored, i.e. uncompressed) header
+ * and is rewritten in place whenever the header changes, every following
+ * one holds the data written since the previous flush. A crash while a
+ * member is appended leaves it cut off; CGZFileHandler then drops that
+ * member and keeps the ones before it, so only the data of the current
+ * flush interval is lost. A crash while the header member is rewritten
+ * can leave it with a mix of the old and new header, which fails its CRC
+ * check and makes the file unreadable; the header is small and rarely
+ * rewritten, which keeps this window short.
+ *
+ * Written data is buffered until the writer thread compresses it, which
+ * happens every <flushInterval> milliseconds or as soon as half of the
+ * <bufferSize> is used. Write blocks while a full buffer is pending, so no
+ * more than about twice <bufferSize> bytes are held in memory.
+ */
+class CDemoStreamWriter
+{
+public:
+	CDemoStreamWriter(
+		const std::string& fileName,
+		const void* header,
+		unsigned int headerSize,
+		unsigned int flushInterval,
+		unsigned int bufferSize
+	);
+	CDemoStreamWriter(const CDemoStreamWriter&) = delete;
+	~CDemoStreamWriter() { Close(); }
+
+	CDemoStreamWriter& operator = (const CDemoStreamWriter&) = delete;
+
+	bool IsOpen() const { return (file != nullptr); }
+
+	void Write(const void* data, unsigned int size);
+	// <header> must have the same size as the one passed to the ctor
+	void WriteHeader(const void* header);
+
+	// returns once everything written so far (including the header) is in the file
+	void Flush();
+
+	// writes all pending data and the last header, then closes the file
+	void Close();
+
+private:
+	void WriterThread();
+
+	bool WriteMember(z_stream& stream, const std::vector<std::uint8_t>& data);
+
+private:
+	FILE* file = nullptr;
+
+	z_stream dataStream;
+	z_stream headerStream;
+
+	spring::thread writerThread;
+	spring::mutex bufferMutex;
+	spring::condition_variable_any dataCond;
+	spring::condition_variable_any spaceCond;
+	spring::condition_variable_any flushCond;
+
+	// filled by Write and WriteHeader
+	std::vector<std::uint8_t> pendingData;
+	std::vector<std::uint8_t> pendingHeader;
+	// swapped with the above and compressed by the writer thread
+	std::vector<std::uint8_t> writingData;
+	std::vector<std::uint8_t> writingHeader;
+	std::vector<std::uint8_t> compressedData;
+
+	unsigned int headerSize = 0;
+	unsigned int headerMemberSize = 0;
+	unsigned int flushInterval = 0;
+	unsigned int bufferSize = 0;
+
+	// incremented by Flush, copied by the writer thread once it has written what was pending at that time
+	unsigned int numFlushRequests = 0;
+	unsigned int numFlushesDone = 0;
+
+	bool closing = false;
+	bool writeError = false;
+};
+
+#endif
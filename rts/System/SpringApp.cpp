@@ -105,6 +105,8 @@ CONFIG(unsigned, SetCoreAffinity).defaultValue(0).safemodeValue(1).description("
 CONFIG(unsigned, TextureMemPoolSize).defaultValue(512).minimumValue(0).description("Set to 0 to disable, otherwise specify a predefined memory to serve Bitmap allocation requests");
 CONFIG(bool, UseLuaMemPools).defaultValue(true).description("Whether Lua VM memory allocations are made from pools.");
 CONFIG(bool, UseHighResTimer).defaultValue(false).description("On Windows, sets whether Spring will use low- or high-resolution timer functions for tasks like graphical interpolation between game frames.");
+CONFIG(bool, TraceEventRecording).defaultValue(false).description("Record begin/end timestamps of all profiler timers per thread from startup, see /TraceEvents for dumping them.");
+CONFIG(int, TraceEventBufferSize).defaultValue(1 << 16).minimumValue(1024).description("Number of most recent timer events kept per thread for /TraceEvents dumps.");
 CONFIG(bool, UseFontConfigLib).defaultValue(true).description("Whether the system fontconfig library (if present and enabled at compile-time) should be used for handling fonts.");
 
 CONFIG(std::string, name).defaultValue(UnnamedPlayerName).description("Sets your name in the game. Since this is overridden by lobbies with your lobby username when playing, it usually only comes up when viewing replays or starting the engine directly for testing purposes.");
@@ -132,6 +134,7 @@ DEFINE_bool_EX  (test_creg,          "test-creg",          false, "Test if all C
 DEFINE_bool     (safemode,                                 false, "Turns off many things that are known to cause problems (i.e. on PC/Mac's with lower-end graphic cards)");
 
 DEFINE_string   (config,                                   "",    "Exclusive configuration file");
+DEFINE_string_EX(benchmark_replay,   "benchmark-replay",   "",    "Replay the given demo at maximum speed and write per-timer frame-time percentiles to this file (.json or .csv) when it ends, then quit");
 DEFINE_bool     (isolation,                                false, "Limit the data-dir (games & maps) scanner to one directory");
 DEFINE_string_EX(isolation_dir,      "isolation-dir",      "",    "Specify the isolation-mode data-dir (see --isolation)");
 DEFINE_string_EX(write_dir,          "write-dir",          "",    "Specify where Spring writes to.");
@@ -528,6 +531,12 @@ void SpringApp::ParseCmdLine(int argc, char* argv[])
 	// logOutput's init depends on configHandler
 	FileSystemInitializer::PreInitializeConfigHandler(FLAGS_config, FLAGS_name, FLAGS_safemode);
 	FileSystemInitializer::InitializeLogOutput();
+
+	if (!FLAGS_benchmark_replay.empty())
+		configHandler->SetString("ReplayBenchmarkOutput", FLAGS_benchmark_replay, true);
+
+	traceRecorder.SetBufferSize(configHandler->GetInt("TraceEventBufferSize"));
+	traceRecorder.SetEnabled(configHandler->GetBool("TraceEventRecording"));
 }
 
 
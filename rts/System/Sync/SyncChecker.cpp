@@ -9,13 +9,119 @@
 #include "System/Threading/ThreadPool.h"
 
 
+static_assert(ThreadPool::MAX_THREADS <= CSyncChecker::MAX_LANES, "");
+
 unsigned CSyncChecker::g_checksum;
 int CSyncChecker::inSyncedCode;
 
+CSyncChecker::Lane CSyncChecker::lanes[MAX_LANES];
+int CSyncChecker::parallelSection;
+
 
 void CSyncChecker::debugSyncCheckThreading()
 {
     assert(ThreadPool::GetThreadNum() == 0);
 }
 
+
+void CSyncChecker::BeginParallelSection()
+{
+	assert(ThreadPool::GetThreadNum() == 0);
+	++parallelSection;
+}
+
+void CSyncChecker::EndParallelSection()
+{
+	assert(InParallelSection());
+	assert(ThreadPool::GetThreadNum() == 0);
+
+	if (--parallelSection > 0)
+		return;
+
+	Lane merged = {};
+
+	for (Lane& lane: lanes) {
+		assert(!lane.item.active);
+
+		merged.sum += lane.sum;
+		merged.count += lane.count;
+		lane = {};
+	}
+
+	// sections without any Sync calls leave the checksum untouched
+	if (merged.count == 0)
+		return;
+
+	const unsigned values[2] = {merged.sum, merged.count};
+
+#ifdef SYNC_HSIEH
+	g_checksum = HsiehHash((const char*)values, sizeof(values), g_checksum);
+#else
+	g_checksum = spring::LiteHash((const char*)values, sizeof(values), g_checksum);
+#endif
+}
+
+static inline unsigned HashValue(const void* p, unsigned size, unsigned seed)
+{
+#ifdef SYNC_HSIEH
+	return HsiehHash((const char*)p, size, seed);
+#else
+	return spring::LiteHash((const char*)p, size, seed);
+#endif
+}
+
+CSyncChecker::Lane& CSyncChecker::GetLane()
+{
+	const unsigned threadNum = ThreadPool::GetThreadNum();
+
+	assert(threadNum < MAX_LANES);
+	return lanes[threadNum % MAX_LANES];
+}
+
+
+CSyncChecker::Item CSyncChecker::BeginParallelItem(unsigned index)
+{
+	assert(InParallelSection());
+
+	Lane& lane = GetLane();
+	const Item prevItem = lane.item;
+
+	// seeded with the index, s.t. the same values synced by another item
+	// (or by this one in another order) give a different hash
+	lane.item = {HashValue(&index, sizeof(index), 0xfade1eaf), true, false};
+	return prevItem;
+}
+
+void CSyncChecker::EndParallelItem(const Item& prevItem)
+{
+	Lane& lane = GetLane();
+
+	assert(lane.item.active);
+
+	// only the seed was hashed, nothing to compare
+	if (lane.item.synced) {
+		lane.sum += lane.item.hash;
+		lane.count += 1;
+	}
+
+	lane.item = prevItem;
+}
+
+
+void CSyncChecker::SyncLane(const void* p, unsigned size)
+{
+	Lane& lane = GetLane();
+
+	if (lane.item.active) {
+		lane.item.hash = HashValue(p, size, lane.item.hash);
+		lane.item.synced = true;
+		return;
+	}
+
+	// seeded with a constant rather than the running checksum, s.t. equal
+	// values hash the same no matter which thread they came from
+	lane.sum += HashValue(p, size, 0xfade1eaf);
+	lane.count += 1;
+}
+
 #endif // SYNCDEBUG
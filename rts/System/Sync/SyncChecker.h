@@ -32,10 +32,16 @@ class CSyncChecker {
 		/**
 		 * Keeps a running checksum over all assignments to synced variables.
 		 */
-		static unsigned GetChecksum() { return g_checksum; }
-		static void NewFrame() { g_checksum = 0xfade1eaf; }
+		static unsigned GetChecksum() { assert(!InParallelSection()); return g_checksum; }
+		static void NewFrame() { assert(!InParallelSection()); g_checksum = 0xfade1eaf; }
+		/// restores the checksum of a loaded savestate (demo keyframe)
+		static void SetChecksum(unsigned checksum) { assert(!InParallelSection()); g_checksum = checksum; }
 		static void debugSyncCheckThreading();
 		static void Sync(const void* p, unsigned size) {
+			if (InParallelSection()) {
+				SyncLane(p, size);
+				return;
+			}
 #ifdef DEBUG_SYNC_MT_CHECK
 			// Sync calls should not be occuring in multi-threaded sections
 			debugSyncCheckThreading();
@@ -50,7 +56,77 @@ class CSyncChecker {
 			//LOG("[Sync::Checker] chksum=%u\n", g_checksum);
 		}
 
+		/**
+		 * Between Begin- and EndParallelSection (called by the thread that
+		 * starts and joins the parallel work), Sync may be called from any
+		 * pool thread. Hashes are summed into the lane of the calling thread;
+		 * at the end of the (outermost) section the lanes are summed and
+		 * folded into the running checksum. Sums do not depend on which
+		 * thread got which item, so every client ends up with the same
+		 * checksum.
+		 *
+		 * Sync calls made inside a ScopedParallelItem are chained into one
+		 * hash seeded with the item index, which catches values that were
+		 * reordered within an item or swapped between items. Calls outside
+		 * of any item are hashed one by one and only catch changed values.
+		 * Items without any Sync calls leave the checksum untouched.
+		 */
+		static bool InParallelSection() { return (parallelSection > 0); }
+		static void BeginParallelSection();
+		static void EndParallelSection();
+
+		struct ScopedParallelSection {
+			ScopedParallelSection() { BeginParallelSection(); }
+			~ScopedParallelSection() { EndParallelSection(); }
+		};
+
+	private:
+		struct Item {
+			unsigned hash;
+			bool active;
+			/// set by the item's first Sync call
+			bool synced;
+		};
+
+	public:
+		/**
+		 * Wraps the work done for item <index> of a for_mt inside a parallel
+		 * section; restores the enclosing item of the same thread (if any),
+		 * which can happen when a nested for_mt runs other items while it
+		 * waits.
+		 */
+		struct ScopedParallelItem {
+			ScopedParallelItem(unsigned index): prevItem(BeginParallelItem(index)) {}
+			~ScopedParallelItem() { EndParallelItem(prevItem); }
+
+			const Item prevItem;
+		};
+
+		static constexpr unsigned MAX_LANES = 64;
+
+	private:
+		static void SyncLane(const void* p, unsigned size);
+
+		static Item BeginParallelItem(unsigned index);
+		static void EndParallelItem(const Item& prevItem);
+
 	private:
+		struct alignas(64) Lane {
+			unsigned sum;
+			unsigned count;
+
+			/// item currently run by the lane's thread
+			Item item;
+		};
+
+		static Lane& GetLane();
+
+		/**
+		 * Per-thread partial checksums of the current parallel section
+		 */
+		static Lane lanes[MAX_LANES];
+		static int parallelSection;
+
 
 		/**
 		 * The sync checksum
@@ -12,6 +12,9 @@
 #endif
 
 #include <assert.h>
+#ifdef TRACE_SYNC
+	#include <cstdio>
+#endif
 
 
 // NOTE: lowercase sync clashes with extern void sync(...) from unistd.h
@@ -47,8 +50,13 @@ namespace Sync {
 		assert(CSyncChecker::InSyncedCode());
 		CSyncChecker::Sync(p, size);
 	#ifdef TRACE_SYNC
-		unsigned int crc = CSyncChecker::GetChecksum();
-		fprintf(stderr, "[Sync::%s] msg=%s chksum=%u\n", __func__, msg, crc);
+		// the running checksum is only updated when a parallel section ends
+		if (CSyncChecker::InParallelSection()) {
+			fprintf(stderr, "[Sync::%s] msg=%s (parallel section)\n", __func__, msg);
+		} else {
+			unsigned int crc = CSyncChecker::GetChecksum();
+			fprintf(stderr, "[Sync::%s] msg=%s chksum=%u\n", __func__, msg, crc);
+		}
 	#endif
 #endif
 	}
@@ -71,6 +79,15 @@ namespace Sync {
 #  define LEAVE_SYNCED_CODE()
 #endif
 
+// wraps synced code that runs on the thread pool, see CSyncChecker
+#ifdef SYNCCHECK
+#  define SCOPED_SYNC_PARALLEL_SECTION() CSyncChecker::ScopedParallelSection syncParallelSection
+#  define SCOPED_SYNC_PARALLEL_ITEM(i) CSyncChecker::ScopedParallelItem syncParallelItem(i)
+#else
+#  define SCOPED_SYNC_PARALLEL_SECTION()
+#  define SCOPED_SYNC_PARALLEL_ITEM(i)
+#endif
+
 #ifdef SYNCDEBUG
 #  define ASSERT_SYNCED(x) Sync::AssertDebugger(x, "assert(" #x ")")
 #else
@@ -40,6 +40,7 @@
 
 #ifndef UNIT_TEST
 CONFIG(int, WorkerThreadCount).defaultValue(-1).safemodeValue(0).minimumValue(-1).description("Number of workers (including the main thread!) used by ThreadPool.");
+CONFIG(bool, WorkerThreadWorkStealing).defaultValue(false).safemodeValue(false).description("If true, for_mt loops give each worker its own range of iterations and let idle workers steal from busy ones (adaptive chunk-sizes) rather than handing out iterations one-by-one from a shared counter.");
 #endif
 
 
@@ -74,9 +75,11 @@ static std::array<moodycamel::ConcurrentQueue<ITaskGroup*>, ThreadPool::MAX_THRE
 static std::vector<void*> workerThreads[2];
 static std::array<bool, ThreadPool::MAX_THREADS> exitFlags;
 static std::array<ThreadStats, ThreadPool::MAX_THREADS> threadStats[2];
+static std::array<ThreadPool::WorkerCounters, ThreadPool::MAX_THREADS> workerCounters[2];
 static spring::signal newTasksSignal[2];
 
 static _threadlocal int threadnum(0);
+static std::atomic<bool> workStealing(false);
 
 #ifndef UNITSYNC
 // if enabled, allows OpenGL calls from ThreadPool tasks
@@ -105,6 +108,14 @@ static int GetConfigNumWorkers() {
 	#endif
 }
 
+static bool GetConfigWorkStealing() {
+	#ifndef UNIT_TEST
+	return configHandler->GetBool("WorkerThreadWorkStealing");
+	#else
+	return workStealing.load();
+	#endif
+}
+
 static int GetDefaultNumWorkers() {
 	const int maxNumThreads = GetMaxThreads(); // min(MAX_THREADS, logicalCpus)
 	const int cfgNumWorkers = GetConfigNumWorkers();
@@ -129,6 +140,39 @@ int GetMaxThreads() { return std::min(MAX_THREADS, Threading::GetLogicalCpuCores
 
 bool HasThreads() { return !workerThreads[false].empty(); }
 
+void SetWorkStealing(bool enable) { workStealing.store(enable); }
+bool UseWorkStealing() { return (workStealing.load(std::memory_order_relaxed)); }
+
+
+const WorkerCounters& GetWorkerCounters(int tid, bool async) { return workerCounters[async][tid]; }
+
+void ResetWorkerCounters()
+{
+	for (bool async: {false, true}) {
+		for (WorkerCounters& wc: workerCounters[async]) {
+			wc.busyTime.store(0);
+			wc.idleTime.store(0);
+			wc.numTasksRun.store(0);
+			wc.numSteals.store(0);
+		}
+	}
+}
+
+void AddWorkerSteal(int tid) { workerCounters[false][tid].numSteals.fetch_add(1, std::memory_order_relaxed); }
+
+static void AddWorkerTime(int tid, bool async, bool busy, const spring_time dt)
+{
+	WorkerCounters& wc = workerCounters[async][tid];
+
+	// only the owning worker writes these, readers may see slightly stale values
+	if (busy) {
+		wc.busyTime.store(wc.busyTime.load(std::memory_order_relaxed) + dt.toNanoSecsi(), std::memory_order_relaxed);
+		wc.numTasksRun.store(wc.numTasksRun.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	} else {
+		wc.idleTime.store(wc.idleTime.load(std::memory_order_relaxed) + dt.toNanoSecsi(), std::memory_order_relaxed);
+	}
+}
+
 
 
 static bool DoTask(int tid, bool async)
@@ -223,13 +267,23 @@ static void WorkerLoop(int tid, bool async)
 	while (!exitFlags[tid]) {
 		const auto spinlockEnd = spring_now() + ourSpinTime;
 		      auto sleepTime   = spring_time::fromMicroSecs(1);
+		const auto idleStart   = spring_now();
+		      auto taskStart   = idleStart;
 
-		while (!DoTask(tid, async) && !exitFlags[tid]) {
-			if (spring_now() < spinlockEnd)
-				continue;
+		bool ranTask = false;
+
+		while (!(ranTask = DoTask(tid, async)) && !exitFlags[tid]) {
+			if (spring_now() >= spinlockEnd)
+				newTasksSignal[async].wait_for(sleepTime = std::min(sleepTime * 1.25f, maxSleepTime));
 
-			newTasksSignal[async].wait_for(sleepTime = std::min(sleepTime * 1.25f, maxSleepTime));
+			taskStart = spring_now();
 		}
+
+		// time until the successful DoTask call counts as idle
+		AddWorkerTime(tid, async, false, taskStart - idleStart);
+
+		if (ranTask)
+			AddWorkerTime(tid, async, true, spring_now() - taskStart);
 	}
 }
 
@@ -461,6 +515,7 @@ void SetThreadCount(int wantedNumThreads)
 		"[ThreadPool::%s][2] workers=%lu",
 		"\t[async=%d] threads=%d tasks=%lu {sum,avg}{exec,wait}time={{%.3f, %.3f}, {%.3f, %.3f}}ms",
 		"\t\tthread=%d tasks=%lu {sum,min,max,avg}{exec,wait}time={{%.3f, %.3f, %.3f, %.3f}, {%.3f, %.3f, %.3f, %.3f}}ms",
+		"\t\tthread=%d {busy,idle}time={%.3f, %.3f}ms (%.1f%% busy) steals=%lu",
 	};
 
 	// total number of tasks executed by pool; total time spent in DoTask
@@ -491,6 +546,8 @@ void SetThreadCount(int wantedNumThreads)
 			}
 		}
 		#endif
+
+		ResetWorkerCounters();
 	}
 
 
@@ -553,6 +610,13 @@ void SetThreadCount(int wantedNumThreads)
 				const float tAvgWaitTime = tSumWaitTime / std::max(ts.numTasksRun, uint64_t(1));
 
 				LOG(fmts[3], i, ts.numTasksRun,  tSumExecTime, tMinExecTime, tMaxExecTime, tAvgExecTime,  tSumWaitTime, tMinWaitTime, tMaxWaitTime, tAvgWaitTime);
+
+				const WorkerCounters& wc = workerCounters[async][i];
+
+				const float wBusyTime = wc.busyTime * 1e-6f; // ms
+				const float wIdleTime = wc.idleTime * 1e-6f; // ms
+
+				LOG(fmts[4], i, wBusyTime, wIdleTime, (wBusyTime * 100.0f) / std::max(wBusyTime + wIdleTime, 1e-3f), uint64_t(wc.numSteals));
 			}
 		}
 	}
@@ -576,6 +640,8 @@ void SetMaximumThreadCount()
 		#endif
 	}
 
+	SetWorkStealing(GetConfigWorkStealing());
+
 	if (GetConfigNumWorkers() <= 0)
 		return;
 
@@ -593,6 +659,7 @@ void SetDefaultThreadCount()
 
 	std::uint32_t workerAvailCores = systemCores & ~mainAffinity;
 
+	SetWorkStealing(GetConfigWorkStealing());
 	SetThreadCount(GetDefaultNumWorkers());
 
 	{
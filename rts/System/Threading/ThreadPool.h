@@ -26,6 +26,8 @@ namespace ThreadPool {
 	static inline int GetNumThreads() { return 1; }
 	static inline void NotifyWorkerThreads(bool force, bool async) {}
 	static inline bool HasThreads() { return false; }
+	static inline void SetWorkStealing(bool enable) {}
+	static inline bool UseWorkStealing() { return false; }
 
 	static constexpr int MAX_THREADS = 1;
 }
@@ -72,6 +74,7 @@ static inline auto parallel_reduce(F&& f, G&& g) -> typename std::result_of<F()>
 #include <vector>
 #include <numeric>
 #include <atomic>
+#include <limits>
 
 #undef gt
 #include <memory>
@@ -109,6 +112,24 @@ namespace ThreadPool {
 	int GetNumThreads();
 	void NotifyWorkerThreads(bool force, bool async);
 
+	// if enabled, for_mt and for_mt_chunk hand every thread its own
+	// index range and let threads that run dry steal from the others
+	void SetWorkStealing(bool enable);
+	bool UseWorkStealing();
+
+	struct WorkerCounters {
+		std::atomic<uint64_t> busyTime; // ns spent executing tasks
+		std::atomic<uint64_t> idleTime; // ns spent spinning or sleeping
+		std::atomic<uint64_t> numTasksRun;
+		std::atomic<uint64_t> numSteals; // ranges taken from other threads' for_mt slices
+	};
+
+	// tid=0 (main) only counts steals; busy and idle times are
+	// measured by the worker loops
+	const WorkerCounters& GetWorkerCounters(int tid, bool async = false);
+	void ResetWorkerCounters();
+	void AddWorkerSteal(int tid);
+
 	extern bool inMultiThreadedSection;
 
 	static constexpr int MAX_THREADS = 32;
@@ -641,6 +662,138 @@ private:
 
 
 
+// work-stealing variant of ForTaskGroup; every thread owns a contiguous
+// range of iterations (packed as [begin, end) into one atomic) which it
+// consumes front-to-back in adaptively sized chunks, threads that finish
+// early steal the back half of the fullest-looking range they find
+template<typename F>
+class StealingForTaskGroup: public ITaskGroup
+{
+public:
+	StealingForTaskGroup(bool pooled) : ITaskGroup(false, pooled) {}
+
+	void Enqueue(const int from, const int to, const int step, const int minChunk, const int maxChunk, F& func)
+	{
+		assert(to >= from);
+
+		const int numIters = (step == 1) ? (to - from) : ((to - from + step - 1) / step);
+
+		remainingTasks.store(numIters);
+
+		this->from = from;
+		this->step = step;
+		this->minChunkSize = std::max(minChunk, 1);
+		this->maxChunkSize = std::max(maxChunk, this->minChunkSize);
+		this->numRanges = ThreadPool::GetNumThreads();
+		this->func = func;
+
+		for (int i = 0; i < ThreadPool::MAX_THREADS; i++) {
+			const int b = (i < numRanges)? int((int64_t(numIters) * (i    )) / numRanges): 0;
+			const int e = (i < numRanges)? int((int64_t(numIters) * (i + 1)) / numRanges): 0;
+
+			ranges[i].store(PackRange(b, e), std::memory_order_relaxed);
+		}
+	}
+
+	bool IsSliceTask() const override { return true; }
+	bool ExecuteStep() override
+	{
+		const int tid = std::min(ThreadPool::GetThreadNum(), numRanges - 1);
+
+		int b = 0;
+		int e = 0;
+
+		if (!PopChunk(tid, b, e) && !StealChunk(tid, b, e))
+			return false;
+
+		for (int k = b; k < e; k++) {
+			func(from + step * k);
+		}
+
+		remainingTasks -= (e - b);
+		return true;
+	}
+
+private:
+	static uint64_t PackRange(int b, int e) { return ((uint64_t(uint32_t(e)) << 32) | uint32_t(b)); }
+	static int RangeBegin(uint64_t r) { return (int(uint32_t(r      ))); }
+	static int RangeEnd  (uint64_t r) { return (int(uint32_t(r >> 32))); }
+
+	// owners take small chunks from the front to leave enough behind for thieves
+	int ChunkSize(int numLeft) const { return std::min(numLeft, std::max(minChunkSize, std::min(numLeft / (numRanges * 2), maxChunkSize))); }
+
+	bool PopChunk(int tid, int& b, int& e)
+	{
+		uint64_t r = ranges[tid].load(std::memory_order_acquire);
+
+		while (RangeBegin(r) < RangeEnd(r)) {
+			const int rb = RangeBegin(r);
+			const int re = RangeEnd(r);
+			const int cs = ChunkSize(re - rb);
+
+			if (ranges[tid].compare_exchange_weak(r, PackRange(rb + cs, re), std::memory_order_acq_rel)) {
+				b = rb;
+				e = rb + cs;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool StealChunk(int tid, int& b, int& e)
+	{
+		for (int n = 1; n < numRanges; n++) {
+			const int vid = (tid + n) % numRanges;
+
+			uint64_t r = ranges[vid].load(std::memory_order_acquire);
+
+			while (RangeBegin(r) < RangeEnd(r)) {
+				const int rb = RangeBegin(r);
+				const int re = RangeEnd(r);
+				const int rm = rb + (re - rb) / 2;
+
+				if (!ranges[vid].compare_exchange_weak(r, PackRange(rb, rm), std::memory_order_acq_rel))
+					continue;
+
+				ThreadPool::AddWorkerSteal(ThreadPool::GetThreadNum());
+
+				// run the first chunk of the stolen half now and publish the rest
+				// as our own range so it can be stolen from again; a failed CAS
+				// means another thread with the same id (e.g. an external one in
+				// WaitForFinished) refilled it first and we keep the whole half
+				const int cs = ChunkSize(re - rm);
+
+				uint64_t own = ranges[tid].load(std::memory_order_acquire);
+
+				if (RangeBegin(own) >= RangeEnd(own) && ranges[tid].compare_exchange_strong(own, PackRange(rm + cs, re), std::memory_order_acq_rel)) {
+					b = rm;
+					e = rm + cs;
+				} else {
+					b = rm;
+					e = re;
+				}
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+private:
+	std::array<std::atomic<uint64_t>, ThreadPool::MAX_THREADS> ranges;
+	std::function<void(const int)> func;
+
+	int from = 0;
+	int step = 1;
+	int minChunkSize = 1;
+	int maxChunkSize = 1;
+	int numRanges = 1;
+};
+
+
+
 
 
 
@@ -682,6 +835,41 @@ struct TaskPool {
 
 
 
+template <typename F>
+static inline void for_mt_stealing(int start, int end, int step, int minChunk, int maxChunk, F&& f)
+{
+	if (!ThreadPool::HasThreads() || ((end - start) < step)) {
+		for (int i = start; i < end; i += step) {
+			f(i);
+		}
+		return;
+	}
+
+	SCOPED_MT_TIMER("ThreadPool::AddTask");
+
+	ThreadPool::inMultiThreadedSection = true;
+
+	// static, so TaskGroup's are recycled
+	static TaskPool<StealingForTaskGroup, F> pool;
+	auto taskGroup = pool.GetTaskGroup();
+
+	taskGroup->Enqueue(start, end, step, minChunk, maxChunk, f);
+	taskGroup->UpdateId();
+
+	assert(taskGroup->IsInJobQueue());
+
+	// every worker starts on its own range, see StealingForTaskGroup
+	for (size_t i = 1; i < ThreadPool::GetNumThreads(); ++i) {
+		taskGroup->wantedThread.store(i);
+		ThreadPool::PushTaskGroup(taskGroup);
+	}
+
+	ThreadPool::WaitForFinished(taskGroup);
+
+	ThreadPool::inMultiThreadedSection = false;
+}
+
+
 template <typename F>
 static inline void for_mt(int start, int end, int step, F&& f)
 {
@@ -692,6 +880,11 @@ static inline void for_mt(int start, int end, int step, F&& f)
 		return;
 	}
 
+	if (ThreadPool::UseWorkStealing()) {
+		for_mt_stealing(start, end, step, 1, std::numeric_limits<int>::max(), f);
+		return;
+	}
+
 	SCOPED_MT_TIMER("ThreadPool::AddTask");
 
 	ThreadPool::inMultiThreadedSection = true;
@@ -734,6 +927,23 @@ static inline void for_mt_chunk(int b, int e, F&& f, int chunkOrMinChinkSize = 0
 
 	const int numElems  = e - b;
 
+	if (ThreadPool::UseWorkStealing()) {
+		// chunks are sized adaptively (never below the minimum) instead of
+		// being split evenly up front, a fixed chunk-size is kept as given
+		const int minChunkSize = std::max(1, std::abs(chunkOrMinChinkSize));
+		const int maxChunkSize = (chunkOrMinChinkSize > 0)? chunkOrMinChinkSize: std::numeric_limits<int>::max();
+
+		if (numElems <= minChunkSize) {
+			for (int i = b; i < e; ++i)
+				f(i);
+
+			return;
+		}
+
+		for_mt_stealing(b, e, 1, minChunkSize, maxChunkSize, f);
+		return;
+	}
+
 	int chunkSize = chunkOrMinChinkSize;
 	if (chunkOrMinChinkSize <= 0) {
 		chunkSize = numElems / maxThreads + (numElems % maxThreads != 0); //split the work evenly. Does for_mt() do the same?
@@ -2,12 +2,15 @@
 
 #include <algorithm>
 #include <climits>
+#include <cstdio>
 #include <cstring>
 
 #include "System/TimeProfiler.h"
 #include "System/GlobalRNG.h"
+#include "System/MainDefines.h"
 #include "System/StringHash.h"
 #include "System/Log/ILog.h"
+#include "System/Platform/Threading.h"
 #include "System/Threading/SpringThreading.h"
 
 #ifdef THREADPOOL
@@ -24,6 +27,9 @@ static spring::unordered_map<unsigned, int> refCounters;
 
 static CGlobalUnsyncedRNG profileColorRNG;
 
+// guards CTraceEventRecorder::threadBuffers, only taken on registration and dump
+static spring::mutex traceBuffersMutex;
+
 
 spring_time BasicTimer::GetDuration() const
 {
@@ -57,6 +63,9 @@ ScopedTimer::~ScopedTimer()
 	if (--(iter->second) == 0) {
 		profiler.AddTime(nameHash, startTime, GetDuration(), autoShowGraph, specialTimer, false);
 	}
+
+	if (CTraceEventRecorder::IsEnabled())
+		traceRecorder.AddEvent(nameHash, startTime, spring_gettime());
 }
 
 
@@ -100,6 +109,9 @@ ScopedMtTimer::ScopedMtTimer(unsigned _nameHash, bool _autoShowGraph)
 ScopedMtTimer::~ScopedMtTimer()
 {
 	profiler.AddTime(nameHash, startTime, GetDuration(), autoShowGraph, false, true);
+
+	if (CTraceEventRecorder::IsEnabled())
+		traceRecorder.AddEvent(nameHash, startTime, spring_gettime());
 }
 
 
@@ -399,6 +411,31 @@ void CTimeProfiler::AddTimeRaw(
 	}
 }
 
+void CTimeProfiler::GetTotalTimes(std::vector< std::pair<unsigned, spring_time> >& totalTimes) const
+{
+	std::lock_guard<ProfileMutexType> lock(profileMutex);
+
+	totalTimes.clear();
+	totalTimes.reserve(profiles.size());
+
+	for (const auto& profile: profiles) {
+		totalTimes.emplace_back(profile.first, profile.second.total);
+	}
+}
+
+std::string CTimeProfiler::GetTimerName(unsigned nameHash)
+{
+	std::lock_guard<HashNamMutexType> lock(hashToNameMutex);
+
+	const auto iter = hashToName.find(nameHash);
+
+	if (iter == hashToName.end())
+		return "???";
+
+	return iter->second;
+}
+
+
 void CTimeProfiler::PrintProfilingInfo() const
 {
 	if (sortedProfiles.empty())
@@ -414,3 +451,121 @@ void CTimeProfiler::PrintProfilingInfo() const
 	}
 }
 
+
+
+
+std::atomic<bool> CTraceEventRecorder::enabled{false};
+
+CTraceEventRecorder& CTraceEventRecorder::GetInstance()
+{
+	static CTraceEventRecorder tr;
+	return tr;
+}
+
+CTraceEventRecorder::ThreadBuffer* CTraceEventRecorder::GetThreadBuffer()
+{
+	static _threadlocal ThreadBuffer* threadBuffer = nullptr;
+
+	if (threadBuffer != nullptr)
+		return threadBuffer;
+
+	std::lock_guard<spring::mutex> lock(traceBuffersMutex);
+
+	threadBuffers.emplace_back(new ThreadBuffer());
+	threadBuffer = threadBuffers.back().get();
+	threadBuffer->events.reset(new Event[bufferSize]);
+	threadBuffer->capacity = bufferSize;
+	threadBuffer->threadIdx = threadBuffers.size() - 1;
+
+	#ifdef THREADPOOL
+	const int poolThreadNum = ThreadPool::GetThreadNum();
+	#else
+	const int poolThreadNum = 0;
+	#endif
+
+	if (Threading::IsMainThread()) {
+		threadBuffer->threadName = "main";
+	} else if (poolThreadNum > 0) {
+		threadBuffer->threadName = "worker " + std::to_string(poolThreadNum);
+	} else {
+		threadBuffer->threadName = "thread " + std::to_string(threadBuffer->threadIdx);
+	}
+
+	return threadBuffer;
+}
+
+void CTraceEventRecorder::AddEvent(unsigned nameHash, spring_time startTime, spring_time endTime)
+{
+	ThreadBuffer* tb = GetThreadBuffer();
+
+	// single producer per buffer; each slot is a small seqlock so
+	// Dump can detect (and skip) slots that are being overwritten
+	const uint64_t eventIdx = tb->numEvents.load(std::memory_order_relaxed);
+	Event& e = tb->events[eventIdx % tb->capacity];
+
+	e.seqNum.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	e.startTime.store(startTime.toNanoSecsi(), std::memory_order_relaxed);
+	e.endTime.store(endTime.toNanoSecsi(), std::memory_order_relaxed);
+	e.nameHash.store(nameHash, std::memory_order_relaxed);
+	e.seqNum.store(eventIdx + 1, std::memory_order_release);
+
+	tb->numEvents.store(eventIdx + 1, std::memory_order_release);
+}
+
+bool CTraceEventRecorder::Dump(const std::string& fileName) const
+{
+	FILE* f = fopen(fileName.c_str(), "w");
+
+	if (f == nullptr)
+		return false;
+
+	std::lock_guard<spring::mutex> lock(traceBuffersMutex);
+
+	fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+	bool firstEvent = true;
+
+	const auto WriteSeparator = [&]() {
+		if (!firstEvent)
+			fprintf(f, ",\n");
+
+		firstEvent = false;
+	};
+
+	for (const auto& tbPtr: threadBuffers) {
+		const ThreadBuffer& tb = *tbPtr.get();
+
+		WriteSeparator();
+		fprintf(f, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %u, \"args\": {\"name\": \"%s\"}}", tb.threadIdx, tb.threadName.c_str());
+
+		const uint64_t numEvents = tb.numEvents.load(std::memory_order_acquire);
+		const uint64_t minEventIdx = numEvents - std::min(numEvents, uint64_t(tb.capacity));
+
+		for (uint64_t eventIdx = minEventIdx; eventIdx < numEvents; eventIdx++) {
+			const Event& e = tb.events[eventIdx % tb.capacity];
+
+			if (e.seqNum.load(std::memory_order_acquire) != (eventIdx + 1))
+				continue;
+
+			const int64_t startTime = e.startTime.load(std::memory_order_relaxed);
+			const int64_t endTime = e.endTime.load(std::memory_order_relaxed);
+			const unsigned nameHash = e.nameHash.load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			// overwritten by the owning thread while we were reading
+			if (e.seqNum.load(std::memory_order_relaxed) != (eventIdx + 1))
+				continue;
+
+			WriteSeparator();
+			fprintf(f, "{\"name\": \"%s\", \"cat\": \"timer\", \"ph\": \"X\", \"pid\": 0, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+				CTimeProfiler::GetTimerName(nameHash).c_str(), tb.threadIdx, startTime * 1e-3, (endTime - startTime) * 1e-3);
+		}
+	}
+
+	fprintf(f, "\n]}\n");
+	fclose(f);
+	return true;
+}
@@ -3,9 +3,11 @@
 #ifndef TIME_PROFILER_H
 #define TIME_PROFILER_H
 
+#include <algorithm>
 #include <atomic>
 #include <string>
 #include <deque>
+#include <memory>
 #include <vector>
 #include <array>
 
@@ -24,7 +26,7 @@
 #define SCOPED_SPECIAL_TIMER(      name)  static TimerNameRegistrar __stnr(name); ScopedTimer __scopedTimer(hashString(name), false, true);
 #define SCOPED_SPECIAL_TIMER_NOREG(name)                                          ScopedTimer __scopedTimer(hashString(name), false, true);
 
-#define SCOPED_MT_TIMER(name)  ScopedMtTimer __scopedTimer(hashString(name));
+#define SCOPED_MT_TIMER(name)  static TimerNameRegistrar __tnr(name); ScopedMtTimer __scopedTimer(hashString(name));
 
 
 class BasicTimer : public spring::noncopyable
@@ -167,6 +169,11 @@ public:
 	void SetEnabled(bool b) { enabled = b; }
 	void PrintProfilingInfo() const;
 
+	// accumulated total time of every timer, for sampling outside of Update
+	void GetTotalTimes(std::vector< std::pair<unsigned, spring_time> >& totalTimes) const;
+
+	static std::string GetTimerName(unsigned nameHash);
+
 	void AddTime(
 		unsigned nameHash,
 		const spring_time startTime,
@@ -200,6 +207,60 @@ private:
 };
 
 
+/**
+ * @brief Records begin/end timestamps of ScopedTimer and ScopedMtTimer
+ *
+ * Opt-in; while enabled every timer appends its interval to a ring buffer
+ * owned by the calling thread, so recording takes no locks and only the
+ * most recent events per thread are kept. Dump writes them out in Chrome's
+ * trace-event JSON format (viewable in chrome://tracing or Perfetto).
+ */
+class CTraceEventRecorder
+{
+public:
+	static CTraceEventRecorder& GetInstance();
+
+	static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+	void SetEnabled(bool b) { enabled.store(b, std::memory_order_relaxed); }
+	// only affects threads that have not recorded any events yet
+	void SetBufferSize(unsigned numEvents) { bufferSize = std::max(numEvents, 1u); }
+
+	void AddEvent(unsigned nameHash, spring_time startTime, spring_time endTime);
+
+	bool Dump(const std::string& fileName) const;
+
+private:
+	struct Event {
+		// index+1 of the event stored in this slot, 0 while being written
+		std::atomic<uint64_t> seqNum{0};
+		std::atomic<int64_t> startTime{0};
+		std::atomic<int64_t> endTime{0};
+		std::atomic<unsigned> nameHash{0};
+	};
+
+	struct ThreadBuffer {
+		std::unique_ptr<Event[]> events;
+		std::atomic<uint64_t> numEvents{0};
+
+		unsigned capacity = 0;
+		unsigned threadIdx = 0;
+
+		std::string threadName;
+	};
+
+	ThreadBuffer* GetThreadBuffer();
+
+private:
+	// buffers are never freed, threads keep a pointer to theirs
+	std::vector< std::unique_ptr<ThreadBuffer> > threadBuffers;
+
+	unsigned bufferSize = 1 << 16;
+
+	static std::atomic<bool> enabled;
+};
+
+
 class TimerNameRegistrar : public spring::noncopyable
 {
 public:
@@ -209,5 +270,6 @@ public:
 };
 
 #define profiler (CTimeProfiler::GetInstance())
+#define traceRecorder (CTraceEventRecorder::GetInstance())
 
 #endif // TIME_PROFILER_H
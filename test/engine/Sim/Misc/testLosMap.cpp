@@ -0,0 +1,103 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Map/MapDimensions.h"
+#include "Sim/Misc/LosMap.h"
+#include "System/Rectangle.h"
+#include "System/type2.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+// normally defined by ReadMap.cpp, used for the emitter-below-ground check
+MapDimensions mapDims;
+
+
+static bool SameSquares(const SLosInstance& a, const SLosInstance& b)
+{
+	if (a.squares.size() != b.squares.size())
+		return false;
+
+	for (size_t i = 0; i < a.squares.size(); i++) {
+		if (a.squares[i].start != b.squares[i].start || a.squares[i].length != b.squares[i].length)
+			return false;
+	}
+
+	return true;
+}
+
+static void InitInstance(SLosInstance& li, int radius, int2 basePos, float baseHeight)
+{
+	li.radius = radius;
+	li.basePos = basePos;
+	li.baseHeight = baseHeight;
+	li.squares.clear();
+	li.dirtyRect = {};
+}
+
+
+
+TEST_CASE("IncrementalLosUpdate")
+{
+	static constexpr int TEST_RUNS = 400;
+	static constexpr int TERRAFORMS_PER_RUN = 3;
+
+	std::mt19937 rng(1);
+
+	for (int n = 0; n < TEST_RUNS; ++n) {
+		const int2 size = {64 + int(rng() % 64), 64 + int(rng() % 64)};
+
+		// center heightmap is only read to check if the emitter is below ground
+		std::vector<float> ctrHeightMap(size.x * size.y * 4, -100.0f);
+		std::vector<float> mipHeightMap(size.x * size.y);
+
+		for (float& h: mipHeightMap) {
+			h = float(int(rng() % 200)) - 20.0f;
+		}
+
+		mapDims.mapx = size.x * 2;
+		mapDims.mapy = size.y * 2;
+
+		CLosMap incMap;
+		CLosMap fullMap;
+		incMap.Init(size, size * 2, ctrHeightMap.data(), mipHeightMap.data(), false, true);
+		fullMap.Init(size, size * 2, ctrHeightMap.data(), mipHeightMap.data(), false, false);
+
+		// includes emitters outside the map and ones close to its edges
+		const int radius = 2 + rng() % 40;
+		const int2 basePos = {int(rng() % (size.x + 20)) - 10, int(rng() % (size.y + 20)) - 10};
+		const float baseHeight = 50.0f + rng() % 100;
+
+		SLosInstance incInstance(0);
+		SLosInstance fullInstance(1);
+
+		InitInstance(incInstance, radius, basePos, baseHeight);
+		incMap.PrepareRaycast(&incInstance);
+
+		for (int k = 0; k < TERRAFORMS_PER_RUN; ++k) {
+			const int x1 = rng() % size.x;
+			const int y1 = rng() % size.y;
+			const int x2 = std::min(size.x, x1 + 1 + int(rng() % 12));
+			const int y2 = std::min(size.y, y1 + 1 + int(rng() % 12));
+
+			for (int y = y1; y < y2; y++) {
+				for (int x = x1; x < x2; x++) {
+					mipHeightMap[y * size.x + x] += float(int(rng() % 300)) - 150.0f;
+				}
+			}
+
+			incInstance.dirtyRect = SRectangle(x1, y1, x2, y2);
+			incMap.UpdateRaycast(&incInstance);
+
+			InitInstance(fullInstance, radius, basePos, baseHeight);
+			fullMap.PrepareRaycast(&fullInstance);
+
+			INFO("run " << n << ": radius " << radius << " at (" << basePos.x << ", " << basePos.y << ")");
+			CHECK(SameSquares(incInstance, fullInstance));
+		}
+	}
+}
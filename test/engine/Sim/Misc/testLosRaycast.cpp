@@ -0,0 +1,165 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Sim/Misc/LosRaycast.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+// rays from the center to every square on the upper-right quadrant's
+// border; similar in shape (but not identical) to CLosTableHelper's
+static LosRaycast::RayTable GenerateRays(int radius)
+{
+	LosRaycast::RayTable rays;
+
+	for (int k = 0; k <= radius; ++k) {
+		for (const int2 end: {int2(radius, k), int2(k, radius)}) {
+			LosRaycast::RayLine ray;
+
+			const int steps = std::max(end.x, end.y);
+
+			for (int s = 1; s <= steps; ++s) {
+				ray.emplace_back(int(std::round(end.x * s / float(steps))), int(std::round(end.y * s / float(steps))));
+			}
+
+			rays.push_back(std::move(ray));
+		}
+	}
+
+	return rays;
+}
+
+// rolling hills plus noise, converted to angles the way CLosMap does
+static std::vector<float> GenerateAngles(int radius, const std::vector<float>& isqrtTable, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> noise(-20.0f, 20.0f);
+
+	const int size = 2 * radius + 1;
+	std::vector<float> angles(size * size, -1e8f);
+
+	for (int y = -radius; y <= radius; ++y) {
+		for (int x = -radius; x <= radius; ++x) {
+			if (x == 0 && y == 0)
+				continue;
+
+			const float h = 100.0f * std::sin(x * 0.21f) * std::cos(y * 0.17f) + noise(rng);
+			angles[(y + radius) * size + (x + radius)] = (std::max(0.0f, h) - 50.0f + 5.0f) * isqrtTable[x * x + y * y];
+		}
+	}
+
+	return angles;
+}
+
+struct RaycastResult {
+	std::vector<char> visible;
+	std::vector<bool> occluded;
+};
+
+static RaycastResult Cast(LosRaycast::KernelType type, const LosRaycast::RayTable& rays, const std::vector<int>& rayOffsets, const std::vector<float>& isqrtTable, const std::vector<float>& angles, int radius)
+{
+	RaycastResult result;
+	result.visible.resize(angles.size(), true);
+	result.occluded.resize(rayOffsets.back() * 4, false);
+
+	LosRaycast::CastArgs args;
+	args.rays = &rays;
+	args.isqrtTable = isqrtTable.data();
+	args.squareAngles = angles.data();
+	args.visibleSquares = result.visible.data();
+	args.rayOffsets = rayOffsets.data();
+	args.occludedRaySquares = &result.occluded;
+	args.radius = radius;
+
+	LosRaycast::CastRays(type, args);
+	return result;
+}
+
+
+
+TEST_CASE("LosRaycast")
+{
+	constexpr int radii[] = {1, 7, 32, 95};
+
+	for (const int radius: radii) {
+		const LosRaycast::RayTable rays = GenerateRays(radius);
+
+		std::vector<int> rayOffsets(1, 0);
+		std::vector<float> isqrtTable(2 * (radius + 1) * (radius + 1));
+
+		for (const auto& ray: rays)
+			rayOffsets.push_back(rayOffsets.back() + ray.size());
+		for (size_t r = 0; r < isqrtTable.size(); ++r)
+			isqrtTable[r] = 1.0f / std::sqrt(float(std::max(r, size_t(1))));
+
+		for (unsigned seed = 0; seed < 8; ++seed) {
+			const std::vector<float> angles = GenerateAngles(radius, isqrtTable, seed);
+			const RaycastResult reference = Cast(LosRaycast::KERNEL_SCALAR, rays, rayOffsets, isqrtTable, angles, radius);
+
+			for (int type = LosRaycast::KERNEL_SCALAR + 1; type < LosRaycast::KERNEL_COUNT; ++type) {
+				if (!LosRaycast::IsKernelSupported(LosRaycast::KernelType(type)))
+					continue;
+
+				const RaycastResult result = Cast(LosRaycast::KernelType(type), rays, rayOffsets, isqrtTable, angles, radius);
+
+				CHECK(result.visible == reference.visible);
+				CHECK(result.occluded == reference.occluded);
+			}
+		}
+	}
+}
+
+
+TEST_CASE("LosRaycastBenchmark", "[.]")
+{
+	constexpr int radius = 64;
+	constexpr int numIters = 200;
+
+	const LosRaycast::RayTable rays = GenerateRays(radius);
+
+	std::vector<int> rayOffsets(1, 0);
+	std::vector<float> isqrtTable(2 * (radius + 1) * (radius + 1));
+
+	for (const auto& ray: rays)
+		rayOffsets.push_back(rayOffsets.back() + ray.size());
+	for (size_t r = 0; r < isqrtTable.size(); ++r)
+		isqrtTable[r] = 1.0f / std::sqrt(float(std::max(r, size_t(1))));
+
+	const std::vector<float> angles = GenerateAngles(radius, isqrtTable, 1234);
+
+	LosRaycast::CastArgs args;
+	args.rays = &rays;
+	args.isqrtTable = isqrtTable.data();
+	args.squareAngles = angles.data();
+	args.radius = radius;
+
+	std::vector<char> visible(angles.size());
+
+	for (int type = LosRaycast::KERNEL_SCALAR; type < LosRaycast::KERNEL_COUNT; ++type) {
+		if (!LosRaycast::IsKernelSupported(LosRaycast::KernelType(type)))
+			continue;
+
+		const auto t0 = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < numIters; ++i) {
+			std::fill(visible.begin(), visible.end(), true);
+			args.visibleSquares = visible.data();
+			LosRaycast::CastRays(LosRaycast::KernelType(type), args);
+		}
+
+		const auto t1 = std::chrono::steady_clock::now();
+		const double usPerCast = std::chrono::duration<double, std::micro>(t1 - t0).count() / numIters;
+
+		const char* kernelName = LosRaycast::GetKernelName(LosRaycast::KernelType(type));
+		const size_t numRays = rays.size();
+
+		WARN("kernel=" << kernelName << " radius=" << radius << " rays=" << numRays << ": " << usPerCast << "us per cast");
+	}
+
+	SUCCEED();
+}
@@ -0,0 +1,144 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Sim/Path/PathEstimatorFile.h"
+#include "System/FileSystem/MemoryMappedFile.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static const std::string TEST_FILE = "testPathEstimatorFile" + std::string(PathEstimatorFile::FILE_EXTENSION);
+
+static void GenerateData(std::vector< std::vector<short2> >& nodeOffsets, std::vector<float>& vertexCosts, size_t numPathTypes, size_t numBlocks, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> offset(0, 31);
+	std::uniform_real_distribution<float> cost(1.0f, 1000.0f);
+
+	nodeOffsets.clear();
+	nodeOffsets.resize(numPathTypes, std::vector<short2>(numBlocks));
+	vertexCosts.resize(numPathTypes * numBlocks * 4);
+
+	for (auto& offsets: nodeOffsets) {
+		for (short2& o: offsets) {
+			o = short2(offset(rng), offset(rng));
+		}
+	}
+	for (float& c: vertexCosts) {
+		c = cost(rng);
+	}
+}
+
+static void PatchFile(const std::string& filePath, long pos, char value)
+{
+	FILE* f = fopen(filePath.c_str(), "r+b");
+	REQUIRE(f != nullptr);
+	fseek(f, pos, SEEK_SET);
+	fwrite(&value, 1, 1, f);
+	fclose(f);
+}
+
+
+
+TEST_CASE("PathEstimatorFile")
+{
+	std::vector< std::vector<short2> > srcOffsets;
+	std::vector< std::vector<short2> > dstOffsets;
+	std::vector<float> srcCosts;
+	std::vector<float> dstCosts;
+
+	GenerateData(srcOffsets, srcCosts, 5, 64 * 64, 1234);
+
+	dstOffsets.resize(srcOffsets.size(), std::vector<short2>(srcOffsets[0].size()));
+	dstCosts.resize(srcCosts.size());
+
+	REQUIRE(PathEstimatorFile::Write(TEST_FILE, 0xC0FFEE, srcOffsets, srcCosts));
+
+	SECTION("RoundTrip") {
+		CHECK(PathEstimatorFile::Read(TEST_FILE, 0xC0FFEE, dstOffsets, dstCosts));
+		CHECK(dstOffsets == srcOffsets);
+		CHECK(dstCosts == srcCosts);
+	}
+
+	SECTION("SectionsArePageAligned") {
+		CMemoryMappedFile file(TEST_FILE);
+
+		REQUIRE(file.IsOpen());
+		// header page + offsets rounded up to a page + costs
+		const size_t offsetsSize = srcOffsets.size() * srcOffsets[0].size() * sizeof(short2);
+		const size_t alignment = PathEstimatorFile::SECTION_ALIGNMENT;
+		CHECK(file.GetSize() == alignment + ((offsetsSize + alignment - 1) / alignment) * alignment + srcCosts.size() * sizeof(float));
+	}
+
+	SECTION("Replace") {
+		// the existing file is overwritten in place
+		REQUIRE(PathEstimatorFile::Write(TEST_FILE, 0xC0FFEF, srcOffsets, srcCosts));
+		CHECK(!PathEstimatorFile::Read(TEST_FILE, 0xC0FFEE, dstOffsets, dstCosts));
+		CHECK(PathEstimatorFile::Read(TEST_FILE, 0xC0FFEF, dstOffsets, dstCosts));
+	}
+
+	SECTION("StaleHash") {
+		CHECK(!PathEstimatorFile::Read(TEST_FILE, 0xC0FFEF, dstOffsets, dstCosts));
+	}
+
+	SECTION("SizeMismatch") {
+		dstCosts.resize(dstCosts.size() + 1);
+		CHECK(!PathEstimatorFile::Read(TEST_FILE, 0xC0FFEE, dstOffsets, dstCosts));
+
+		dstCosts.resize(srcCosts.size());
+		dstOffsets.pop_back();
+		CHECK(!PathEstimatorFile::Read(TEST_FILE, 0xC0FFEE, dstOffsets, dstCosts));
+	}
+
+	SECTION("CorruptHeader") {
+		// numBlocks
+		PatchFile(TEST_FILE, 20, 0x7F);
+		CHECK(!PathEstimatorFile::Read(TEST_FILE, 0xC0FFEE, dstOffsets, dstCosts));
+	}
+
+	SECTION("CorruptData") {
+		PatchFile(TEST_FILE, PathEstimatorFile::SECTION_ALIGNMENT + 3, 0x7F);
+		CHECK(!PathEstimatorFile::Read(TEST_FILE, 0xC0FFEE, dstOffsets, dstCosts));
+	}
+
+	SECTION("Missing") {
+		remove(TEST_FILE.c_str());
+		CHECK(!PathEstimatorFile::Read(TEST_FILE, 0xC0FFEE, dstOffsets, dstCosts));
+	}
+
+	remove(TEST_FILE.c_str());
+}
+
+
+TEST_CASE("PathEstimatorFileBenchmark", "[.]")
+{
+	constexpr int numIters = 20;
+
+	std::vector< std::vector<short2> > nodeOffsets;
+	std::vector<float> vertexCosts;
+
+	// roughly a 24x24 map at BLOCK_SIZE 8 with 40 movedefs
+	GenerateData(nodeOffsets, vertexCosts, 40, 192 * 192, 5678);
+
+	REQUIRE(PathEstimatorFile::Write(TEST_FILE, 1, nodeOffsets, vertexCosts));
+
+	const auto t0 = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < numIters; ++i) {
+		REQUIRE(PathEstimatorFile::Read(TEST_FILE, 1, nodeOffsets, vertexCosts));
+	}
+
+	const auto t1 = std::chrono::steady_clock::now();
+	const double msPerRead = std::chrono::duration<double, std::milli>(t1 - t0).count() / numIters;
+	const double fileSizeMB = (nodeOffsets.size() * nodeOffsets[0].size() * sizeof(short2) + vertexCosts.size() * sizeof(float)) / (1024.0 * 1024.0);
+
+	WARN(fileSizeMB << "MB: " << msPerRead << "ms per (warm) read");
+
+	remove(TEST_FILE.c_str());
+	SUCCEED();
+}
@@ -0,0 +1,413 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Sim/Path/TKPFS/PathHierarchy.h"
+#include "Sim/Path/TKPFS/PathConstants.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static constexpr int BLOCK_SIZE = 16;
+
+// a stand-in for the med-res estimator's data
+struct BaseGraph {
+	int2 numBlocks;
+
+	std::vector<std::uint8_t> blocked; // per block, shared by all path-types
+	std::vector<float> vertexCosts;
+	std::vector< std::vector<short2> > nodeOffsets;
+	std::vector<float> maxSpeedMods;
+
+	bool IsOpen(int2 pos) const {
+		if (static_cast<unsigned int>(pos.x) >= numBlocks.x || static_cast<unsigned int>(pos.y) >= numBlocks.y)
+			return false;
+
+		return (blocked[pos.y * numBlocks.x + pos.x] == 0);
+	}
+
+	float GetCost(unsigned int pathType, int2 pos, unsigned int pathDir) const {
+		const unsigned int idx = (pathType * numBlocks.x * numBlocks.y + pos.y * numBlocks.x + pos.x) * PATH_DIRECTION_VERTICES;
+		return vertexCosts[idx + GetBlockVertexOffset(pathDir, numBlocks.x)];
+	}
+
+	// recalculates the vertex costs stored by <pos>
+	void CalcBlock(int2 pos, std::mt19937& rng) {
+		std::uniform_real_distribution<float> costMult(1.0f, 2.0f);
+
+		for (unsigned int pathType = 0; pathType < nodeOffsets.size(); pathType++) {
+			const unsigned int idx = (pathType * numBlocks.x * numBlocks.y + pos.y * numBlocks.x + pos.x) * PATH_DIRECTION_VERTICES;
+
+			for (unsigned int pathDir = 0; pathDir < PATH_DIRECTION_VERTICES; pathDir++) {
+				const int2 dir = PE_DIRECTION_VECTORS[pathDir];
+				const int2 ngb = pos + dir;
+
+				// no corner-cutting
+				const bool open = IsOpen(pos) && IsOpen(ngb) && IsOpen(pos + int2(dir.x, 0)) && IsOpen(pos + int2(0, dir.y));
+				const float dist = (dir.x != 0 && dir.y != 0)? 1.4142f: 1.0f;
+
+				vertexCosts[idx + pathDir] = open? (dist * BLOCK_SIZE * costMult(rng) * (1 + pathType)): PATHCOST_INFINITY;
+			}
+		}
+	}
+
+	void Generate(int2 size, unsigned int numPathTypes, float blockedFraction, unsigned int seed) {
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		numBlocks = size;
+		blocked.assign(size.x * size.y, 0);
+		vertexCosts.assign(numPathTypes * size.x * size.y * PATH_DIRECTION_VERTICES, PATHCOST_INFINITY);
+		nodeOffsets.assign(numPathTypes, std::vector<short2>(size.x * size.y));
+		maxSpeedMods.assign(numPathTypes, 1.0f);
+
+		for (std::uint8_t& b: blocked) {
+			b = (unit(rng) < blockedFraction);
+		}
+
+		// long walls with a few gaps, to force detours
+		for (int z = 8; z < size.y; z += 24) {
+			for (int x = 0; x < size.x; x++) {
+				blocked[z * size.x + x] = ((x % 61) > 2);
+			}
+		}
+
+		for (int z = 0; z < size.y; z++) {
+			for (int x = 0; x < size.x; x++) {
+				for (auto& offsets: nodeOffsets) {
+					offsets[z * size.x + x] = short2(x * BLOCK_SIZE + BLOCK_SIZE / 2, z * BLOCK_SIZE + BLOCK_SIZE / 2);
+				}
+
+				CalcBlock({x, z}, rng);
+			}
+		}
+	}
+
+	// the path a (complete) estimator search would find
+	float FindPath(unsigned int pathType, int2 strt, int2 goal) const {
+		const auto cmp = std::greater<std::pair<float, unsigned int>>();
+
+		std::vector<float> costs(numBlocks.x * numBlocks.y, PATHCOST_INFINITY);
+		std::vector<std::pair<float, unsigned int>> openQueue;
+
+		costs[strt.y * numBlocks.x + strt.x] = 0.0f;
+		openQueue.emplace_back(0.0f, strt.y * numBlocks.x + strt.x);
+
+		while (!openQueue.empty()) {
+			std::pop_heap(openQueue.begin(), openQueue.end(), cmp);
+
+			const unsigned int curIdx = openQueue.back().second;
+			const int2 curPos = {int(curIdx % numBlocks.x), int(curIdx / numBlocks.x)};
+			const float curCost = costs[curIdx];
+
+			openQueue.pop_back();
+
+			if (curPos == goal)
+				return curCost;
+
+			for (unsigned int pathDir = 0; pathDir < PATH_DIRECTIONS; pathDir++) {
+				const int2 ngbPos = curPos + PE_DIRECTION_VECTORS[pathDir];
+
+				if (static_cast<unsigned int>(ngbPos.x) >= numBlocks.x || static_cast<unsigned int>(ngbPos.y) >= numBlocks.y)
+					continue;
+
+				const float ngbCost = curCost + GetCost(pathType, curPos, pathDir);
+				const unsigned int ngbIdx = ngbPos.y * numBlocks.x + ngbPos.x;
+
+				if (ngbCost >= costs[ngbIdx])
+					continue;
+
+				const int dx = std::abs(ngbPos.x - goal.x) * BLOCK_SIZE;
+				const int dz = std::abs(ngbPos.y - goal.y) * BLOCK_SIZE;
+
+				costs[ngbIdx] = ngbCost;
+				openQueue.emplace_back(ngbCost + std::max(dx, dz) + std::min(dx, dz) * 0.41421356f, ngbIdx);
+				std::push_heap(openQueue.begin(), openQueue.end(), cmp);
+			}
+		}
+
+		return PATHCOST_INFINITY;
+	}
+};
+
+static void InitHierarchy(TKPFS::PathHierarchy& ph, const BaseGraph& bg)
+{
+	ph.Init(bg.numBlocks, &bg.vertexCosts, &bg.nodeOffsets, &bg.maxSpeedMods);
+}
+
+// cost of following <blockPath> on the estimator graph; only its ends may skip blocks
+static float GetPathCost(const BaseGraph& bg, unsigned int pathType, const std::vector<int2>& blockPath)
+{
+	const size_t n = blockPath.size();
+
+	if (n < 3)
+		return bg.FindPath(pathType, blockPath.front(), blockPath.back());
+
+	float cost = bg.FindPath(pathType, blockPath[0], blockPath[1]) + bg.FindPath(pathType, blockPath[n - 2], blockPath[n - 1]);
+
+	for (size_t i = 2; i + 1 < n; i++) {
+		const int2 d = blockPath[i] - blockPath[i - 1];
+		const auto dir = std::find(std::begin(PE_DIRECTION_VECTORS), std::end(PE_DIRECTION_VECTORS), d);
+
+		if (dir == std::end(PE_DIRECTION_VECTORS))
+			return PATHCOST_INFINITY;
+
+		cost += bg.GetCost(pathType, blockPath[i - 1], dir - std::begin(PE_DIRECTION_VECTORS));
+	}
+
+	return cost;
+}
+
+static std::vector<std::pair<int2, int2>> GenerateQueries(const BaseGraph& bg, size_t numQueries, int minDist, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> px(0, bg.numBlocks.x - 1);
+	std::uniform_int_distribution<int> pz(0, bg.numBlocks.y - 1);
+
+	std::vector<std::pair<int2, int2>> queries;
+
+	while (queries.size() < numQueries) {
+		const int2 strt = {px(rng), pz(rng)};
+		const int2 goal = {px(rng), pz(rng)};
+
+		if (!bg.IsOpen(strt) || !bg.IsOpen(goal))
+			continue;
+		if (std::max(std::abs(strt.x - goal.x), std::abs(strt.y - goal.y)) < minDist)
+			continue;
+
+		queries.emplace_back(strt, goal);
+	}
+
+	return queries;
+}
+
+
+
+TEST_CASE("PathHierarchy")
+{
+	BaseGraph bg;
+	bg.Generate({256, 192}, 2, 0.15f, 1234);
+
+	TKPFS::PathHierarchy ph;
+	InitHierarchy(ph, bg);
+
+	const auto queries = GenerateQueries(bg, 64, 32, 5678);
+
+	std::vector<int2> blockPath;
+
+	SECTION("Levels") {
+		// 256x192 -> 64x48 -> 16x12
+		REQUIRE(ph.GetNumLevels() == 3);
+		CHECK(ph.GetNumNodes(1) == int2(64, 48));
+		CHECK(ph.GetNumNodes(2) == int2(16, 12));
+		CHECK(ph.GetNumBuiltNodes(1) == 0);
+		CHECK(ph.GetNumBuiltNodes(2) == 0);
+	}
+
+	SECTION("ValidPaths") {
+		size_t numReachable = 0;
+		size_t numFound = 0;
+
+		for (unsigned int pathType = 0; pathType < 2; pathType++) {
+			for (const auto& q: queries) {
+				const float optCost = bg.FindPath(pathType, q.first, q.second);
+
+				if (optCost >= PATHCOST_INFINITY)
+					continue;
+
+				numReachable += 1;
+
+				if (!ph.FindPath(pathType, q.first, q.second, blockPath))
+					continue;
+
+				numFound += 1;
+
+				REQUIRE(blockPath.size() >= 2);
+				CHECK(blockPath.front() == q.first);
+				CHECK(blockPath.back() == q.second);
+
+				// apart from its ends, the path consists of passable estimator edges
+				const float pathCost = GetPathCost(bg, pathType, blockPath);
+
+				CHECK(pathCost < PATHCOST_INFINITY);
+				CHECK(pathCost >= optCost * 0.999f);
+			}
+		}
+
+		// one representative per node does not connect every corner of a node
+		CHECK(numFound >= (numReachable * 9 / 10));
+		// only parts of the hierarchy were needed
+		CHECK(ph.GetNumBuiltNodes(1) < (64 * 48 * 2));
+	}
+
+	SECTION("OrderIndependence") {
+		TKPFS::PathHierarchy ph2;
+		InitHierarchy(ph2, bg);
+
+		std::vector<int2> blockPath2;
+
+		// warm up the second one differently
+		for (auto it = queries.rbegin(); it != queries.rend(); ++it) {
+			ph2.FindPath(1, it->second, it->first, blockPath2);
+		}
+
+		for (const auto& q: queries) {
+			const bool found1 = ph.FindPath(1, q.first, q.second, blockPath);
+			const bool found2 = ph2.FindPath(1, q.first, q.second, blockPath2);
+
+			CHECK(found1 == found2);
+			CHECK(blockPath == blockPath2);
+		}
+	}
+
+	SECTION("Threads") {
+		// the same queries on a fresh hierarchy from several threads at once
+		TKPFS::PathHierarchy ph2;
+		InitHierarchy(ph2, bg);
+
+		std::vector<std::vector<int2>> blockPaths(queries.size());
+		std::vector<std::thread> threads;
+
+		for (size_t t = 0; t < 4; t++) {
+			threads.emplace_back([&, t]() {
+				for (size_t i = t; i < queries.size(); i += 4) {
+					ph2.FindPath(1, queries[i].first, queries[i].second, blockPaths[i]);
+				}
+			});
+		}
+
+		for (std::thread& t: threads) {
+			t.join();
+		}
+
+		for (size_t i = 0; i < queries.size(); i++) {
+			ph.FindPath(1, queries[i].first, queries[i].second, blockPath);
+			CHECK(blockPath == blockPaths[i]);
+		}
+
+		CHECK(ph.GetNumBuiltNodes(1) == ph2.GetNumBuiltNodes(1));
+	}
+
+	SECTION("BlocksChanged") {
+		for (const auto& q: queries) {
+			ph.FindPath(0, q.first, q.second, blockPath);
+		}
+
+		// close a gap in every wall and fill a random area
+		std::mt19937 rng(4321);
+
+		for (int z = 8; z < bg.numBlocks.y; z += 24) {
+			bg.blocked[z * bg.numBlocks.x + 61] = 1;
+		}
+		for (int z = 100; z < 120; z++) {
+			for (int x = 100; x < 140; x++) {
+				bg.blocked[z * bg.numBlocks.x + x] = 1;
+			}
+		}
+
+		// like the estimator, recalculate the changed blocks and their neighbors
+		const auto Recalc = [&](int2 minPos, int2 maxPos) {
+			minPos = {std::max(minPos.x - 1, 0), std::max(minPos.y - 1, 0)};
+			maxPos = {std::min(maxPos.x + 1, bg.numBlocks.x - 1), std::min(maxPos.y + 1, bg.numBlocks.y - 1)};
+
+			for (int z = minPos.y; z <= maxPos.y; z++) {
+				for (int x = minPos.x; x <= maxPos.x; x++) {
+					bg.CalcBlock({x, z}, rng);
+				}
+			}
+
+			ph.BlocksChanged(minPos, maxPos);
+		};
+
+		for (int z = 8; z < bg.numBlocks.y; z += 24) {
+			Recalc({61, z}, {61, z});
+		}
+
+		Recalc({100, 100}, {139, 119});
+
+		TKPFS::PathHierarchy ph2;
+		InitHierarchy(ph2, bg);
+
+		std::vector<int2> blockPath2;
+
+		for (const auto& q: queries) {
+			const bool found1 = ph.FindPath(0, q.first, q.second, blockPath);
+			const bool found2 = ph2.FindPath(0, q.first, q.second, blockPath2);
+
+			CHECK(found1 == found2);
+			CHECK(blockPath == blockPath2);
+		}
+	}
+}
+
+
+// run it explicitly by its name
+TEST_CASE("PathHierarchyBenchmark", "[.]")
+{
+	using namespace std::chrono;
+
+	// a 128x128 map (8192 squares per side) at the med-res BLOCK_SIZE
+	BaseGraph bg;
+	bg.Generate({512, 512}, 1, 0.15f, 8765);
+
+	const auto queries = GenerateQueries(bg, 200, 128, 9876);
+
+	TKPFS::PathHierarchy ph;
+	std::vector<int2> blockPath;
+
+	const auto t0 = steady_clock::now();
+	InitHierarchy(ph, bg);
+	const auto t1 = steady_clock::now();
+
+	size_t numFound = 0;
+	float sumCost = 0.0f;
+	float sumOptCost = 0.0f;
+
+	for (const auto& q: queries) {
+		if (!ph.FindPath(0, q.first, q.second, blockPath))
+			continue;
+
+		numFound += 1;
+	}
+
+	const auto t2 = steady_clock::now();
+
+	for (const auto& q: queries) {
+		ph.FindPath(0, q.first, q.second, blockPath);
+	}
+
+	const auto t3 = steady_clock::now();
+
+	for (const auto& q: queries) {
+		bg.FindPath(0, q.first, q.second);
+	}
+
+	const auto t4 = steady_clock::now();
+
+	for (const auto& q: queries) {
+		const float optCost = bg.FindPath(0, q.first, q.second);
+
+		if (optCost >= PATHCOST_INFINITY || !ph.FindPath(0, q.first, q.second, blockPath))
+			continue;
+
+		sumCost += GetPathCost(bg, 0, blockPath);
+		sumOptCost += optCost;
+	}
+
+	const double initMS = duration<double, std::milli>(t1 - t0).count();
+	const double coldMS = duration<double, std::milli>(t2 - t1).count();
+	const double warmMS = duration<double, std::milli>(t3 - t2).count();
+	const double refMS = duration<double, std::milli>(t4 - t3).count();
+
+	WARN(bg.numBlocks.x << "x" << bg.numBlocks.y << " blocks, " << ph.GetNumLevels() << " levels, init " << initMS << "ms");
+	WARN(numFound << "/" << queries.size() << " found, " << (coldMS / queries.size()) << "ms cold / " << (warmMS / queries.size()) << "ms warm per query, " << (refMS / queries.size()) << "ms per full block-level search");
+	WARN("path cost " << ((sumCost / sumOptCost) * 100.0f) << "% of optimal, " << ph.GetNumBuiltNodes(1) << " of " << (ph.GetNumNodes(1).x * ph.GetNumNodes(1).y) << " level 1 nodes built");
+
+	CHECK(numFound > 0);
+}
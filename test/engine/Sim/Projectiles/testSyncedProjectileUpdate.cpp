@@ -0,0 +1,227 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Sim/Projectiles/SyncedProjectileUpdate.h"
+#include "System/SpringHash.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Platform/Threading.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+struct do_once {
+	do_once() { Threading::DetectCores(); } // make GetMaxThreads() work
+};
+
+InitSpringTime ist;
+do_once doonce;
+
+
+struct TestProjectile;
+
+// what the projectiles can affect besides themselves
+struct TestWorld {
+	void Spawn(const float* pos, const float* speed, int ttl, int generation);
+
+	std::vector<TestProjectile*> projectiles;
+	std::vector<std::unique_ptr<TestProjectile>> pool;
+
+	std::vector<int> explosions;
+	std::vector<int> moved;
+};
+
+// falls, bounces off the ground and explodes into two fragments when its
+// ttl runs out, like a cluster CExplosiveProjectile
+struct TestProjectile {
+	static constexpr float GRAVITY = 0.25f;
+
+	// same refusals as CExplosiveProjectile: expiring or bouncing this frame
+	bool UpdateMt() {
+		if (ttl <= 1 || WillBounce())
+			return false;
+
+		UpdateFlight();
+		return true;
+	}
+
+	void Update() {
+		UpdateFlight();
+
+		if (ttl == 0) {
+			world->explosions.push_back(id);
+
+			if (generation < 2) {
+				const float speedL[3] = {speed[0] - 1.0f, speed[1] + 2.0f, speed[2]};
+				const float speedR[3] = {speed[0] + 1.0f, speed[1] + 2.0f, speed[2]};
+
+				world->Spawn(pos, speedL, 10 + (id % 7), generation + 1);
+				world->Spawn(pos, speedR, 10 + (id % 5), generation + 1);
+			}
+		}
+
+		if (pos[1] < 0.0f) {
+			pos[1] = -pos[1];
+			speed[1] = -speed[1] * 0.5f;
+		}
+	}
+
+	void UpdateFlight() {
+		speed[1] -= GRAVITY;
+
+		for (int i = 0; i < 3; i++) {
+			pos[i] += speed[i];
+		}
+
+		ttl -= 1;
+
+		CSyncChecker::Sync(pos, sizeof(pos));
+		CSyncChecker::Sync(&ttl, sizeof(ttl));
+	}
+
+	bool WillBounce() const { return ((pos[1] + speed[1] - GRAVITY) < 0.0f); }
+
+	TestWorld* world;
+
+	int id;
+	int ttl;
+	int generation;
+
+	float pos[3];
+	float speed[3];
+};
+
+void TestWorld::Spawn(const float* pos, const float* speed, int ttl, int generation)
+{
+	pool.emplace_back(new TestProjectile{this, int(pool.size()), ttl, generation, {pos[0], pos[1], pos[2]}, {speed[0], speed[1], speed[2]}});
+	projectiles.push_back(pool.back().get());
+}
+
+
+static void CreateProjectiles(TestWorld& world, size_t numProjectiles, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> hpos(0.0f, 1000.0f);
+	std::uniform_real_distribution<float> vpos(0.0f, 200.0f);
+	std::uniform_real_distribution<float> hspeed(-5.0f, 5.0f);
+	std::uniform_real_distribution<float> vspeed(-2.0f, 8.0f);
+	std::uniform_int_distribution<int> ttl(5, 60);
+
+	for (size_t i = 0; i < numProjectiles; i++) {
+		const float pos[3] = {hpos(rng), vpos(rng), hpos(rng)};
+		const float speed[3] = {hspeed(rng), vspeed(rng), hspeed(rng)};
+
+		world.Spawn(pos, speed, ttl(rng), 0);
+	}
+}
+
+// runs <numFrames> frames the way CProjectileHandler::UpdateProjectilesImpl
+// does and returns the sync checksums of all of them folded into one
+static unsigned UpdateFrames(TestWorld& world, int numFrames, bool parallel)
+{
+	const auto check = [](const TestProjectile* p) {};
+	const auto moved = [&](TestProjectile* p) { world.moved.push_back(p->id); };
+
+	auto& pc = world.projectiles;
+
+	std::vector<std::uint8_t> updatedMT;
+
+	unsigned checksum = 0;
+
+	for (int frame = 0; frame < numFrames; frame++) {
+		CSyncChecker::NewFrame();
+
+		// deletion, same swap-with-last as the handler's container
+		for (size_t i = 0; i < pc.size(); ) {
+			if (pc[i]->ttl <= 0) {
+				pc[i] = pc.back();
+				pc.pop_back();
+				continue;
+			}
+
+			++i;
+		}
+
+		size_t numUpdatedMT = 0;
+
+		if (parallel)
+			numUpdatedMT = SyncedProjectileUpdate::UpdateParallel(pc, updatedMT, check);
+
+		SyncedProjectileUpdate::UpdateSerial(pc, updatedMT, numUpdatedMT, check, moved);
+
+		const unsigned frameChecksum = CSyncChecker::GetChecksum();
+		checksum = spring::LiteHash(&frameChecksum, sizeof(frameChecksum), checksum);
+	}
+
+	return checksum;
+}
+
+// what /DumpState would compare
+static unsigned StateChecksum(const TestWorld& world)
+{
+	unsigned checksum = 0;
+
+	for (const auto& p: world.pool) {
+		checksum = spring::LiteHash(p->pos, sizeof(p->pos), checksum);
+		checksum = spring::LiteHash(p->speed, sizeof(p->speed), checksum);
+		checksum = spring::LiteHash(&p->ttl, sizeof(p->ttl), checksum);
+	}
+
+	checksum = spring::LiteHash(world.explosions.data(), world.explosions.size() * sizeof(int), checksum);
+	checksum = spring::LiteHash(world.moved.data(), world.moved.size() * sizeof(int), checksum);
+	return checksum;
+}
+
+
+TEST_CASE("SyncedProjectileUpdate")
+{
+	constexpr size_t numProjectiles = 2000;
+	constexpr int numFrames = 100;
+
+	TestWorld serialWorld;
+	TestWorld parallelWorld;
+	TestWorld parallelWorld1;
+
+	CreateProjectiles(serialWorld, numProjectiles, 1234);
+	CreateProjectiles(parallelWorld, numProjectiles, 1234);
+	CreateProjectiles(parallelWorld1, numProjectiles, 1234);
+
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+
+	const unsigned serialChecksum = UpdateFrames(serialWorld, numFrames, false);
+	const unsigned parallelChecksum = UpdateFrames(parallelWorld, numFrames, true);
+
+	ThreadPool::SetThreadCount(1);
+
+	const unsigned parallelChecksum1 = UpdateFrames(parallelWorld1, numFrames, true);
+
+	ThreadPool::SetThreadCount(0);
+
+	// the fragments, explosions and quadfield order must not depend on the mode
+	REQUIRE(serialWorld.pool.size() > numProjectiles);
+	REQUIRE(serialWorld.pool.size() == parallelWorld.pool.size());
+	CHECK(serialWorld.explosions == parallelWorld.explosions);
+	CHECK(serialWorld.moved == parallelWorld.moved);
+
+	for (size_t i = 0; i < serialWorld.pool.size(); i++) {
+		const TestProjectile* sp = serialWorld.pool[i].get();
+		const TestProjectile* pp = parallelWorld.pool[i].get();
+
+		INFO("projectile " << i);
+		CHECK(sp->ttl == pp->ttl);
+		CHECK(std::equal(sp->pos, sp->pos + 3, pp->pos));
+		CHECK(std::equal(sp->speed, sp->speed + 3, pp->speed));
+	}
+
+	CHECK(StateChecksum(serialWorld) == StateChecksum(parallelWorld));
+
+	// the sync checksum of a parallel frame folds lane sums and differs from
+	// a serial one, but not between clients running a different thread count
+	CHECK(parallelChecksum != serialChecksum);
+	CHECK(parallelChecksum == parallelChecksum1);
+	CHECK(StateChecksum(parallelWorld) == StateChecksum(parallelWorld1));
+}
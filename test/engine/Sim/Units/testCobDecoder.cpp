@@ -0,0 +1,452 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Sim/Units/Scripts/CobDecoder.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+// raw opcodes as found in .cob files
+static constexpr int SPIN           = 0x10003000;
+static constexpr int SHADE          = 0x1000D000;
+static constexpr int SLEEP          = 0x10013000;
+static constexpr int MOVE           = 0x10001000;
+static constexpr int PUSH_CONSTANT  = 0x10021001;
+static constexpr int PUSH_LOCAL_VAR = 0x10021002;
+static constexpr int PUSH_STATIC    = 0x10021004;
+static constexpr int CREATE_LOCAL   = 0x10022000;
+static constexpr int POP_STATIC     = 0x10023004;
+static constexpr int ADD            = 0x10031000;
+static constexpr int MUL            = 0x10033000;
+static constexpr int BITWISE_AND    = 0x10035000;
+static constexpr int SET_LESS       = 0x10051000;
+static constexpr int START          = 0x10061000;
+static constexpr int CALL           = 0x10062000;
+static constexpr int JUMP           = 0x10064000;
+static constexpr int REAL_CALL      = 0x10062001;
+static constexpr int RETURN         = 0x10065000;
+static constexpr int JUMP_NOT_EQUAL = 0x10066000;
+
+
+struct CobScript {
+	std::vector<int> code;
+	std::vector<std::string> scriptNames = {"Create", "lua_Foo", "Empty", "Killed"};
+	std::vector<int> scriptOffsets = {0, 0, 0, 0};
+	std::vector<int> scriptLengths = {1, 1, 0, 1};
+	std::vector<CobInstruction> instructions;
+
+	void Decode(int numStaticVars = 2) {
+		CobDecoder::Decode(code, scriptNames, scriptOffsets, scriptLengths, numStaticVars, instructions);
+	}
+};
+
+
+TEST_CASE("CobDecoder")
+{
+	CobScript script;
+
+	SECTION("Operands") {
+		script.code = {PUSH_CONSTANT, 5, PUSH_STATIC, 1, POP_STATIC, 7, SPIN, 3, 1, SHADE, 2, RETURN};
+		script.Decode();
+
+		// every word gets an instruction, plus the sentinel
+		REQUIRE(script.instructions.size() == (script.code.size() + 1));
+		CHECK(script.instructions.back().op == CobInstruction::OP_OUT_OF_RANGE);
+
+		CHECK(script.instructions[0].op == CobInstruction::OP_PUSH_CONSTANT);
+		CHECK(script.instructions[0].args[0] == 5);
+		CHECK(script.instructions[0].next == 2);
+
+		CHECK(script.instructions[2].op == CobInstruction::OP_PUSH_STATIC);
+		CHECK(script.instructions[2].args[0] == 1);
+		CHECK(script.instructions[2].next == 4);
+
+		// invalid static indices are resolved here, not in the interpreter
+		CHECK(script.instructions[4].op == CobInstruction::OP_POP_STACK);
+		CHECK(script.instructions[4].next == 6);
+
+		CHECK(script.instructions[6].op == CobInstruction::OP_SPIN);
+		CHECK(script.instructions[6].args[0] == 3);
+		CHECK(script.instructions[6].args[1] == 1);
+		CHECK(script.instructions[6].next == 9);
+
+		CHECK(script.instructions[9].op == CobInstruction::OP_NOP);
+		CHECK(script.instructions[9].next == 11);
+
+		CHECK(script.instructions[11].op == CobInstruction::OP_RETURN);
+		CHECK(script.instructions[11].next == 12);
+	}
+
+	SECTION("Calls") {
+		script.code = {CALL, 0, 2, CALL, 1, 3, CALL, 2, 0, START, 2, 0, START, 3, 1, CALL, 9, 0, RETURN};
+		script.Decode();
+
+		CHECK(script.instructions[0].op == CobInstruction::OP_CALL);
+		CHECK(script.instructions[0].args[0] == 0);
+		CHECK(script.instructions[0].args[1] == 2);
+		CHECK(script.instructions[0].next == 3);
+
+		CHECK(script.instructions[3].op == CobInstruction::OP_LUA_CALL);
+		CHECK(script.instructions[3].args[0] == 1);
+		CHECK(script.instructions[3].args[1] == 3);
+
+		// zero-length functions are skipped
+		CHECK(script.instructions[6].op == CobInstruction::OP_NOP);
+		CHECK(script.instructions[6].next == 9);
+		CHECK(script.instructions[9].op == CobInstruction::OP_NOP);
+		CHECK(script.instructions[9].next == 12);
+
+		CHECK(script.instructions[12].op == CobInstruction::OP_START);
+		CHECK(script.instructions[12].args[0] == 3);
+
+		CHECK(script.instructions[15].op == CobInstruction::OP_INVALID);
+		CHECK(script.instructions[15].next == 16);
+	}
+
+	SECTION("Jumps") {
+		script.code = {JUMP, 4, JUMP_NOT_EQUAL, -1, JUMP, 1000, RETURN};
+		script.Decode();
+
+		CHECK(script.instructions[0].op == CobInstruction::OP_JUMP);
+		CHECK(script.instructions[0].args[0] == 4);
+
+		// out of range targets lead to the sentinel
+		CHECK(script.instructions[2].op == CobInstruction::OP_JUMP_NOT_EQUAL);
+		CHECK(script.instructions[2].args[0] == int(script.code.size()));
+		CHECK(script.instructions[4].op == CobInstruction::OP_JUMP);
+		CHECK(script.instructions[4].args[0] == int(script.code.size()));
+	}
+
+	SECTION("Malformed") {
+		script.code = {0x12345678, ADD, MOVE, 1};
+		script.Decode();
+
+		CHECK(script.instructions[0].op == CobInstruction::OP_INVALID);
+		CHECK(script.instructions[0].next == 1);
+		CHECK(script.instructions[1].op == CobInstruction::OP_ADD);
+
+		// operands past the end of the code
+		CHECK(script.instructions[2].op == CobInstruction::OP_OUT_OF_RANGE);
+	}
+
+	SECTION("Names") {
+		CHECK(std::string(CobDecoder::GetOpName(CobInstruction::OP_NOP)) == "NOP");
+		CHECK(std::string(CobDecoder::GetOpName(CobInstruction::OP_DROP)) == "DROP");
+		CHECK(std::string(CobDecoder::GetOpName(CobInstruction::NUM_OPS)) == "UNKNOWN");
+	}
+}
+
+
+TEST_CASE("CobDecoderBenchmark", "[.]")
+{
+	// typical unit scripts are well below 64K words
+	constexpr int numWords = 1 << 20;
+
+	const int opcodes[] = {PUSH_CONSTANT, PUSH_STATIC, POP_STATIC, ADD, SPIN, SLEEP, JUMP, CALL, MOVE, RETURN};
+
+	std::mt19937 rng(1234);
+	CobScript script;
+
+	script.code.reserve(numWords);
+
+	while (script.code.size() < numWords) {
+		script.code.push_back(opcodes[rng() % (sizeof(opcodes) / sizeof(opcodes[0]))]);
+		script.code.push_back(rng() % 4);
+	}
+
+	const auto t0 = std::chrono::steady_clock::now();
+	script.Decode();
+	const auto t1 = std::chrono::steady_clock::now();
+
+	const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+	WARN("decoded " << numWords << " words in " << ms << "ms");
+
+	CHECK(script.instructions.size() == (numWords + 1));
+}
+
+
+
+// the parts of CCobInstance a thread running pure computation touches
+struct StubInstance {
+	void Spin(int piece, int axis, int speed, int accel) { numSpins += 1; spinSum += (piece + axis + speed + accel); }
+
+	std::vector<int> staticVars = {0, 0};
+
+	int numSpins = 0;
+	int spinSum = 0;
+};
+
+// CCobThread's stacks and both of its dispatch loops, restricted to the
+// instructions used by the benchmark script; TickRaw fetches and switches
+// on the raw code like Tick did before instructions were decoded, while
+// TickDecoded is today's direct-threaded Tick
+struct StubThread {
+	struct CallInfo {
+		int functionId = -1;
+		int returnAddr = -1;
+		int stackTop = -1;
+	};
+
+	StubThread(CobScript& s, StubInstance& i): script(s), inst(i), callStack(64), dataStack(1024) {
+		callStack[callStackSize++] = {0, -1, 0};
+	}
+
+	void PushDataStack(int v) { dataStack[dataStackSize++] = v; }
+	int PopDataStack() { return ((dataStackSize > 0)? dataStack[--dataStackSize]: 0); }
+
+	int* GetLocalVar(int varIdx) { return &dataStack[LocalStackFrame() + varIdx]; }
+	int LocalReturnAddr() const { return callStack[callStackSize - 1].returnAddr; }
+	int LocalStackFrame() const { return callStack[callStackSize - 1].stackTop; }
+
+	void Call(int func, int numArgs) {
+		callStack[callStackSize++] = {func, pc, dataStackSize - numArgs};
+		paramCount = numArgs;
+		pc = script.scriptOffsets[func];
+	}
+	bool Return() {
+		retCode = PopDataStack();
+
+		if (LocalReturnAddr() == -1)
+			return false;
+
+		pc = LocalReturnAddr();
+		dataStackSize = std::min(dataStackSize, LocalStackFrame());
+		callStackSize -= 1;
+		return true;
+	}
+
+	void TickRaw() {
+		std::vector<int>& code = script.code;
+		int r1, r2, r3, r4;
+
+		for (;;) {
+			switch (code.at(pc++)) {
+				case PUSH_CONSTANT: { PushDataStack(code.at(pc++)); } break;
+				case PUSH_STATIC: { PushDataStack(inst.staticVars[code.at(pc++)]); } break;
+				case POP_STATIC: { inst.staticVars[code.at(pc++)] = PopDataStack(); } break;
+				case PUSH_LOCAL_VAR: { PushDataStack(*GetLocalVar(code.at(pc++))); } break;
+				case CREATE_LOCAL: {
+					if (paramCount == 0) {
+						PushDataStack(0);
+					} else {
+						paramCount--;
+					}
+				} break;
+
+				case ADD: { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(r1 + r2); } break;
+				case MUL: { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(r1 * r2); } break;
+				case BITWISE_AND: { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(r1 & r2); } break;
+				case SET_LESS: { r2 = PopDataStack(); r1 = PopDataStack(); PushDataStack(int(r1 < r2)); } break;
+
+				case SPIN: {
+					r1 = code.at(pc++);
+					r2 = code.at(pc++);
+					r3 = PopDataStack();
+					r4 = PopDataStack();
+					inst.Spin(r1, r2, r3, r4);
+				} break;
+
+				case CALL: {
+					// patched on first use, see REAL_CALL
+					code[pc - 1] = REAL_CALL;
+					pc--;
+				} break;
+				case REAL_CALL: {
+					r1 = code.at(pc++);
+					r2 = code.at(pc++);
+					Call(r1, r2);
+				} break;
+				case RETURN: {
+					if (!Return())
+						return;
+				} break;
+
+				case JUMP: { pc = code.at(pc); } break;
+				case JUMP_NOT_EQUAL: {
+					r1 = code.at(pc++);
+
+					if (PopDataStack() == 0)
+						pc = r1;
+				} break;
+
+				default: { FAIL("unexpected opcode"); } return;
+			}
+		}
+	}
+
+	void TickDecoded() {
+		const CobInstruction* instrs = script.instructions.data();
+		const CobInstruction* instr = nullptr;
+
+		int r1, r2;
+
+	#if defined(__GNUC__)
+		#define STUB_INSTR(name) op_##name:
+		#define STUB_NEXT_INSTR() { instr = &instrs[pc]; pc = instr->next; goto *dispatchTable[instr->op]; }
+
+		const void* dispatchTable[CobInstruction::NUM_OPS];
+
+		std::fill(std::begin(dispatchTable), std::end(dispatchTable), &&op_UNSUPPORTED);
+
+		dispatchTable[CobInstruction::OP_NOP           ] = &&op_NOP;
+		dispatchTable[CobInstruction::OP_PUSH_CONSTANT ] = &&op_PUSH_CONSTANT;
+		dispatchTable[CobInstruction::OP_PUSH_STATIC   ] = &&op_PUSH_STATIC;
+		dispatchTable[CobInstruction::OP_POP_STATIC    ] = &&op_POP_STATIC;
+		dispatchTable[CobInstruction::OP_PUSH_LOCAL_VAR] = &&op_PUSH_LOCAL_VAR;
+		dispatchTable[CobInstruction::OP_CREATE_LOCAL_VAR] = &&op_CREATE_LOCAL_VAR;
+		dispatchTable[CobInstruction::OP_ADD           ] = &&op_ADD;
+		dispatchTable[CobInstruction::OP_MUL           ] = &&op_MUL;
+		dispatchTable[CobInstruction::OP_BITWISE_AND   ] = &&op_BITWISE_AND;
+		dispatchTable[CobInstruction::OP_SET_LESS      ] = &&op_SET_LESS;
+		dispatchTable[CobInstruction::OP_SPIN          ] = &&op_SPIN;
+		dispatchTable[CobInstruction::OP_CALL          ] = &&op_CALL;
+		dispatchTable[CobInstruction::OP_RETURN        ] = &&op_RETURN;
+		dispatchTable[CobInstruction::OP_JUMP          ] = &&op_JUMP;
+		dispatchTable[CobInstruction::OP_JUMP_NOT_EQUAL] = &&op_JUMP_NOT_EQUAL;
+
+		STUB_NEXT_INSTR();
+		{
+	#else
+		#define STUB_INSTR(name) case CobInstruction::OP_##name:
+		#define STUB_NEXT_INSTR() { continue; }
+
+		for (;;) {
+			instr = &instrs[pc];
+			pc = instr->next;
+
+			switch (instr->op) {
+	#endif
+				STUB_INSTR(NOP) {} STUB_NEXT_INSTR();
+				STUB_INSTR(PUSH_CONSTANT) { PushDataStack(instr->args[0]); } STUB_NEXT_INSTR();
+				STUB_INSTR(PUSH_STATIC) { PushDataStack(inst.staticVars[instr->args[0]]); } STUB_NEXT_INSTR();
+				STUB_INSTR(POP_STATIC) { inst.staticVars[instr->args[0]] = PopDataStack(); } STUB_NEXT_INSTR();
+				STUB_INSTR(PUSH_LOCAL_VAR) { PushDataStack(*GetLocalVar(instr->args[0])); } STUB_NEXT_INSTR();
+				STUB_INSTR(CREATE_LOCAL_VAR) {
+					if (paramCount == 0) {
+						PushDataStack(0);
+					} else {
+						paramCount--;
+					}
+				} STUB_NEXT_INSTR();
+
+				STUB_INSTR(ADD) { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(r1 + r2); } STUB_NEXT_INSTR();
+				STUB_INSTR(MUL) { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(r1 * r2); } STUB_NEXT_INSTR();
+				STUB_INSTR(BITWISE_AND) { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(r1 & r2); } STUB_NEXT_INSTR();
+				STUB_INSTR(SET_LESS) { r2 = PopDataStack(); r1 = PopDataStack(); PushDataStack(int(r1 < r2)); } STUB_NEXT_INSTR();
+
+				STUB_INSTR(SPIN) {
+					r1 = PopDataStack();
+					r2 = PopDataStack();
+					inst.Spin(instr->args[0], instr->args[1], r1, r2);
+				} STUB_NEXT_INSTR();
+
+				STUB_INSTR(CALL) { Call(instr->args[0], instr->args[1]); } STUB_NEXT_INSTR();
+				STUB_INSTR(RETURN) {
+					if (!Return())
+						return;
+				} STUB_NEXT_INSTR();
+
+				STUB_INSTR(JUMP) { pc = instr->args[0]; } STUB_NEXT_INSTR();
+				STUB_INSTR(JUMP_NOT_EQUAL) {
+					if (PopDataStack() == 0)
+						pc = instr->args[0];
+				} STUB_NEXT_INSTR();
+
+	#if defined(__GNUC__)
+				op_UNSUPPORTED: { FAIL("unexpected instruction"); return; }
+			}
+	#else
+				default: { FAIL("unexpected instruction"); } return;
+			}
+		}
+	#endif
+
+		#undef STUB_INSTR
+		#undef STUB_NEXT_INSTR
+	}
+
+	CobScript& script;
+	StubInstance& inst;
+
+	std::vector<CallInfo> callStack;
+	std::vector<int> dataStack;
+
+	int callStackSize = 0;
+	int dataStackSize = 0;
+
+	int pc = 0;
+	int paramCount = 0;
+	int retCode = -1;
+};
+
+
+TEST_CASE("CobDispatchBenchmark", "[.]")
+{
+	constexpr int numLoops = 1000000;
+	constexpr int numTicks = 5;
+
+	// Loop: while (s0 < numLoops) { s0 = s0 + 1; call Step(s0); spin piece 2 around y; }
+	// Step(x): s1 = (s1 + x * 3) & 0xffff;
+	CobScript script;
+	script.scriptNames = {"Loop", "Step"};
+	script.code = {
+		PUSH_STATIC, 0, PUSH_CONSTANT, numLoops, SET_LESS, JUMP_NOT_EQUAL, 28,
+		PUSH_STATIC, 0, PUSH_CONSTANT, 1, ADD, POP_STATIC, 0,
+		PUSH_STATIC, 0, CALL, 1, 1,
+		PUSH_CONSTANT, 10, PUSH_CONSTANT, 20, SPIN, 2, 1,
+		JUMP, 0,
+		PUSH_CONSTANT, 0, RETURN,
+
+		CREATE_LOCAL, PUSH_STATIC, 1, PUSH_LOCAL_VAR, 0, PUSH_CONSTANT, 3, MUL, ADD,
+		PUSH_CONSTANT, 0xffff, BITWISE_AND, POP_STATIC, 1, PUSH_CONSTANT, 0, RETURN,
+	};
+	script.scriptOffsets = {0, 31};
+	script.scriptLengths = {31, int(script.code.size()) - 31};
+	script.Decode();
+
+	const std::vector<int> rawCode = script.code;
+
+	double ms[2] = {0.0, 0.0};
+	StubInstance insts[2];
+
+	for (int tick = 0; tick < numTicks; tick++) {
+		for (int decoded = 0; decoded < 2; decoded++) {
+			insts[decoded] = {};
+			script.code = rawCode;
+
+			StubThread thread(script, insts[decoded]);
+
+			const auto t0 = std::chrono::steady_clock::now();
+
+			if (decoded == 0) {
+				thread.TickRaw();
+			} else {
+				thread.TickDecoded();
+			}
+
+			const auto t1 = std::chrono::steady_clock::now();
+
+			ms[decoded] += std::chrono::duration<double, std::milli>(t1 - t0).count();
+		}
+	}
+
+	// both loops have to compute the same thing for the timings to mean anything
+	CHECK(insts[0].staticVars[0] == numLoops);
+	CHECK(insts[0].staticVars == insts[1].staticVars);
+	CHECK(insts[0].numSpins == numLoops);
+	CHECK(insts[0].numSpins == insts[1].numSpins);
+	CHECK(insts[0].spinSum == insts[1].spinSum);
+
+	const double rawMs = ms[0] / numTicks;
+	const double decodedMs = ms[1] / numTicks;
+
+	WARN("raw switch: " << rawMs << "ms, decoded: " << decodedMs << "ms per " << numLoops << " loops");
+}
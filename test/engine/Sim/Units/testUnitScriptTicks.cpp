@@ -0,0 +1,296 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Sim/Units/Scripts/UnitScriptTicks.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Platform/Threading.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+struct do_once {
+	do_once() { Threading::DetectCores(); } // make GetMaxThreads() work
+};
+
+InitSpringTime ist;
+do_once doonce;
+
+
+struct TestScript;
+
+// same instance bookkeeping as CUnitScriptEngine
+struct TestEngine {
+	void AddInstance(TestScript* instance) {
+		if (instance == currentScript)
+			return;
+
+		spring::VectorInsertUnique(animating, instance);
+	}
+	void RemoveInstance(TestScript* instance) {
+		if (instance == currentScript)
+			return;
+
+		UnitScriptTicks::RemoveInstance(animating, tickedScripts, instance);
+	}
+
+	void Tick(int deltaTime, bool parallel) {
+		if (parallel) {
+			UnitScriptTicks::TickParallel(animating, tickedScripts, deltaTime);
+		} else {
+			UnitScriptTicks::Tick(animating, currentScript, deltaTime);
+		}
+	}
+
+	TestScript* currentScript = nullptr;
+
+	std::vector<TestScript*> animating;
+	std::vector<TestScript*> tickedScripts;
+};
+
+
+// move-animations of a few pieces, mirroring CUnitScript's tick and dispatch
+struct TestScript {
+	struct Anim {
+		int piece;
+		float dest;
+		float speed;
+	};
+
+	TestScript(TestEngine* e, int numPieces): engine(e), pieces(numPieces, 0.0f), numTrips(numPieces, 0) {}
+
+	// what ~CUnitScript does, but keeps the object around for checking
+	void Destroy() {
+		destroyed = true;
+
+		if (!HaveAnimations() && !HaveFinishedAnimations())
+			return;
+
+		engine->RemoveInstance(this);
+	}
+
+	void AddAnim(int piece, float dest, float speed) {
+		const auto it = std::find_if(anims.begin(), anims.end(), [&](const Anim& a) { return (a.piece == piece); });
+
+		if (it != anims.end()) {
+			*it = {piece, dest, speed};
+			return;
+		}
+
+		if (!HaveAnimations() && !HaveFinishedAnimations())
+			engine->AddInstance(this);
+
+		anims.push_back({piece, dest, speed});
+	}
+
+	void StopAnims() {
+		anims.clear();
+
+		if (HaveFinishedAnimations())
+			return;
+
+		engine->RemoveInstance(this);
+	}
+
+	bool Tick(int deltaTime) {
+		TickAnimations(deltaTime);
+		DispatchFinishedAnims();
+
+		return (HaveAnimations());
+	}
+
+	void TickAnimations(int deltaTime) {
+		for (size_t i = 0; i < anims.size(); ) {
+			Anim& a = anims[i];
+			float& cur = pieces[a.piece];
+
+			const float delta = a.dest - cur;
+			const float step = a.speed * deltaTime * 0.001f;
+
+			if (std::abs(delta) > step) {
+				cur += ((delta > 0.0f)? step: -step);
+				i++;
+				continue;
+			}
+
+			cur = a.dest;
+
+			doneAnims.push_back(a);
+			a = anims.back();
+			anims.pop_back();
+		}
+	}
+
+	void DispatchFinishedAnims() {
+		// callbacks could add more
+		for (size_t i = 0; i < doneAnims.size(); i++) {
+			AnimFinished(doneAnims[i]);
+		}
+
+		doneAnims.clear();
+	}
+
+	// moves the piece back and forth a few times, then the next piece
+	void AnimFinished(const Anim& a) {
+		CHECK(!destroyed);
+
+		if (onFinished)
+			onFinished(*this);
+
+		if ((numTrips[a.piece] += 1) < maxTrips) {
+			AddAnim(a.piece, -a.dest, a.speed * 1.5f);
+			return;
+		}
+
+		if ((a.piece + 1) < int(pieces.size()))
+			AddAnim(a.piece + 1, a.dest, a.speed);
+	}
+
+	bool HaveAnimations() const { return (!anims.empty()); }
+	bool HaveFinishedAnimations() const { return (!doneAnims.empty()); }
+
+	TestEngine* engine;
+
+	std::vector<float> pieces;
+	std::vector<int> numTrips;
+	std::vector<Anim> anims;
+	std::vector<Anim> doneAnims;
+
+	std::function<void(TestScript&)> onFinished;
+
+	int maxTrips = 3;
+	bool destroyed = false;
+};
+
+
+static std::vector<std::unique_ptr<TestScript>> CreateScripts(TestEngine& engine, size_t numScripts, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> dest(10.0f, 100.0f);
+	std::uniform_real_distribution<float> speed(5.0f, 200.0f);
+	std::uniform_int_distribution<int> trips(1, 6);
+
+	std::vector<std::unique_ptr<TestScript>> scripts;
+
+	for (size_t i = 0; i < numScripts; i++) {
+		scripts.emplace_back(new TestScript(&engine, 4));
+		scripts.back()->maxTrips = trips(rng);
+
+		// not every script animates from the start
+		if ((i % 5) != 0)
+			scripts.back()->AddAnim(0, dest(rng), speed(rng));
+	}
+
+	return scripts;
+}
+
+
+TEST_CASE("UnitScriptTicks")
+{
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+
+	SECTION("SameAsSerial") {
+		TestEngine serialEngine;
+		TestEngine parallelEngine;
+
+		const auto serialScripts = CreateScripts(serialEngine, 500, 1234);
+		const auto parallelScripts = CreateScripts(parallelEngine, 500, 1234);
+
+		for (int frame = 0; frame < 300; frame++) {
+			// start animations on idle scripts now and then, like COB threads do
+			if ((frame % 50) == 25) {
+				for (size_t i = 0; i < serialScripts.size(); i += 5) {
+					serialScripts[i]->AddAnim(3, -20.0f, 40.0f);
+					parallelScripts[i]->AddAnim(3, -20.0f, 40.0f);
+				}
+			}
+
+			serialEngine.Tick(33, false);
+			parallelEngine.Tick(33, true);
+		}
+
+		for (size_t i = 0; i < serialScripts.size(); i++) {
+			INFO("script " << i);
+			CHECK(serialScripts[i]->pieces == parallelScripts[i]->pieces);
+			CHECK(serialScripts[i]->numTrips == parallelScripts[i]->numTrips);
+			CHECK(serialScripts[i]->HaveAnimations() == parallelScripts[i]->HaveAnimations());
+		}
+
+		std::sort(serialEngine.animating.begin(), serialEngine.animating.end(), [&](const TestScript* a, const TestScript* b) { return (a->pieces < b->pieces); });
+		std::sort(parallelEngine.animating.begin(), parallelEngine.animating.end(), [&](const TestScript* a, const TestScript* b) { return (a->pieces < b->pieces); });
+
+		REQUIRE(serialEngine.animating.size() == parallelEngine.animating.size());
+
+		for (size_t i = 0; i < serialEngine.animating.size(); i++) {
+			CHECK(serialEngine.animating[i]->pieces == parallelEngine.animating[i]->pieces);
+		}
+	}
+
+	SECTION("RemovedByCallback") {
+		TestEngine engine;
+
+		auto scripts = CreateScripts(engine, 8, 5678);
+
+		// the even ones finish their animations in the first tick, the odd ones do not
+		for (size_t i = 0; i < scripts.size(); i++) {
+			scripts[i]->AddAnim(0, 1.0f, ((i & 1) == 0)? 1000.0f: 1.0f);
+		}
+
+		// the first callback stops the animations of every odd script and destroys
+		// the last even one, whose finished animations are still pending dispatch
+		TestScript* destroyed = scripts[scripts.size() - 2].get();
+		TestScript* stopper = nullptr;
+
+		const auto onFinished = [&](TestScript& script) {
+			if (stopper != nullptr)
+				return;
+
+			stopper = &script;
+
+			for (size_t i = 1; i < scripts.size(); i += 2) {
+				scripts[i]->StopAnims();
+			}
+
+			if (destroyed != &script)
+				destroyed->Destroy();
+		};
+
+		for (const auto& script: scripts) {
+			script->onFinished = onFinished;
+		}
+
+		engine.Tick(33, true);
+
+		REQUIRE(stopper != nullptr);
+		REQUIRE(stopper != destroyed);
+		CHECK(engine.tickedScripts.empty());
+		CHECK(std::find(engine.animating.begin(), engine.animating.end(), destroyed) == engine.animating.end());
+
+		for (size_t i = 0; i < scripts.size(); i++) {
+			INFO("script " << i);
+
+			if ((i & 1) != 0) {
+				CHECK(std::find(engine.animating.begin(), engine.animating.end(), scripts[i].get()) == engine.animating.end());
+				continue;
+			}
+
+			// everything except the destroyed one got its callbacks (and animates back)
+			CHECK(scripts[i]->HaveFinishedAnimations() == (scripts[i].get() == destroyed));
+			CHECK(scripts[i]->HaveAnimations() == (scripts[i].get() != destroyed));
+		}
+
+		// the rest keeps going without ever dispatching to the destroyed one
+		for (int frame = 0; frame < 10; frame++) {
+			engine.Tick(33, true);
+		}
+
+		CHECK(std::find(engine.animating.begin(), engine.animating.end(), destroyed) == engine.animating.end());
+	}
+
+	ThreadPool::SetThreadCount(0);
+}
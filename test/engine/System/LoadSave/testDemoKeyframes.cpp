@@ -0,0 +1,222 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SYNCCHECK
+	#error "This test requires SYNCCHECK to be defined on the compiler command line."
+#endif
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Net/Protocol/NetMessageTypes.h"
+#include "System/LoadSave/DemoKeyframes.h"
+#include "System/LoadSave/demofile.h"
+#include "System/Sync/SyncChecker.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static constexpr int NUM_FRAMES = 200;
+static constexpr int KEYFRAME_INTERVAL = 30;
+
+
+// stands in for the synced game state, savestates are its raw bytes
+struct Sim {
+	std::vector<std::int32_t> values = std::vector<std::int32_t>(64, 0);
+
+	void SimFrame(int frameNum) {
+		for (size_t i = 0; i < values.size(); i++) {
+			values[i] = values[i] * 3 + (frameNum % 7) + int(i);
+			CSyncChecker::Sync(&values[i], sizeof(values[i]));
+		}
+	}
+
+	std::string Save() const { return {(const char*)values.data(), values.size() * sizeof(values[0])}; }
+	void Load(const std::string& saveData) { memcpy(values.data(), saveData.data(), saveData.size()); }
+};
+
+
+// a demo stream holding each frame, its sync response and (every
+// KEYFRAME_INTERVAL frames) a keyframe taken after that frame
+struct DemoStream {
+	void AddChunk(const void* data, unsigned int length) {
+		DemoStreamChunkHeader header;
+		header.modGameTime = 0.0f;
+		header.length = length;
+		header.swab();
+
+		stream.append((const char*)&header, sizeof(header));
+		stream.append((const char*)data, length);
+	}
+
+	void AddFrame() {
+		const std::uint8_t msg = NETMSG_NEWFRAME;
+		AddChunk(&msg, sizeof(msg));
+	}
+
+	void AddSyncResponse(std::int32_t frameNum, std::uint32_t checksum) {
+		std::uint8_t msg[1 + sizeof(frameNum) + sizeof(checksum)] = {NETMSG_SYNCRESPONSE};
+		memcpy(&msg[1], &frameNum, sizeof(frameNum));
+		memcpy(&msg[1 + sizeof(frameNum)], &checksum, sizeof(checksum));
+		AddChunk(msg, sizeof(msg));
+	}
+
+	void AddKeyframe(int frameNum, unsigned int checksum, const std::string& saveData) {
+		std::uint8_t header[DemoKeyframes::HEADER_SIZE];
+		DemoKeyframes::PackHeader(header, frameNum, checksum);
+
+		std::string chunk((const char*)header, sizeof(header));
+		chunk += saveData;
+		AddChunk(chunk.data(), chunk.size());
+	}
+
+	int Read(int pos, char* buf, int size) const {
+		const int n = std::max(0, std::min(size, int(stream.size()) - pos));
+		memcpy(buf, stream.data() + pos, n);
+		return n;
+	}
+
+	std::string stream;
+};
+
+
+struct ReplayResult {
+	int numVerified = 0;
+	int numMismatches = 0;
+	std::vector<std::int32_t> values;
+};
+
+// plays the stream from <streamPos> on (starting after <frameNum>) and
+// compares every recorded sync response with the replayed checksum
+static ReplayResult Replay(const DemoStream& demo, Sim& sim, int streamPos, int frameNum)
+{
+	ReplayResult result;
+
+	while (streamPos < int(demo.stream.size())) {
+		DemoStreamChunkHeader header;
+		memcpy(&header, demo.stream.data() + streamPos, sizeof(header));
+		header.swab();
+
+		const std::uint8_t* data = (const std::uint8_t*)demo.stream.data() + streamPos + sizeof(header);
+		streamPos += (sizeof(header) + header.length);
+
+		switch (data[0]) {
+			case NETMSG_NEWFRAME: {
+				sim.SimFrame(++frameNum);
+			} break;
+			case NETMSG_SYNCRESPONSE: {
+				std::int32_t syncFrameNum;
+				std::uint32_t syncChecksum;
+				memcpy(&syncFrameNum, &data[1], sizeof(syncFrameNum));
+				memcpy(&syncChecksum, &data[1 + sizeof(syncFrameNum)], sizeof(syncChecksum));
+
+				result.numVerified += 1;
+				result.numMismatches += (syncFrameNum != frameNum || syncChecksum != CSyncChecker::GetChecksum());
+			} break;
+			default: {
+			} break;
+		}
+	}
+
+	result.values = sim.values;
+	return result;
+}
+
+
+
+TEST_CASE("DemoKeyframes")
+{
+	DemoStream demo;
+	Sim recordSim;
+
+	CSyncChecker::NewFrame();
+
+	for (int frameNum = 1; frameNum <= NUM_FRAMES; frameNum++) {
+		demo.AddFrame();
+		recordSim.SimFrame(frameNum);
+		demo.AddSyncResponse(frameNum, CSyncChecker::GetChecksum());
+
+		if ((frameNum % KEYFRAME_INTERVAL) == 0)
+			demo.AddKeyframe(frameNum, CSyncChecker::GetChecksum(), recordSim.Save());
+	}
+
+	const auto read = [&](int pos, char* buf, int size) { return demo.Read(pos, buf, size); };
+
+	std::vector<DemoKeyframe> keyframes;
+	DemoKeyframes::Scan(read, 0, demo.stream.size(), keyframes);
+
+	SECTION("Scan") {
+		REQUIRE(keyframes.size() == (NUM_FRAMES / KEYFRAME_INTERVAL));
+
+		for (size_t i = 0; i < keyframes.size(); i++) {
+			CHECK(keyframes[i].frameNum == int(i + 1) * KEYFRAME_INTERVAL);
+			CHECK(keyframes[i].saveDataSize == recordSim.Save().size());
+		}
+
+		// a truncated stream only loses the keyframes past its end
+		std::vector<DemoKeyframe> truncKeyframes;
+		DemoKeyframes::Scan(read, 0, keyframes[2].saveDataPos, truncKeyframes);
+		CHECK(truncKeyframes.size() == 2);
+
+		CHECK(DemoKeyframes::GetFrameNum((const std::uint8_t*)demo.stream.data() + keyframes[1].saveDataPos - DemoKeyframes::HEADER_SIZE, DemoKeyframes::HEADER_SIZE) == keyframes[1].frameNum);
+		CHECK(DemoKeyframes::GetFrameNum((const std::uint8_t*)demo.stream.data(), 2) == -1);
+	}
+
+	SECTION("Find") {
+		CHECK(DemoKeyframes::Find(keyframes, 0) == nullptr);
+		CHECK(DemoKeyframes::Find(keyframes, KEYFRAME_INTERVAL - 1) == nullptr);
+		CHECK(DemoKeyframes::Find(keyframes, KEYFRAME_INTERVAL) == &keyframes[0]);
+		CHECK(DemoKeyframes::Find(keyframes, KEYFRAME_INTERVAL * 2 - 1) == &keyframes[0]);
+		CHECK(DemoKeyframes::Find(keyframes, NUM_FRAMES * 2) == &keyframes.back());
+	}
+
+	SECTION("SeekThenVerify") {
+		CSyncChecker::NewFrame();
+
+		Sim fullSim;
+		const ReplayResult fullReplay = Replay(demo, fullSim, 0, 0);
+
+		REQUIRE(fullReplay.numVerified == NUM_FRAMES);
+		REQUIRE(fullReplay.numMismatches == 0);
+
+		for (const int seekFrameNum: {KEYFRAME_INTERVAL, KEYFRAME_INTERVAL + 7, NUM_FRAMES - 1, NUM_FRAMES}) {
+			const DemoKeyframe* keyframe = DemoKeyframes::Find(keyframes, seekFrameNum);
+
+			REQUIRE(keyframe != nullptr);
+
+			std::string saveData(keyframe->saveDataSize, 0);
+			REQUIRE(demo.Read(keyframe->saveDataPos, &saveData[0], saveData.size()) == int(saveData.size()));
+
+			// same as CCregLoadSaveHandler::LoadKeyframe
+			Sim seekSim;
+			seekSim.Load(saveData);
+			CSyncChecker::SetChecksum(keyframe->syncChecksum);
+
+			const ReplayResult seekReplay = Replay(demo, seekSim, keyframe->saveDataPos + keyframe->saveDataSize, keyframe->frameNum);
+
+			INFO("seek to frame " << seekFrameNum << " from keyframe " << keyframe->frameNum);
+			CHECK(seekReplay.numVerified == (NUM_FRAMES - keyframe->frameNum));
+			CHECK(seekReplay.numMismatches == 0);
+			CHECK(seekReplay.values == fullReplay.values);
+		}
+	}
+
+	SECTION("SeekWithoutChecksum") {
+		// the checksum runs over all frames, restoring the state alone is not enough
+		const DemoKeyframe& keyframe = keyframes[1];
+
+		std::string saveData(keyframe.saveDataSize, 0);
+		demo.Read(keyframe.saveDataPos, &saveData[0], saveData.size());
+
+		Sim seekSim;
+		seekSim.Load(saveData);
+		CSyncChecker::NewFrame();
+
+		const ReplayResult seekReplay = Replay(demo, seekSim, keyframe.saveDataPos + keyframe.saveDataSize, keyframe.frameNum);
+
+		CHECK(seekReplay.numVerified == (NUM_FRAMES - keyframe.frameNum));
+		CHECK(seekReplay.numMismatches == seekReplay.numVerified);
+	}
+}
@@ -0,0 +1,184 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "System/FileSystem/GZFileHandler.h"
+#include "System/LoadSave/DemoStreamWriter.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+// reads the file the same way CDemoReader does
+static bool ReadGZFile(const std::string& fileName, std::string& data)
+{
+	CGZFileHandler file(fileName, SPRING_VFS_PWD);
+
+	data.clear();
+
+	if (!file.FileExists())
+		return false;
+
+	data.resize(file.FileSize());
+	return (file.Read(&data[0], data.size()) == int(data.size()));
+}
+
+static std::string ReadGZFile(const std::string& fileName)
+{
+	std::string data;
+	ReadGZFile(fileName, data);
+	return data;
+}
+
+static std::string ReadRawFile(const std::string& fileName)
+{
+	std::ifstream ifs(fileName, std::ios::in | std::ios::binary);
+	return {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+}
+
+static void WriteRawFile(const std::string& fileName, const std::string& data)
+{
+	std::ofstream ofs(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+	ofs.write(data.data(), data.size());
+}
+
+
+TEST_CASE("DemoStreamWriter")
+{
+	const std::string fileName = "testDemoStreamWriter.sdfz";
+	const std::string truncFileName = "testDemoStreamWriterTrunc.sdfz";
+	const std::string header = "HEADER-0";
+
+	std::string data;
+
+	for (int i = 0; i < 10000; i++) {
+		data += std::to_string(i);
+	}
+
+	SECTION("Close") {
+		{
+			CDemoStreamWriter writer(fileName, header.data(), header.size(), 60 * 1000, 1024 * 1024);
+
+			REQUIRE(writer.IsOpen());
+
+			writer.Write(data.data(), data.size());
+			writer.WriteHeader("HEADER-1");
+		}
+
+		CHECK(ReadGZFile(fileName) == ("HEADER-1" + data));
+	}
+
+	SECTION("Flush") {
+		CDemoStreamWriter writer(fileName, header.data(), header.size(), 60 * 1000, 1024 * 1024);
+
+		REQUIRE(writer.IsOpen());
+
+		// nothing but the header until the first flush
+		writer.Write(data.data(), data.size());
+		CHECK(ReadGZFile(fileName) == header);
+
+		writer.Flush();
+		CHECK(ReadGZFile(fileName) == (header + data));
+
+		writer.WriteHeader("HEADER-1");
+		writer.Write(data.data(), data.size());
+		writer.Flush();
+		CHECK(ReadGZFile(fileName) == ("HEADER-1" + data + data));
+	}
+
+	SECTION("Interval") {
+		CDemoStreamWriter writer(fileName, header.data(), header.size(), 10, 1024 * 1024);
+
+		REQUIRE(writer.IsOpen());
+
+		writer.Write(data.data(), data.size());
+
+		// the writer flushes on its own, wait for it (but not forever)
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+		while (ReadGZFile(fileName) != (header + data) && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::yield();
+		}
+
+		CHECK(ReadGZFile(fileName) == (header + data));
+	}
+
+	SECTION("BufferSize") {
+		// small buffers are flushed right away, and Write has
+		// to wait for the writer thread to catch up with them
+		CDemoStreamWriter writer(fileName, header.data(), header.size(), 60 * 1000, 1024);
+
+		REQUIRE(writer.IsOpen());
+
+		for (size_t i = 0; i < data.size(); i += 100) {
+			writer.Write(&data[i], std::min(data.size() - i, size_t(100)));
+		}
+
+		writer.Close();
+
+		CHECK(!writer.IsOpen());
+		CHECK(ReadGZFile(fileName) == (header + data));
+	}
+
+	SECTION("Truncated") {
+		// a crash while a member is written cuts the file off within it
+		size_t headerMemberEnd = 0;
+		size_t dataMemberEnd = 0;
+
+		{
+			CDemoStreamWriter writer(fileName, header.data(), header.size(), 60 * 1000, 1024 * 1024);
+
+			REQUIRE(writer.IsOpen());
+
+			headerMemberEnd = ReadRawFile(fileName).size();
+
+			writer.Write(data.data(), data.size());
+			writer.Flush();
+
+			dataMemberEnd = ReadRawFile(fileName).size();
+
+			writer.Write(data.data(), data.size() / 2);
+		}
+
+		const std::string file = ReadRawFile(fileName);
+
+		REQUIRE(headerMemberEnd > 0);
+		REQUIRE(dataMemberEnd > headerMemberEnd);
+		REQUIRE(file.size() > dataMemberEnd);
+
+		// complete members are kept, the cut-off one is dropped
+		for (const size_t size: {dataMemberEnd, dataMemberEnd + 1, dataMemberEnd + 10, (dataMemberEnd + file.size()) / 2, file.size() - 1}) {
+			std::string truncData;
+
+			WriteRawFile(truncFileName, file.substr(0, size));
+
+			INFO("truncated to " << size << " of " << file.size() << " bytes");
+			CHECK(ReadGZFile(truncFileName, truncData));
+			CHECK(truncData == (header + data));
+		}
+
+		{
+			std::string truncData;
+
+			WriteRawFile(truncFileName, file.substr(0, headerMemberEnd + 1));
+			CHECK(ReadGZFile(truncFileName, truncData));
+			CHECK(truncData == header);
+
+			// without a single complete member there is nothing to recover
+			WriteRawFile(truncFileName, file.substr(0, headerMemberEnd - 1));
+			CHECK(!ReadGZFile(truncFileName, truncData));
+		}
+
+		CHECK(ReadGZFile(fileName) == (header + data + data.substr(0, data.size() / 2)));
+
+		std::remove(truncFileName.c_str());
+	}
+
+	std::remove(fileName.c_str());
+}
@@ -0,0 +1,233 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SYNCCHECK
+	#error "This test requires SYNCCHECK to be defined on the compiler command line."
+#endif
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "System/Sync/SyncedPrimitiveBase.h"
+#include "System/Threading/ThreadPool.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Platform/Threading.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+struct do_once {
+	do_once() { Threading::DetectCores(); } // make GetMaxThreads() work
+};
+
+InitSpringTime ist;
+do_once doonce;
+
+
+static unsigned SyncValues(const std::vector<int>& values, bool parallel)
+{
+	CSyncChecker::NewFrame();
+
+	if (parallel) {
+		SCOPED_SYNC_PARALLEL_SECTION();
+
+		for (const int& v: values) {
+			CSyncChecker::Sync(&v, sizeof(v));
+		}
+	} else {
+		for (const int& v: values) {
+			CSyncChecker::Sync(&v, sizeof(v));
+		}
+	}
+
+	return CSyncChecker::GetChecksum();
+}
+
+// syncs values[i * k, (i + 1) * k) as the k-value item i, with the items
+// in the given order
+static unsigned SyncItems(const std::vector<int>& values, const std::vector<int>& order, int k)
+{
+	CSyncChecker::NewFrame();
+
+	{
+		SCOPED_SYNC_PARALLEL_SECTION();
+
+		for (const int i: order) {
+			SCOPED_SYNC_PARALLEL_ITEM(i);
+
+			for (int j = 0; j < k; j++) {
+				CSyncChecker::Sync(&values[i * k + j], sizeof(int));
+			}
+		}
+	}
+
+	return CSyncChecker::GetChecksum();
+}
+
+
+TEST_CASE("SyncChecker")
+{
+	std::vector<int> values(1000);
+	std::mt19937 rng(1234);
+
+	for (int& v: values) {
+		v = rng();
+	}
+
+	SECTION("Serial") {
+		unsigned checksum = 0xfade1eaf;
+
+		for (const int& v: values) {
+			checksum = spring::LiteHash(&v, sizeof(v), checksum);
+		}
+
+		CHECK(SyncValues(values, false) == checksum);
+
+		// serial checksums depend on the order of the values
+		std::reverse(values.begin(), values.end());
+		CHECK(SyncValues(values, false) != checksum);
+	}
+
+	SECTION("Parallel") {
+		const unsigned checksum = SyncValues(values, true);
+
+		CHECK(checksum != SyncValues({}, false));
+
+		// parallel ones do not, s.t. the item to thread mapping does not matter
+		std::shuffle(values.begin(), values.end(), rng);
+		CHECK(SyncValues(values, true) == checksum);
+
+		// but still on the values themselves
+		values[0] += 1;
+		CHECK(SyncValues(values, true) != checksum);
+	}
+
+	SECTION("EmptySection") {
+		CHECK(SyncValues({}, true) == SyncValues({}, false));
+	}
+
+	SECTION("NestedSections") {
+		const unsigned checksum = SyncValues(values, true);
+
+		CSyncChecker::NewFrame();
+		{
+			SCOPED_SYNC_PARALLEL_SECTION();
+
+			for (size_t i = 0; i < values.size(); i++) {
+				if (i == (values.size() / 2)) {
+					SCOPED_SYNC_PARALLEL_SECTION();
+					CSyncChecker::Sync(&values[i], sizeof(values[i]));
+				} else {
+					CSyncChecker::Sync(&values[i], sizeof(values[i]));
+				}
+			}
+
+			CHECK(CSyncChecker::InParallelSection());
+		}
+
+		CHECK(!CSyncChecker::InParallelSection());
+		CHECK(CSyncChecker::GetChecksum() == checksum);
+	}
+
+	SECTION("Items") {
+		constexpr int k = 4;
+
+		std::vector<int> order(values.size() / k);
+
+		for (size_t i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+
+		const unsigned checksum = SyncItems(values, order, k);
+
+		// the order in which the items run does not matter
+		std::shuffle(order.begin(), order.end(), rng);
+		CHECK(SyncItems(values, order, k) == checksum);
+
+		// values swapped between items do
+		std::swap(values[0], values[k]);
+		CHECK(SyncItems(values, order, k) != checksum);
+		std::swap(values[0], values[k]);
+
+		// and so do values reordered within an item
+		std::swap(values[0], values[1]);
+		CHECK(SyncItems(values, order, k) != checksum);
+		std::swap(values[0], values[1]);
+
+		CHECK(SyncItems(values, order, k) == checksum);
+	}
+
+	SECTION("EmptyItems") {
+		std::vector<int> order(values.size());
+
+		for (size_t i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+
+		// items that sync nothing change nothing, no matter how many ran
+		CHECK(SyncItems(values, order, 0) == SyncValues({}, false));
+		CHECK(SyncItems(values, {}, 0) == SyncValues({}, false));
+
+		// nor do they change the checksum of the items that did sync
+		const unsigned checksum = SyncItems(values, {0, 1, 2}, 4);
+
+		CSyncChecker::NewFrame();
+		{
+			SCOPED_SYNC_PARALLEL_SECTION();
+
+			for (const int i: {0, 1, 2}) {
+				SCOPED_SYNC_PARALLEL_ITEM(i);
+
+				for (int j = 0; j < 4; j++) {
+					CSyncChecker::Sync(&values[i * 4 + j], sizeof(int));
+				}
+			}
+			for (const int i: {3, 4, 5}) {
+				SCOPED_SYNC_PARALLEL_ITEM(i);
+			}
+		}
+
+		CHECK(CSyncChecker::GetChecksum() == checksum);
+	}
+}
+
+
+TEST_CASE("SyncCheckerThreadPool")
+{
+	std::vector<int> values(20000);
+	std::vector<int> order(values.size());
+	std::mt19937 rng(1234);
+
+	for (size_t i = 0; i < values.size(); i++) {
+		values[i] = rng();
+		order[i] = i;
+	}
+
+	// reference checksum of a single-threaded run
+	const unsigned checksum = SyncItems(values, order, 1);
+
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+
+	for (const bool workStealing: {false, true}) {
+		ThreadPool::SetWorkStealing(workStealing);
+
+		for (int run = 0; run < 20; run++) {
+			CSyncChecker::NewFrame();
+
+			{
+				SCOPED_SYNC_PARALLEL_SECTION();
+
+				for_mt(0, values.size(), [&](const int i) {
+					SCOPED_SYNC_PARALLEL_ITEM(i);
+					CSyncChecker::Sync(&values[i], sizeof(values[i]));
+				});
+			}
+
+			INFO("work stealing " << workStealing << ", run " << run);
+			CHECK(CSyncChecker::GetChecksum() == checksum);
+		}
+	}
+
+	ThreadPool::SetWorkStealing(false);
+	ThreadPool::SetThreadCount(0);
+}
@@ -203,6 +203,86 @@ TEST_CASE("test_sse_for_mt")
 }
 
 
+TEST_CASE("test_stealing_for_mt")
+{
+	LOG("[%s::test_stealing_for_mt]", __func__);
+
+	ThreadPool::SetWorkStealing(true);
+
+	for (const int step: {1, 2, 7}) {
+		std::vector<std::atomic<int>> nums(NUM_RUNS);
+
+		for (auto& n: nums)
+			n = 0;
+
+		for_mt(0, NUM_RUNS, step, [&](const int i) {
+			const int threadnum = ThreadPool::GetThreadNum();
+			SAFE_CHECK(threadnum < NUM_THREADS);
+			SAFE_CHECK(threadnum >= 0);
+			nums[i]++;
+		});
+
+		for (int i = 0; i < NUM_RUNS; i++) {
+			CHECK(nums[i] == ((i % step) == 0));
+		}
+	}
+
+	// fixed and minimum chunk-sizes
+	for (const int chunkSize: {0, 16, -16, 10000}) {
+		std::vector<std::atomic<int>> nums(NUM_RUNS);
+
+		for (auto& n: nums)
+			n = 0;
+
+		for_mt_chunk(0, NUM_RUNS, [&](const int i) { nums[i]++; }, chunkSize);
+
+		for (int i = 0; i < NUM_RUNS; i++) {
+			CHECK(nums[i] == 1);
+		}
+	}
+
+	// nested loops must not steal across groups
+	std::atomic<int> cnt(0);
+
+	for_mt(0, 100, [&](const int y) {
+		for_mt(0, 100, [&](const int x) {
+			++cnt;
+		});
+	});
+
+	CHECK(cnt == 100 * 100);
+
+	ThreadPool::SetWorkStealing(false);
+}
+
+TEST_CASE("test_worker_counters")
+{
+	LOG("[%s::test_worker_counters]", __func__);
+
+	ThreadPool::ResetWorkerCounters();
+
+	for_mt(0, NUM_THREADS * 16, [&](const int i) {
+		const spring_time finish = spring_now() + spring_time::fromMicroSecs(100);
+		while (spring_now() < finish) {}
+	});
+
+	// give workers a chance to go back to waiting
+	spring_time::fromMilliSecs(10).sleep();
+
+	uint64_t busyTime = 0;
+	uint64_t numTasks = 0;
+
+	for (int i = 1; i < NUM_THREADS; i++) {
+		const ThreadPool::WorkerCounters& wc = ThreadPool::GetWorkerCounters(i);
+
+		busyTime += wc.busyTime;
+		numTasks += wc.numTasksRun;
+	}
+
+	CHECK((NUM_THREADS == 1 || (busyTime > 0 && numTasks > 0)));
+}
+
+
 
 
 
@@ -256,6 +336,103 @@ TEST_CASE("test_for_vs_for_mt")
 }
 
 
+static spring_time for_mt_throughput_kernel(const bool stealing, const int numRuns, const int innerLoad)
+{
+	std::vector<float> sums(ThreadPool::MAX_THREADS, 0.0f);
+
+	ThreadPool::SetWorkStealing(stealing);
+
+	const spring_time start = spring_now();
+
+	for_mt(0, numRuns, [&](const int i) {
+		float sum = 0.0f;
+
+		for (int k = 0; k < innerLoad; k++)
+			sum += math::sqrt(float(i + k));
+
+		sums[ThreadPool::GetThreadNum()] += sum;
+	});
+
+	const spring_time elapsed = spring_now() - start;
+
+	ThreadPool::SetWorkStealing(false);
+	return elapsed;
+}
+
+TEST_CASE("test_for_mt_throughput")
+{
+	LOG("[%s::test_for_mt_throughput]", __func__);
+
+	for (const int numRuns: {1000, 100000, 1000000}) {
+		for (const int innerLoad: {1, 16}) {
+			spring_time t_shared;
+			spring_time t_stealing;
+
+			// best of a few runs, the first ones also warm up the pool
+			for (int n = 0; n < 5; n++) {
+				const spring_time a = for_mt_throughput_kernel(false, numRuns, innerLoad);
+				const spring_time b = for_mt_throughput_kernel( true, numRuns, innerLoad);
+
+				t_shared   = (n == 0)? a: std::min(t_shared  , a);
+				t_stealing = (n == 0)? b: std::min(t_stealing, b);
+			}
+
+			LOG("\t%7d runs (load %2d): shared-counter %.4fms, work-stealing %.4fms (%.0f%%)", numRuns, innerLoad, t_shared.toMilliSecsf(), t_stealing.toMilliSecsf(), (t_stealing.toMilliSecsf() / std::max(t_shared.toMilliSecsf(), 1e-3f)) * 100.0f);
+		}
+	}
+}
+
+
+TEST_CASE("test_for_mt_fairness")
+{
+	LOG("[%s::test_for_mt_fairness]", __func__);
+
+	constexpr int RUNS = 1024;
+
+	// all of the cost is in the first eighth of the range, i.e. what a static
+	// even split would hand to a single thread
+	const auto ExecKernel = [](const int i) {
+		if (i >= (RUNS / 8))
+			return;
+
+		const spring_time finish = spring_now() + spring_time::fromMicroSecs(400);
+		while (spring_now() < finish) {}
+	};
+
+	for (const bool stealing: {false, true}) {
+		std::vector<int> runs(ThreadPool::MAX_THREADS, 0);
+
+		ThreadPool::SetWorkStealing(stealing);
+		ThreadPool::ResetWorkerCounters();
+
+		const spring_time start = spring_now();
+
+		for_mt_chunk(0, RUNS, [&](const int i) {
+			ExecKernel(i);
+			runs[ThreadPool::GetThreadNum()] += (i < (RUNS / 8));
+		});
+
+		const spring_time elapsed = spring_now() - start;
+
+		uint64_t numSteals = 0;
+		int maxRuns = 0;
+
+		for (int i = 0; i < NUM_THREADS; i++) {
+			numSteals += ThreadPool::GetWorkerCounters(i).numSteals;
+			maxRuns = std::max(maxRuns, runs[i]);
+		}
+
+		LOG("\t[%s] %.3fms, at most %d/%d expensive iterations on one thread, %lu steals", stealing? "work-stealing": "static-chunks", elapsed.toMilliSecsf(), maxRuns, RUNS / 8, numSteals);
+
+		// the expensive iterations take long enough for every thread to wake up
+		if (stealing && NUM_THREADS > 1)
+			CHECK(numSteals > 0);
+	}
+
+	ThreadPool::SetWorkStealing(false);
+}
+
+
 static void test_parallel_reaction_times_aux(int numRuns)
 {
 	LOG("\t[%s]", __func__);